@@ -995,8 +995,10 @@ vsObject *vsAvatar::makeVsSequencer()
     char token[256];
     int lineType = 0;
     char objName[256];
+    char resourceName[256];
     vsSequencer *result;
     vsUpdatable *updatable;
+    vsUpdatable *dependency;
     double time;
 
     // Construct the sequencer _first_, so that we can add the updatable
@@ -1035,6 +1037,39 @@ vsObject *vsAvatar::makeVsSequencer()
             if (updatable)
                 result->addUpdatable(updatable, time, objName);
         }
+        else if (!strcmp(token, "parallel"))
+        {
+            // Let updatables with declared resources run in parallel
+            result->setScheduleMode(VS_SEQUENCER_PARALLEL);
+        }
+        else if ((!strcmp(token, "reads")) || (!strcmp(token, "writes")))
+        {
+            // Read the object name and resource name
+            sscanf(cfgLine, "%*s %s %s", objName, resourceName);
+
+            // Find the specified object and declare its access
+            updatable = (vsUpdatable *)(findObject(objName));
+            if (updatable)
+            {
+                if (!strcmp(token, "reads"))
+                    result->addUpdatableAccess(updatable, resourceName,
+                        VS_SEQUENCER_READ);
+                else
+                    result->addUpdatableAccess(updatable, resourceName,
+                        VS_SEQUENCER_WRITE);
+            }
+        }
+        else if (!strcmp(token, "dependsOn"))
+        {
+            // Read the object name and the name of its dependency
+            sscanf(cfgLine, "%*s %s %s", objName, resourceName);
+
+            // Find the specified objects and declare the dependency
+            updatable = (vsUpdatable *)(findObject(objName));
+            dependency = (vsUpdatable *)(findObject(resourceName));
+            if ((updatable) && (dependency))
+                result->addUpdatableDependency(updatable, dependency);
+        }
         else
             printf("vsAvatar::makeVsSequencer: Unrecognized token '%s'\n",
                 token);
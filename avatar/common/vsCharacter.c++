@@ -27,6 +27,47 @@
 //------------------------------------------------------------------------
 #include "vsCharacter.h++"
 #include "vsSkinProgramNode.h++"
+#include "vsThreadPool.h++"
+#include <stdlib.h>
+
+// Describes a batch of characters being updated by the thread pool
+struct vsCharacterBatch
+{
+    vsCharacter    **characters;
+    int            characterCount;
+    double         deltaTime;
+};
+
+// Pairs a bone kinematics object of a character with the corresponding
+// bone kinematics of a clone of the character
+struct vsCharacterKinPair
+{
+    vsKinematics    *original;
+    vsKinematics    *clone;
+};
+
+// ------------------------------------------------------------------------
+// Static function
+// Compares two kinematics pairs by the address of their original
+// kinematics (used to sort and search the pairs with qsort/bsearch)
+// ------------------------------------------------------------------------
+static int compareKinPairs(const void *first, const void *second)
+{
+    vsCharacterKinPair *firstPair;
+    vsCharacterKinPair *secondPair;
+
+    // Get the pairs
+    firstPair = (vsCharacterKinPair *)first;
+    secondPair = (vsCharacterKinPair *)second;
+
+    // Order them by address
+    if (firstPair->original < secondPair->original)
+        return -1;
+    else if (firstPair->original > secondPair->original)
+        return 1;
+    else
+        return 0;
+}
 
 // ------------------------------------------------------------------------
 // Constructor for a simple character with a single skeleton, kinematics,
@@ -110,7 +151,6 @@ vsCharacter::vsCharacter(vsSkeleton *skeleton, vsSkeletonKinematics *skelKin,
     oneTimeAnimation = NULL;
     oneTimeStarted = false;
     finalStarted = false;
-    transitionAnimation = NULL;
     transitioning = false;
 
     // Set the flag to indicate whether or not the character is valid
@@ -250,7 +290,6 @@ vsCharacter::vsCharacter(vsList *skeletons, vsList *skelKins,
     oneTimeAnimation = NULL;
     oneTimeStarted = false;
     finalStarted = false;
-    transitionAnimation = NULL;
     transitioning = false;
 
     // Set the flag to indicate whether or not the character is valid
@@ -509,20 +548,14 @@ vsGLSLProgramAttribute *vsCharacter::createDefaultSkinProgram()
 }
 
 // ------------------------------------------------------------------------
-// Create a transition animation from the 
+// Starts a transition from the current pose of the character into the
+// first pose of the target animation.  The target animation's path
+// motions blend from their bones' current poses over the given time, and
+// then play the animation normally, so no temporary animation is created
 // ------------------------------------------------------------------------
 void vsCharacter::transitionToAnimation(vsPathMotionManager *target,
                                         double transitionTime)
 {
-    vsPathMotion *transPath;
-    vsPathMotion *sourcePath;
-    vsPathMotion *targetPath;
-    int index;
-    int targetIndex;
-    vsPathMotionManager *newTransition;
-    vsKinematics *sourceKin;
-    vsKinematics *targetKin;
-
     // If the target animation is NULL, do nothing
     if (target == NULL)
     {
@@ -559,112 +592,23 @@ void vsCharacter::transitionToAnimation(vsPathMotionManager *target,
         return;
     }
 
-    // Create the vsPathMotionManager representing the transition animation
-    newTransition = new vsPathMotionManager();
-
-    // Loop through the path motions until we've hit the end of one of the
-    // managers
-    index = 0;
-    while (index < currentAnimation->getPathMotionCount() &&
-           index < target->getPathMotionCount())
-    {
-        // Get the path motion at the index from the source animation
-        sourcePath = currentAnimation->getPathMotion(index);
-
-        // Get the source's kinematics
-        sourceKin = sourcePath->getKinematics();
-
-        // See if the target path motion is at the same index as the source
-        // path motion (this is often the case, but we have to check to be
-        // sure)
-        targetPath = target->getPathMotion(index);
-        targetKin = targetPath->getKinematics();
-        if (targetKin != sourceKin)
-        {
-            // Search the target animation for the path motion corresponding
-            // to the source path motion (they both should be targeting the
-            // same kinematics object)
-            targetIndex = 0;
-            targetPath = target->getPathMotion(targetIndex);
-            targetKin = targetPath->getKinematics();
-            while ((targetPath != NULL) && (targetKin != sourceKin))
-            {
-                targetIndex++;
-                targetPath = target->getPathMotion(targetIndex);
-                if (targetPath == NULL)
-                    targetKin = NULL;
-                else
-                    targetKin = targetPath->getKinematics();
-            }
-        }
-
-        // Make sure we found the target kinematics (otherwise, we'll skip
-        // this channel in the transition animation)
-        if (targetKin != NULL)
-        {
-            // Create a new path motion using the same kinematics
-            transPath = new vsPathMotion(sourceKin);
-
-            // There are two points in this path motion - the current position
-            // of the current animation, and the starting position of the
-            // target animation
-            transPath->setPointListSize(2);
-
-            // Set the position/orientation data for the first point
-            transPath->setPosition(0, sourcePath->getCurrentPosition());
-            transPath->setOrientation(0, sourcePath->getCurrentOrientation());
-
-            // Get the path to the end of this animation. As we are going
-            // forward, the second point should be the beginning of the new
-            // animation.
-            transPath->setPosition(1, targetPath->getPosition(0));
-            transPath->setOrientation(1, targetPath->getOrientation(0));
-
-            // Set the time to be equal to the specified transition time
-            transPath->setTime(0, transitionTime);
-
-            // Use linear interpolation for the transition
-            transPath->setPositionMode(VS_PATH_POS_IMODE_LINEAR);
-            transPath->setOrientationMode(VS_PATH_ORI_IMODE_SLERP);
-
-            // Add this path motion (corresponding only to a single bone in the
-            // skeleton) to the overall animation
-            newTransition->addPathMotion(transPath);
-        }
-
-        // Next bone
-        index++;
-    }
-
-    // Stop the current animation
+    // Stop the current animation (this also cancels any transition that
+    // it was in the middle of, leaving the bones where they are now)
     currentAnimation->stop();
 
-    // See whether the current animation was also a transition
-    if (currentAnimation == transitionAnimation)
-    {
-        // Delete the previous transition
-        vsObject::unrefDelete(transitionAnimation);
-    }
-
-    // Set the new transition animation
-    transitionAnimation = newTransition;
-    transitionAnimation->ref();
-
-    // Set the transition's properties and start it up
-    transitionAnimation->setCycleMode(VS_PATH_CYCLE_RESTART);
-    transitionAnimation->setCycleCount(1);
-    transitionAnimation->stop();
-    transitionAnimation->startResume();
+    // Start the target animation, blending in from the current pose
+    target->stop();
+    target->startResume();
+    target->startTransition(transitionTime);
     transitioning = true;
 
-    // Make the transition animation current
-    currentAnimation = transitionAnimation;
+    // Make the target animation current
+    currentAnimation = target;
 }
 
 // ------------------------------------------------------------------------
-// After an animation transition is complete, this method cleans up the
-// transition animation and figures out which animation to start playing
-// next
+// After an animation transition is complete, this method figures out
+// which animation to start playing next
 // ------------------------------------------------------------------------
 void vsCharacter::finishTransition()
 {
@@ -689,16 +633,173 @@ void vsCharacter::finishTransition()
     currentAnimation->stop();
     currentAnimation->startResume();
 
-    // Make sure we actually have a transition to finish
-    if (transitionAnimation != NULL)
+    // Mark that we're not transitioning
+    transitioning = false;
+}
+
+// ------------------------------------------------------------------------
+// Static function
+// Thread pool task that updates the poses of a range of characters in a
+// batch
+// ------------------------------------------------------------------------
+void vsCharacter::characterBatchTaskFunc(void *userData, int first,
+                                         int last)
+{
+    vsCharacterBatch *batch;
+    int i;
+
+    // Get the batch
+    batch = (vsCharacterBatch *)userData;
+
+    // Update each character in the range
+    for (i = first; i < last; i++)
+        batch->characters[i]->updatePose(batch->deltaTime);
+}
+
+// ------------------------------------------------------------------------
+// Updates the animation state and the current animation, then applies the
+// new poses to the skeleton kinematics, skeletons, and skins to generate
+// the new skin matrices.  This only touches objects that belong to this
+// character, so it's safe to call for several characters at once.
+// ------------------------------------------------------------------------
+void vsCharacter::updatePose(double deltaTime)
+{
+    vsSkeletonKinematics *kin;
+    vsSkeleton *skeleton;
+    vsSkin *skin;
+
+    // Update the animation state
+    if (currentAnimation != NULL)
+    {
+        // See if we're currently transitioning between animations
+        if (transitioning)
+        {
+            // Update the current animation (it blends in from the pose
+            // the character was in when the transition started)
+            currentAnimation->update(deltaTime);
+
+            // If the transition is complete, finish it up and move on to
+            // the next animation
+            if (!currentAnimation->isTransitioning())
+                finishTransition();
+        }
+
+        // If we're not transitioning (or not _still_ transitioning)
+        // update the current animation.  In the case where we just completed
+        // a transition, we allow this double-update to "prime" the new
+        // animation
+        if (!transitioning)
+        {
+            // Update the current animation
+            currentAnimation->update(deltaTime);
+
+            // See if we need to switch animations
+            if (currentAnimation->isDone())
+            {
+                // See if a one time-animation is playing
+                if (oneTimeStarted)
+                {
+                    // We're done with this one-time animation, so
+                    // clean up the state
+                    oneTimeAnimation = NULL;
+                    oneTimeStarted = false;
+
+                    // See if this is a final animation
+                    if (finalStarted)
+                    {
+                        // No more animations will be applied, set the
+                        // current animation to NULL to avoid unnecessary
+                        // checks on the next update
+                        currentAnimation = NULL;
+                    }
+                    else
+                    {
+                        // We need to transition back to another animation
+                        if (loopStarted)
+                        {
+                            // There is a looping animation defined,
+                            // transition back to that
+                            transitionToAnimation(loopingAnimation,
+                                                  oneTimeTransOutTime);
+                        }
+                        else
+                        {
+                            // Transition back to the default animation
+                            transitionToAnimation(defaultAnimation,
+                                                  oneTimeTransOutTime);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // Update all kinematics and skeletons with the time value
+    kin = (vsSkeletonKinematics *)skeletonKinematics->getFirstEntry();
+    while (kin != NULL)
+    {
+        kin->update(deltaTime);
+        kin = (vsSkeletonKinematics *)skeletonKinematics->getNextEntry();
+    }
+    skeleton = (vsSkeleton *)characterSkeletons->getFirstEntry();
+    while (skeleton != NULL)
+    {
+        skeleton->update();
+        skeleton = (vsSkeleton *)characterSkeletons->getNextEntry();
+    }
+
+    // Update the character's skins to generate the new skin matrices
+    skin = (vsSkin *)characterSkins->getFirstEntry();
+    while (skin != NULL)
     {
-        // Delete the transition animation
-        vsObject::unrefDelete(transitionAnimation);
-        transitionAnimation = NULL;
+        skin->update();
+        skin = (vsSkin *)characterSkins->getNextEntry();
     }
+}
 
-    // Mark that we're not transitioning
-    transitioning = false;
+// ------------------------------------------------------------------------
+// Passes the current skin matrices of each of the character's skins to
+// the skin's GLSL program
+// ------------------------------------------------------------------------
+void vsCharacter::updateSkinPrograms()
+{
+    atMatrix skinMatrix;
+    vsSkin *skin;
+    vsGLSLProgramAttribute *prog;
+    vsGLSLUniform *matrixList;
+    int i;
+
+    // Iterate over the skins
+    skin = (vsSkin *)characterSkins->getFirstEntry();
+    while (skin != NULL)
+    {
+        // Get the skin program and matrix list
+        prog = getSkinProgram(skin);
+        if (prog != NULL)
+            matrixList = prog->getUniform("matrixList");
+        else
+            matrixList = NULL;
+
+        // Make sure we have a matrix list to update
+        if (matrixList != NULL)
+        {
+            // Update the shader's uniform parameters with the new skin
+            // poses 
+            for (i = 0; i < skin->getSkeleton()->getBoneCount(); i++)
+            {
+                // Don't bother updating the matrix for this bone if
+                // the skin doesn't use it
+                if (skin->usesBone(i))
+                {
+                    skinMatrix = skin->getSkinMatrix(i);
+                    matrixList->setEntry(i, skinMatrix);
+                }
+            }
+        }
+
+        // Next skin
+        skin = (vsSkin *)characterSkins->getNextEntry();
+    }
 }
 
 // --------------------------------------------------------------------------
@@ -739,8 +840,10 @@ vsCharacter *vsCharacter::clone()
     vsArray *newAnimations;
     vsPathMotionManager *animation;
     vsPathMotionManager *newAnimation;
-    int boneID;
-    int skelKinIndex;
+    vsCharacterKinPair *kinPairs;
+    int kinPairCount;
+    vsCharacterKinPair searchPair;
+    vsCharacterKinPair *foundPair;
     vsPathMotion *pathMotion;
     vsPathMotion *newPathMotion;
 
@@ -753,6 +856,20 @@ vsCharacter *vsCharacter::clone()
     newSkeletonList = new vsList();
     newSkelKinList = new vsList();
 
+    // Create a table to pair each of the original bone kinematics with its
+    // clone, so that the animations can be moved over to the new bones
+    // quickly (make room for every bone of every skeleton)
+    kinPairCount = 0;
+    skeleton = (vsSkeleton *)characterSkeletons->getFirstEntry();
+    while (skeleton != NULL)
+    {
+        kinPairCount += skeleton->getBoneCount();
+        skeleton = (vsSkeleton *)characterSkeletons->getNextEntry();
+    }
+    kinPairs = (vsCharacterKinPair *)
+        malloc(sizeof(vsCharacterKinPair) * (kinPairCount + 1));
+    kinPairCount = 0;
+
     // Iterate over the list of skeletons
     skeleton = (vsSkeleton *)characterSkeletons->getFirstEntry();
     skelKin = (vsSkeletonKinematics *)skeletonKinematics->getFirstEntry();
@@ -782,6 +899,11 @@ vsCharacter *vsCharacter::clone()
                 // created bone
                 newKin->setPosition(kin->getPosition());
                 newKin->setOrientation(kin->getOrientation());
+
+                // Remember which new kinematics goes with the original
+                kinPairs[kinPairCount].original = kin;
+                kinPairs[kinPairCount].clone = newKin;
+                kinPairCount++;
             }
         }
 
@@ -869,15 +991,21 @@ vsCharacter *vsCharacter::clone()
         }
     }
 
-    // Clone the array of animations
+    // Sort the kinematics pairs so we can search them quickly
+    qsort(kinPairs, kinPairCount, sizeof(vsCharacterKinPair),
+        compareKinPairs);
+
+    // Clone the array of animations.  The path motions of the cloned
+    // animations share their compiled tracks with the originals, so this
+    // only copies the per-instance playback state
     newAnimations = new vsArray();
     for (i = 0; i < characterAnimations->getNumEntries(); i++)
     {
-        // Get the i'th name
+        // Get the i'th animation
         animation = (vsPathMotionManager *)characterAnimations->getEntry(i);
 
-        // See if the name is valid
-        if (name != NULL)
+        // See if the animation is valid
+        if (animation != NULL)
         {
             // Clone the path motion manager, and add it to the new array in
             // the same position
@@ -891,49 +1019,28 @@ vsCharacter *vsCharacter::clone()
                 // Get the j'th path motion from the old animation
                 pathMotion = animation->getPathMotion(j);
 
-                // Get the kinematics from the old path motion
-                kin = pathMotion->getKinematics();
-
-                // Find the old skeleton kinematics and bone ID corresponding
-                // to this individual kinematics object
-                boneID = -1;
-                skelKinIndex = 0;
-                skelKin = (vsSkeletonKinematics *)
-                    skeletonKinematics->getFirstEntry();
-                while ((skelKin != NULL) && (boneID < 0))
-                {
-                    // Look for the kinematics in this skeleton kinematics
-                    // object
-                    boneID = skelKin->getBoneIDForKinematics(kin);
-
-                    // Try the next kinematics if we didn't find it
-                    if (boneID < 0)
-                    {
-                        skelKinIndex++;
-                        skelKin = (vsSkeletonKinematics *)
-                            skeletonKinematics->getNextEntry();
-                    }
-                }
+                // Look up the cloned kinematics corresponding to the
+                // kinematics of the old path motion
+                searchPair.original = pathMotion->getKinematics();
+                searchPair.clone = NULL;
+                foundPair = (vsCharacterKinPair *)bsearch(&searchPair,
+                    kinPairs, kinPairCount, sizeof(vsCharacterKinPair),
+                    compareKinPairs);
 
                 // Make sure we found it
-                if ((skelKin != NULL) && (boneID >= 0))
+                if (foundPair != NULL)
                 {
-                    // Get the j'th path motion from the new animation
+                    // Set the corresponding new kinematics on the j'th
+                    // path motion of the new animation
                     newPathMotion = newAnimation->getPathMotion(j);
-
-                    // Get the kinematics from the corresponding new
-                    // skeleton kinematics object and bone ID
-                    newSkelKin = (vsSkeletonKinematics *)
-                        newSkelKinList->getNthEntry(skelKinIndex);
-                    newKin = newSkelKin->getBoneKinematics(boneID);
-
-                    // Set the kinematics from the corresponding new skeleton
-                    // kinematics and bone ID on the new path motion
-                    newPathMotion->setKinematics(newKin);
+                    newPathMotion->setKinematics(foundPair->clone);
                 }
             }
         }
     }
+
+    // Done with the kinematics pairs
+    free(kinPairs);
     
     // Create a character using the skeletons, skins, kinematics, and
     // animations that we just finished creating.  The character takes
@@ -1287,25 +1394,13 @@ void vsCharacter::setCurrentAnimation(vsPathMotionManager *anim)
     if (!validFlag)
         return;
 
-    // Deactivate the previous animation
+    // Deactivate the previous animation (this also breaks out of any
+    // transition into it)
     if (currentAnimation != NULL)
-    {
-        // See whether we need to break out of a transition first
-        if (transitioning)
-        {
-            // Free the transition animation
-            vsObject::unrefDelete(transitionAnimation);
-            transitionAnimation = NULL;
+        currentAnimation->stop();
 
-            // We are no longer transitioning
-            transitioning = false;
-        }
-        else
-        {
-            // Simply halt the previous animation
-            currentAnimation->stop();
-        }
-    }
+    // We are no longer transitioning
+    transitioning = false;
 
     // Set the new animation
     currentAnimation = anim;
@@ -1515,9 +1610,9 @@ void vsCharacter::restartAnimation()
     // See whether we need to break out of a transition first
     if (transitioning)
     {
-        // Free the temporary transition animation
-        vsObject::unrefDelete(transitionAnimation);
-        transitionAnimation = NULL;
+        // Halt the animation we were transitioning into
+        if (currentAnimation != NULL)
+            currentAnimation->stop();
 
         // Set transitioning back to false
         transitioning = false;
@@ -1663,141 +1758,93 @@ void vsCharacter::update()
 // ------------------------------------------------------------------------
 void vsCharacter::update(double deltaTime)
 {
-    atMatrix skinMatrix;
-    vsSkeletonKinematics *kin;
-    vsSkeleton *skeleton;
     vsSkin *skin;
-    vsGLSLProgramAttribute *prog;
-    vsGLSLUniform *matrixList;
-    int i;
 
     // Make sure we have a character to update
     if (!validFlag)
         return;
 
-    // Update the animation state
-    if (currentAnimation != NULL)
+    // Update the animation and compute the new skin matrices
+    updatePose(deltaTime);
+
+    // Pass the skin matrices to the skin programs, or apply the skins in
+    // software
+    if (hardwareSkinning)
+        updateSkinPrograms();
+    else
     {
-        // See if we're currently transitioning between animations
-        if (transitioning)
+        skin = (vsSkin *)characterSkins->getFirstEntry();
+        while (skin != NULL)
         {
-            // Update the transition animation (the current animation is
-            // the transition animation in this case)
-            currentAnimation->update(deltaTime);
-
-            // If the transition is complete, finish it up and move on to
-            // the next animation
-            if (currentAnimation->isDone())
-                finishTransition();
+            skin->applySkin();
+            skin = (vsSkin *)characterSkins->getNextEntry();
         }
+    }
+}
 
-        // If we're not transitioning (or not _still_ transitioning)
-        // update the current animation.  In the case where we just completed
-        // a transition, we allow this double-update to "prime" the new
-        // animation
-        if (!transitioning)
-        {
-            // Update the current animation
-            currentAnimation->update(deltaTime);
+// ------------------------------------------------------------------------
+// Static function
+// Updates a whole crowd of characters using the given deltaTime.  Each
+// character's animation, skeletons, and skin matrices only depend on the
+// character itself, so these are computed for many characters at once
+// on the default thread pool.  The skin program uniforms are then updated
+// on the calling thread, and all of the software skins are applied
+// together in a single batch.  This gives the same results as calling
+// update() on each character in turn.
+// ------------------------------------------------------------------------
+void vsCharacter::updateCharacters(vsArray *characters, double deltaTime)
+{
+    vsCharacterBatch batch;
+    vsCharacter *character;
+    vsArray softwareSkins;
+    vsSkin *skin;
+    int i;
 
-            // See if we need to switch animations
-            if (currentAnimation->isDone())
-            {
-                // See if a one time-animation is playing
-                if (oneTimeStarted)
-                {
-                    // We're done with this one-time animation, so
-                    // clean up the state
-                    oneTimeAnimation = NULL;
-                    oneTimeStarted = false;
+    // Nothing to do without a list of characters
+    if (characters == NULL)
+        return;
 
-                    // See if this is a final animation
-                    if (finalStarted)
-                    {
-                        // No more animations will be applied, set the
-                        // current animation to NULL to avoid unnecessary
-                        // checks on the next update
-                        currentAnimation = NULL;
-                    }
-                    else
-                    {
-                        // We need to transition back to another animation
-                        if (loopStarted)
-                        {
-                            // There is a looping animation defined,
-                            // transition back to that
-                            transitionToAnimation(loopingAnimation,
-                                                  oneTimeTransOutTime);
-                        }
-                        else
-                        {
-                            // Transition back to the default animation
-                            transitionToAnimation(defaultAnimation,
-                                                  oneTimeTransOutTime);
-                        }
-                    }
-                }
-            }
+    // Collect the valid characters into a batch
+    batch.characters = (vsCharacter **)
+        malloc(sizeof(vsCharacter *) * (characters->getNumEntries() + 1));
+    batch.characterCount = 0;
+    batch.deltaTime = deltaTime;
+    for (i = 0; i < characters->getNumEntries(); i++)
+    {
+        character = (vsCharacter *)characters->getEntry(i);
+        if ((character != NULL) && (character->isValid()))
+        {
+            batch.characters[batch.characterCount] = character;
+            batch.characterCount++;
         }
     }
 
-    // Update all kinematics and skeletons with the time value
-    kin = (vsSkeletonKinematics *)skeletonKinematics->getFirstEntry();
-    while (kin != NULL)
-    {
-        kin->update(deltaTime);
-        kin = (vsSkeletonKinematics *)skeletonKinematics->getNextEntry();
-    }
-    skeleton = (vsSkeleton *)characterSkeletons->getFirstEntry();
-    while (skeleton != NULL)
-    {
-        skeleton->update();
-        skeleton = (vsSkeleton *)characterSkeletons->getNextEntry();
-    }
+    // Update the poses of all of the characters in parallel
+    vsThreadPool::getDefaultPool()->parallelFor(batch.characterCount,
+        VS_CHAR_BATCH_GRAIN, characterBatchTaskFunc, &batch);
 
-    // Update the character's skins to generate the new skin matrices
-    skin = (vsSkin *)characterSkins->getFirstEntry();
-    while (skin != NULL)
+    // Now, update the skin programs of the hardware-skinned characters, and
+    // gather up the skins of the others
+    for (i = 0; i < batch.characterCount; i++)
     {
-        // Update the skin to generate the final skinning matrices
-        skin->update();
-
-        // See if we're doing skinning on the CPU, or if we're letting the
-        // GPU take care of it
-        if (hardwareSkinning)
+        character = batch.characters[i];
+        if (character->hardwareSkinning)
+            character->updateSkinPrograms();
+        else
         {
-            // Get the skin program and matrix list
-            prog = getSkinProgram(skin);
-            if (prog != NULL)
-                matrixList = prog->getUniform("matrixList");
-            else
-                matrixList = NULL;
-
-            // Make sure we have a matrix list to update
-            if (matrixList != NULL)
+            skin = (vsSkin *)character->characterSkins->getFirstEntry();
+            while (skin != NULL)
             {
-                // Update the shader's uniform parameters with the new skin
-                // poses 
-                for (i = 0; i < skin->getSkeleton()->getBoneCount(); i++)
-                {
-                    // Don't bother updating the matrix for this bone if
-                    // the skin doesn't use it
-                    if (skin->usesBone(i))
-                    {
-                        skinMatrix = skin->getSkinMatrix(i);
-                        matrixList->setEntry(i, skinMatrix);
-                    }
-                }
+                softwareSkins.addEntry(skin);
+                skin = (vsSkin *)character->characterSkins->getNextEntry();
             }
         }
-        else
-        {
-            // Apply the skin in software to the mesh geometries
-            skin->applySkin();
-        }
-
-        // Next skin
-        skin = (vsSkin *)characterSkins->getNextEntry();
     }
-}
 
+    // Apply all of the software skins at once
+    vsSkin::applySkins(&softwareSkins);
+
+    // Clean up
+    softwareSkins.removeAllEntries();
+    free(batch.characters);
+}
@@ -43,6 +43,10 @@
 
 #define VS_CHAR_MAX_BONES 36
 
+// Number of characters updated by each thread pool task in
+// updateCharacters()
+#define VS_CHAR_BATCH_GRAIN 4
+
 class VESS_SYM vsCharacter : public vsUpdatable
 {
 protected:
@@ -68,7 +72,6 @@ protected:
     bool                       finalStarted;
 
     bool                       transitioning;
-    vsPathMotionManager        *transitionAnimation;
 
     vsList                     *skinProgramList;
 
@@ -81,6 +84,12 @@ protected:
                                                   double transitionTime);
     void                    finishTransition();
 
+    void                    updatePose(double deltaTime);
+    void                    updateSkinPrograms();
+
+    static void             characterBatchTaskFunc(void *userData, int first,
+                                                   int last);
+
 public:
 
                               vsCharacter(vsSkeleton *skeleton,
@@ -144,6 +153,9 @@ public:
 
     virtual void              update();
     virtual void              update(double deltaTime);
+
+    static void               updateCharacters(vsArray *characters,
+                                               double deltaTime);
 };
 
 
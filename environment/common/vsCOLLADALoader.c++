@@ -18,6 +18,12 @@ vsCOLLADALoader::vsCOLLADALoader()
 
     // We haven't parsed a document yet
     mainDocument = NULL;
+
+    // Scene caching is off by default
+    sceneCacheEnabled = false;
+    sceneCacheValidation = VS_SCENE_CACHE_VALIDATE_TIMESTAMP;
+    cachedScene = NULL;
+    cachedCharacter = NULL;
 }
 
 // ------------------------------------------------------------------------
@@ -31,6 +37,9 @@ vsCOLLADALoader::~vsCOLLADALoader()
 
     // Delete the main document
     vsObject::unrefDelete(mainDocument);
+
+    // Delete any scene read from the scene cache
+    clearCachedScene();
 }
 
 // ------------------------------------------------------------------------
@@ -107,6 +116,428 @@ atString vsCOLLADALoader::findFile(const char *filename)
     return findFile(baseFile);
 }
 
+// ------------------------------------------------------------------------
+// Deletes the scene and character read from the scene cache (if any)
+// ------------------------------------------------------------------------
+void vsCOLLADALoader::clearCachedScene()
+{
+    // Delete the scene
+    if (cachedScene != NULL)
+    {
+        cachedScene->deleteTree();
+        vsObject::unrefDelete(cachedScene);
+        cachedScene = NULL;
+    }
+
+    // Delete the character
+    if (cachedCharacter != NULL)
+    {
+        vsObject::unrefDelete(cachedCharacter);
+        cachedCharacter = NULL;
+    }
+}
+
+// ------------------------------------------------------------------------
+// Tries to read the scene and character for the given source file from
+// its scene cache.  Returns false if there is no up-to-date cache, in
+// which case the file must be parsed instead.
+// ------------------------------------------------------------------------
+bool vsCOLLADALoader::readSceneCache(const char *sourceFile)
+{
+    vsSceneCache *cache;
+    atString cacheFile;
+    vsNode *scene;
+    vsCharacter *character;
+    bool valid;
+
+    // Open the cache (it may not exist yet, or may be out of date)
+    cache = new vsSceneCache();
+    cache->ref();
+    cacheFile = vsSceneCache::getCacheFilename(sourceFile);
+    if (!cache->beginRead(cacheFile.getString(), sourceFile,
+        sceneCacheValidation, 0))
+    {
+        vsObject::unrefDelete(cache);
+        return false;
+    }
+
+    // Read the scene, and keep it around past the end of the read
+    scene = cache->readNode();
+    if (scene != NULL)
+        scene->ref();
+
+    // Read the character (if there is one), and keep it as well
+    character = NULL;
+    if (cache->readInt())
+    {
+        character = readCharacter(cache);
+        if (character != NULL)
+            character->ref();
+    }
+
+    // Finish up with the cache
+    valid = cache->finishRead();
+    vsObject::unrefDelete(cache);
+
+    // The scene must be a component (it's always the root of a scene
+    // created from a document)
+    if ((scene != NULL) && (scene->getNodeType() != VS_NODE_TYPE_COMPONENT))
+        valid = false;
+
+    // Throw everything away if the cache couldn't be read properly
+    if (!valid)
+    {
+        if (scene != NULL)
+        {
+            scene->deleteTree();
+            vsObject::unrefDelete(scene);
+        }
+        if (character != NULL)
+            vsObject::unrefDelete(character);
+
+        return false;
+    }
+
+    // Keep the scene and character
+    cachedScene = (vsComponent *)scene;
+    cachedCharacter = character;
+
+    // Pose the character, as is done when it's first created
+    if (cachedCharacter != NULL)
+        cachedCharacter->update();
+
+    return true;
+}
+
+// ------------------------------------------------------------------------
+// Stores the scene and character from the main document in the scene
+// cache for the given source file.  If there's anything in them that the
+// cache can't handle, the cache isn't written, and the file will just be
+// parsed again the next time it's loaded.
+// ------------------------------------------------------------------------
+void vsCOLLADALoader::writeSceneCache(const char *sourceFile)
+{
+    vsSceneCache *cache;
+    atString cacheFile;
+    vsComponent *scene;
+    vsCharacter *character;
+    bool complete;
+
+    // Get copies of the document's scene and character
+    scene = mainDocument->getScene();
+    if (scene != NULL)
+        scene->ref();
+    character = mainDocument->getCharacter();
+    if (character != NULL)
+        character->ref();
+
+    // Write the scene and character to the cache
+    cache = new vsSceneCache();
+    cache->ref();
+    cacheFile = vsSceneCache::getCacheFilename(sourceFile);
+    if (cache->beginWrite(cacheFile.getString(), sourceFile,
+        sceneCacheValidation, 0))
+    {
+        // Write the scene, followed by the character (if any)
+        cache->writeNode(scene);
+        cache->writeInt(character != NULL);
+        complete = true;
+        if (character != NULL)
+            complete = writeCharacter(cache, character);
+
+        // Only write the cache file if everything was stored (otherwise
+        // the unfinished cache is discarded along with the cache object)
+        if (complete)
+            cache->finishWrite();
+    }
+    vsObject::unrefDelete(cache);
+
+    // Get rid of the copies
+    if (scene != NULL)
+    {
+        scene->deleteTree();
+        vsObject::unrefDelete(scene);
+    }
+    if (character != NULL)
+        vsObject::unrefDelete(character);
+}
+
+// ------------------------------------------------------------------------
+// Stores the given character's skeletons, skins and animations in the
+// scene cache.  The animation paths are stored as their compiled tracks,
+// along with the skeleton and bone that each one drives.  Returns false
+// if the character can't be stored.
+// ------------------------------------------------------------------------
+bool vsCOLLADALoader::writeCharacter(vsSceneCache *cache,
+                                     vsCharacter *character)
+{
+    vsPathMotionManager *animation;
+    vsPathMotion *path;
+    vsKinematics *kin;
+    int skelIndex, boneID;
+    vsPathMotionTrack *track;
+    vsPathMotionKey *key;
+    double orientation[4];
+    int i, j, k;
+
+    // Each skeleton must have a matching skeleton kinematics
+    if (character->getNumSkeletonKinematics() !=
+        character->getNumSkeletons())
+    {
+        printf("vsCOLLADALoader::writeCharacter:  Character's skeleton "
+            "kinematics don't match its skeletons\n");
+        return false;
+    }
+
+    // Write the skeletons
+    cache->writeInt(character->getNumSkeletons());
+    for (i = 0; i < character->getNumSkeletons(); i++)
+        cache->writeSkeleton(character->getSkeleton(i));
+
+    // Write the skins (their skeletons are already in the cache, so they
+    // will just refer to them)
+    cache->writeInt(character->getNumSkins());
+    for (i = 0; i < character->getNumSkins(); i++)
+        cache->writeSkin(character->getSkin(i));
+
+    // Write the animations
+    cache->writeInt(character->getNumAnimations());
+    for (i = 0; i < character->getNumAnimations(); i++)
+    {
+        // Write the animation's name and settings
+        animation = character->getAnimation(i);
+        cache->writeString(character->getAnimationName(i).getString());
+        cache->writeInt(animation->getCycleMode());
+        cache->writeInt(animation->getCycleCount());
+
+        // Write each of the animation's paths
+        cache->writeInt(animation->getPathMotionCount());
+        for (j = 0; j < animation->getPathMotionCount(); j++)
+        {
+            path = animation->getPathMotion(j);
+
+            // Find the skeleton and bone that the path drives
+            kin = path->getKinematics();
+            skelIndex = 0;
+            boneID = -1;
+            while ((boneID < 0) &&
+                (skelIndex < character->getNumSkeletonKinematics()))
+            {
+                boneID = character->getSkeletonKinematics(skelIndex)->
+                    getBoneIDForKinematics(kin);
+                if (boneID < 0)
+                    skelIndex++;
+            }
+
+            // We can't store paths that drive something else
+            if (boneID < 0)
+            {
+                printf("vsCOLLADALoader::writeCharacter:  Animation path "
+                    "doesn't drive one of the character's bones\n");
+                return false;
+            }
+            cache->writeInt(skelIndex);
+            cache->writeInt(boneID);
+
+            // Write the path's settings
+            cache->writeInt(path->getPositionMode());
+            cache->writeInt(path->getOrientationMode());
+            cache->writeInt(path->getCycleMode());
+            cache->writeInt(path->getCycleCount());
+            cache->writeDouble(path->getCornerRadius());
+            cache->writeVector(path->getLookAtPoint());
+            cache->writeVector(path->getUpDirection());
+
+            // Write the path's key points
+            track = path->getTrack();
+            cache->writeInt(track->getKeyCount());
+            for (k = 0; k < track->getKeyCount(); k++)
+            {
+                key = track->getKey(k);
+                cache->writeVector(key->position);
+                orientation[0] = key->orientation[AT_X];
+                orientation[1] = key->orientation[AT_Y];
+                orientation[2] = key->orientation[AT_Z];
+                orientation[3] = key->orientation[AT_W];
+                cache->writeDoubles(orientation, 4);
+                cache->writeDouble(key->travelTime);
+                cache->writeDouble(key->pauseTime);
+            }
+        }
+    }
+
+    return cache->isValid();
+}
+
+// ------------------------------------------------------------------------
+// Reads a character written by writeCharacter() from the scene cache.
+// Returns NULL if the character can't be read.
+// ------------------------------------------------------------------------
+vsCharacter *vsCOLLADALoader::readCharacter(vsSceneCache *cache)
+{
+    vsList *skeletonList;
+    vsList *skelKinList;
+    vsList *skinList;
+    atArray *animationNames;
+    vsArray *animations;
+    vsSkeleton *skeleton;
+    vsSkin *skin;
+    vsPathMotionManager *animation;
+    vsPathMotion *path;
+    vsSkeletonKinematics *skelKin;
+    vsKinematics *kin;
+    vsPathMotionKey *keys;
+    atString name;
+    double orientation[4];
+    int count, pathCount, keyCount;
+    int skelIndex, boneID;
+    bool valid;
+    int i, j, k;
+
+    // Create the lists for the character's parts
+    skeletonList = new vsList();
+    skelKinList = new vsList();
+    skinList = new vsList();
+    animationNames = new atArray();
+    animations = new vsArray();
+
+    // Read the skeletons, and create a kinematics for each one
+    valid = true;
+    count = cache->readInt();
+    for (i = 0; (i < count) && (valid); i++)
+    {
+        skeleton = cache->readSkeleton();
+        if (skeleton != NULL)
+        {
+            skeletonList->addEntry(skeleton);
+            skelKinList->addEntry(new vsSkeletonKinematics(skeleton));
+        }
+        else
+            valid = false;
+    }
+
+    // Read the skins
+    count = cache->readInt();
+    for (i = 0; (i < count) && (valid); i++)
+    {
+        skin = cache->readSkin();
+        if (skin != NULL)
+            skinList->addEntry(skin);
+        else
+            valid = false;
+    }
+
+    // Read the animations
+    count = cache->readInt();
+    for (i = 0; (i < count) && (valid) && (cache->isValid()); i++)
+    {
+        // Create the animation, and add it to the arrays
+        name = cache->readString();
+        animation = new vsPathMotionManager();
+        animation->setCycleMode(cache->readInt());
+        animation->setCycleCount(cache->readInt());
+        animations->addEntry(animation);
+        animationNames->addEntry(new atString(name));
+
+        // Read the animation's paths
+        pathCount = cache->readInt();
+        for (j = 0; (j < pathCount) && (valid) && (cache->isValid()); j++)
+        {
+            // Find the bone kinematics that the path drives
+            skelIndex = cache->readInt();
+            boneID = cache->readInt();
+            kin = NULL;
+            if ((skelIndex >= 0) &&
+                (skelIndex < (int)skelKinList->getNumEntries()))
+            {
+                skelKin = (vsSkeletonKinematics *)
+                    skelKinList->getNthEntry(skelIndex);
+                kin = skelKin->getBoneKinematics(boneID);
+            }
+            if (kin == NULL)
+            {
+                valid = false;
+                break;
+            }
+
+            // Create the path, and read its settings
+            path = new vsPathMotion(kin);
+            path->setPositionMode(cache->readInt());
+            path->setOrientationMode(cache->readInt());
+            path->setCycleMode(cache->readInt());
+            path->setCycleCount(cache->readInt());
+            path->setCornerRadius(cache->readDouble());
+            path->setLookAtPoint(cache->readVector());
+            path->setUpDirection(cache->readVector());
+
+            // Read the key points, and give them to the path as a track
+            keyCount = cache->readInt();
+            if (keyCount > 0)
+            {
+                keys = new vsPathMotionKey[keyCount];
+                for (k = 0; k < keyCount; k++)
+                {
+                    keys[k].position = cache->readVector();
+                    cache->readDoubles(orientation, 4);
+                    keys[k].orientation.set(orientation[0], orientation[1],
+                        orientation[2], orientation[3]);
+                    keys[k].travelTime = cache->readDouble();
+                    keys[k].pauseTime = cache->readDouble();
+                }
+                path->setTrack(new vsPathMotionTrack(keys, keyCount));
+                delete [] keys;
+            }
+
+            // Add the path to the animation
+            animation->addPathMotion(path);
+        }
+    }
+
+    // Clean up if anything went wrong
+    if ((!valid) || (!cache->isValid()))
+    {
+        delete skeletonList;
+        delete skelKinList;
+        delete skinList;
+        delete animationNames;
+        delete animations;
+        return NULL;
+    }
+
+    // Create the character (it takes ownership of the lists)
+    return new vsCharacter(skeletonList, skelKinList, skinList,
+        animationNames, animations);
+}
+
+// ------------------------------------------------------------------------
+// Enables the scene cache.  When a file is parsed, the resulting scene
+// and character are stored in a cache file next to it, and later parses
+// of the same file read the cache instead, as long as the file hasn't
+// changed.  The validation mode determines whether the file's time stamp
+// or a hash of its contents is used to tell if it has changed.
+// ------------------------------------------------------------------------
+void vsCOLLADALoader::enableSceneCache(int validation)
+{
+    sceneCacheEnabled = true;
+    sceneCacheValidation = validation;
+}
+
+// ------------------------------------------------------------------------
+// Disables the scene cache
+// ------------------------------------------------------------------------
+void vsCOLLADALoader::disableSceneCache()
+{
+    sceneCacheEnabled = false;
+}
+
+// ------------------------------------------------------------------------
+// Returns whether or not the scene cache is enabled
+// ------------------------------------------------------------------------
+bool vsCOLLADALoader::isSceneCacheEnabled()
+{
+    return sceneCacheEnabled;
+}
+
 // ------------------------------------------------------------------------
 // Adds a path to search when looking for the file to parse
 // ------------------------------------------------------------------------
@@ -152,6 +583,9 @@ void vsCOLLADALoader::parseFile(const char *filename)
        mainDocument = NULL;
     }
 
+    // Also delete any scene we read from the scene cache
+    clearCachedScene();
+
     // Find the full path to the requested file
     path = findFile(filename);
 
@@ -189,6 +623,11 @@ void vsCOLLADALoader::parseFile(const char *filename)
         addPath(documentPath.getString());
     }
 
+    // If the scene cache is enabled, try to read the scene from the cache
+    // before going to the trouble of parsing the file
+    if ((sceneCacheEnabled) && (readSceneCache(path.getString())))
+        return;
+
     // Create an XML reader for the given file
     reader = new atXMLReader(path.getString());
 
@@ -211,6 +650,10 @@ void vsCOLLADALoader::parseFile(const char *filename)
         // Create a COLLADA document from the XML document
         mainDocument = new vsCOLLADADocument(doc, pathList);
         mainDocument->ref();
+
+        // Store the new scene in the scene cache, if it's enabled
+        if (sceneCacheEnabled)
+            writeSceneCache(path.getString());
     }
 
     // We're done with the XML reader and document now
@@ -225,9 +668,12 @@ void vsCOLLADALoader::parseFile(const char *filename)
 // ------------------------------------------------------------------------
 vsComponent *vsCOLLADALoader::getScene()
 {
-    // Return the scene created in the main document
+    // Return the scene created in the main document, or a copy of the
+    // scene read from the scene cache
     if (mainDocument != NULL)
         return (vsComponent *)mainDocument->getScene();
+    else if (cachedScene != NULL)
+        return (vsComponent *)cachedScene->cloneTree();
     else
         return NULL;
 }
@@ -238,9 +684,12 @@ vsComponent *vsCOLLADALoader::getScene()
 // ------------------------------------------------------------------------
 vsCharacter *vsCOLLADALoader::getCharacter()
 {
-    // Return a clone of the main document's character (if we found one)
+    // Return a clone of the main document's character (if we found one),
+    // or of the character read from the scene cache
     if (mainDocument != NULL)
         return mainDocument->getCharacter();
+    else if (cachedCharacter != NULL)
+        return cachedCharacter->clone();
     else
         return NULL;
 }
@@ -13,6 +13,7 @@
 #include "vsList.h++"
 #include "vsCharacter.h++"
 #include "vsCOLLADADocument.h++"
+#include "vsSceneCache.h++"
 
 class VESS_SYM vsCOLLADALoader : public vsObject
 {
@@ -24,8 +25,20 @@ protected:
 
     vsCOLLADADocument   *mainDocument;
 
+    bool                sceneCacheEnabled;
+    int                 sceneCacheValidation;
+    vsComponent         *cachedScene;
+    vsCharacter         *cachedCharacter;
+
     atString               findFile(const char *filename);
 
+    void                   clearCachedScene();
+    bool                   readSceneCache(const char *sourceFile);
+    void                   writeSceneCache(const char *sourceFile);
+    bool                   writeCharacter(vsSceneCache *cache,
+                                          vsCharacter *character);
+    vsCharacter            *readCharacter(vsSceneCache *cache);
+
 
 public:
 
@@ -37,6 +50,10 @@ public:
     void                  addPath(const char *path);
     void                  clearPath();
 
+    void                  enableSceneCache(int validation);
+    void                  disableSceneCache();
+    bool                  isSceneCacheEnabled();
+
     void                  parseFile(const char *filename);
 
     vsComponent           *getScene();
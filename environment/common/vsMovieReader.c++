@@ -88,11 +88,12 @@ vsMovieReader::vsMovieReader()
     videoFrame = av_frame_alloc();
     audioFrame = av_frame_alloc();
 
-    // Allocate an AVPicture structure to hold the RGB converted frame.
-    // We can't actually allocate the pixel buffers yet, because we don't
-    // know the size of the image
+    // Allocate an AVPicture structure to describe the RGB converted frame.
+    // The pixels themselves live in the slots of the frame queue, which
+    // can't be created until we know the size of the image
     rgbFrame = (AVPicture *)malloc(sizeof(AVPicture));
-    memset(rgbFrame, 0, sizeof(rgbFrame));
+    memset(rgbFrame, 0, sizeof(AVPicture));
+    frameQueue = NULL;
 
     // Create the file and queue mutex objects
     pthread_mutex_init(&fileMutex, NULL);
@@ -137,6 +138,11 @@ vsMovieReader::~vsMovieReader()
     // Free the current frame structures
     av_free(videoFrame);
     av_free(audioFrame);
+    free(rgbFrame);
+
+    // Release the decoded frame queue
+    if (frameQueue != NULL)
+        vsObject::unrefDelete(frameQueue);
 }
 
 // ------------------------------------------------------------------------
@@ -251,11 +257,16 @@ bool vsMovieReader::openFile(char *filename)
                 imageWidth = videoCodecContext->width;
                 imageHeight = videoCodecContext->height;
 
-                // Now that we know the width and height of the image, 
-                // allocate the pixel buffer for the rgbFrame structure.  
-                // We're allocating a single plane for RGB triplets (the same 
-                // format that OpenGL textures like).
-                rgbFrame->data[0] = (uint8_t *)malloc(getDataSize());
+                // Now that we know the width and height of the image,
+                // create the queue of frame slots that the decoded images
+                // are converted into.  Each slot is a single plane of RGB
+                // triplets (the same format that OpenGL textures like).
+                // The rgbFrame structure is pointed at a slot each time a
+                // frame is decoded.
+                frameQueue = new vsVideoQueue(imageWidth, imageHeight,
+                    VS_MOVIE_FRAME_QUEUE_SIZE);
+                frameQueue->ref();
+                rgbFrame->data[0] = NULL;
                 rgbFrame->data[1] = NULL;
                 rgbFrame->data[2] = NULL;
                 rgbFrame->data[3] = NULL;
@@ -493,12 +504,14 @@ void vsMovieReader::closeFile()
     // Empty the audio buffer
     audioBufferSize = 0;
 
-    // Deallocate the pixel buffers for the rgbFrame structure
-    if (rgbFrame->data[0] != NULL)
+    // Release the frame queue that held the decoded images (consumers that
+    // still reference it keep it alive until they're done with it)
+    if (frameQueue != NULL)
     {
-        free(rgbFrame->data[0]);
-        rgbFrame->data[0] = NULL;
+        vsObject::unrefDelete(frameQueue);
+        frameQueue = NULL;
     }
+    rgbFrame->data[0] = NULL;
     rgbFrame->linesize[0] = 0;
 
     // Reset the image parameters
@@ -676,6 +689,19 @@ unsigned char *vsMovieReader::getVideoBuffer()
     return outputBuffer;
 }
 
+// ------------------------------------------------------------------------
+// Gets the queue that the decoded video frames are placed in, or NULL if
+// no movie with video is open.  Consumers can lease frames from this
+// queue (see vsVideoQueue) and read the images in place, instead of
+// having each frame copied into a video buffer.  The queue is replaced
+// when a new file is opened, so a consumer holding onto it should ref()
+// it, and release any leased frames before unref'ing it.
+// ------------------------------------------------------------------------
+vsVideoQueue *vsMovieReader::getVideoQueue()
+{
+    return frameQueue;
+}
+
 // ------------------------------------------------------------------------
 // Gets the vsSoundStream that is carrying the movie's audio data
 // ------------------------------------------------------------------------
@@ -1019,6 +1045,7 @@ bool vsMovieReader::decodeVideo()
     AVPacket moviePacket;
     int64_t ts;
     double timeStamp;
+    unsigned char *frameBuffer;
 
     // Try to dequeue a packet from the file
     if (dequeuePacket(videoQueue, &moviePacket))
@@ -1030,10 +1057,19 @@ bool vsMovieReader::decodeVideo()
         // If the video codec gave us a full picture, output it now
         if ((readSize >= 0) && (gotPicture))
         {
-            // Specify that we want the output in 3-bytes-per-pixel RGB
-            // format
-            sws_scale(scaleContext, videoFrame->data, videoFrame->linesize,
-                0, imageHeight, rgbFrame->data, rgbFrame->linesize);
+            // Claim a slot in the frame queue to convert the picture into.
+            // If the consumers are leasing every slot, the picture is
+            // dropped (the clock still moves forward below)
+            frameBuffer = frameQueue->acquireWriteFrame();
+            if (frameBuffer != NULL)
+            {
+                // Specify that we want the output in 3-bytes-per-pixel RGB
+                // format, written straight into the slot
+                rgbFrame->data[0] = frameBuffer;
+                sws_scale(scaleContext, videoFrame->data,
+                    videoFrame->linesize, 0, imageHeight, rgbFrame->data,
+                    rgbFrame->linesize);
+            }
 
             // Fetch the frame's timestamp
             ts = av_frame_get_best_effort_timestamp(videoFrame);
@@ -1048,6 +1084,10 @@ bool vsMovieReader::decodeVideo()
                 timeStamp = ts * av_q2d(videoStream->time_base);
                 lastFrameInterval = timeStamp - videoClock;
             }
+
+            // Publish the converted frame to the queue's consumers
+            if (frameBuffer != NULL)
+                frameQueue->commitWriteFrame(timeStamp);
         }
         else
         {
@@ -1249,21 +1289,28 @@ void vsMovieReader::readNextFrame()
 
 // ------------------------------------------------------------------------
 // Private function
-// Copies the data in the video decoder's internal buffer to the image data
-// area specified for this reader object
+// Copies the newest decoded frame to the image data area specified for
+// this reader object
 // ------------------------------------------------------------------------
 void vsMovieReader::copyFrame()
 {
+    vsVideoFrame *frame;
+
     // If we're not PLAYING, then there's nothing to copy
     if ((playMode != VS_MOVIE_PLAYING) && (playMode != VS_MOVIE_EOF))
         return;
 
-    // Only copy the data if there is a place to copy it to
-    if (outputBuffer)
+    // Only copy the data if there is a place to copy it to (consumers of
+    // the frame queue read the frames in place, and don't need this copy)
+    if ((outputBuffer) && (frameQueue))
     {
         // Copy the data, if it exists
-        if (rgbFrame->data[0] != NULL)
-            memcpy(outputBuffer, rgbFrame->data[0], getDataSize());
+        frame = frameQueue->leaseLatestFrame();
+        if (frame != NULL)
+        {
+            memcpy(outputBuffer, frame->data, getDataSize());
+            frameQueue->releaseFrame(frame);
+        }
     }
 }
 
@@ -1491,6 +1538,9 @@ void *vsMovieReader::fileThreadFunc(void *readerObject)
 void *vsMovieReader::audioThreadFunc(void *readerObject)
 {
     vsMovieReader *instance;
+    void *chunks[VS_SS_BUFFER_COUNT];
+    int chunkCount, usedCount;
+    int i;
 
     // Get the instance of the reader object from the parameter
     instance = (vsMovieReader *)readerObject;
@@ -1503,25 +1553,39 @@ void *vsMovieReader::audioThreadFunc(void *readerObject)
         if ((instance->playMode == VS_MOVIE_PLAYING) ||
             (instance->playMode == VS_MOVIE_EOF))
         {
-            // Lock the audio mutex (the loop below will only execute a
-            // maximum of two times, so it should be OK to lock here)
+            // Lock the audio mutex (we'll only queue a couple of chunks
+            // of data, so it should be OK to lock here)
             pthread_mutex_lock(&instance->audioMutex);
 
             // Check if it's time to update the audio stream
-            while ((instance->soundStream != NULL) && 
-                   (instance->soundStream->isBufferReady()) && 
-                   (instance->audioBufferSize >= instance->streamBufferSize))
+            if ((instance->soundStream != NULL) && 
+                (instance->soundStream->isBufferReady()) && 
+                (instance->audioBufferSize >= instance->streamBufferSize))
             {
-                // Copy the data from the local audio buffer to the sound 
-                // stream
-                instance->soundStream->queueBuffer(instance->audioBuffer);
-
-                // Slide the data in the local buffer down and update the
-                // buffer size
+                // Gather as many full chunks of data from the local audio
+                // buffer as the stream could possibly take
+                chunkCount = instance->audioBufferSize /
+                    instance->streamBufferSize;
+                if (chunkCount > VS_SS_BUFFER_COUNT)
+                    chunkCount = VS_SS_BUFFER_COUNT;
+                for (i = 0; i < chunkCount; i++)
+                    chunks[i] = &instance->audioBuffer[
+                        i * instance->streamBufferSize];
+
+                // Copy the chunks to the sound stream's empty buffers and
+                // queue them together
+                usedCount = instance->soundStream->queueBuffers(chunks,
+                    chunkCount);
+
+                // Slide the remaining data in the local buffer down and
+                // update the buffer size
                 memmove(instance->audioBuffer, 
-                    &instance->audioBuffer[instance->streamBufferSize], 
-                    instance->audioBufferSize - instance->streamBufferSize);
-                instance->audioBufferSize -= instance->streamBufferSize;
+                    &instance->audioBuffer[
+                        usedCount * instance->streamBufferSize], 
+                    instance->audioBufferSize -
+                        usedCount * instance->streamBufferSize);
+                instance->audioBufferSize -=
+                    usedCount * instance->streamBufferSize;
             }
 
             // Unlock the audio mutex
@@ -27,6 +27,7 @@
 #include "vsObject.h++"
 #include "vsSoundStream.h++"
 #include "vsTimer.h++"
+#include "vsVideoQueue.h++"
 #include <stdio.h>
 #include <pthread.h>
 
@@ -38,6 +39,7 @@ extern "C"
 }
 
 #define VS_MOVIE_PACKET_QUEUE_SIZE         8
+#define VS_MOVIE_FRAME_QUEUE_SIZE          3
 #define VS_MOVIE_AUDIO_STREAM_BUFFER_SIZE  8192
 
 // 8 seconds of 48kHz 16-bit audio
@@ -75,6 +77,7 @@ private:
     int                   videoStreamIndex;
     AVFrame               *videoFrame;
     AVPicture             *rgbFrame;
+    vsVideoQueue          *frameQueue;
 
     AVCodecContext        *audioCodecContext;
     AVStream              *audioStream;
@@ -147,6 +150,8 @@ public:
     void             setVideoBuffer(unsigned char *dataOutputBuffer);
     unsigned char    *getVideoBuffer();
 
+    vsVideoQueue     *getVideoQueue();
+
     vsSoundStream    *getSoundStream();
 
     void             advanceFrame();
@@ -0,0 +1,455 @@
+//------------------------------------------------------------------------
+//
+//    VIRTUAL ENVIRONMENT SOFTWARE SANDBOX (VESS)
+//
+//    Copyright (c) 2001, University of Central Florida
+//
+//       See the file LICENSE for license information
+//
+//    E-mail:  vess@ist.ucf.edu
+//    WWW:     http://vess.ist.ucf.edu/
+//
+//------------------------------------------------------------------------
+//
+//    VESS Module:  intersectBenchmark.c++
+//
+//    Description:  Benchmark for segment and sphere intersection against
+//                  a large synthetic terrain.  Segment queries are timed
+//                  with OSG's own line segment intersector (what
+//                  vsIntersect used before the triangle hierarchy) and
+//                  with vsIntersect, one intersector at a time and as a
+//                  threaded batch.  Sphere queries are timed against a
+//                  brute-force test of every triangle (what
+//                  vsSphereIntersect did before) and with
+//                  vsSphereIntersect.  The results of each pair are
+//                  checked against each other.
+//
+//    Usage:        intersectBenchmark [gridSize [queryCount]]
+//
+//    Author(s):    agent
+//
+//------------------------------------------------------------------------
+
+#include "vsComponent.h++"
+#include "vsGeometry.h++"
+#include "vsIntersect.h++"
+#include "vsSphereIntersect.h++"
+#include "vsThreadPool.h++"
+#include "vsTimer.h++"
+#include <osgUtil/LineSegmentIntersector>
+#include <osgUtil/IntersectionVisitor>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+// Spacing between terrain grid points, and the radius of the query
+// spheres
+#define ISECT_BENCH_SPACING       1.0
+#define ISECT_BENCH_RADIUS        0.75
+
+// Distance two hit points may be apart and still count as the same hit
+#define ISECT_BENCH_TOLERANCE     1.0E-3
+
+// ------------------------------------------------------------------------
+// Returns a random number in the range [low, high]
+// ------------------------------------------------------------------------
+double randomRange(double low, double high)
+{
+    return low + (high - low) * ((double)rand() / (double)RAND_MAX);
+}
+
+// ------------------------------------------------------------------------
+// Returns the height of the synthetic terrain at the given point
+// ------------------------------------------------------------------------
+double terrainHeight(double x, double y)
+{
+    return 4.0 * sin(x * 0.05) * cos(y * 0.07) + 0.5 * sin(x * 0.9 + y);
+}
+
+// ------------------------------------------------------------------------
+// Creates a terrain geometry on a gridSize x gridSize grid, with one
+// triangle strip per row of the grid
+// ------------------------------------------------------------------------
+vsGeometry *createTerrain(int gridSize)
+{
+    vsGeometry *terrain;
+    atVector *vertices;
+    double x, y;
+    int row, col, vertex;
+
+    // Create the geometry
+    terrain = new vsGeometry();
+    terrain->setPrimitiveType(VS_GEOMETRY_TYPE_TRI_STRIPS);
+    terrain->setPrimitiveCount(gridSize - 1);
+
+    // Each strip zig-zags between two rows of the grid
+    vertices = new atVector[(gridSize - 1) * gridSize * 2];
+    vertex = 0;
+    for (row = 0; row < gridSize - 1; row++)
+    {
+        terrain->setPrimitiveLength(row, gridSize * 2);
+        for (col = 0; col < gridSize; col++)
+        {
+            x = (double)col * ISECT_BENCH_SPACING;
+            y = (double)row * ISECT_BENCH_SPACING;
+            vertices[vertex++].set(x, y, terrainHeight(x, y));
+            y += ISECT_BENCH_SPACING;
+            vertices[vertex++].set(x, y, terrainHeight(x, y));
+        }
+    }
+
+    // Hand the vertices to the geometry
+    terrain->setDataListSize(VS_GEOMETRY_VERTEX_COORDS, vertex);
+    terrain->setDataList(VS_GEOMETRY_VERTEX_COORDS, vertices);
+    delete [] vertices;
+
+    return terrain;
+}
+
+// ------------------------------------------------------------------------
+// Returns the point on triangle abc closest to point p
+// ------------------------------------------------------------------------
+atVector closestPointOnTriangle(atVector p, atVector a, atVector b,
+                                atVector c)
+{
+    atVector ab, ac, ap, bp, cp;
+    double d1, d2, d3, d4, d5, d6;
+    double va, vb, vc, v, w, denom;
+
+    // See if the point is in the region beyond vertex a
+    ab = b - a;
+    ac = c - a;
+    ap = p - a;
+    d1 = ab.getDotProduct(ap);
+    d2 = ac.getDotProduct(ap);
+    if ((d1 <= 0.0) && (d2 <= 0.0))
+        return a;
+
+    // See if the point is in the region beyond vertex b
+    bp = p - b;
+    d3 = ab.getDotProduct(bp);
+    d4 = ac.getDotProduct(bp);
+    if ((d3 >= 0.0) && (d4 <= d3))
+        return b;
+
+    // See if the point is in the region beyond edge ab
+    vc = d1 * d4 - d3 * d2;
+    if ((vc <= 0.0) && (d1 >= 0.0) && (d3 <= 0.0))
+        return a + ab.getScaled(d1 / (d1 - d3));
+
+    // See if the point is in the region beyond vertex c
+    cp = p - c;
+    d5 = ab.getDotProduct(cp);
+    d6 = ac.getDotProduct(cp);
+    if ((d6 >= 0.0) && (d5 <= d6))
+        return c;
+
+    // See if the point is in the region beyond edge ac
+    vb = d5 * d2 - d1 * d6;
+    if ((vb <= 0.0) && (d2 >= 0.0) && (d6 <= 0.0))
+        return a + ac.getScaled(d2 / (d2 - d6));
+
+    // See if the point is in the region beyond edge bc
+    va = d3 * d6 - d5 * d4;
+    if ((va <= 0.0) && ((d4 - d3) >= 0.0) && ((d5 - d6) >= 0.0))
+        return b + (c - b).getScaled((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+    // The point projects onto the inside of the triangle
+    denom = 1.0 / (va + vb + vc);
+    v = vb * denom;
+    w = vc * denom;
+    return a + ab.getScaled(v) + ac.getScaled(w);
+}
+
+// ------------------------------------------------------------------------
+// Finds the smallest distance from the given point to any triangle of
+// the terrain by testing every triangle
+// ------------------------------------------------------------------------
+double bruteForceDistance(atVector *vertices, int gridSize, atVector point)
+{
+    double minDistance, distance;
+    int stripStart, row, j;
+
+    minDistance = 1.0E9;
+    for (row = 0; row < gridSize - 1; row++)
+    {
+        stripStart = row * gridSize * 2;
+        for (j = 0; j < gridSize * 2 - 2; j++)
+        {
+            distance = (closestPointOnTriangle(point,
+                vertices[stripStart + j], vertices[stripStart + j + 1],
+                vertices[stripStart + j + 2]) - point).getMagnitude();
+            if (distance < minDistance)
+                minDistance = distance;
+        }
+    }
+
+    return minDistance;
+}
+
+// ------------------------------------------------------------------------
+// Prints the time taken by a set of queries
+// ------------------------------------------------------------------------
+void report(const char *name, double seconds, int queryCount,
+            double referenceSeconds)
+{
+    printf("  %-36s %10.0f queries/s  %8.2fx\n", name,
+        (double)queryCount / seconds, referenceSeconds / seconds);
+}
+
+// ------------------------------------------------------------------------
+// Main program
+// ------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    int gridSize, queryCount, sphereCount;
+    int intersectCount, sphereIntersectCount;
+    vsComponent *root;
+    vsGeometry *terrain;
+    atVector *vertices;
+    atVector *segStart, *segEnd, *osgHit, *sphereCenter;
+    bool *osgHitValid;
+    double *bruteDistance;
+    vsIntersect **intersectList;
+    vsSphereIntersect **sphereIntersectList;
+    vsIntersectResult *result;
+    osg::ref_ptr<osgUtil::LineSegmentIntersector> osgIntersector;
+    osgUtil::IntersectionVisitor osgVisitor;
+    osg::Vec3d osgPoint;
+    vsTimer *timer;
+    double extent, x, y;
+    double osgTime, bvhTime, singleTime, batchTime;
+    double bruteTime, sphereTime, sphereBatchTime;
+    double distance;
+    int segmentMismatches, sphereMismatches;
+    int i, j, query;
+
+    // Get the benchmark settings from the command line
+    gridSize = 512;
+    queryCount = 4096;
+    if (argc > 1)
+        gridSize = atoi(argv[1]);
+    if (argc > 2)
+        queryCount = atoi(argv[2]);
+    if ((gridSize < 2) || (queryCount < VS_INTERSECT_SEGS_MAX))
+    {
+        printf("Usage:  %s [gridSize [queryCount]]\n", argv[0]);
+        printf("    (queryCount must be at least %d)\n",
+            VS_INTERSECT_SEGS_MAX);
+        return 1;
+    }
+
+    // Round the query count to whole intersectors
+    intersectCount = queryCount / VS_INTERSECT_SEGS_MAX;
+    queryCount = intersectCount * VS_INTERSECT_SEGS_MAX;
+
+    // The brute-force sphere test is slow, so use fewer spheres
+    sphereIntersectCount = 4;
+    sphereCount = sphereIntersectCount * VS_SPH_ISECT_MAX_SPHERES;
+
+    // Build the terrain, and keep a copy of its vertices for the
+    // brute-force test
+    root = new vsComponent();
+    root->ref();
+    terrain = createTerrain(gridSize);
+    root->addChild(terrain);
+    vertices = new atVector[terrain->getDataListSize(
+        VS_GEOMETRY_VERTEX_COORDS)];
+    terrain->getDataList(VS_GEOMETRY_VERTEX_COORDS, vertices);
+    extent = (double)(gridSize - 1) * ISECT_BENCH_SPACING;
+
+    printf("Terrain of %d triangles, %d segments, %d spheres, "
+        "%d pool threads\n", (gridSize - 1) * (gridSize * 2 - 2),
+        queryCount, sphereCount,
+        vsThreadPool::getDefaultPool()->getThreadCount());
+
+    // Create random vertical segments over the terrain, and random
+    // spheres near its surface
+    srand(1);
+    segStart = new atVector[queryCount];
+    segEnd = new atVector[queryCount];
+    for (i = 0; i < queryCount; i++)
+    {
+        x = randomRange(0.0, extent);
+        y = randomRange(0.0, extent);
+        segStart[i].set(x, y, 20.0);
+        segEnd[i].set(x, y, -20.0);
+    }
+    sphereCenter = new atVector[sphereCount];
+    for (i = 0; i < sphereCount; i++)
+    {
+        x = randomRange(0.0, extent);
+        y = randomRange(0.0, extent);
+        sphereCenter[i].set(x, y, terrainHeight(x, y) +
+            randomRange(-1.0, 2.0) * ISECT_BENCH_RADIUS);
+    }
+
+    // Set up the VESS intersectors
+    intersectList = new vsIntersect *[intersectCount];
+    for (i = 0; i < intersectCount; i++)
+    {
+        intersectList[i] = new vsIntersect();
+        intersectList[i]->ref();
+        intersectList[i]->setSegListSize(VS_INTERSECT_SEGS_MAX);
+        for (j = 0; j < VS_INTERSECT_SEGS_MAX; j++)
+        {
+            query = i * VS_INTERSECT_SEGS_MAX + j;
+            intersectList[i]->setSeg(j, segStart[query], segEnd[query]);
+        }
+    }
+    sphereIntersectList = new vsSphereIntersect *[sphereIntersectCount];
+    for (i = 0; i < sphereIntersectCount; i++)
+    {
+        sphereIntersectList[i] = new vsSphereIntersect();
+        sphereIntersectList[i]->ref();
+        sphereIntersectList[i]->setSphereListSize(VS_SPH_ISECT_MAX_SPHERES);
+        for (j = 0; j < VS_SPH_ISECT_MAX_SPHERES; j++)
+        {
+            query = i * VS_SPH_ISECT_MAX_SPHERES + j;
+            sphereIntersectList[i]->setSphere(j, sphereCenter[query],
+                ISECT_BENCH_RADIUS);
+        }
+    }
+
+    // Build the triangle hierarchy up front, and time it separately (it's
+    // only built once for static geometry)
+    timer = new vsTimer();
+    timer->mark();
+    intersectList[0]->intersect(root);
+    bvhTime = timer->getElapsed();
+
+    // Time OSG's line segment intersector, as vsIntersect used it before
+    // the triangle hierarchy, and keep its hits as the reference
+    osgHit = new atVector[queryCount];
+    osgHitValid = new bool[queryCount];
+    timer->mark();
+    for (i = 0; i < queryCount; i++)
+    {
+        osgIntersector = new osgUtil::LineSegmentIntersector(
+            osg::Vec3d(segStart[i][AT_X], segStart[i][AT_Y],
+            segStart[i][AT_Z]), osg::Vec3d(segEnd[i][AT_X],
+            segEnd[i][AT_Y], segEnd[i][AT_Z]));
+        osgVisitor.reset();
+        osgVisitor.setIntersector(osgIntersector.get());
+        terrain->getBaseLibraryObject()->accept(osgVisitor);
+        osgHitValid[i] = osgIntersector->containsIntersections();
+        if (osgHitValid[i])
+        {
+            osgPoint = osgIntersector->getFirstIntersection().
+                getWorldIntersectPoint();
+            osgHit[i].set(osgPoint.x(), osgPoint.y(), osgPoint.z());
+        }
+    }
+    osgTime = timer->getElapsed();
+
+    // Time vsIntersect, one intersector at a time
+    timer->mark();
+    for (i = 0; i < intersectCount; i++)
+        intersectList[i]->intersect(root);
+    singleTime = timer->getElapsed();
+
+    // Time vsIntersect as a threaded batch
+    timer->mark();
+    vsIntersect::intersectBatch(intersectList, intersectCount, root, true);
+    batchTime = timer->getElapsed();
+
+    // Compare the batch's hits with OSG's
+    segmentMismatches = 0;
+    for (i = 0; i < queryCount; i++)
+    {
+        result = intersectList[i / VS_INTERSECT_SEGS_MAX]->
+            getIntersection(i % VS_INTERSECT_SEGS_MAX);
+        if (result->isValid() != osgHitValid[i])
+            segmentMismatches++;
+        else if ((osgHitValid[i]) &&
+            ((result->getPoint() - osgHit[i]).getMagnitude() >
+            ISECT_BENCH_TOLERANCE))
+            segmentMismatches++;
+    }
+
+    // Time the brute-force sphere test, as vsSphereIntersect did it before
+    // the triangle hierarchy
+    bruteDistance = new double[sphereCount];
+    timer->mark();
+    for (i = 0; i < sphereCount; i++)
+        bruteDistance[i] = bruteForceDistance(vertices, gridSize,
+            sphereCenter[i]);
+    bruteTime = timer->getElapsed();
+
+    // Time vsSphereIntersect, one intersector at a time
+    timer->mark();
+    for (i = 0; i < sphereIntersectCount; i++)
+        sphereIntersectList[i]->intersect(root);
+    sphereTime = timer->getElapsed();
+
+    // Time vsSphereIntersect as a threaded batch
+    timer->mark();
+    vsSphereIntersect::intersectBatch(sphereIntersectList,
+        sphereIntersectCount, root, true);
+    sphereBatchTime = timer->getElapsed();
+
+    // Compare the batch's hits with the brute-force distances (skipping
+    // spheres that just touch the terrain, where rounding decides)
+    sphereMismatches = 0;
+    for (i = 0; i < sphereCount; i++)
+    {
+        if (fabs(bruteDistance[i] - ISECT_BENCH_RADIUS) <
+            ISECT_BENCH_TOLERANCE)
+            continue;
+
+        result = sphereIntersectList[i / VS_SPH_ISECT_MAX_SPHERES]->
+            getIntersection(i % VS_SPH_ISECT_MAX_SPHERES);
+        if (result->isValid() != (bruteDistance[i] < ISECT_BENCH_RADIUS))
+            sphereMismatches++;
+        else if (result->isValid())
+        {
+            distance = (result->getPoint() - sphereCenter[i]).getMagnitude();
+            if (fabs(distance - bruteDistance[i]) > ISECT_BENCH_TOLERANCE)
+                sphereMismatches++;
+        }
+    }
+
+    // Report the results
+    printf("  Triangle hierarchy built with the first query in %.3f ms\n",
+        bvhTime * 1000.0);
+    report("segments, OSG intersector (before)", osgTime, queryCount,
+        osgTime);
+    report("segments, vsIntersect", singleTime, queryCount, osgTime);
+    report("segments, vsIntersect batch", batchTime, queryCount, osgTime);
+    report("spheres, every triangle (before)", bruteTime, sphereCount,
+        bruteTime);
+    report("spheres, vsSphereIntersect", sphereTime, sphereCount,
+        bruteTime);
+    report("spheres, vsSphereIntersect batch", sphereBatchTime,
+        sphereCount, bruteTime);
+    printf("  Mismatched results:  %d segments, %d spheres\n",
+        segmentMismatches, sphereMismatches);
+
+    // Clean up
+    for (i = 0; i < intersectCount; i++)
+        vsObject::unrefDelete(intersectList[i]);
+    for (i = 0; i < sphereIntersectCount; i++)
+        vsObject::unrefDelete(sphereIntersectList[i]);
+    delete [] intersectList;
+    delete [] sphereIntersectList;
+    delete [] vertices;
+    delete [] segStart;
+    delete [] segEnd;
+    delete [] osgHit;
+    delete [] osgHitValid;
+    delete [] sphereCenter;
+    delete [] bruteDistance;
+    delete timer;
+    root->deleteTree();
+    vsObject::unrefDelete(root);
+    vsThreadPool::deleteDefaultPool();
+
+    // Fail if the intersectors disagree with the references
+    if ((segmentMismatches > 0) || (sphereMismatches > 0))
+    {
+        printf("FAILED:  intersection results don't match the reference\n");
+        return 1;
+    }
+
+    return 0;
+}
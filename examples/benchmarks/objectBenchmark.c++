@@ -0,0 +1,196 @@
+//------------------------------------------------------------------------
+//
+//    VIRTUAL ENVIRONMENT SOFTWARE SANDBOX (VESS)
+//
+//    Copyright (c) 2001, University of Central Florida
+//
+//       See the file LICENSE for license information
+//
+//    E-mail:  vess@ist.ucf.edu
+//    WWW:     http://vess.ist.ucf.edu/
+//
+//------------------------------------------------------------------------
+//
+//    VESS Module:  objectBenchmark.c++
+//
+//    Description:  Benchmark for vsObject bookkeeping.  Times loading a
+//                  model (where most of the cost of creating VESS
+//                  objects shows up), then times creating, referencing
+//                  and deleting objects on one thread and on every
+//                  thread of the default pool at once.  Build it with
+//                  and without VESS_DEBUG to compare the cost of the
+//                  list of live objects.
+//
+//    Usage:        objectBenchmark [modelFile [loadCount]]
+//
+//    Author(s):    agent
+//
+//------------------------------------------------------------------------
+
+#include "vsObject.h++"
+#include "vsComponent.h++"
+#include "vsDatabaseLoader.h++"
+#include "vsThreadPool.h++"
+#include "vsTimer.h++"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Number of objects created by each churn task, and the number of tasks
+#define OBJ_BENCH_OBJECTS_PER_TASK    1000
+#define OBJ_BENCH_TASK_COUNT          2048
+
+// Number of references taken and released on the shared object for each
+// object created
+#define OBJ_BENCH_REFS_PER_OBJECT     4
+
+// Smallest possible VESS object
+class benchObject : public vsObject
+{
+public:
+
+    virtual const char    *getClassName() { return "benchObject"; }
+};
+
+// Object that every churn task references, so the tasks contend on its
+// reference count
+vsObject *sharedObject;
+
+// ------------------------------------------------------------------------
+// Creates, references and deletes objects for the tasks in the range
+// [first, last)
+// ------------------------------------------------------------------------
+void churnTaskFunc(void *userData, int first, int last)
+{
+    benchObject *objects[OBJ_BENCH_OBJECTS_PER_TASK];
+    int task, i, j;
+
+    for (task = first; task < last; task++)
+    {
+        // Create a batch of objects, taking a reference to each, and
+        // referencing the shared object a few times for each one
+        for (i = 0; i < OBJ_BENCH_OBJECTS_PER_TASK; i++)
+        {
+            objects[i] = new benchObject();
+            objects[i]->ref();
+            for (j = 0; j < OBJ_BENCH_REFS_PER_OBJECT; j++)
+                sharedObject->ref();
+        }
+
+        // Release everything again
+        for (i = 0; i < OBJ_BENCH_OBJECTS_PER_TASK; i++)
+        {
+            for (j = 0; j < OBJ_BENCH_REFS_PER_OBJECT; j++)
+                sharedObject->unref();
+            vsObject::unrefDelete(objects[i]);
+        }
+    }
+}
+
+// ------------------------------------------------------------------------
+// Main program
+// ------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    char *modelFile;
+    int loadCount;
+    vsDatabaseLoader *loader;
+    vsComponent *model;
+    vsTimer *timer;
+    double loadTime, totalLoadTime;
+    double serialTime, parallelTime;
+    double objectCount;
+    int i;
+
+    // Get the benchmark settings from the command line
+    modelFile = NULL;
+    loadCount = 3;
+    if (argc > 1)
+        modelFile = argv[1];
+    if (argc > 2)
+        loadCount = atoi(argv[2]);
+    if (loadCount < 1)
+    {
+        printf("Usage:  %s [modelFile [loadCount]]\n", argv[0]);
+        return 1;
+    }
+
+#ifdef VESS_DEBUG
+    printf("Live object list:  on (VESS_DEBUG build)\n");
+#else
+    printf("Live object list:  off\n");
+#endif
+    printf("%d pool threads\n",
+        vsThreadPool::getDefaultPool()->getThreadCount());
+
+    timer = new vsTimer();
+
+    // Time loading the model, if we were given one
+    if (modelFile != NULL)
+    {
+        loader = new vsDatabaseLoader();
+        loader->ref();
+        totalLoadTime = 0.0;
+        for (i = 0; i < loadCount; i++)
+        {
+            // Load the model
+            timer->mark();
+            model = loader->loadDatabase(modelFile);
+            loadTime = timer->getElapsed();
+            if (model == NULL)
+            {
+                printf("Unable to load %s\n", modelFile);
+                return 1;
+            }
+            printf("  Load %d of %s:  %.1f ms\n", i + 1, modelFile,
+                loadTime * 1000.0);
+            totalLoadTime += loadTime;
+
+            // Get rid of it again
+            model->ref();
+            model->deleteTree();
+            vsObject::unrefDelete(model);
+        }
+        printf("  Average load time:  %.1f ms\n",
+            totalLoadTime * 1000.0 / (double)loadCount);
+        vsObject::unrefDelete(loader);
+    }
+
+    // Create the object that all of the tasks share
+    sharedObject = new benchObject();
+    sharedObject->ref();
+    objectCount = (double)OBJ_BENCH_TASK_COUNT *
+        (double)OBJ_BENCH_OBJECTS_PER_TASK;
+
+    // Time the churn on this thread alone
+    timer->mark();
+    churnTaskFunc(NULL, 0, OBJ_BENCH_TASK_COUNT);
+    serialTime = timer->getElapsed();
+
+    // Time the churn on all of the pool's threads at once
+    timer->mark();
+    vsThreadPool::getDefaultPool()->parallelFor(OBJ_BENCH_TASK_COUNT, 1,
+        churnTaskFunc, NULL);
+    parallelTime = timer->getElapsed();
+
+    // Report the results
+    printf("  Object create/ref/delete, one thread:   %8.2f M objects/s\n",
+        objectCount / serialTime / 1.0E6);
+    printf("  Object create/ref/delete, thread pool:  %8.2f M objects/s "
+        "(%.2fx)\n", objectCount / parallelTime / 1.0E6,
+        serialTime / parallelTime);
+
+    // Make sure the shared object's reference count survived all that
+    if (sharedObject->getRefCount() != 1)
+    {
+        printf("FAILED:  shared reference count is %d, should be 1\n",
+            sharedObject->getRefCount());
+        return 1;
+    }
+
+    // Clean up
+    vsObject::unrefDelete(sharedObject);
+    delete timer;
+    vsThreadPool::deleteDefaultPool();
+
+    return 0;
+}
@@ -0,0 +1,238 @@
+//------------------------------------------------------------------------
+//
+//    VIRTUAL ENVIRONMENT SOFTWARE SANDBOX (VESS)
+//
+//    Copyright (c) 2001, University of Central Florida
+//
+//       See the file LICENSE for license information
+//
+//    E-mail:  vess@ist.ucf.edu
+//    WWW:     http://vess.ist.ucf.edu/
+//
+//------------------------------------------------------------------------
+//
+//    VESS Module:  optimizeBenchmark.c++
+//
+//    Description:  Benchmark for geometry optimization.  Welds a large
+//                  unindexed triangle mesh (with its triangles in random
+//                  order) and reports the time taken and the simulated
+//                  post-transform cache miss ratio before and after.
+//                  Then runs vsOptimizer over a scene of many separate
+//                  geometry objects, which are merged and welded.
+//
+//    Usage:        optimizeBenchmark [gridSize [geometryCount]]
+//
+//    Author(s):    agent
+//
+//------------------------------------------------------------------------
+
+#include "vsComponent.h++"
+#include "vsGeometry.h++"
+#include "vsOptimizer.h++"
+#include "vsVertexCacheOptimizer.h++"
+#include "vsThreadPool.h++"
+#include "vsTimer.h++"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Size of the grid of each geometry in the scene test
+#define OPT_BENCH_SCENE_GRID    64
+
+// ------------------------------------------------------------------------
+// Creates an unindexed triangle mesh over a gridSize x gridSize grid of
+// points, with the triangles in random order, so that every vertex is
+// repeated once for each triangle that uses it.  If gridIndices isn't
+// NULL, it's filled in with the grid point used by each vertex (which is
+// the index list a naive exporter would produce).
+// ------------------------------------------------------------------------
+vsGeometry *createMesh(int gridSize, double offset, u_int *gridIndices)
+{
+    vsGeometry *mesh;
+    int quadCount, triangleCount;
+    int *triangleOrder;
+    atVector *vertices, *normals;
+    int triangle, quad, row, col, corner, swap;
+    int cornerRow, cornerCol;
+    int i, j;
+
+    // Triangles of each grid square, as (row, column) offsets of their
+    // corners
+    static const int corners[2][3][2] =
+    {
+        { {0, 0}, {0, 1}, {1, 1} },
+        { {0, 0}, {1, 1}, {1, 0} }
+    };
+
+    // Shuffle the triangles
+    quadCount = (gridSize - 1) * (gridSize - 1);
+    triangleCount = quadCount * 2;
+    triangleOrder = new int[triangleCount];
+    for (i = 0; i < triangleCount; i++)
+        triangleOrder[i] = i;
+    for (i = triangleCount - 1; i > 0; i--)
+    {
+        j = rand() % (i + 1);
+        swap = triangleOrder[i];
+        triangleOrder[i] = triangleOrder[j];
+        triangleOrder[j] = swap;
+    }
+
+    // Fill in three vertices for each triangle
+    vertices = new atVector[triangleCount * 3];
+    normals = new atVector[triangleCount * 3];
+    for (i = 0; i < triangleCount; i++)
+    {
+        // Find the grid square and which of its triangles this is
+        triangle = triangleOrder[i];
+        quad = triangle / 2;
+        row = quad / (gridSize - 1);
+        col = quad % (gridSize - 1);
+
+        // Add the triangle's corners
+        for (corner = 0; corner < 3; corner++)
+        {
+            cornerRow = row + corners[triangle % 2][corner][0];
+            cornerCol = col + corners[triangle % 2][corner][1];
+            vertices[i * 3 + corner].set(offset + (double)cornerCol,
+                (double)cornerRow, 0.0);
+            normals[i * 3 + corner].set(0.0, 0.0, 1.0);
+            if (gridIndices != NULL)
+                gridIndices[i * 3 + corner] =
+                    (u_int)(cornerRow * gridSize + cornerCol);
+        }
+    }
+
+    // Create the geometry
+    mesh = new vsGeometry();
+    mesh->setPrimitiveType(VS_GEOMETRY_TYPE_TRIS);
+    mesh->setPrimitiveCount(triangleCount);
+    mesh->setBinding(VS_GEOMETRY_NORMALS, VS_GEOMETRY_BIND_PER_VERTEX);
+    mesh->setDataListSize(VS_GEOMETRY_VERTEX_COORDS, triangleCount * 3);
+    mesh->setDataList(VS_GEOMETRY_VERTEX_COORDS, vertices);
+    mesh->setDataListSize(VS_GEOMETRY_NORMALS, triangleCount * 3);
+    mesh->setDataList(VS_GEOMETRY_NORMALS, normals);
+
+    // Clean up
+    delete [] triangleOrder;
+    delete [] vertices;
+    delete [] normals;
+
+    return mesh;
+}
+
+// ------------------------------------------------------------------------
+// Main program
+// ------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    int gridSize, geometryCount;
+    vsGeometry *mesh;
+    vsComponent *scene;
+    vsOptimizer *optimizer;
+    u_int *gridIndices, *indexList;
+    int triangleCount, vertexCount, indexCount;
+    double naiveRatio, weldedRatio;
+    vsTimer *timer;
+    double weldTime, optimizeTime;
+    int i;
+
+    // Get the benchmark settings from the command line
+    gridSize = 400;
+    geometryCount = 32;
+    if (argc > 1)
+        gridSize = atoi(argv[1]);
+    if (argc > 2)
+        geometryCount = atoi(argv[2]);
+    if ((gridSize < 2) || (geometryCount < 1))
+    {
+        printf("Usage:  %s [gridSize [geometryCount]]\n", argv[0]);
+        return 1;
+    }
+
+    // The unindexed mesh has to fit in a geometry's data lists
+    triangleCount = (gridSize - 1) * (gridSize - 1) * 2;
+    if (triangleCount * 3 > VS_GEOMETRY_MAX_LIST_INDEX)
+    {
+        printf("A grid size of %d needs more than the %d vertices a "
+            "geometry can hold\n", gridSize, VS_GEOMETRY_MAX_LIST_INDEX);
+        return 1;
+    }
+
+    // Create the mesh, along with the index list a naive exporter would
+    // have made for it
+    srand(1);
+    gridIndices = new u_int[triangleCount * 3];
+    mesh = createMesh(gridSize, 0.0, gridIndices);
+    mesh->ref();
+
+    printf("Welding %d triangles (%d vertices unindexed), %d pool threads\n",
+        triangleCount, triangleCount * 3,
+        vsThreadPool::getDefaultPool()->getThreadCount());
+
+    // Measure the naive ordering
+    naiveRatio = vsVertexCacheOptimizer::getCacheMissRatio(gridIndices,
+        triangleCount * 3, VS_VCACHE_DEFAULT_FIFO);
+
+    // Weld the mesh
+    timer = new vsTimer();
+    timer->mark();
+    mesh->optimizeVertices();
+    weldTime = timer->getElapsed();
+
+    // Measure the welded ordering
+    vertexCount = mesh->getDataListSize(VS_GEOMETRY_VERTEX_COORDS);
+    indexCount = mesh->getIndexListSize();
+    indexList = new u_int[indexCount];
+    mesh->getIndexList(indexList);
+    weldedRatio = vsVertexCacheOptimizer::getCacheMissRatio(indexList,
+        indexCount, VS_VCACHE_DEFAULT_FIFO);
+
+    // Report the results
+    printf("  Weld and reorder time:  %.1f ms (%.2f M vertices/s)\n",
+        weldTime * 1000.0, (double)triangleCount * 3.0 / weldTime / 1.0E6);
+    printf("  Vertices after welding:  %d (%d grid points)\n", vertexCount,
+        gridSize * gridSize);
+    printf("  Cache misses per triangle (%d-entry FIFO):  %.3f naive, "
+        "%.3f optimized\n", VS_VCACHE_DEFAULT_FIFO, naiveRatio,
+        weldedRatio);
+
+    // Build a scene of many small geometry objects side by side
+    printf("Optimizing a scene of %d geometry objects of %d triangles\n",
+        geometryCount,
+        (OPT_BENCH_SCENE_GRID - 1) * (OPT_BENCH_SCENE_GRID - 1) * 2);
+    scene = new vsComponent();
+    scene->ref();
+    for (i = 0; i < geometryCount; i++)
+        scene->addChild(createMesh(OPT_BENCH_SCENE_GRID,
+            (double)(i * OPT_BENCH_SCENE_GRID), NULL));
+
+    // Run every optimization over the scene (welding included)
+    optimizer = new vsOptimizer();
+    optimizer->ref();
+    optimizer->setOptimizations(VS_OPTIMIZER_ALL);
+    timer->mark();
+    optimizer->optimize(scene);
+    optimizeTime = timer->getElapsed();
+    printf("  vsOptimizer time:  %.1f ms (%d children left under the "
+        "root)\n", optimizeTime * 1000.0, scene->getChildCount());
+
+    // Clean up
+    delete timer;
+    delete [] gridIndices;
+    delete [] indexList;
+    vsObject::unrefDelete(optimizer);
+    vsObject::unrefDelete(mesh);
+    scene->deleteTree();
+    vsObject::unrefDelete(scene);
+    vsThreadPool::deleteDefaultPool();
+
+    // Fail if welding didn't find all of the shared vertices, or left the
+    // ordering worse than it was
+    if ((vertexCount != gridSize * gridSize) || (weldedRatio > naiveRatio))
+    {
+        printf("FAILED:  welding didn't produce the expected mesh\n");
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,253 @@
+//------------------------------------------------------------------------
+//
+//    VIRTUAL ENVIRONMENT SOFTWARE SANDBOX (VESS)
+//
+//    Copyright (c) 2001, University of Central Florida
+//
+//       See the file LICENSE for license information
+//
+//    E-mail:  vess@ist.ucf.edu
+//    WWW:     http://vess.ist.ucf.edu/
+//
+//------------------------------------------------------------------------
+//
+//    VESS Module:  sceneCacheBenchmark.c++
+//
+//    Description:  Benchmark for the scene cache.  Times loading a model
+//                  with the cache disabled, then a cold load with the
+//                  cache enabled (which parses the model and writes the
+//                  cache file), then several warm loads that read the
+//                  scene back from the cache.  COLLADA files (.dae) are
+//                  loaded with vsCOLLADALoader and everything else with
+//                  vsDatabaseLoader.  Checks that the cached scene has
+//                  the same geometry as the parsed one.
+//
+//    Usage:        sceneCacheBenchmark modelFile [warmLoads]
+//
+//    Author(s):    agent
+//
+//------------------------------------------------------------------------
+
+#include "vsComponent.h++"
+#include "vsGeometryBase.h++"
+#include "vsDatabaseLoader.h++"
+#include "vsCOLLADALoader.h++"
+#include "vsSceneCache.h++"
+#include "vsThreadPool.h++"
+#include "vsTimer.h++"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+
+// Size of the scene that was loaded, used to check that the cached scene
+// matches the parsed one
+struct sceneStats
+{
+    int    nodeCount;
+    int    geometryCount;
+    int    vertexCount;
+};
+
+// ------------------------------------------------------------------------
+// Adds up the nodes, geometry nodes and vertices under the given node
+// ------------------------------------------------------------------------
+void countScene(vsNode *node, sceneStats *stats)
+{
+    int nodeType;
+    int i;
+
+    // Count this node
+    stats->nodeCount++;
+
+    // Count the vertices of geometry nodes
+    nodeType = node->getNodeType();
+    if ((nodeType == VS_NODE_TYPE_GEOMETRY) ||
+        (nodeType == VS_NODE_TYPE_DYNAMIC_GEOMETRY) ||
+        (nodeType == VS_NODE_TYPE_SKELETON_MESH_GEOMETRY))
+    {
+        stats->geometryCount++;
+        stats->vertexCount += ((vsGeometryBase *)node)->
+            getDataListSize(VS_GEOMETRY_VERTEX_COORDS);
+    }
+
+    // Count the children
+    for (i = 0; i < node->getChildCount(); i++)
+        countScene(node->getChild(i), stats);
+}
+
+// ------------------------------------------------------------------------
+// Loads the model, with or without the scene cache, and returns the time
+// taken (or a negative time if the load failed).  The size of the scene
+// is stored in stats, and the scene is deleted again afterwards.
+// ------------------------------------------------------------------------
+double loadModel(char *modelFile, bool collada, bool useCache,
+                 vsTimer *timer, sceneStats *stats)
+{
+    vsCOLLADALoader *colladaLoader;
+    vsDatabaseLoader *databaseLoader;
+    vsComponent *scene;
+    double loadTime;
+
+    // Load the scene with the appropriate loader
+    timer->mark();
+    if (collada)
+    {
+        colladaLoader = new vsCOLLADALoader();
+        colladaLoader->ref();
+        if (useCache)
+            colladaLoader->enableSceneCache(
+                VS_SCENE_CACHE_VALIDATE_TIMESTAMP);
+        colladaLoader->parseFile(modelFile);
+        scene = colladaLoader->getScene();
+        loadTime = timer->getElapsed();
+        vsObject::unrefDelete(colladaLoader);
+    }
+    else
+    {
+        databaseLoader = new vsDatabaseLoader();
+        databaseLoader->ref();
+        databaseLoader->setLoaderMode(VS_DATABASE_MODE_SCENE_CACHE,
+            useCache);
+        scene = databaseLoader->loadDatabase(modelFile);
+        loadTime = timer->getElapsed();
+        vsObject::unrefDelete(databaseLoader);
+    }
+
+    // Bail if nothing was loaded
+    if (scene == NULL)
+        return -1.0;
+
+    // Measure the scene
+    memset(stats, 0, sizeof(sceneStats));
+    countScene(scene, stats);
+
+    // Get rid of the scene again
+    scene->ref();
+    scene->deleteTree();
+    vsObject::unrefDelete(scene);
+
+    return loadTime;
+}
+
+// ------------------------------------------------------------------------
+// Main program
+// ------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    char *modelFile;
+    int warmLoads;
+    bool collada;
+    atString cacheFile;
+    vsTimer *timer;
+    sceneStats parsedStats, cachedStats;
+    double parseTime, coldTime, warmTime, totalWarmTime;
+    bool statsMatch;
+    int i;
+
+    // Get the benchmark settings from the command line
+    modelFile = NULL;
+    warmLoads = 5;
+    if (argc > 1)
+        modelFile = argv[1];
+    if (argc > 2)
+        warmLoads = atoi(argv[2]);
+    if ((modelFile == NULL) || (warmLoads < 1))
+    {
+        printf("Usage:  %s modelFile [warmLoads]\n", argv[0]);
+        return 1;
+    }
+
+    // The loaders find the model along their search paths, but the cache
+    // file name is based on where the model really is, so insist on a
+    // path that we can use as is
+    if (access(modelFile, F_OK) != 0)
+    {
+        printf("Unable to find %s\n", modelFile);
+        return 1;
+    }
+
+    // Pick the loader based on the file's extension
+    collada = ((strlen(modelFile) > 4) &&
+        (strcasecmp(&modelFile[strlen(modelFile) - 4], ".dae") == 0));
+
+    // Start from a cold cache
+    cacheFile = vsSceneCache::getCacheFilename(modelFile);
+    unlink(cacheFile.getString());
+
+    printf("Loading %s with %s, %d pool threads\n", modelFile,
+        collada ? "vsCOLLADALoader" : "vsDatabaseLoader",
+        vsThreadPool::getDefaultPool()->getThreadCount());
+    timer = new vsTimer();
+
+    // Time a plain load, without the cache
+    parseTime = loadModel(modelFile, collada, false, timer, &parsedStats);
+    if (parseTime < 0.0)
+    {
+        printf("Unable to load %s\n", modelFile);
+        delete timer;
+        vsThreadPool::deleteDefaultPool();
+        return 1;
+    }
+    printf("  Scene:  %d nodes, %d geometry nodes, %d vertices\n",
+        parsedStats.nodeCount, parsedStats.geometryCount,
+        parsedStats.vertexCount);
+    printf("  Load without cache:       %9.1f ms\n", parseTime * 1000.0);
+
+    // Time a cold load with the cache enabled (this parses the model and
+    // writes the cache file)
+    coldTime = loadModel(modelFile, collada, true, timer, &cachedStats);
+    printf("  Cold load (cache write):  %9.1f ms\n", coldTime * 1000.0);
+    if ((coldTime < 0.0) || (access(cacheFile.getString(), F_OK) != 0))
+    {
+        printf("FAILED:  cache file %s wasn't written\n",
+            cacheFile.getString());
+        delete timer;
+        vsThreadPool::deleteDefaultPool();
+        return 1;
+    }
+
+    // Time the warm loads, which should all come from the cache
+    totalWarmTime = 0.0;
+    statsMatch = true;
+    for (i = 0; i < warmLoads; i++)
+    {
+        warmTime = loadModel(modelFile, collada, true, timer, &cachedStats);
+        if (warmTime < 0.0)
+        {
+            printf("FAILED:  warm load %d returned no scene\n", i + 1);
+            delete timer;
+            vsThreadPool::deleteDefaultPool();
+            return 1;
+        }
+        totalWarmTime += warmTime;
+
+        // Make sure the cached scene has the same geometry
+        if ((cachedStats.nodeCount != parsedStats.nodeCount) ||
+            (cachedStats.geometryCount != parsedStats.geometryCount) ||
+            (cachedStats.vertexCount != parsedStats.vertexCount))
+            statsMatch = false;
+    }
+    warmTime = totalWarmTime / (double)warmLoads;
+
+    // Report the results
+    printf("  Warm load (cache read):   %9.1f ms average of %d (%.1fx)\n",
+        warmTime * 1000.0, warmLoads, parseTime / warmTime);
+    printf("  Cache file %s left in place\n", cacheFile.getString());
+
+    // Clean up
+    delete timer;
+    vsThreadPool::deleteDefaultPool();
+
+    // Fail if the cached scene doesn't match the parsed one
+    if (!statsMatch)
+    {
+        printf("FAILED:  cached scene has %d nodes, %d geometry nodes and "
+            "%d vertices\n", cachedStats.nodeCount,
+            cachedStats.geometryCount, cachedStats.vertexCount);
+        return 1;
+    }
+
+    return 0;
+}
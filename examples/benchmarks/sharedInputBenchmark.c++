@@ -0,0 +1,313 @@
+//------------------------------------------------------------------------
+//
+//    VIRTUAL ENVIRONMENT SOFTWARE SANDBOX (VESS)
+//
+//    Copyright (c) 2001, University of Central Florida
+//
+//       See the file LICENSE for license information
+//
+//    E-mail:  vess@ist.ucf.edu
+//    WWW:     http://vess.ist.ucf.edu/
+//
+//------------------------------------------------------------------------
+//
+//    VESS Module:  sharedInputBenchmark.c++
+//
+//    Description:  Benchmark for vsSharedInputData.  Forks a simulated
+//                  tracker server that publishes samples for several
+//                  trackers at a fixed rate, the same way the forked
+//                  tracker classes do.  The application process measures
+//                  the latency from when each sample was stored to when
+//                  it first sees it, then measures how many reads per
+//                  second retrieveData() and retrieveInterpolatedData()
+//                  manage while the server keeps writing.  Every sample
+//                  read is checked for torn data.
+//
+//    Usage:        sharedInputBenchmark [rateHz [seconds [trackers]]]
+//
+//    Author(s):    agent
+//
+//------------------------------------------------------------------------
+
+#include "vsSharedInputData.h++"
+#include "atVector.h++"
+#include "atQuat.h++"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+// Base of the shared memory key (the process ID fills in the rest)
+#define INPUT_BENCH_SHM_KEY_BASE    0xbe5c0000
+
+// Number of reads in each reads-per-second test
+#define INPUT_BENCH_READ_COUNT      5000000
+
+// Set by the signal handler when the server should quit
+volatile bool serverDone;
+
+// ------------------------------------------------------------------------
+// Signal handler that tells the server to quit
+// ------------------------------------------------------------------------
+void quitServer(int arg)
+{
+    serverDone = true;
+}
+
+// ------------------------------------------------------------------------
+// Creates the position and orientation of the given sample for a
+// tracker.  The components all depend on the sample number, so a sample
+// mixed together from two different updates can be detected.
+// ------------------------------------------------------------------------
+void makeSample(int tracker, int sampleNumber, atVector *vector,
+                atQuat *quat)
+{
+    double value;
+
+    value = (double)sampleNumber + (double)tracker * 0.25;
+    vector->setSize(3);
+    vector->set(value, value * 2.0, value * 3.0);
+    quat->set(value, value * 4.0, value * 5.0, value * 6.0);
+}
+
+// ------------------------------------------------------------------------
+// Returns whether the given position and orientation came from a single
+// sample
+// ------------------------------------------------------------------------
+bool checkSample(atVector vector, atQuat quat)
+{
+    double value;
+
+    value = vector[AT_X];
+    return ((vector[AT_Y] == value * 2.0) &&
+        (vector[AT_Z] == value * 3.0) &&
+        (quat[AT_X] == value) &&
+        (quat[AT_Y] == value * 4.0) &&
+        (quat[AT_Z] == value * 5.0) &&
+        (quat[AT_W] == value * 6.0));
+}
+
+// ------------------------------------------------------------------------
+// Compares two latencies for qsort()
+// ------------------------------------------------------------------------
+int compareLatency(const void *first, const void *second)
+{
+    double a, b;
+
+    a = *(const double *)first;
+    b = *(const double *)second;
+    if (a < b)
+        return -1;
+    else if (a > b)
+        return 1;
+    else
+        return 0;
+}
+
+// ------------------------------------------------------------------------
+// Simulated tracker server.  Publishes a sample for each tracker at the
+// given rate until told to quit.
+// ------------------------------------------------------------------------
+void serverLoop(key_t key, int trackerCount, int rate)
+{
+    vsSharedInputData *sharedData;
+    struct timespec nextTime;
+    long period;
+    atVector vector;
+    atQuat quat;
+    int sampleNumber;
+    int i;
+
+    // Set up the signal handler
+    serverDone = false;
+    signal(SIGUSR1, quitServer);
+
+    // Create the shared memory
+    sharedData = new vsSharedInputData(key, trackerCount, true);
+
+    // Publish samples at the given rate, on an absolute schedule so the
+    // rate doesn't drift
+    period = 1000000000L / (long)rate;
+    clock_gettime(CLOCK_MONOTONIC, &nextTime);
+    sampleNumber = 0;
+    while (!serverDone)
+    {
+        // "Read the hardware" and store the new samples
+        for (i = 0; i < trackerCount; i++)
+        {
+            makeSample(i, sampleNumber, &vector, &quat);
+            sharedData->storeData(i, vector, quat);
+        }
+        sampleNumber++;
+
+        // Wait for the next update
+        nextTime.tv_nsec += period;
+        while (nextTime.tv_nsec >= 1000000000L)
+        {
+            nextTime.tv_nsec -= 1000000000L;
+            nextTime.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &nextTime, NULL);
+    }
+
+    // Detach from (and remove) the shared memory
+    delete sharedData;
+}
+
+// ------------------------------------------------------------------------
+// Main program
+// ------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    int rate, seconds, trackerCount;
+    key_t key;
+    pid_t serverPID;
+    vsSharedInputData *sharedData;
+    atVector vector;
+    atQuat quat;
+    double timestamp, lastTimestamp;
+    double now, endTime, startTime;
+    double *latencies;
+    int latencyCount, maxLatencies;
+    double latencySum;
+    double newestTime, interpolatedTime;
+    int tornCount, missingCount;
+    int i;
+
+    // Get the benchmark settings from the command line
+    rate = 1000;
+    seconds = 5;
+    trackerCount = 4;
+    if (argc > 1)
+        rate = atoi(argv[1]);
+    if (argc > 2)
+        seconds = atoi(argv[2]);
+    if (argc > 3)
+        trackerCount = atoi(argv[3]);
+    if ((rate < 1) || (rate > 1000000) || (seconds < 1) ||
+        (trackerCount < 1))
+    {
+        printf("Usage:  %s [rateHz [seconds [trackers]]]\n", argv[0]);
+        return 1;
+    }
+
+    // Use the process ID for the second half of the shared memory key,
+    // so several copies of the benchmark don't collide
+    key = INPUT_BENCH_SHM_KEY_BASE | (getpid() & 0x0000FFFF);
+
+    // Fork the simulated tracker server
+    serverPID = fork();
+    if (serverPID == -1)
+    {
+        printf("fork() failed\n");
+        return 1;
+    }
+    else if (serverPID == 0)
+    {
+        serverLoop(key, trackerCount, rate);
+        exit(0);
+    }
+
+    // Connect to the server's shared memory
+    sharedData = new vsSharedInputData(key, trackerCount, false);
+    printf("Server PID %d publishing %d trackers at %d Hz\n", serverPID,
+        trackerCount, rate);
+
+    // Wait for the first sample
+    while (!sharedData->retrieveData(0, &vector, &quat, &lastTimestamp))
+        ;
+
+    // Watch the first tracker for new samples for the given time, and
+    // note how long each one took to get here
+    maxLatencies = rate * (seconds + 1);
+    latencies = new double[maxLatencies];
+    latencyCount = 0;
+    latencySum = 0.0;
+    tornCount = 0;
+    endTime = vsSharedInputData::getCurrentTime() + (double)seconds;
+    do
+    {
+        // Read the newest sample
+        sharedData->retrieveData(0, &vector, &quat, &timestamp);
+        now = vsSharedInputData::getCurrentTime();
+
+        // If it's new, record its latency
+        if (timestamp != lastTimestamp)
+        {
+            if (!checkSample(vector, quat))
+                tornCount++;
+            if (latencyCount < maxLatencies)
+            {
+                latencies[latencyCount] = now - timestamp;
+                latencySum += now - timestamp;
+                latencyCount++;
+            }
+            lastTimestamp = timestamp;
+        }
+    }
+    while (now < endTime);
+
+    // Report the latencies
+    qsort(latencies, latencyCount, sizeof(double), compareLatency);
+    printf("  Samples seen:  %d of about %d\n", latencyCount,
+        rate * seconds);
+    if (latencyCount > 0)
+    {
+        printf("  Store-to-read latency:  %.2f us average, %.2f us median, "
+            "%.2f us 99th percentile, %.2f us worst\n",
+            latencySum / (double)latencyCount * 1.0E6,
+            latencies[latencyCount / 2] * 1.0E6,
+            latencies[latencyCount * 99 / 100] * 1.0E6,
+            latencies[latencyCount - 1] * 1.0E6);
+    }
+
+    // Time reading the newest sample of every tracker while the server
+    // keeps writing
+    missingCount = 0;
+    startTime = vsSharedInputData::getCurrentTime();
+    for (i = 0; i < INPUT_BENCH_READ_COUNT; i++)
+    {
+        if (!sharedData->retrieveData(i % trackerCount, &vector, &quat,
+            NULL))
+            missingCount++;
+        else if (!checkSample(vector, quat))
+            tornCount++;
+    }
+    newestTime = vsSharedInputData::getCurrentTime() - startTime;
+
+    // Time interpolating to a display time two updates in the past
+    startTime = vsSharedInputData::getCurrentTime();
+    for (i = 0; i < INPUT_BENCH_READ_COUNT; i++)
+    {
+        if (!sharedData->retrieveInterpolatedData(i % trackerCount,
+            vsSharedInputData::getCurrentTime() - 2.0 / (double)rate,
+            &vector, &quat))
+            missingCount++;
+    }
+    interpolatedTime = vsSharedInputData::getCurrentTime() - startTime;
+
+    // Report the read rates
+    printf("  retrieveData():              %8.2f M reads/s\n",
+        (double)INPUT_BENCH_READ_COUNT / newestTime / 1.0E6);
+    printf("  retrieveInterpolatedData():  %8.2f M reads/s\n",
+        (double)INPUT_BENCH_READ_COUNT / interpolatedTime / 1.0E6);
+
+    // Stop the server and clean up
+    kill(serverPID, SIGUSR1);
+    waitpid(serverPID, NULL, 0);
+    delete sharedData;
+    delete [] latencies;
+
+    // Fail if a read came back empty or mixed two samples together
+    if ((tornCount > 0) || (missingCount > 0) || (latencyCount == 0))
+    {
+        printf("FAILED:  %d torn reads, %d empty reads, %d samples seen\n",
+            tornCount, missingCount, latencyCount);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,328 @@
+//------------------------------------------------------------------------
+//
+//    VIRTUAL ENVIRONMENT SOFTWARE SANDBOX (VESS)
+//
+//    Copyright (c) 2001, University of Central Florida
+//
+//       See the file LICENSE for license information
+//
+//    E-mail:  vess@ist.ucf.edu
+//    WWW:     http://vess.ist.ucf.edu/
+//
+//------------------------------------------------------------------------
+//
+//    VESS Module:  skinBenchmark.c++
+//
+//    Description:  Benchmark for software skinning.  Skins a large
+//                  synthetic mesh with the original atArray-based
+//                  applySkin() and with the palette-based path (on one
+//                  thread and on the default thread pool), checks that
+//                  the results agree, and reports vertices per second.
+//
+//    Usage:        skinBenchmark [vertexCount [boneCount [iterations]]]
+//
+//    Author(s):    agent
+//
+//------------------------------------------------------------------------
+
+#include "vsSkeletonMeshGeometry.h++"
+#include "vsThreadPool.h++"
+#include "vsTimer.h++"
+#include "atArray.h++"
+#include "atMatrix.h++"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Largest difference allowed between the reference and palette results
+// (the palette path works in single precision)
+#define SKIN_BENCH_TOLERANCE    1.0E-3
+
+// ------------------------------------------------------------------------
+// Returns a random number in the range [low, high]
+// ------------------------------------------------------------------------
+double randomRange(double low, double high)
+{
+    return low + (high - low) * ((double)rand() / (double)RAND_MAX);
+}
+
+// ------------------------------------------------------------------------
+// Creates a skeleton mesh with the given number of vertices, each
+// influenced by up to four random bones
+// ------------------------------------------------------------------------
+vsSkeletonMeshGeometry *createMesh(int vertexCount, int boneCount)
+{
+    vsSkeletonMeshGeometry *mesh;
+    atVector normal, weights, bones;
+    double weightSum;
+    int i, j;
+
+    // Create the mesh as a point cloud (the primitives don't matter for
+    // skinning)
+    mesh = new vsSkeletonMeshGeometry();
+    mesh->ref();
+    mesh->beginNewState();
+    mesh->setPrimitiveType(VS_GEOMETRY_TYPE_POINTS);
+    mesh->setPrimitiveCount(vertexCount);
+
+    // Size the lists
+    mesh->setDataListSize(VS_GEOMETRY_VERTEX_COORDS, vertexCount);
+    mesh->setDataListSize(VS_GEOMETRY_NORMALS, vertexCount);
+    mesh->setDataListSize(VS_GEOMETRY_VERTEX_WEIGHTS, vertexCount);
+    mesh->setDataListSize(VS_GEOMETRY_BONE_INDICES, vertexCount);
+    mesh->setBinding(VS_GEOMETRY_NORMALS, VS_GEOMETRY_BIND_PER_VERTEX);
+    mesh->setBinding(VS_GEOMETRY_VERTEX_WEIGHTS,
+        VS_GEOMETRY_BIND_PER_VERTEX);
+    mesh->setBinding(VS_GEOMETRY_BONE_INDICES, VS_GEOMETRY_BIND_PER_VERTEX);
+
+    // Fill in the vertices
+    for (i = 0; i < vertexCount; i++)
+    {
+        // Random position and normal
+        mesh->setData(VS_GEOMETRY_VERTEX_COORDS, i,
+            atVector(randomRange(-1.0, 1.0), randomRange(-1.0, 1.0),
+            randomRange(0.0, 2.0)));
+        normal.set(randomRange(-1.0, 1.0), randomRange(-1.0, 1.0),
+            randomRange(-1.0, 1.0));
+        normal.normalize();
+        mesh->setData(VS_GEOMETRY_NORMALS, i, normal);
+
+        // Four random bones with weights that add up to one (some of the
+        // weights are zero, as they usually are in real meshes)
+        weights.setSize(4);
+        bones.setSize(4);
+        weightSum = 0.0;
+        for (j = 0; j < 4; j++)
+        {
+            if ((j == 0) || (rand() % 3 != 0))
+                weights[j] = randomRange(0.1, 1.0);
+            else
+                weights[j] = 0.0;
+            weightSum += weights[j];
+            bones[j] = (double)(rand() % boneCount);
+        }
+        for (j = 0; j < 4; j++)
+            weights[j] /= weightSum;
+        mesh->setData(VS_GEOMETRY_VERTEX_WEIGHTS, i, weights);
+        mesh->setData(VS_GEOMETRY_BONE_INDICES, i, bones);
+    }
+    mesh->finishNewState();
+
+    return mesh;
+}
+
+// ------------------------------------------------------------------------
+// Fills in the bone matrices (random rotations and translations), their
+// inverse transposes, and the flattened palettes that vsSkin would build
+// from them
+// ------------------------------------------------------------------------
+void createBones(int boneCount, atArray *boneMatrices,
+                 atArray *itBoneMatrices, float *palette, float *itPalette)
+{
+    atMatrix *boneMatrix, *itBoneMatrix;
+    atMatrix translation;
+    int i, row, col;
+
+    for (i = 0; i < boneCount; i++)
+    {
+        // Create a random rigid transform for the bone
+        boneMatrix = new atMatrix();
+        boneMatrix->setEulerRotation(AT_EULER_ANGLES_ZXY_R,
+            randomRange(-180.0, 180.0), randomRange(-90.0, 90.0),
+            randomRange(-180.0, 180.0));
+        translation.setTranslation(randomRange(-1.0, 1.0),
+            randomRange(-1.0, 1.0), randomRange(-1.0, 1.0));
+        *boneMatrix = translation * (*boneMatrix);
+
+        // Get its inverse transpose for the normals
+        itBoneMatrix = new atMatrix();
+        *itBoneMatrix = boneMatrix->getInverseRigid();
+        itBoneMatrix->transpose();
+
+        // Store them in the lists
+        boneMatrices->setEntry(i, boneMatrix);
+        itBoneMatrices->setEntry(i, itBoneMatrix);
+
+        // Flatten them into the palettes
+        for (row = 0; row < 3; row++)
+            for (col = 0; col < 4; col++)
+            {
+                palette[i * VS_SKIN_PALETTE_STRIDE + row * 4 + col] =
+                    (float)((*boneMatrix)[row][col]);
+                itPalette[i * VS_SKIN_PALETTE_STRIDE + row * 4 + col] =
+                    (float)((*itBoneMatrix)[row][col]);
+            }
+    }
+}
+
+// ------------------------------------------------------------------------
+// Copies the skinned vertices and normals out of the mesh
+// ------------------------------------------------------------------------
+void saveResult(vsSkeletonMeshGeometry *mesh, atVector *vertices,
+                atVector *normals)
+{
+    mesh->getDataList(VS_GEOMETRY_VERTEX_COORDS, vertices);
+    mesh->getDataList(VS_GEOMETRY_NORMALS, normals);
+}
+
+// ------------------------------------------------------------------------
+// Returns the largest difference between the mesh's current vertices and
+// normals and the given reference results
+// ------------------------------------------------------------------------
+double compareResult(vsSkeletonMeshGeometry *mesh, atVector *vertices,
+                     atVector *normals, atVector *scratch)
+{
+    double maxError;
+    int vertexCount;
+    int i, j;
+
+    vertexCount = mesh->getDataListSize(VS_GEOMETRY_VERTEX_COORDS);
+    maxError = 0.0;
+
+    // Compare the vertices
+    mesh->getDataList(VS_GEOMETRY_VERTEX_COORDS, scratch);
+    for (i = 0; i < vertexCount; i++)
+        for (j = 0; j < 3; j++)
+            if (fabs(scratch[i][j] - vertices[i][j]) > maxError)
+                maxError = fabs(scratch[i][j] - vertices[i][j]);
+
+    // Compare the normals
+    mesh->getDataList(VS_GEOMETRY_NORMALS, scratch);
+    for (i = 0; i < vertexCount; i++)
+        for (j = 0; j < 3; j++)
+            if (fabs(scratch[i][j] - normals[i][j]) > maxError)
+                maxError = fabs(scratch[i][j] - normals[i][j]);
+
+    return maxError;
+}
+
+// ------------------------------------------------------------------------
+// Prints the time taken by one of the skinning paths
+// ------------------------------------------------------------------------
+void report(const char *name, double seconds, int iterations,
+            int vertexCount, double referenceSeconds)
+{
+    double verticesPerSecond;
+
+    verticesPerSecond = (double)vertexCount * (double)iterations / seconds;
+    printf("  %-28s %9.3f ms/skin  %8.2f Mvertices/s  %6.2fx\n", name,
+        seconds * 1000.0 / (double)iterations, verticesPerSecond / 1.0E6,
+        referenceSeconds / seconds);
+}
+
+// ------------------------------------------------------------------------
+// Main program
+// ------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    int vertexCount, boneCount, iterations;
+    vsSkeletonMeshGeometry *mesh;
+    atArray *boneMatrices, *itBoneMatrices;
+    float *palette, *itPalette;
+    atVector *referenceVertices, *referenceNormals, *scratch;
+    vsTimer *timer;
+    double referenceTime, serialTime, parallelTime;
+    double serialError, parallelError;
+    int i;
+
+    // Get the benchmark settings from the command line
+    vertexCount = 200000;
+    boneCount = 64;
+    iterations = 20;
+    if (argc > 1)
+        vertexCount = atoi(argv[1]);
+    if (argc > 2)
+        boneCount = atoi(argv[2]);
+    if (argc > 3)
+        iterations = atoi(argv[3]);
+    if ((vertexCount < 1) || (boneCount < 1) || (iterations < 1))
+    {
+        printf("Usage:  %s [vertexCount [boneCount [iterations]]]\n",
+            argv[0]);
+        return 1;
+    }
+
+    // Create the mesh and the bones
+    srand(1);
+    mesh = createMesh(vertexCount, boneCount);
+    boneMatrices = new atArray();
+    itBoneMatrices = new atArray();
+    palette = new float[boneCount * VS_SKIN_PALETTE_STRIDE];
+    itPalette = new float[boneCount * VS_SKIN_PALETTE_STRIDE];
+    createBones(boneCount, boneMatrices, itBoneMatrices, palette, itPalette);
+
+    // Create space for the reference results
+    referenceVertices = new atVector[vertexCount];
+    referenceNormals = new atVector[vertexCount];
+    scratch = new atVector[vertexCount];
+
+    printf("Skinning %d vertices with %d bones, %d iterations, "
+        "%d pool threads\n", vertexCount, boneCount, iterations,
+        vsThreadPool::getDefaultPool()->getThreadCount());
+
+    // Time the original skinning path, and keep its results as the
+    // reference
+    timer = new vsTimer();
+    timer->mark();
+    for (i = 0; i < iterations; i++)
+        mesh->applySkin(boneMatrices, itBoneMatrices);
+    referenceTime = timer->getElapsed();
+    saveResult(mesh, referenceVertices, referenceNormals);
+
+    // Time the palette path on this thread only (building the skinning
+    // data isn't part of the time, since it's only done once)
+    mesh->resetSkin();
+    mesh->prepareSkin(boneCount);
+    timer->mark();
+    for (i = 0; i < iterations; i++)
+    {
+        mesh->skinVertices(palette, itPalette, 0,
+            mesh->getSkinVertexCount());
+        mesh->finishSkin();
+    }
+    serialTime = timer->getElapsed();
+    serialError = compareResult(mesh, referenceVertices, referenceNormals,
+        scratch);
+
+    // Time the palette path on the thread pool
+    mesh->resetSkin();
+    timer->mark();
+    for (i = 0; i < iterations; i++)
+        mesh->applySkin(palette, itPalette, boneCount);
+    parallelTime = timer->getElapsed();
+    parallelError = compareResult(mesh, referenceVertices, referenceNormals,
+        scratch);
+
+    // Report the results
+    report("applySkin (atArray)", referenceTime, iterations, vertexCount,
+        referenceTime);
+    report("palette, one thread", serialTime, iterations, vertexCount,
+        referenceTime);
+    report("palette, thread pool", parallelTime, iterations, vertexCount,
+        referenceTime);
+    printf("  Largest difference from reference:  %g (one thread), "
+        "%g (thread pool)\n", serialError, parallelError);
+
+    // Clean up
+    delete timer;
+    delete [] referenceVertices;
+    delete [] referenceNormals;
+    delete [] scratch;
+    delete [] palette;
+    delete [] itPalette;
+    delete boneMatrices;
+    delete itBoneMatrices;
+    vsObject::unrefDelete(mesh);
+    vsThreadPool::deleteDefaultPool();
+
+    // Fail if the palette path doesn't match the reference
+    if ((serialError > SKIN_BENCH_TOLERANCE) ||
+        (parallelError > SKIN_BENCH_TOLERANCE))
+    {
+        printf("FAILED:  palette skinning doesn't match the reference\n");
+        return 1;
+    }
+
+    return 0;
+}
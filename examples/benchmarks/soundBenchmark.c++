@@ -0,0 +1,375 @@
+//------------------------------------------------------------------------
+//
+//    VIRTUAL ENVIRONMENT SOFTWARE SANDBOX (VESS)
+//
+//    Copyright (c) 2001, University of Central Florida
+//
+//       See the file LICENSE for license information
+//
+//    E-mail:  vess@ist.ucf.edu
+//    WWW:     http://vess.ist.ucf.edu/
+//
+//------------------------------------------------------------------------
+//
+//    VESS Module:  soundBenchmark.c++
+//
+//    Description:  Headless benchmark for vsSoundManager with thousands
+//                  of sound sources.  Opens OpenAL Soft's null output
+//                  device (so no sound hardware is needed), scatters
+//                  looping and streaming sources around a moving
+//                  listener, and times creating the sources, the
+//                  per-frame voice management in update(), refilling
+//                  the streams, and removing the sources.  Checks that
+//                  the voices went to the loudest sources.
+//
+//    Usage:        soundBenchmark [sourceCount [frames [voiceLimit]]]
+//
+//    Author(s):    agent
+//
+//------------------------------------------------------------------------
+
+#include "vsComponent.h++"
+#include "vsTransformAttribute.h++"
+#include "vsSoundManager.h++"
+#include "vsSoundPipe.h++"
+#include "vsSoundSample.h++"
+#include "vsSoundStream.h++"
+#include "vsSoundSourceAttribute.h++"
+#include "vsSoundListenerAttribute.h++"
+#include "vsTimer.h++"
+#include "atMatrix.h++"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+
+// Format of the generated sample (and the streamed audio)
+#define SOUND_BENCH_FREQUENCY       22050
+#define SOUND_BENCH_SAMPLE_COUNT    22050
+
+// Size of each chunk of streamed audio, in bytes
+#define SOUND_BENCH_CHUNK_SIZE      4096
+
+// One in this many sources is a streaming source
+#define SOUND_BENCH_STREAM_RATIO    16
+
+// Sources are scattered over a square this many meters across (far
+// enough that the most distant ones are culled)
+#define SOUND_BENCH_AREA_SIZE       4000.0
+
+// ------------------------------------------------------------------------
+// Returns a random number in the range [low, high]
+// ------------------------------------------------------------------------
+double randomRange(double low, double high)
+{
+    return low + (high - low) * ((double)rand() / (double)RAND_MAX);
+}
+
+// ------------------------------------------------------------------------
+// Writes an integer to the file, least significant byte first
+// ------------------------------------------------------------------------
+void writeLittleEndian(FILE *file, unsigned int value, int byteCount)
+{
+    int i;
+
+    for (i = 0; i < byteCount; i++)
+        fputc((value >> (i * 8)) & 0xFF, file);
+}
+
+// ------------------------------------------------------------------------
+// Fills the buffer with a 16-bit mono tone
+// ------------------------------------------------------------------------
+void createTone(short *samples, int count)
+{
+    int i;
+
+    for (i = 0; i < count; i++)
+        samples[i] = (short)(8000.0 * sin(2.0 * M_PI * 440.0 * (double)i /
+            (double)SOUND_BENCH_FREQUENCY));
+}
+
+// ------------------------------------------------------------------------
+// Writes a one-second tone to a 16-bit mono WAV file, so there's a
+// sample to load without needing any data files
+// ------------------------------------------------------------------------
+bool writeToneFile(char *fileName)
+{
+    FILE *file;
+    short *samples;
+    int dataSize;
+    int i;
+
+    // Open the file
+    file = fopen(fileName, "wb");
+    if (file == NULL)
+        return false;
+
+    // Write the RIFF header and the format chunk
+    dataSize = SOUND_BENCH_SAMPLE_COUNT * 2;
+    fwrite("RIFF", 1, 4, file);
+    writeLittleEndian(file, 36 + dataSize, 4);
+    fwrite("WAVEfmt ", 1, 8, file);
+    writeLittleEndian(file, 16, 4);
+    writeLittleEndian(file, 1, 2);
+    writeLittleEndian(file, 1, 2);
+    writeLittleEndian(file, SOUND_BENCH_FREQUENCY, 4);
+    writeLittleEndian(file, SOUND_BENCH_FREQUENCY * 2, 4);
+    writeLittleEndian(file, 2, 2);
+    writeLittleEndian(file, 16, 2);
+
+    // Write the samples
+    samples = new short[SOUND_BENCH_SAMPLE_COUNT];
+    createTone(samples, SOUND_BENCH_SAMPLE_COUNT);
+    fwrite("data", 1, 4, file);
+    writeLittleEndian(file, dataSize, 4);
+    for (i = 0; i < SOUND_BENCH_SAMPLE_COUNT; i++)
+        writeLittleEndian(file, (unsigned short)samples[i], 2);
+
+    // Clean up
+    delete [] samples;
+    fclose(file);
+    return true;
+}
+
+// ------------------------------------------------------------------------
+// Creates a component at the given position, with a transform attribute
+// to move it around, and adds it to the parent
+// ------------------------------------------------------------------------
+vsComponent *createComponent(vsComponent *parent, double x, double y,
+                             vsTransformAttribute **transform)
+{
+    vsComponent *component;
+    atMatrix position;
+
+    // Create the component and its transform
+    component = new vsComponent();
+    *transform = new vsTransformAttribute();
+    component->addAttribute(*transform);
+    position.setTranslation(x, y, 0.0);
+    (*transform)->setDynamicTransform(position);
+
+    // Put it in the scene
+    parent->addChild(component);
+    return component;
+}
+
+// ------------------------------------------------------------------------
+// Main program
+// ------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    int sourceCount, frames, voiceLimit;
+    char toneFile[32];
+    int toneDescriptor;
+    vsSoundPipe *soundPipe;
+    vsSoundSample *sample;
+    vsComponent *scene, *component, *listenerComponent;
+    vsTransformAttribute *transform, *listenerTransform;
+    vsSoundListenerAttribute *listener;
+    vsSoundSourceAttribute **sources;
+    vsSoundStream **streams;
+    int streamCount;
+    short *toneChunk;
+    void *chunks[VS_SS_BUFFER_COUNT];
+    atMatrix listenerPosition;
+    atVector listenerPos;
+    vsTimer *timer, *frameTimer;
+    double createTime, updateTime, maxUpdateTime, refillTime, removeTime;
+    double frameTime;
+    double gain, minActiveGain, maxInactiveGain;
+    int activeCount;
+    int frame;
+    int i;
+
+    // Get the benchmark settings from the command line
+    sourceCount = 4000;
+    frames = 300;
+    voiceLimit = VS_SDM_DEFAULT_VOICE_LIMIT;
+    if (argc > 1)
+        sourceCount = atoi(argv[1]);
+    if (argc > 2)
+        frames = atoi(argv[2]);
+    if (argc > 3)
+        voiceLimit = atoi(argv[3]);
+    if ((sourceCount < 1) || (frames < 1) || (voiceLimit < 1))
+    {
+        printf("Usage:  %s [sourceCount [frames [voiceLimit]]]\n", argv[0]);
+        return 1;
+    }
+
+    // Use OpenAL Soft's null output device, unless the user picked a
+    // different driver, so this runs without sound hardware
+    setenv("ALSOFT_DRIVERS", "null", 0);
+
+    // Generate a tone to use for the looping sources
+    strcpy(toneFile, "/tmp/soundBenchXXXXXX.wav");
+    toneDescriptor = mkstemps(toneFile, 4);
+    if (toneDescriptor == -1)
+    {
+        printf("Unable to create a temporary file\n");
+        return 1;
+    }
+    close(toneDescriptor);
+    if (!writeToneFile(toneFile))
+    {
+        printf("Unable to write %s\n", toneFile);
+        unlink(toneFile);
+        return 1;
+    }
+
+    // Open the audio device and load the tone
+    soundPipe = new vsSoundPipe();
+    soundPipe->ref();
+    sample = new vsSoundSample(toneFile);
+    sample->ref();
+    unlink(toneFile);
+
+    // Create a chunk of the tone to stream
+    toneChunk = new short[SOUND_BENCH_CHUNK_SIZE / 2];
+    createTone(toneChunk, SOUND_BENCH_CHUNK_SIZE / 2);
+    for (i = 0; i < VS_SS_BUFFER_COUNT; i++)
+        chunks[i] = toneChunk;
+
+    // Set the voice limit (the manager clamps it to what the device can
+    // do)
+    vsSoundManager::getInstance()->setVoiceLimit(voiceLimit);
+    voiceLimit = vsSoundManager::getInstance()->getVoiceLimit();
+
+    // Create the scene, with the listener in the middle
+    scene = new vsComponent();
+    scene->ref();
+    listenerComponent = createComponent(scene, 0.0, 0.0,
+        &listenerTransform);
+    listener = new vsSoundListenerAttribute();
+    listenerComponent->addAttribute(listener);
+
+    printf("%d sources (%d streaming), voice limit %d, %d frames\n",
+        sourceCount, (sourceCount + SOUND_BENCH_STREAM_RATIO - 1) /
+        SOUND_BENCH_STREAM_RATIO, voiceLimit, frames);
+
+    // Create the sources, scattered around the listener, and start them
+    // all playing
+    sources = new vsSoundSourceAttribute *[sourceCount];
+    streams = new vsSoundStream *[sourceCount];
+    streamCount = 0;
+    srand(1);
+    timer = new vsTimer();
+    timer->mark();
+    for (i = 0; i < sourceCount; i++)
+    {
+        component = createComponent(scene,
+            randomRange(-SOUND_BENCH_AREA_SIZE / 2.0,
+                SOUND_BENCH_AREA_SIZE / 2.0),
+            randomRange(-SOUND_BENCH_AREA_SIZE / 2.0,
+                SOUND_BENCH_AREA_SIZE / 2.0), &transform);
+
+        // Every so often, make a streaming source
+        if (i % SOUND_BENCH_STREAM_RATIO == 0)
+        {
+            streams[streamCount] = new vsSoundStream(SOUND_BENCH_CHUNK_SIZE,
+                VS_SS_FORMAT_MONO16, SOUND_BENCH_FREQUENCY);
+            sources[i] = new vsSoundSourceAttribute(streams[streamCount]);
+            streamCount++;
+        }
+        else
+            sources[i] = new vsSoundSourceAttribute(sample, true);
+
+        component->addAttribute(sources[i]);
+        sources[i]->play();
+    }
+    createTime = timer->getElapsed();
+
+    // Run the frames, moving the listener around the area
+    updateTime = 0.0;
+    maxUpdateTime = 0.0;
+    refillTime = 0.0;
+    frameTimer = new vsTimer();
+    for (frame = 0; frame < frames; frame++)
+    {
+        // Start the frame
+        vsTimer::getSystemTimer()->mark();
+
+        // Move the listener in a circle
+        listenerPosition.setTranslation(
+            SOUND_BENCH_AREA_SIZE / 4.0 * cos(2.0 * M_PI * frame / frames),
+            SOUND_BENCH_AREA_SIZE / 4.0 * sin(2.0 * M_PI * frame / frames),
+            0.0);
+        listenerTransform->setDynamicTransform(listenerPosition);
+
+        // Refill the streams, as a decoder would
+        timer->mark();
+        for (i = 0; i < streamCount; i++)
+        {
+            if (streams[i]->isBufferReady())
+                streams[i]->queueBuffers(chunks, VS_SS_BUFFER_COUNT);
+        }
+        refillTime += timer->getElapsed();
+
+        // Update the sources and do the voice management
+        frameTimer->mark();
+        vsSoundManager::getInstance()->update();
+        frameTime = frameTimer->getElapsed();
+        updateTime += frameTime;
+        if (frameTime > maxUpdateTime)
+            maxUpdateTime = frameTime;
+    }
+
+    // Check that the voices went to the loudest of the looping sources
+    // (the streaming sources may have run dry, so they're left out)
+    listenerPos = listener->getLastPosition();
+    activeCount = 0;
+    minActiveGain = 1.0E9;
+    maxInactiveGain = 0.0;
+    for (i = 0; i < sourceCount; i++)
+    {
+        if (sources[i]->isActive())
+            activeCount++;
+        if ((sources[i]->isStreaming()) || (!sources[i]->isPlaying()))
+            continue;
+
+        gain = sources[i]->getEffectiveGain(listenerPos);
+        if ((sources[i]->isActive()) && (gain < minActiveGain))
+            minActiveGain = gain;
+        else if ((!sources[i]->isActive()) && (gain > maxInactiveGain))
+            maxInactiveGain = gain;
+    }
+
+    // Report the results
+    printf("  Create and start sources:  %9.2f ms\n", createTime * 1000.0);
+    printf("  Manager update:            %9.3f ms/frame average, %.3f ms "
+        "worst\n", updateTime * 1000.0 / (double)frames,
+        maxUpdateTime * 1000.0);
+    printf("  Stream refills:            %9.3f ms/frame\n",
+        refillTime * 1000.0 / (double)frames);
+    printf("  Active voices:  %d (quietest %g, loudest left out %g)\n",
+        activeCount, minActiveGain, maxInactiveGain);
+
+    // Time removing all of the sources
+    timer->mark();
+    scene->deleteTree();
+    removeTime = timer->getElapsed();
+    printf("  Remove sources:            %9.2f ms\n", removeTime * 1000.0);
+
+    // Clean up
+    vsObject::unrefDelete(scene);
+    vsObject::unrefDelete(sample);
+    delete [] sources;
+    delete [] streams;
+    delete [] toneChunk;
+    delete timer;
+    delete frameTimer;
+    vsObject::unrefDelete(soundPipe);
+    vsSoundManager::deleteInstance();
+    vsTimer::deleteSystemTimer();
+
+    // Fail if too many voices were handed out, or a louder source was
+    // left without one
+    if ((activeCount > voiceLimit) || (minActiveGain < maxInactiveGain))
+    {
+        printf("FAILED:  voices weren't given to the loudest sources\n");
+        return 1;
+    }
+
+    return 0;
+}
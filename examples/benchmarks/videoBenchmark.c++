@@ -0,0 +1,383 @@
+//------------------------------------------------------------------------
+//
+//    VIRTUAL ENVIRONMENT SOFTWARE SANDBOX (VESS)
+//
+//    Copyright (c) 2001, University of Central Florida
+//
+//       See the file LICENSE for license information
+//
+//    E-mail:  vess@ist.ucf.edu
+//    WWW:     http://vess.ist.ucf.edu/
+//
+//------------------------------------------------------------------------
+//
+//    VESS Module:  videoBenchmark.c++
+//
+//    Description:  Throughput benchmark for the video path (1080p by
+//                  default).  Times vsChromaKey's createAlphaFromColor()
+//                  and combineImages() against a plain per-pixel loop for
+//                  each key equation and checks that the results match.
+//                  Then pushes frames through a vsVideoQueue to several
+//                  consumers, once with the copying enqueue()/dequeue()
+//                  calls and once by filling and leasing the frame slots
+//                  in place, and reports frames per second for each.
+//
+//    Usage:        videoBenchmark [width height [frames]]
+//
+//    Author(s):    agent
+//
+//------------------------------------------------------------------------
+
+#include "vsChromaKey.h++"
+#include "vsVideoQueue.h++"
+#include "vsThreadPool.h++"
+#include "vsTimer.h++"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Key color and threshold used for the chroma key tests
+#define VIDEO_BENCH_KEY_RED        20
+#define VIDEO_BENCH_KEY_GREEN      40
+#define VIDEO_BENCH_KEY_BLUE       220
+#define VIDEO_BENCH_THRESHOLD      60
+
+// Number of consumers reading from the video queue, and the number of
+// frames the queue holds
+#define VIDEO_BENCH_CONSUMERS      3
+#define VIDEO_BENCH_QUEUE_FRAMES   4
+
+// Names of the key equations, for the report
+static const char *equationNames[3] =
+{
+    "DIFF_SUM",
+    "DIFF_SUM_SQUARED",
+    "DIFF_LARGEST"
+};
+
+// ------------------------------------------------------------------------
+// Returns the difference between the given color and the key color, the
+// same way the original per-pixel chroma key did
+// ------------------------------------------------------------------------
+int referenceDifference(vsChromaKeyEquationType equation,
+                        unsigned char red, unsigned char green,
+                        unsigned char blue)
+{
+    int dr, dg, db;
+
+    // Get the difference in each channel
+    dr = abs(red - VIDEO_BENCH_KEY_RED);
+    dg = abs(green - VIDEO_BENCH_KEY_GREEN);
+    db = abs(blue - VIDEO_BENCH_KEY_BLUE);
+
+    // Combine them according to the equation
+    switch (equation)
+    {
+        case VS_CHROMAKEY_DIFF_SUM:
+            return dr + dg + db;
+
+        case VS_CHROMAKEY_DIFF_SUM_SQUARED:
+            return dr * dr + dg * dg + db * db;
+
+        case VS_CHROMAKEY_DIFF_LARGEST:
+        default:
+            if ((dr >= dg) && (dr >= db))
+                return dr;
+            else if (dg >= db)
+                return dg;
+            else
+                return db;
+    }
+}
+
+// ------------------------------------------------------------------------
+// Creates an RGBA image from an RGB image with a plain per-pixel loop
+// ------------------------------------------------------------------------
+void referenceCreateAlpha(vsChromaKeyEquationType equation, int threshold,
+                          unsigned char *input, int pixelCount,
+                          unsigned char *output)
+{
+    int i;
+
+    for (i = 0; i < pixelCount; i++)
+    {
+        output[i * 4] = input[i * 3];
+        output[i * 4 + 1] = input[i * 3 + 1];
+        output[i * 4 + 2] = input[i * 3 + 2];
+        if (referenceDifference(equation, input[i * 3], input[i * 3 + 1],
+            input[i * 3 + 2]) <= threshold)
+            output[i * 4 + 3] = 0;
+        else
+            output[i * 4 + 3] = 255;
+    }
+}
+
+// ------------------------------------------------------------------------
+// Keys a foreground RGB image over a background with a plain per-pixel
+// loop
+// ------------------------------------------------------------------------
+void referenceCombine(vsChromaKeyEquationType equation, int threshold,
+                      unsigned char *foreground, unsigned char *background,
+                      int pixelCount, unsigned char *output)
+{
+    unsigned char *source;
+    int i;
+
+    for (i = 0; i < pixelCount; i++)
+    {
+        if (referenceDifference(equation, foreground[i * 3],
+            foreground[i * 3 + 1], foreground[i * 3 + 2]) <= threshold)
+            source = &background[i * 3];
+        else
+            source = &foreground[i * 3];
+        output[i * 3] = source[0];
+        output[i * 3 + 1] = source[1];
+        output[i * 3 + 2] = source[2];
+    }
+}
+
+// ------------------------------------------------------------------------
+// Fills in a foreground image that's about half "blue screen" (colors
+// scattered around the key color) and half random colors, and a random
+// background image
+// ------------------------------------------------------------------------
+void createImages(int pixelCount, unsigned char *foreground,
+                  unsigned char *background)
+{
+    int i;
+
+    for (i = 0; i < pixelCount * 3; i++)
+        background[i] = (unsigned char)(rand() % 256);
+
+    for (i = 0; i < pixelCount; i++)
+    {
+        if (rand() % 2)
+        {
+            foreground[i * 3] = VIDEO_BENCH_KEY_RED + rand() % 41 - 20;
+            foreground[i * 3 + 1] = VIDEO_BENCH_KEY_GREEN + rand() % 41 - 20;
+            foreground[i * 3 + 2] = VIDEO_BENCH_KEY_BLUE + rand() % 41 - 20;
+        }
+        else
+        {
+            foreground[i * 3] = (unsigned char)(rand() % 256);
+            foreground[i * 3 + 1] = (unsigned char)(rand() % 256);
+            foreground[i * 3 + 2] = (unsigned char)(rand() % 256);
+        }
+    }
+}
+
+// ------------------------------------------------------------------------
+// Prints the time taken by one of the chroma key runs
+// ------------------------------------------------------------------------
+void report(const char *name, double seconds, int frames, int pixelCount,
+            double referenceSeconds)
+{
+    printf("    %-24s %8.3f ms/frame  %8.1f fps  %8.1f Mpixels/s  %6.2fx\n",
+        name, seconds * 1000.0 / (double)frames,
+        (double)frames / seconds,
+        (double)pixelCount * (double)frames / seconds / 1.0E6,
+        referenceSeconds / seconds);
+}
+
+// ------------------------------------------------------------------------
+// Main program
+// ------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    int width, height, frames;
+    int pixelCount;
+    unsigned char *foreground, *background;
+    unsigned char *referenceOutput, *output;
+    vsChromaKey *chromaKey;
+    vsVideoQueue *queue;
+    vsVideoFrame *frame;
+    int consumerID[VIDEO_BENCH_CONSUMERS];
+    unsigned char *consumerImage;
+    unsigned char *slot;
+    vsTimer *timer;
+    double referenceTime, keyTime, copyTime, leaseTime;
+    double timestamp;
+    int equation;
+    int frameNumber, consumer;
+    int mismatches, missedFrames;
+    int i;
+
+    // Get the benchmark settings from the command line
+    width = 1920;
+    height = 1080;
+    frames = 100;
+    if (argc > 2)
+    {
+        width = atoi(argv[1]);
+        height = atoi(argv[2]);
+    }
+    if (argc > 3)
+        frames = atoi(argv[3]);
+    if ((argc == 2) || (width < 1) || (height < 1) || (frames < 1))
+    {
+        printf("Usage:  %s [width height [frames]]\n", argv[0]);
+        return 1;
+    }
+
+    // Create the images
+    srand(1);
+    pixelCount = width * height;
+    foreground = new unsigned char[pixelCount * 3];
+    background = new unsigned char[pixelCount * 3];
+    referenceOutput = new unsigned char[pixelCount * 4];
+    output = new unsigned char[pixelCount * 4];
+    createImages(pixelCount, foreground, background);
+
+    printf("%dx%d frames, %d frames per test, %d pool threads\n", width,
+        height, frames, vsThreadPool::getDefaultPool()->getThreadCount());
+
+    // Set up the chroma key
+    chromaKey = new vsChromaKey();
+    chromaKey->ref();
+    chromaKey->setKeyColor(VIDEO_BENCH_KEY_RED, VIDEO_BENCH_KEY_GREEN,
+        VIDEO_BENCH_KEY_BLUE);
+    timer = new vsTimer();
+    mismatches = 0;
+
+    // Try each key equation
+    for (equation = 0; equation < 3; equation++)
+    {
+        printf("  %s:\n", equationNames[equation]);
+        chromaKey->setEquationType((vsChromaKeyEquationType)equation,
+            VIDEO_BENCH_THRESHOLD);
+
+        // Time creating the alpha channel with the plain loop and with
+        // vsChromaKey, and compare the results
+        timer->mark();
+        for (i = 0; i < frames; i++)
+            referenceCreateAlpha((vsChromaKeyEquationType)equation,
+                VIDEO_BENCH_THRESHOLD, foreground, pixelCount,
+                referenceOutput);
+        referenceTime = timer->getElapsed();
+        timer->mark();
+        for (i = 0; i < frames; i++)
+            chromaKey->createAlphaFromColor(foreground, width, height,
+                output);
+        keyTime = timer->getElapsed();
+        report("per-pixel alpha", referenceTime, frames, pixelCount,
+            referenceTime);
+        report("createAlphaFromColor", keyTime, frames, pixelCount,
+            referenceTime);
+        if (memcmp(referenceOutput, output, pixelCount * 4) != 0)
+        {
+            printf("    createAlphaFromColor() doesn't match\n");
+            mismatches++;
+        }
+
+        // Do the same for combining the images
+        timer->mark();
+        for (i = 0; i < frames; i++)
+            referenceCombine((vsChromaKeyEquationType)equation,
+                VIDEO_BENCH_THRESHOLD, foreground, background, pixelCount,
+                referenceOutput);
+        referenceTime = timer->getElapsed();
+        timer->mark();
+        for (i = 0; i < frames; i++)
+            chromaKey->combineImages(foreground, background, width, height,
+                output);
+        keyTime = timer->getElapsed();
+        report("per-pixel combine", referenceTime, frames, pixelCount,
+            referenceTime);
+        report("combineImages", keyTime, frames, pixelCount,
+            referenceTime);
+        if (memcmp(referenceOutput, output, pixelCount * 3) != 0)
+        {
+            printf("    combineImages() doesn't match\n");
+            mismatches++;
+        }
+    }
+
+    // Create a video queue with a few consumers
+    printf("  vsVideoQueue, %d consumers:\n", VIDEO_BENCH_CONSUMERS);
+    queue = new vsVideoQueue(width, height, VIDEO_BENCH_QUEUE_FRAMES);
+    queue->ref();
+    for (consumer = 0; consumer < VIDEO_BENCH_CONSUMERS; consumer++)
+        consumerID[consumer] = queue->addReference();
+    consumerImage = new unsigned char[queue->getBytesPerImage()];
+    missedFrames = 0;
+
+    // Time passing frames through the copying interface (the producer
+    // copies each image in, and each consumer copies it back out)
+    timer->mark();
+    for (frameNumber = 0; frameNumber < frames; frameNumber++)
+    {
+        // Tag the image with its frame number and queue it
+        foreground[0] = (unsigned char)frameNumber;
+        queue->enqueue((char *)foreground, (double)frameNumber);
+
+        // Have each consumer read it
+        for (consumer = 0; consumer < VIDEO_BENCH_CONSUMERS; consumer++)
+        {
+            if ((!queue->dequeue((char *)consumerImage, &timestamp,
+                consumerID[consumer])) ||
+                (consumerImage[0] != (unsigned char)frameNumber))
+                missedFrames++;
+        }
+    }
+    copyTime = timer->getElapsed();
+
+    // Time passing frames through the frame slots in place (the producer
+    // writes each image straight into a slot, as a decoder or camera
+    // would, and each consumer leases it without copying)
+    timer->mark();
+    for (frameNumber = 0; frameNumber < frames; frameNumber++)
+    {
+        // Fill a slot with the tagged image and commit it
+        slot = queue->acquireWriteFrame();
+        if (slot == NULL)
+        {
+            missedFrames++;
+            continue;
+        }
+        memcpy(slot, foreground, queue->getBytesPerImage());
+        slot[0] = (unsigned char)frameNumber;
+        queue->commitWriteFrame((double)frameNumber);
+
+        // Have each consumer lease it, look at it, and release it
+        for (consumer = 0; consumer < VIDEO_BENCH_CONSUMERS; consumer++)
+        {
+            frame = queue->leaseFrame(consumerID[consumer]);
+            if ((frame == NULL) ||
+                (frame->data[0] != (unsigned char)frameNumber))
+                missedFrames++;
+            queue->releaseFrame(frame);
+        }
+    }
+    leaseTime = timer->getElapsed();
+
+    // Report the queue results
+    printf("    %-24s %8.3f ms/frame  %8.1f fps\n", "enqueue()/dequeue()",
+        copyTime * 1000.0 / (double)frames, (double)frames / copyTime);
+    printf("    %-24s %8.3f ms/frame  %8.1f fps  %6.2fx\n",
+        "acquire/commit/lease", leaseTime * 1000.0 / (double)frames,
+        (double)frames / leaseTime, copyTime / leaseTime);
+
+    // Clean up
+    for (consumer = 0; consumer < VIDEO_BENCH_CONSUMERS; consumer++)
+        queue->yieldReference(consumerID[consumer]);
+    vsObject::unrefDelete(queue);
+    vsObject::unrefDelete(chromaKey);
+    delete timer;
+    delete [] consumerImage;
+    delete [] foreground;
+    delete [] background;
+    delete [] referenceOutput;
+    delete [] output;
+    vsThreadPool::deleteDefaultPool();
+
+    // Fail if the chroma key results were wrong, or a consumer missed a
+    // frame
+    if ((mismatches > 0) || (missedFrames > 0))
+    {
+        printf("FAILED:  %d chroma key mismatches, %d missed frames\n",
+            mismatches, missedFrames);
+        return 1;
+    }
+
+    return 0;
+}
@@ -41,6 +41,7 @@
 #include "vsGLSLShader.h++"
 #include "vsGLSLUniform.h++"
 #include "vsOptimizer.h++"
+#include "vsSceneCache.h++"
 #include "atList.h++"
 #include "atString.h++"
 #include "atStringTokenizer.h++"
@@ -49,6 +50,7 @@
 #include <osgDB/Registry>
 #include <osgDB/ReadFile>
 #include <osgDB/WriteFile>
+#include <osgDB/FileUtils>
 #include <osg/LOD>
 #include <osg/Sequence>
 #include <osgSim/MultiSwitch>
@@ -307,6 +309,11 @@ bool vsDatabaseLoader::getLoaderMode(int whichMode)
 // given named database file. The database file must have an extension
 // that was added as a valid extension to the vsSystem object before
 // init() was called.
+//
+// If the scene cache mode is enabled, the converted scene is also stored
+// in a cache file next to the database file, and later loads of the same
+// database (with the same loader settings) are read from the cache
+// instead, as long as the database file hasn't changed.
 // ------------------------------------------------------------------------
 vsComponent *vsDatabaseLoader::loadDatabase(char *databaseFilename)
 {
@@ -316,6 +323,66 @@ vsComponent *vsDatabaseLoader::loadDatabase(char *databaseFilename)
     osg::Node *osgScene;
     vsObjectMap *nodeMap, *attrMap;
     vsOptimizer *optimizer;
+    std::string sourceFile;
+    atString cacheFile;
+    int cacheValidation;
+    u_int cacheKey;
+    vsSceneCache *sceneCache;
+
+    // See if we can load the scene from its cache
+    sceneCache = NULL;
+    if (loaderModes & VS_DATABASE_MODE_SCENE_CACHE)
+    {
+        // Find the database file on the search path (there's no point in
+        // caching a file that can't be found)
+        sourceFile = osgDB::findDataFile(databaseFilename);
+        if (!sourceFile.empty())
+        {
+            // Figure out how the cache is validated, and which settings
+            // it must have been created with
+            cacheFile = vsSceneCache::getCacheFilename(sourceFile.c_str());
+            if (loaderModes & VS_DATABASE_MODE_CACHE_HASH)
+                cacheValidation = VS_SCENE_CACHE_VALIDATE_HASH;
+            else
+                cacheValidation = VS_SCENE_CACHE_VALIDATE_TIMESTAMP;
+            cacheKey = getCacheSettingsKey();
+
+            // Try to read the scene from the cache
+            sceneCache = new vsSceneCache();
+            sceneCache->ref();
+            if (sceneCache->beginRead(cacheFile.getString(),
+                sourceFile.c_str(), cacheValidation, cacheKey))
+            {
+                // Read the scene, and keep it around past the end of the
+                // read
+                dbRoot = sceneCache->readNode();
+                if (dbRoot != NULL)
+                    dbRoot->ref();
+
+                // Use the scene if it was read successfully
+                if ((sceneCache->finishRead()) && (dbRoot != NULL))
+                {
+                    // Done with the cache
+                    vsObject::unrefDelete(sceneCache);
+
+                    // Package the database into its own component, and
+                    // return it
+                    result = new vsComponent();
+                    result->addChild(dbRoot);
+                    dbRoot->unref();
+                    return result;
+                }
+
+                // Get rid of whatever we read, and load the database
+                // normally
+                if (dbRoot != NULL)
+                {
+                    dbRoot->deleteTree();
+                    vsObject::unrefDelete(dbRoot);
+                }
+            }
+        }
+    }
 
     // Create a ReaderWriter options object to tell OSG that we want any
     // .dds files we load to be flipped vertically (this accounts for the
@@ -330,6 +397,8 @@ vsComponent *vsDatabaseLoader::loadDatabase(char *databaseFilename)
     {
         printf("vsDatabaseLoader::loadDatabase: Load of '%s' failed\n",
             databaseFilename);
+        if (sceneCache != NULL)
+            vsObject::unrefDelete(sceneCache);
         return NULL;
     }
     osgScene->ref();
@@ -368,6 +437,22 @@ vsComponent *vsDatabaseLoader::loadDatabase(char *databaseFilename)
     optimizer->optimize(dbRoot);
     delete optimizer;
 
+    // Store the new scene in the cache if we're caching it.  If the
+    // scene contains anything the cache can't store, the cache file
+    // simply isn't written.
+    if (sceneCache != NULL)
+    {
+        if (sceneCache->beginWrite(cacheFile.getString(),
+            sourceFile.c_str(), cacheValidation, cacheKey))
+        {
+            sceneCache->writeNode(dbRoot);
+            sceneCache->finishWrite();
+        }
+
+        // Done with the cache
+        vsObject::unrefDelete(sceneCache);
+    }
+
     // Package the resulting database into its own component and return
     result = new vsComponent();
     result->addChild(dbRoot);
@@ -413,6 +498,41 @@ bool vsDatabaseLoader::importanceCheck(osg::Node *targetNode)
     return false;
 }
 
+// ------------------------------------------------------------------------
+// Private function
+// Computes a key identifying the loader settings that affect the scene
+// created from a database, so that a scene cached with one set of
+// settings isn't used when loading with different ones
+// ------------------------------------------------------------------------
+u_int vsDatabaseLoader::getCacheSettingsKey()
+{
+    int settings[2];
+    unsigned long long hash;
+    atString *importantName;
+
+    // Start with the loader modes (except for the caching modes, which
+    // don't change the scene) and the units
+    settings[0] = loaderModes &
+        ~(VS_DATABASE_MODE_SCENE_CACHE | VS_DATABASE_MODE_CACHE_HASH);
+    settings[1] = unitMode;
+    hash = vsSceneCache::hashData((unsigned char *)settings,
+        sizeof(settings));
+
+    // Mix in each of the important node names
+    importantName = (atString *) nodeNames.getFirstEntry();
+    while (importantName != NULL)
+    {
+        hash ^= vsSceneCache::hashData(
+            (unsigned char *)importantName->getString(),
+            strlen(importantName->getString()));
+        hash *= 1099511628211ULL;
+        importantName = (atString *) nodeNames.getNextEntry();
+    }
+
+    // Fold the hash down to the size of the key
+    return (u_int)(hash ^ (hash >> 32));
+}
+
 // ------------------------------------------------------------------------
 // Private function
 // Converts an OSG tree, rooted at the specified node, into a VESS tree.
@@ -33,6 +33,8 @@
 #define VS_DATABASE_MODE_NAME_ALL        0x02
 #define VS_DATABASE_MODE_AUTO_UNLIT      0x04
 #define VS_DATABASE_MODE_AUTOGEN_NORMALS 0x08
+#define VS_DATABASE_MODE_SCENE_CACHE     0x10
+#define VS_DATABASE_MODE_CACHE_HASH      0x20
 
 enum vsDatabaseUnits
 {
@@ -57,6 +59,8 @@ private:
 
     char      *stringDup(char *from);
 
+    u_int     getCacheSettingsKey();
+
     vsNode    *convertGeode(osg::Geode *geode,
                             vsObjectMap *attrMap);
     void      convertAttrs(vsNode *node, osg::StateSet *stateSet,
@@ -28,8 +28,63 @@
 #include "vsTextureCubeAttribute.h++"
 #include "vsTextureRectangleAttribute.h++"
 #include "vsTransformAttribute.h++"
+#include "vsVertexCacheOptimizer.h++"
 #include <osg/MatrixTransform>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Size of the grid cells used to find duplicate vertices when welding.
+// This must be at least the tolerance that vertex data is compared with;
+// beyond that, it only affects how many vertices share a hash bucket.
+#define VS_GEOMETRY_WELD_CELL_SIZE    1.0E-3
+
+// ------------------------------------------------------------------------
+// Static function
+// Computes a hash value for the given vertex welding grid cell
+// ------------------------------------------------------------------------
+static int hashWeldCell(long long x, long long y, long long z)
+{
+    unsigned long long hash;
+
+    // Mix the cell coordinates together with some large primes
+    hash = ((unsigned long long)x * 73856093ULL) ^
+        ((unsigned long long)y * 19349663ULL) ^
+        ((unsigned long long)z * 83492791ULL);
+
+    // Fold the upper bits in, and return a positive value
+    hash ^= (hash >> 31);
+    return (int)(hash & 0x7FFFFFFF);
+}
+
+// ------------------------------------------------------------------------
+// Static function
+// Returns whether the two given vertices have the same data (within the
+// usual tolerance) in all of the given data lists
+// ------------------------------------------------------------------------
+static bool weldVerticesMatch(float **listData, int *listComponents,
+                              int listCount, int v1, int v2)
+{
+    float *data1, *data2;
+    int i, j;
+
+    // Compare the vertices in each list
+    for (i = 0; i < listCount; i++)
+    {
+        // Get the data for each vertex
+        data1 = &listData[i][v1 * listComponents[i]];
+        data2 = &listData[i][v2 * listComponents[i]];
+
+        // Compare each component
+        for (j = 0; j < listComponents[i]; j++)
+            if (fabs(data1[j] - data2[j]) > AT_DEFAULT_TOLERANCE)
+                return false;
+    }
+
+    // If we get this far, the vertices must be equivalent
+    return true;
+}
 
 // ------------------------------------------------------------------------
 // Default Constructor - does nothing in the base class
@@ -50,6 +105,9 @@ vsGeometryBase::vsGeometryBase()
     osgGeometry->ref();
     osgGeode->addDrawable(osgGeometry);
 
+    // Let the drawable lead back to this geometry
+    osgGeometry->setUserData(new vsGeometryDrawableData(this));
+
     // Initialize texture bindings to NONE
     for (loop = 0; loop < VS_MAXIMUM_TEXTURE_UNITS; loop++)
         textureBinding[loop] = VS_GEOMETRY_BIND_NONE;
@@ -78,6 +136,10 @@ vsGeometryBase::vsGeometryBase()
 
     // Set the render bin to NULL (just use the default bin)
     renderBin = NULL;
+
+    // The triangle hierarchy used for intersection is built on demand
+    triangleBVH = NULL;
+    pthread_mutex_init(&triangleBVHMutex, NULL);
 }
 
 // ------------------------------------------------------------------------
@@ -99,7 +161,13 @@ vsGeometryBase::~vsGeometryBase()
     if (lengthsList)
         free(lengthsList);
 
-    // Unlink and destroy the OSG objects
+    // Get rid of the intersection hierarchy, if we've built one
+    deleteTriangleBVH();
+    pthread_mutex_destroy(&triangleBVHMutex);
+
+    // Unlink and destroy the OSG objects (the drawable may outlive us if
+    // something else holds on to it, so it can't lead back here anymore)
+    osgGeometry->setUserData(NULL);
     osgGeometry->unref();
     osgGeode->unref();
 
@@ -1592,21 +1660,38 @@ void vsGeometryBase::expandToPerVertex(int whichData)
 // Optimizes the vertex data lists by searching for duplicate vertices
 // (i.e.: vertices that have the same data in all lists that are in use),
 // and re-indexing them so that all duplicates are indexed to a single
-// instance of that vertex
+// instance of that vertex.  The duplicates are found by hashing the
+// vertex positions into a grid, so only vertices in the same (or an
+// adjacent) grid cell need to be compared.  Afterward, the triangles
+// and vertices are reordered to make good use of the vertex cache.
 // ------------------------------------------------------------------------
 void vsGeometryBase::optimizeVertices()
 {
     int listSize;
-    int i, j, k;
-    u_int **candidateList;
-    u_int *candidateCount;
-    u_int *candidateSize;
-    u_int *newList;
-    u_int v1, v2;
-    atVector vec1, vec2;
-    u_int *adjustment;
-    u_int currentAdjustment;
+    int i, j;
     int whichData;
+    float *weldData[VS_GEOMETRY_LIST_COUNT];
+    int weldComponents[VS_GEOMETRY_LIST_COUNT];
+    int weldList[VS_GEOMETRY_LIST_COUNT];
+    int weldListCount;
+    float *position;
+    int positionComponents;
+    int tableSize;
+    int *bucketHead;
+    int *bucketNext;
+    int *newIndex;
+    bool *uniqueFlag;
+    int uniqueCount;
+    double cellSize;
+    long long cell[3];
+    long long lowCell[3], highCell[3];
+    long long x, y, z;
+    double offset;
+    int bucket;
+    int match;
+    int candidate;
+    float *listData;
+    int elementSize;
 
     // Check for any PER_PRIMITIVE list bindings.  If there are any,
     // refactor them into PER_VERTEX lists (PER_PRIMITIVE data is incompatible
@@ -1625,242 +1710,236 @@ void vsGeometryBase::optimizeVertices()
     if (getIndexListSize() > 0)
         deindexGeometry();
 
-    // Now, create a new index list for the geometry that is a simple 1:1
-    // contiguous mapping from each vertex to its attribute index in each
-    // data list
-    listSize = getDataListSize(VS_GEOMETRY_VERTEX_COORDS);
-    setIndexListSize(listSize);
-    for (i = 0; i < listSize; i++)
-        indexList[i] = i;
-
-    // Create some temporary lists that we'll use to keep track of good
-    // candidates for optimization.  A "good" candidate is simply a vertex
-    // that shares the same position as a previous vertex in the list
-    candidateList = (u_int **)calloc(listSize, sizeof(u_int *));
-    candidateCount = (u_int *)calloc(listSize, sizeof(u_int));
-    candidateSize = (u_int *)calloc(listSize, sizeof(u_int));
-    for (i = 0; i < listSize; i++)
-    {
-        // Create the array for this vertex and set its size to 16
-        candidateList[i] = (u_int *)calloc(16, sizeof(int));
-        candidateSize[i] = 16;
-
-        // Add this vertex to its own list of equivalents (i.e.: the first
-        // candidate in any vertex's candidate list is the vertex itself).
-        // If this vertex is found to be equivalent to another vertex, it
-        // will be removed from its own list
-        candidateList[i][0] = i;
-        candidateCount[i] = 1;
-    }
-
-    // Now, iterate over the temporary list and find all candidates for
-    // optimization.  We'll do this in such a way that the candidates for
-    // optimization are associated with the first equivalent vertex in the
-    // list.  This first pass will speed up the full optimization process
-    // below, because we won't need to check the full data set for every
-    // vertex against every other vertex.  We'll only do the full check on
-    // the vertices that share the same position
-    for (i = 0; i < listSize; i++)
+    // Nothing to do without vertices
+    listSize = dataListSize[VS_GEOMETRY_VERTEX_COORDS];
+    if (listSize <= 0)
+        return;
+
+    // Gather up the data of all the PER_VERTEX lists, so we can compare
+    // vertices directly.  Every one of the lists must have an entry for
+    // every vertex.
+    weldListCount = 0;
+    for (i = 0; i < VS_GEOMETRY_LIST_COUNT; i++)
     {
-        // See if this vertex is already known to be a candidate for another
-        // vertex or not
-        if (candidateCount[i] > 0)
-        {
-            // Get the position of this vertex
-            vec1 = getData(VS_GEOMETRY_VERTEX_COORDS, i);
+        // Account for the use of generic attributes
+        if (dataIsGeneric[i])
+            whichData = i + VS_GEOMETRY_LIST_COUNT;
+        else
+            whichData = i;
 
-            // Iterate over the remaining vertices
-            for (j = i+1; j < listSize; j++)
+        // See if this list is PER_VERTEX
+        if ((getBinding(whichData) == VS_GEOMETRY_BIND_PER_VERTEX) &&
+            (dataListSize[i] > 0))
+        {
+            // Make sure the list is big enough
+            if (dataListSize[i] < listSize)
             {
-                // Get the position of this vertex and compare the two
-                vec2 = getData(VS_GEOMETRY_VERTEX_COORDS, j);
-                if (vec1.isEqual(vec2))
-                {
-                    // Add this vertex to the candidate list of the
-                    // earlier equivalent vertex
-                    candidateCount[i]++;
-
-                    // Expand the candidate list, if necessary
-                    if (candidateCount[i] >= candidateSize[i])
-                    {
-                        // Reallocate the list
-                        newList = (u_int *)realloc(candidateList[i],
-                            candidateSize[i] * 2 * sizeof(u_int));
-
-                        // Update the list size
-                        candidateList[i] = newList;
-                        candidateSize[i] *= 2;
-                    }
-
-                    // Add vertex j to the existing list
-                    candidateList[i][candidateCount[i]-1] = j;
-
-                    // Remove vertex j from its own list
-                    candidateCount[j] = 0;
-                }
+                printf("vsGeometryBase::optimizeVertices:  Vertex data lists "
+                    "are not all the same size!\n");
+                return;
             }
+
+            // Add the list's data
+            weldData[weldListCount] = getDataPointer(i);
+            weldComponents[weldListCount] = getDataComponentCount(whichData);
+            weldList[weldListCount] = whichData;
+            weldListCount++;
         }
     }
 
-    // Create a list that will store how many spaces we'll need to slide
-    // each vertex and index after the optimization is complete
-    adjustment = new u_int[listSize];
-    currentAdjustment = 0;
-
-    // Iterate over each vertex of the geometry and see if any vertices
-    // have nearly the same data across all relevant data lists.  Use the
-    // same temporary list we created above to keep track of equivalent
-    // vertices
+    // Get the vertex positions that we'll hash on
+    position = getDataPointer(VS_GEOMETRY_VERTEX_COORDS);
+    if (dataIsGeneric[VS_GEOMETRY_VERTEX_COORDS])
+        positionComponents =
+            getDataComponentCount(VS_GEOMETRY_GENERIC_0);
+    else
+        positionComponents =
+            getDataComponentCount(VS_GEOMETRY_VERTEX_COORDS);
+
+    // Create the hash table.  Each bucket holds a chain of unique vertices
+    // whose grid cells hash to the bucket
+    tableSize = 1;
+    while (tableSize < listSize * 2)
+        tableSize *= 2;
+    bucketHead = (int *)malloc(sizeof(int) * tableSize);
+    for (i = 0; i < tableSize; i++)
+        bucketHead[i] = -1;
+    bucketNext = (int *)malloc(sizeof(int) * listSize);
+
+    // Create the lists that keep track of where each vertex ends up
+    newIndex = (int *)malloc(sizeof(int) * listSize);
+    uniqueFlag = (bool *)malloc(sizeof(bool) * listSize);
+
+    // Vertices within the tolerance of each other can only be in the same
+    // grid cell, or in neighboring cells if they're close to the cell's
+    // edge
+    cellSize = VS_GEOMETRY_WELD_CELL_SIZE;
+
+    // Check each vertex against the unique vertices we've found so far
+    uniqueCount = 0;
     for (i = 0; i < listSize; i++)
     {
-        // This is for readability... v1 is the i'th vertex in the
-        // geometry
-        v1 = (u_int) i;
-
-        // See if this vertex is unique, or if it's already deemed equivalent
-        // to another vertex
-        if (candidateCount[v1] > 0)
+        // Figure out which cells to search for this vertex
+        for (j = 0; j < 3; j++)
         {
-            // This vertex is currently unique.  Check each candidate
-            // vertex to see if they are totally equivalent to this
-            // vertex (skip the first candidate, as we know the vertex
-            // is equivalent to itself)
-            for (j = 1; j < candidateCount[v1]; j++)
-            {
-                // This is for readability... v1 is the i'th vertex in the
-                // geometry and v2 is the j'th candidate equivalent vertex
-                // of v1
-                v2 = candidateList[v1][j];
+            cell[j] = (long long)floor(position[i*positionComponents + j] /
+                cellSize);
+            offset = position[i*positionComponents + j] - cell[j] * cellSize;
+            lowCell[j] = cell[j];
+            highCell[j] = cell[j];
+            if (offset <= AT_DEFAULT_TOLERANCE)
+                lowCell[j]--;
+            if ((cellSize - offset) <= AT_DEFAULT_TOLERANCE)
+                highCell[j]++;
+        }
 
-                // Check for equivalence
-                if (areVerticesEquivalent(v1, v2))
+        // Look for an equivalent vertex in the cells
+        match = -1;
+        for (x = lowCell[0]; (x <= highCell[0]) && (match < 0); x++)
+            for (y = lowCell[1]; (y <= highCell[1]) && (match < 0); y++)
+                for (z = lowCell[2]; (z <= highCell[2]) && (match < 0); z++)
                 {
-                    // The vertices are equivalent, so leave the candidates
-                    // array as it is (this vertex will be optimized away).
-                    // Update the index list to have v2 point to v1
-                    indexList[v2] = v1;
-                }
-                else
-                {
-                    // These vertices are not equivalent.  Put this vertex
-                    // back into its own place in the candidates array
-                    candidateList[v2][0] = v2;
-
-                    // Any remaining candidate vertices for v1 might also be
-                    // equivalent to v2, so copy them as candidates of
-                    // v2 as well
-                    if (candidateSize[v2] < candidateCount[v1] - j)
+                    // Check each vertex in this cell's bucket
+                    bucket = hashWeldCell(x, y, z) & (tableSize - 1);
+                    candidate = bucketHead[bucket];
+                    while ((candidate >= 0) && (match < 0))
                     {
-                        // Make sure the list has enough space before copying
-                        newList = (u_int *)realloc(candidateList[v2],
-                            candidateCount[v1] * 2 * sizeof(u_int));
-
-                        // Update the list size
-                        candidateList[v2] = newList;
-                        candidateSize[v2] = candidateCount[v1] * 2;
+                        if (weldVerticesMatch(weldData, weldComponents,
+                            weldListCount, i, candidate))
+                            match = candidate;
+                        candidate = bucketNext[candidate];
                     }
-
-                    // Copy the remaining vertices from the candidate
-                    // list for v1 to the candidate list for v2
-                    candidateCount[v2] = candidateCount[v1] - j + 1;
-                    for (k = 1; k < candidateCount[v2]; k++)
-                        candidateList[v2][k] = candidateList[v1][j+k];
-
-                    // Remove this vertex from the candidates for v1 (we
-                    // now know that v1 and v2 are not equivalent)
-                    candidateCount[v1]--;
-                    if (j < candidateCount[v1])
-                        memmove(&candidateList[v1][j], &candidateList[v1][j+1],
-                            sizeof(u_int) * (candidateCount[v1] - j));
                 }
-            }
 
-            // We didn't optimize away this vertex, so put the same adjustment
-            // as for the last vertex in this vertex's slot
-            adjustment[i] = currentAdjustment;
+        // See if we found a match
+        if (match >= 0)
+        {
+            // This vertex will be optimized away, and indexed to the
+            // equivalent vertex instead
+            newIndex[i] = newIndex[match];
+            uniqueFlag[i] = false;
         }
         else
         {
-            // This vertex is equivalent to another vertex, so it should
-            // be optimized away.  Increment the current adjustment value,
-            // and store it in the adjustment array (this indicates each
-            // following vertex must be moved back one additional place
-            // to account for the removal of this vertex)
-            currentAdjustment++;
-            adjustment[i] = currentAdjustment;
+            // This vertex is unique, so it gets the next slot in the
+            // compacted lists
+            newIndex[i] = uniqueCount;
+            uniqueFlag[i] = true;
+            uniqueCount++;
+
+            // Add it to the bucket for its own cell
+            bucket = hashWeldCell(cell[0], cell[1], cell[2]) &
+                (tableSize - 1);
+            bucketNext[i] = bucketHead[bucket];
+            bucketHead[bucket] = i;
         }
     }
 
-    // We're done with the candidate list and supporting data now (all we
-    // need from now on is the adjustment list we just constructed)
-    for (i = 0; i < listSize; i++)
-        free(candidateList[i]);
-    free(candidateList);
-    free(candidateCount);
-    free(candidateSize);
-
-    // Now, use the adjustment list to compact the vertex attribute lists
-    // by removing duplicate vertex data values, and sliding the remaining
-    // data into place.  Also adjust the index list to account for the new
-    // positions of the unique data values
-    for (i = 0; i < listSize; i++)
+    // We're done with the hash table
+    free(bucketHead);
+    free(bucketNext);
+
+    // Slide the unique vertices' data down into place in each list.  Each
+    // unique vertex only moves toward the front of the list, and only into
+    // a slot that we've already handled, so this can be done in place
+    for (i = 0; i < weldListCount; i++)
     {
-        // Adjust the index array according to the adjustment array that
-        // we created above
-        indexList[i] -= adjustment[indexList[i]];
-
-        // See if this vertex is unique, or if it will be optimized away.
-        // We can do this by comparing the adjustment value for this vertex
-        // with the value for the previous vertex.  If they are different,
-        // then this vertex is redundant, and we should ignore its data.
-        // If they are equal, then this vertex's data is important, and
-        // we should moved it into the correct position
-        if ((i > 0) && (adjustment[i] == adjustment[i-1]))
+        listData = weldData[i];
+        elementSize = sizeof(float) * weldComponents[i];
+        for (j = 0; j < listSize; j++)
         {
-            // Iterate over all potential vertex attribute lists
-            for (j = 0; j < VS_GEOMETRY_LIST_COUNT; j++)
-            {
-                // Account for the use of generic attributes
-                if (dataIsGeneric[j])
-                    whichData = j + VS_GEOMETRY_LIST_COUNT;
-                else
-                    whichData = j;
-
-                // See if this list is PER_VERTEX, and adjust the i'th item
-                // if so
-                if ((getBinding(whichData) == VS_GEOMETRY_BIND_PER_VERTEX) &&
-                    (dataListSize[whichData] > 0))
-                {
-                    // Move the data according to the adjustment array
-                    vec1 = getData(whichData, i);
-                    setData(whichData, i-adjustment[i], vec1);
-                }
-            }
+            if ((uniqueFlag[j]) && (newIndex[j] != j))
+                memcpy(&listData[newIndex[j] * weldComponents[i]],
+                    &listData[j * weldComponents[i]], elementSize);
         }
     }
 
+    // Create the new index list, pointing each vertex at the unique copy
+    // of its data
+    setIndexListSize(listSize);
+    for (i = 0; i < listSize; i++)
+        indexList[i] = newIndex[i];
+
+    // Done with the remaining temporary lists
+    free(newIndex);
+    free(uniqueFlag);
+
     // Finally, resize all of the vertex attribute lists to the new
-    // (hopefully smaller) size
-    listSize -= adjustment[listSize-1];
-    for (i = 0; i < VS_GEOMETRY_LIST_COUNT; i++)
+    // (hopefully smaller) size.  This also lets OSG know that the data
+    // has changed
+    for (i = 0; i < weldListCount; i++)
+        setDataListSize(weldList[i], uniqueCount);
+
+    // Reorder the new index list (and the vertices) for the vertex cache
+    optimizeIndexOrder();
+
+    // Now that we have a new index list, rebuild the primitive sets
+    rebuildPrimitives();
+}
+
+// ------------------------------------------------------------------------
+// Copies a range of entries from one of the data lists of another
+// geometry object into the same list of this one.  Both geometries must
+// use the same kind (conventional or generic) of list, and both lists
+// must be big enough to hold the range.  The data is copied in bulk,
+// which is much faster than copying it one entry at a time.
+// ------------------------------------------------------------------------
+void vsGeometryBase::copyDataRange(int whichData, int destIndex,
+                                   vsGeometryBase *source, int sourceIndex,
+                                   int count)
+{
+    int slotNum;
+    int components;
+    float *destData;
+    float *sourceData;
+
+    // Make sure we recognize the list
+    if (getDataElementCount(whichData) == -1)
     {
-        // Account for the use of generic attributes
-        if (dataIsGeneric[i])
-            whichData = i + VS_GEOMETRY_LIST_COUNT;
-        else
-            whichData = i;
+        printf("vsGeometryBase::copyDataRange: Unrecognized data type\n");
+        return;
+    }
 
-        // See if this list is PER_VERTEX, and resize it if so
-        if ((getBinding(whichData) == VS_GEOMETRY_BIND_PER_VERTEX) &&
-            (dataListSize[whichData] > 0))
-            setDataListSize(whichData, listSize);
+    // Calculate which entry in the data arrays corresponds to the given
+    // constant
+    if (whichData < VS_GEOMETRY_LIST_COUNT)
+        slotNum = whichData;
+    else
+        slotNum = whichData - VS_GEOMETRY_LIST_COUNT;
+
+    // Make sure both geometries are using the requested kind of list
+    if ((dataIsGeneric[slotNum] != (whichData >= VS_GEOMETRY_LIST_COUNT)) ||
+        (source->dataIsGeneric[slotNum] !=
+            (whichData >= VS_GEOMETRY_LIST_COUNT)))
+    {
+        printf("vsGeometryBase::copyDataRange: Conventional and generic "
+            "data can't be mixed\n");
+        return;
     }
 
-    // Now we're done with the adjustment list as well
-    delete [] adjustment;
+    // Nothing to do for an empty range
+    if (count <= 0)
+        return;
 
-    // Now that we have a new index list, rebuild the primitive sets
-    rebuildPrimitives();
+    // Bounds checking; make sure the range fits in both lists
+    if ((destIndex < 0) || (sourceIndex < 0) ||
+        ((destIndex + count) > dataListSize[slotNum]) ||
+        ((sourceIndex + count) > source->dataListSize[slotNum]))
+    {
+        printf("vsGeometryBase::copyDataRange: Index out of bounds\n");
+        return;
+    }
+
+    // Copy the data
+    components = getDataComponentCount(whichData);
+    destData = getDataPointer(slotNum);
+    sourceData = source->getDataPointer(slotNum);
+    memmove(&destData[destIndex * components],
+        &sourceData[sourceIndex * components],
+        sizeof(float) * components * count);
+
+    // Let the appropriate OSG data array know that it's data has changed
+    notifyOSGDataChanged(whichData);
 }
 
 // ------------------------------------------------------------------------
@@ -1884,6 +1963,10 @@ void vsGeometryBase::rebuildPrimitives()
     osg::DrawElementsUInt *osgDrawElements;
     int i, indexIndex;
 
+    // The primitives are changing, so any intersection hierarchy we've
+    // built is now out of date
+    deleteTriangleBVH();
+
     // Erase the current list of PrimitiveSets
     numSets = osgGeometry->getNumPrimitiveSets();
     if (numSets > 0)
@@ -2149,6 +2232,129 @@ int vsGeometryBase::getDataElementCount(int whichData)
     return -1;
 }
 
+// ------------------------------------------------------------------------
+// Private function
+// Returns the number of floats used by each entry of the given data list
+// ------------------------------------------------------------------------
+int vsGeometryBase::getDataComponentCount(int whichData)
+{
+    int elementCount;
+
+    // Lists that can hold any kind of data always use four components
+    elementCount = getDataElementCount(whichData);
+    if (elementCount == 0)
+        return 4;
+
+    return elementCount;
+}
+
+// ------------------------------------------------------------------------
+// Private function
+// Returns a pointer to the raw data in the data list in the given slot,
+// or NULL if the list is empty
+// ------------------------------------------------------------------------
+float *vsGeometryBase::getDataPointer(int slotNum)
+{
+    // An empty list has no data
+    if (dataListSize[slotNum] <= 0)
+        return NULL;
+
+    // All of our data arrays are tightly packed arrays of floats
+    return (float *)(dataList[slotNum]->getDataPointer());
+}
+
+// ------------------------------------------------------------------------
+// Private function
+// Reorders the index list to make good use of the post-transform vertex
+// cache, and then renumbers the vertices in the order that they're used
+// so the vertex data is read sequentially.  Only triangle lists are
+// reordered for the cache, as the order of the other primitive types'
+// vertices matters.  The primitives aren't rebuilt here, so the caller
+// must do that afterward.
+// ------------------------------------------------------------------------
+void vsGeometryBase::optimizeIndexOrder()
+{
+    int vertexCount;
+    int *vertexRemap;
+    int newVertexCount;
+    float *listData;
+    float *newData;
+    int components;
+    int whichData;
+    int i, j;
+
+    // We need an index list to reorder
+    if (indexListSize <= 0)
+        return;
+
+    // Make sure all of the PER_VERTEX lists have the same size (the
+    // vertices can't be reordered otherwise)
+    vertexCount = dataListSize[VS_GEOMETRY_VERTEX_COORDS];
+    for (i = 0; i < VS_GEOMETRY_LIST_COUNT; i++)
+    {
+        // Account for the use of generic attributes
+        if (dataIsGeneric[i])
+            whichData = i + VS_GEOMETRY_LIST_COUNT;
+        else
+            whichData = i;
+
+        // Check the list size
+        if ((getBinding(whichData) == VS_GEOMETRY_BIND_PER_VERTEX) &&
+            (dataListSize[i] > 0) && (dataListSize[i] != vertexCount))
+            return;
+    }
+
+    // Reorder the triangles for the vertex cache
+    if (primitiveType == VS_GEOMETRY_TYPE_TRIS)
+        vsVertexCacheOptimizer::optimizeTriangleOrder(indexList,
+            indexListSize, vertexCount);
+
+    // Renumber the vertices in the order they're now used
+    vertexRemap = (int *)malloc(sizeof(int) * vertexCount);
+    newVertexCount = vsVertexCacheOptimizer::optimizeVertexOrder(indexList,
+        indexListSize, vertexCount, vertexRemap);
+
+    // Move the vertex data to match
+    for (i = 0; i < VS_GEOMETRY_LIST_COUNT; i++)
+    {
+        // Account for the use of generic attributes
+        if (dataIsGeneric[i])
+            whichData = i + VS_GEOMETRY_LIST_COUNT;
+        else
+            whichData = i;
+
+        // Only PER_VERTEX lists need to be reordered
+        if ((getBinding(whichData) != VS_GEOMETRY_BIND_PER_VERTEX) ||
+            (dataListSize[i] <= 0))
+            continue;
+
+        // Copy each used vertex to its new position in a temporary list,
+        // then copy the whole list back
+        components = getDataComponentCount(whichData);
+        listData = getDataPointer(i);
+        newData = (float *)malloc(sizeof(float) * components *
+            (newVertexCount + 1));
+        for (j = 0; j < vertexCount; j++)
+        {
+            if (vertexRemap[j] >= 0)
+                memcpy(&newData[vertexRemap[j] * components],
+                    &listData[j * components], sizeof(float) * components);
+        }
+        memcpy(listData, newData, sizeof(float) * components * newVertexCount);
+        free(newData);
+
+        // Drop any unused vertices from the end of the list, and let OSG
+        // know the data changed
+        if (newVertexCount < vertexCount)
+            setDataListSize(whichData, newVertexCount);
+        else
+            notifyOSGDataChanged(whichData);
+    }
+
+    // Done with the vertex mapping
+    free(vertexRemap);
+}
+
 // ------------------------------------------------------------------------
 // Private function
 // Allocates the correct OSG array associated with the specified data type,
@@ -2284,6 +2490,10 @@ void vsGeometryBase::notifyOSGDataChanged(int whichData)
     else
         slotNum = whichData - VS_GEOMETRY_LIST_COUNT;
 
+    // If the vertices changed, the intersection hierarchy is out of date
+    if (slotNum == VS_GEOMETRY_VERTEX_COORDS)
+        deleteTriangleBVH();
+
     // Let the appropriate OSG data array know that it's data has changed
     switch (whichData)
     {
@@ -2346,6 +2556,24 @@ void vsGeometryBase::notifyOSGDataChanged(int whichData)
     }
 }
 
+// ------------------------------------------------------------------------
+// Private function
+// Deletes the triangle hierarchy used for intersection (if one has been
+// built), so that it will be rebuilt from the current primitives and
+// vertices the next time it is needed
+// ------------------------------------------------------------------------
+void vsGeometryBase::deleteTriangleBVH()
+{
+    // Throw away the hierarchy
+    pthread_mutex_lock(&triangleBVHMutex);
+    if (triangleBVH != NULL)
+    {
+        delete triangleBVH;
+        triangleBVH = NULL;
+    }
+    pthread_mutex_unlock(&triangleBVHMutex);
+}
+
 // ------------------------------------------------------------------------
 // Internal function
 // Adds a node to this node's list of parent nodes
@@ -2450,6 +2678,270 @@ void vsGeometryBase::getAxisAlignedBoxBounds(atVector *minValues,
     }
 }
 
+// ------------------------------------------------------------------------
+// Internal function
+// Returns a bounding volume hierarchy over the triangles of this geometry
+// (in the geometry's local coordinates), building it if necessary.  The
+// hierarchy is kept until the primitives or vertex coordinates change.
+// Each triangle records the primitive it came from, and its position in
+// the sequence of triangles that OSG would produce for this geometry.
+// Returns NULL if the geometry has no triangles.  This function may be
+// called from several threads at once, but not while the geometry is
+// being modified.
+// ------------------------------------------------------------------------
+vsTriangleBVH *vsGeometryBase::getTriangleBVH()
+{
+    osg::Vec3Array *vertexArray;
+    float *vertices;
+    int vertexCount;
+    vsTriangleBVHTriangle *triangles;
+    int triangleCount;
+    int primLength, primTriCount;
+    int lengthSum;
+    int i, j, k;
+    int vertIndex[3];
+    int tempIndex;
+    bool indicesValid;
+    vsTriangleBVH *result;
+
+    // Points and lines don't have any triangles, and we can't interpret
+    // the vertices if they've been replaced with a generic attribute
+    if ((primitiveType == VS_GEOMETRY_TYPE_POINTS) ||
+        (primitiveType == VS_GEOMETRY_TYPE_LINES) ||
+        (primitiveType == VS_GEOMETRY_TYPE_LINE_STRIPS) ||
+        (primitiveType == VS_GEOMETRY_TYPE_LINE_LOOPS) ||
+        (dataIsGeneric[VS_GEOMETRY_VERTEX_COORDS]))
+        return NULL;
+
+    // Only one thread builds the hierarchy
+    pthread_mutex_lock(&triangleBVHMutex);
+
+    // See if we've already got an up-to-date hierarchy
+    if (triangleBVH != NULL)
+    {
+        result = triangleBVH;
+        pthread_mutex_unlock(&triangleBVHMutex);
+        return result;
+    }
+
+    // Count the triangles in the primitives
+    triangleCount = 0;
+    for (i = 0; i < primitiveCount; i++)
+    {
+        if (primitiveType == VS_GEOMETRY_TYPE_TRIS)
+            primTriCount = 1;
+        else if (primitiveType == VS_GEOMETRY_TYPE_QUADS)
+            primTriCount = 2;
+        else
+            primTriCount = getPrimitiveLength(i) - 2;
+
+        if (primTriCount > 0)
+            triangleCount += primTriCount;
+    }
+
+    // Nothing to build if there aren't any triangles
+    if (triangleCount == 0)
+    {
+        pthread_mutex_unlock(&triangleBVHMutex);
+        return NULL;
+    }
+
+    // Copy the vertex coordinates
+    vertexArray = (osg::Vec3Array *)dataList[VS_GEOMETRY_VERTEX_COORDS];
+    vertexCount = dataListSize[VS_GEOMETRY_VERTEX_COORDS];
+    vertices = new float[vertexCount * 3 + 1];
+    for (i = 0; i < vertexCount; i++)
+    {
+        vertices[i * 3] = (*vertexArray)[i][0];
+        vertices[i * 3 + 1] = (*vertexArray)[i][1];
+        vertices[i * 3 + 2] = (*vertexArray)[i][2];
+    }
+
+    // Break the primitives into triangles.  The triangles are produced in
+    // the same order (and with the same winding) that OSG uses when it
+    // intersects the geometry
+    triangles = new vsTriangleBVHTriangle[triangleCount];
+    triangleCount = 0;
+    lengthSum = 0;
+    indicesValid = true;
+    for (i = 0; i < primitiveCount; i++)
+    {
+        // Get the number of triangles in this primitive
+        primLength = getPrimitiveLength(i);
+        if (primitiveType == VS_GEOMETRY_TYPE_TRIS)
+            primTriCount = 1;
+        else if (primitiveType == VS_GEOMETRY_TYPE_QUADS)
+            primTriCount = 2;
+        else
+            primTriCount = primLength - 2;
+
+        for (j = 0; j < primTriCount; j++)
+        {
+            // Figure out which of the primitive's vertices make up the jth
+            // triangle
+            triangles[triangleCount].windingSwapped = false;
+            switch (primitiveType)
+            {
+                case VS_GEOMETRY_TYPE_TRIS:
+                case VS_GEOMETRY_TYPE_QUADS:
+                case VS_GEOMETRY_TYPE_TRI_FANS:
+                case VS_GEOMETRY_TYPE_POLYS:
+                    // Fan out from the first vertex
+                    vertIndex[0] = lengthSum;
+                    vertIndex[1] = lengthSum + j + 1;
+                    vertIndex[2] = lengthSum + j + 2;
+                    break;
+
+                default:
+                    // Strips use a sliding window of three vertices, with
+                    // every other triangle reversed to keep the winding
+                    // consistent
+                    vertIndex[0] = lengthSum + j;
+                    vertIndex[1] = lengthSum + j + 1;
+                    vertIndex[2] = lengthSum + j + 2;
+                    if (j & 1)
+                    {
+                        tempIndex = vertIndex[1];
+                        vertIndex[1] = vertIndex[2];
+                        vertIndex[2] = tempIndex;
+                        triangles[triangleCount].windingSwapped = true;
+                    }
+                    break;
+            }
+
+            // Look up the actual vertices through the index list, if we
+            // have one, and make sure they're all in range
+            for (k = 0; k < 3; k++)
+            {
+                if (indexList != NULL)
+                {
+                    if (vertIndex[k] < indexListSize)
+                        vertIndex[k] = indexList[vertIndex[k]];
+                    else
+                        vertIndex[k] = -1;
+                }
+
+                if ((vertIndex[k] < 0) || (vertIndex[k] >= vertexCount))
+                    indicesValid = false;
+
+                triangles[triangleCount].vertexIndex[k] = vertIndex[k];
+            }
+
+            // Remember where this triangle came from
+            triangles[triangleCount].primitiveIndex = i;
+            triangles[triangleCount].triangleIndex = triangleCount;
+            triangleCount++;
+        }
+
+        // Move on to the next primitive's vertices
+        lengthSum += primLength;
+    }
+
+    // Build the hierarchy, as long as the primitives only refer to
+    // vertices we actually have
+    if (indicesValid)
+    {
+        triangleBVH = new vsTriangleBVH(vertices, vertexCount, triangles,
+            triangleCount);
+    }
+    else
+    {
+        printf("vsGeometryBase::getTriangleBVH: Primitives refer to "
+            "vertices that don't exist\n");
+    }
+
+    // Clean up
+    delete [] vertices;
+    delete [] triangles;
+
+    // Return the new hierarchy
+    result = triangleBVH;
+    pthread_mutex_unlock(&triangleBVHMutex);
+    return result;
+}
+
+// ------------------------------------------------------------------------
+// Internal function
+// Returns a pointer to the packed floating-point data of the specified
+// list, and stores the number of elements in the list in dataCount, and
+// the number of components in each element in componentCount (four for
+// generic attributes).  Returns NULL if the list is empty, or if the kind
+// of data requested (conventional or generic) isn't the kind the list is
+// currently holding.  The data must not be modified.
+// ------------------------------------------------------------------------
+float *vsGeometryBase::getRawDataList(int whichData, int *dataCount,
+                                      int *componentCount)
+{
+    int slotNum;
+
+    // Assume there's no data until we find some
+    *dataCount = 0;
+    *componentCount = 0;
+
+    // Make sure we recognize the list
+    if (getDataElementCount(whichData) == -1)
+        return NULL;
+
+    // Calculate which entry in the data arrays corresponds to the given
+    // constant
+    if (whichData < VS_GEOMETRY_LIST_COUNT)
+        slotNum = whichData;
+    else
+        slotNum = whichData - VS_GEOMETRY_LIST_COUNT;
+
+    // Make sure the list is holding the requested kind of data
+    if (dataIsGeneric[slotNum] != (whichData >= VS_GEOMETRY_LIST_COUNT))
+        return NULL;
+
+    // Return the list's data
+    *dataCount = dataListSize[slotNum];
+    *componentCount = getDataComponentCount(whichData);
+    return getDataPointer(slotNum);
+}
+
+// ------------------------------------------------------------------------
+// Internal function
+// Resizes the specified list to hold dataCount elements, and copies the
+// packed floating-point data for all of them from the given buffer in a
+// single operation
+// ------------------------------------------------------------------------
+void vsGeometryBase::setRawDataList(int whichData, float *dataBuffer,
+                                    int dataCount)
+{
+    int slotNum;
+
+    // Make sure we recognize the list
+    if (getDataElementCount(whichData) == -1)
+    {
+        printf("vsGeometryBase::setRawDataList: Unrecognized data type\n");
+        return;
+    }
+
+    // Calculate which entry in the data arrays corresponds to the given
+    // constant
+    if (whichData < VS_GEOMETRY_LIST_COUNT)
+        slotNum = whichData;
+    else
+        slotNum = whichData - VS_GEOMETRY_LIST_COUNT;
+
+    // Resize the list (this also takes care of switching between
+    // conventional and generic data)
+    setDataListSize(whichData, dataCount);
+
+    // Make sure the resize worked
+    if ((dataListSize[slotNum] != dataCount) ||
+        (dataIsGeneric[slotNum] != (whichData >= VS_GEOMETRY_LIST_COUNT)))
+        return;
+
+    // Copy the data
+    if (dataCount > 0)
+        memcpy(getDataPointer(slotNum), dataBuffer,
+            sizeof(float) * getDataComponentCount(whichData) * dataCount);
+
+    // Let the appropriate OSG data array know that it's data has changed
+    notifyOSGDataChanged(whichData);
+}
+
 // ------------------------------------------------------------------------
 // Internal function
 // Calls the apply function on all attached attributes, and then calls the
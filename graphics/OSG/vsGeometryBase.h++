@@ -29,6 +29,8 @@
 #include "vsAttribute.h++"
 #include "vsNode.h++"
 #include "vsRenderBin.h++"
+#include "vsTriangleBVH.h++"
+#include <pthread.h>
 #include <osg/Geode>
 #include <osg/Geometry>
 
@@ -168,13 +170,20 @@ protected:
     
     vsRenderBin         *renderBin;
 
+    vsTriangleBVH       *triangleBVH;
+    pthread_mutex_t     triangleBVHMutex;
+
     void                rebuildPrimitives();
+    void                deleteTriangleBVH();
 
     int                 getDataElementCount(int whichData);
+    int                 getDataComponentCount(int whichData);
+    float               *getDataPointer(int slotNum);
     void                allocateDataArray(int whichData);
     void                notifyOSGDataChanged(int whichData);
 
     bool                areVerticesEquivalent(int v1, int v2);
+    void                optimizeIndexOrder();
 
 VS_INTERNAL:
 
@@ -186,6 +195,13 @@ VS_INTERNAL:
     virtual void    getAxisAlignedBoxBounds(atVector *minValues, 
                                             atVector *maxValues);
 
+    vsTriangleBVH   *getTriangleBVH();
+
+    virtual float   *getRawDataList(int whichData, int *dataCount,
+                                    int *componentCount);
+    virtual void    setRawDataList(int whichData, float *dataBuffer,
+                                   int dataCount);
+
 public:
 
                           vsGeometryBase();
@@ -220,6 +236,9 @@ public:
     void                  getDataList(int whichData, atVector *dataBuffer);
     void                  setDataListSize(int whichData, int newSize);
     int                   getDataListSize(int whichData);
+    void                  copyDataRange(int whichData, int destIndex,
+                                        vsGeometryBase *source,
+                                        int sourceIndex, int count);
 
     void                  setIndex(int indexIndex, u_int index);
     u_int                 getIndex(int indexIndex);
@@ -253,4 +272,16 @@ public:
     osg::Geode            *getBaseLibraryObject();
 };
 
+// Attached to each geometry's OSG drawable as its user data, so that the
+// intersection code can get from a drawable back to the VESS geometry
+// that owns it without going through the node map
+class VESS_SYM vsGeometryDrawableData : public osg::Referenced
+{
+public:
+
+    vsGeometryBase    *geometry;
+
+    vsGeometryDrawableData(vsGeometryBase *owner) { geometry = owner; }
+};
+
 #endif
@@ -28,6 +28,8 @@
 #include "vsScene.h++"
 #include "vsUnmanagedNode.h++"
 #include "vsOSGNode.h++"
+#include "vsThreadPool.h++"
+#include "vsTriangleBVHIntersector.h++"
 
 #include <osg/StateAttribute>
 #include <osg/StateSet>
@@ -37,6 +39,14 @@
 #include <osgUtil/LineSegmentIntersector>
 
 #include <stdio.h>
+#include <string.h>
+
+// Information about a batch of intersectors for the thread pool
+struct vsIntersectBatch
+{
+    vsIntersect    **intersectList;
+    osg::Node      *osgNode;
+};
 
 
 // ------------------------------------------------------------------------
@@ -61,6 +71,10 @@ vsIntersect::vsIntersect()
     // modes for sequence, switches, and LOD's
     intersectTraverser = new vsIntersectTraverser();
     intersectTraverser->ref();
+
+    // No traversal in progress
+    osgIsectGroup = NULL;
+    memset(segIntersectors, 0, sizeof(segIntersectors));
     
     // TODO: Database read callback?
 }
@@ -552,42 +566,27 @@ int vsIntersect::getLODTravMode()
 }
 
 // ------------------------------------------------------------------------
-// Initiates an intersection traversal over the indicated geometry tree.
-// The results of the traversal are stored and can be retrieved with the
-// getIsect* functions.
+// Private function
+// Clears out the previous results and sets up the OSG intersectors for
+// the next traversal
 // ------------------------------------------------------------------------
-void vsIntersect::intersect(vsNode *targetNode)
+void vsIntersect::startIntersection()
 {
-    osg::Node *osgNode;
-    osgUtil::IntersectorGroup *intersectorGroup;
-    osgUtil::LineSegmentIntersector **segmentIntersectors;
-    osgUtil::LineSegmentIntersector *segmentIntersector;
-    osgUtil::LineSegmentIntersector::Intersections *intersections;
-    osgUtil::LineSegmentIntersector::Intersections::const_iterator iterator;
-    const SegIntersection * intersection;
-    osg::Vec3d osgStart, osgEnd;
-    osg::Vec3 polyNormal;
     vsLineSegment *segment;
     atVector atStart, atEnd;
-    atVector viewVec, normalVec;
-    double viewDot;
+    osg::Vec3d osgStart, osgEnd;
     int loop;
 
     // Before doing anything else, clear out the existing intersection results.
     clearIntersectionResults();
 
-    // Fetch the OSG node from the VESS node.
-    osgNode = getBaseLibraryObject(targetNode);
-
     // Create a new intersector group to handle this request.
-    intersectorGroup = new osgUtil::IntersectorGroup();
-    intersectorGroup->ref();
-
-    // Create a temporary array to store the intersector for each line segment.
-    // This is necessary because the IntersectorGroup doesn't guarantee order.
-    segmentIntersectors = new osgUtil::LineSegmentIntersector*[segListSize];
+    osgIsectGroup = new osgUtil::IntersectorGroup();
+    osgIsectGroup->ref();
 
-    // Add all the segments from the segment list to the IntersectVisitor
+    // Add all the segments from the segment list to the IntersectVisitor.
+    // We keep our own list of the intersectors for each segment, because
+    // the IntersectorGroup doesn't guarantee order.
     for (loop = 0; loop < segListSize; loop++)
     {
         // Fetch the segment from the array. It may be NULL.
@@ -600,33 +599,49 @@ void vsIntersect::intersect(vsNode *targetNode)
             osgStart.set(atStart[AT_X], atStart[AT_Y], atStart[AT_Z]);
             osgEnd.set(atEnd[AT_X], atEnd[AT_Y], atEnd[AT_Z]);
 
-            // Create a new LineSegmentIntersector to handle this segment and
-            // add it to the IntersectorGroup.
-            segmentIntersector =
-                new osgUtil::LineSegmentIntersector(osgStart, osgEnd);
-            segmentIntersector->ref();
-            intersectorGroup->addIntersector(segmentIntersector);
-            segmentIntersectors[loop] = segmentIntersector;
+            // Create a new intersector to handle this segment and add it to
+            // the IntersectorGroup.  Our intersector uses the triangle
+            // hierarchies cached on the geometry instead of testing every
+            // triangle.
+            segIntersectors[loop] =
+                new vsTriangleBVHIntersector(osgStart, osgEnd);
+            segIntersectors[loop]->ref();
+            osgIsectGroup->addIntersector(segIntersectors[loop]);
         }
         else
         {
             // Set the segmentIntersector to NULL just to be safe.
-            segmentIntersectors[loop] = NULL;
+            segIntersectors[loop] = NULL;
         }
     }
 
     // The IntersectorGroup is now configured. Associate it with the traverser.
-    intersectTraverser->setIntersector(intersectorGroup);
+    intersectTraverser->setIntersector(osgIsectGroup);
+}
 
-    // Call the target accept method to perform the intersection traversal.
-    osgNode->accept(*intersectTraverser);
+// ------------------------------------------------------------------------
+// Private function
+// Interprets and stores the results of the last traversal, and cleans up
+// the OSG intersectors
+// ------------------------------------------------------------------------
+void vsIntersect::finishIntersection()
+{
+    osgUtil::LineSegmentIntersector *segmentIntersector;
+    osgUtil::LineSegmentIntersector::Intersections *intersections;
+    osgUtil::LineSegmentIntersector::Intersections::const_iterator iterator;
+    const SegIntersection * intersection;
+    osg::Vec3 polyNormal;
+    vsLineSegment *segment;
+    atVector viewVec, normalVec;
+    double viewDot;
+    int loop;
 
     // Interpret and store the results.
     for (loop = 0; loop < segListSize; loop++)
     {
         // Attempt to retrieve the segment intersector at this index. If there
         // was no intersector defined then no intersection could have occurred.
-        segmentIntersector = segmentIntersectors[loop];
+        segmentIntersector = segIntersectors[loop];
         if ((segmentIntersector != NULL) &&
             (segmentIntersector->containsIntersections()))
         {
@@ -716,15 +731,108 @@ void vsIntersect::intersect(vsNode *targetNode)
     for (loop = 0; loop < segListSize; loop++)
     {
         // Unref the segment
-        if (segmentIntersectors[loop] != NULL)
-            segmentIntersectors[loop]->unref();
+        if (segIntersectors[loop] != NULL)
+        {
+            segIntersectors[loop]->unref();
+            segIntersectors[loop] = NULL;
+        }
     }
 
-    // Delete the array of segment intersectors
-    delete [] segmentIntersectors;
+    // Detach and unref the intersectorGroup
+    intersectTraverser->setIntersector(NULL);
+    osgIsectGroup->unref();
+    osgIsectGroup = NULL;
+}
+
+// ------------------------------------------------------------------------
+// Initiates an intersection traversal over the indicated geometry tree.
+// The results of the traversal are stored and can be retrieved with the
+// getIsect* functions.
+// ------------------------------------------------------------------------
+void vsIntersect::intersect(vsNode *targetNode)
+{
+    osg::Node *osgNode;
+
+    // Set up the intersectors for each segment
+    startIntersection();
+
+    // Fetch the OSG node from the VESS node, and call its accept method
+    // to perform the intersection traversal.
+    osgNode = getBaseLibraryObject(targetNode);
+    if (osgNode != NULL)
+        osgNode->accept(*intersectTraverser);
+
+    // Interpret and store the results
+    finishIntersection();
+}
+
+// ------------------------------------------------------------------------
+// Private static function
+// Thread pool task that runs the traversals for a range of intersectors
+// in a batch
+// ------------------------------------------------------------------------
+void vsIntersect::batchTaskFunc(void *userData, int first, int last)
+{
+    vsIntersectBatch *batch;
+    int i;
+
+    // Get the batch
+    batch = (vsIntersectBatch *)userData;
+
+    // Run the traversal for each intersector
+    for (i = first; i < last; i++)
+        if (batch->intersectList[i] != NULL)
+            batch->osgNode->accept(
+                *(batch->intersectList[i]->intersectTraverser));
+}
+
+// ------------------------------------------------------------------------
+// Static function
+// Runs the intersection traversals for a whole list of intersectors
+// against the same geometry tree.  This is equivalent to calling
+// intersect() on each one, but if useThreads is true, the traversals are
+// spread across the shared thread pool.  The traversals only read the
+// scene, so the tree must not be modified until this method returns.  The
+// result objects are created afterwards on the calling thread.
+// ------------------------------------------------------------------------
+void vsIntersect::intersectBatch(vsIntersect **intersectList,
+                                 int intersectCount, vsNode *targetNode,
+                                 bool useThreads)
+{
+    vsIntersectBatch batch;
+    int i;
+
+    // Make sure there's something to do
+    if ((intersectCount <= 0) || (targetNode == NULL))
+        return;
+
+    // Fetch the OSG node from the VESS node
+    batch.intersectList = intersectList;
+    batch.osgNode = intersectList[0]->getBaseLibraryObject(targetNode);
+
+    // Set up each intersector for the traversal
+    for (i = 0; i < intersectCount; i++)
+        if (intersectList[i] != NULL)
+            intersectList[i]->startIntersection();
+
+    // Run the traversals, one intersector per task
+    if (batch.osgNode != NULL)
+    {
+        // OSG computes bounding volumes lazily, so make sure they're all up
+        // to date before the threads start reading them
+        batch.osgNode->getBound();
+
+        if (useThreads)
+            vsThreadPool::getDefaultPool()->parallelFor(intersectCount, 1,
+                batchTaskFunc, &batch);
+        else
+            batchTaskFunc(&batch, 0, intersectCount);
+    }
 
-    // Unref the intersectorGroup
-    intersectorGroup->unref();
+    // Interpret and store the results
+    for (i = 0; i < intersectCount; i++)
+        if (intersectList[i] != NULL)
+            intersectList[i]->finishIntersection();
 }
 
 // ------------------------------------------------------------------------
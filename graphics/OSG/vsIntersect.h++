@@ -54,6 +54,9 @@ private:
     osgUtil::IntersectorGroup    *osgIsectGroup;
     vsIntersectTraverser         *intersectTraverser;
 
+    osgUtil::LineSegmentIntersector
+                                 *segIntersectors[VS_INTERSECT_SEGS_MAX];
+
     int                          segListSize;
     atArray                      *segList;
     atArray                      *resultList;
@@ -63,11 +66,16 @@ private:
     typedef osgUtil::LineSegmentIntersector::Intersection    SegIntersection;
 
     void                         clearIntersectionResults();
+    void                         startIntersection();
+    void                         finishIntersection();
     void                         populateIntersection(
                                          int index,
                                          const SegIntersection *intersection);
     bool                         isClipped(osg::Node * node, osg::Vec3 point);
 
+    static void                  batchTaskFunc(void *userData, int first,
+                                               int last);
+
 public:
 
                          vsIntersect();
@@ -111,6 +119,9 @@ public:
     int                  getLODTravMode();
 
     void                 intersect(vsNode *targetNode);
+    static void          intersectBatch(vsIntersect **intersectList,
+                                        int intersectCount,
+                                        vsNode *targetNode, bool useThreads);
 
     vsIntersectResult    *getIntersection(int segNum);
 };
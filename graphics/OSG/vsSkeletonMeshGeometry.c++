@@ -23,7 +23,39 @@
 //------------------------------------------------------------------------
 
 #include "vsSkeletonMeshGeometry.h++"
+#include "vsSkin.h++"
 #include "vsOSGNode.h++"
+#include "vsThreadPool.h++"
+#include <string.h>
+
+// Use the SSE skinning kernel wherever the compiler supports it
+#if defined(__SSE__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && (_M_IX86_FP >= 1))
+    #define VS_SKIN_USE_SSE
+    #include <xmmintrin.h>
+#endif
+
+// Describes a palette skinning job on a single mesh for the thread pool
+struct vsSkinMeshTask
+{
+    vsSkeletonMeshGeometry    *mesh;
+    float                     *bonePalette;
+    float                     *itBonePalette;
+};
+
+// ------------------------------------------------------------------------
+// Static function
+// Thread pool task that skins a range of four-vertex groups on one mesh
+// ------------------------------------------------------------------------
+static void skinMeshTaskFunc(void *userData, int first, int last)
+{
+    vsSkinMeshTask *task;
+
+    // Skin the groups of vertices in the given range
+    task = (vsSkinMeshTask *)userData;
+    task->mesh->skinVertices(task->bonePalette, task->itBonePalette,
+        first * 4, last * 4);
+}
 
 // ------------------------------------------------------------------------
 // Default Constructor - Creates an OSG geode and geometry and connects
@@ -33,6 +65,8 @@
 vsSkeletonMeshGeometry::vsSkeletonMeshGeometry() 
                       : vsGeometryBase()
 {
+    int i;
+
     // Vertex array, a copy to keep in its original form unmodified by the
     // skeleton.
     originalVertexList = new osg::Vec3Array();
@@ -43,6 +77,21 @@ vsSkeletonMeshGeometry::vsSkeletonMeshGeometry()
     originalNormalList = new osg::Vec3Array();
     originalNormalList->ref();
 
+    // The structure-of-arrays skinning data is built on demand
+    for (i = 0; i < 3; i++)
+    {
+        skinVertexData[i] = NULL;
+        skinNormalData[i] = NULL;
+    }
+    for (i = 0; i < VS_SKIN_MAX_INFLUENCES; i++)
+    {
+        skinWeightData[i] = NULL;
+        skinBoneData[i] = NULL;
+    }
+    skinDataSize = 0;
+    skinBoneCount = 0;
+    skinDataDirty = true;
+
     // Since this geometry is dynamic (i.e.: it will change every frame),
     // disable display listing of the geometry data, and set its data
     // variance to dynamic
@@ -70,6 +119,9 @@ vsSkeletonMeshGeometry::~vsSkeletonMeshGeometry()
     originalVertexList->unref();
     originalNormalList->unref();
 
+    // Destroy the skinning copy of the vertex data
+    deleteSkinData();
+
     // Unregister this node and get rid of its vsOSGNode wrapper
     nodeRefObj = getMap()->removeLink(this, VS_OBJMAP_FIRST_LIST);
     delete nodeRefObj;
@@ -544,6 +596,9 @@ void vsSkeletonMeshGeometry::setData(int whichData, int dataIndex,
             break;
     }
 
+    // The skinning copy of the vertex data is now out of date
+    skinDataDirty = true;
+
     // Let the appropriate OSG data array know that it's data has changed
     notifyOSGDataChanged(whichData);
 }
@@ -832,6 +887,9 @@ void vsSkeletonMeshGeometry::setDataList(int whichData, atVector *dataBuffer)
             break;
     }
 
+    // The skinning copy of the vertex data is now out of date
+    skinDataDirty = true;
+
     // Let the appropriate OSG data array know that it's data has changed
     notifyOSGDataChanged(whichData);
 }
@@ -1113,6 +1171,9 @@ void vsSkeletonMeshGeometry::setDataListSize(int whichData, int newSize)
     }
     dataListSize[slotNum] = newSize;
 
+    // The skinning copy of the vertex data is now out of date
+    skinDataDirty = true;
+
     // Let the appropriate OSG data array know that it's data has changed
     notifyOSGDataChanged(whichData);
 
@@ -1211,6 +1272,9 @@ void vsSkeletonMeshGeometry::deindexGeometry()
         originalVertexList->assign(vertexList->begin(), vertexList->end());
     if (normalList != NULL)
         originalNormalList->assign(normalList->begin(), normalList->end());
+
+    // The skinning copy of the vertex data is now out of date
+    skinDataDirty = true;
 }
 
 // ------------------------------------------------------------------------
@@ -1255,6 +1319,9 @@ void vsSkeletonMeshGeometry::optimizeVertices()
         originalVertexList->assign(vertexList->begin(), vertexList->end());
     if (normalList != NULL)
         originalNormalList->assign(normalList->begin(), normalList->end());
+
+    // The skinning copy of the vertex data is now out of date
+    skinDataDirty = true;
 }
 
 // ------------------------------------------------------------------------
@@ -1383,6 +1450,535 @@ void vsSkeletonMeshGeometry::applySkin(atArray *boneMatrices,
     }
 }
 
+// ------------------------------------------------------------------------
+// Apply the skin based on flattened skin matrix palettes, as built by
+// vsSkin.  Each palette holds boneCount entries of VS_SKIN_PALETTE_STRIDE
+// floats (the top three rows of each bone's matrix).  The math is the same
+// as the atArray version above, but the vertices are processed four at a
+// time from the structure-of-arrays copy of the vertex data, and large
+// meshes are split across the default thread pool.
+// ------------------------------------------------------------------------
+void vsSkeletonMeshGeometry::applySkin(float *bonePalette,
+                                       float *itBonePalette, int boneCount)
+{
+    vsSkinMeshTask task;
+    int groupCount;
+
+    // Make sure the skinning data is ready to go
+    if (!prepareSkin(boneCount))
+        return;
+
+    // Set up the task description
+    task.mesh = this;
+    task.bonePalette = bonePalette;
+    task.itBonePalette = itBonePalette;
+
+    // Split the mesh into groups of four vertices, and hand them to the
+    // thread pool
+    groupCount = (getSkinVertexCount() + 3) / 4;
+    vsThreadPool::getDefaultPool()->parallelFor(groupCount,
+        VS_SKIN_GROUPS_PER_TASK, skinMeshTaskFunc, &task);
+
+    // Tell OSG it has new vertex and normal data
+    finishSkin();
+}
+
+// ------------------------------------------------------------------------
+// Internal function
+// Makes sure the structure-of-arrays copy of the vertex data is up to date
+// and valid for the given number of bones.  Returns false (and prints a
+// message) if the mesh can't be skinned.
+// ------------------------------------------------------------------------
+bool vsSkeletonMeshGeometry::prepareSkin(int boneCount)
+{
+    // Rebuild the skinning data if anything changed since the last time
+    if ((skinDataDirty) || (boneCount != skinBoneCount))
+        return updateSkinData(boneCount);
+
+    return true;
+}
+
+// ------------------------------------------------------------------------
+// Internal function
+// Returns the number of vertices that will be skinned by skinVertices()
+// ------------------------------------------------------------------------
+int vsSkeletonMeshGeometry::getSkinVertexCount()
+{
+    return dataListSize[VS_GEOMETRY_VERTEX_COORDS];
+}
+
+// ------------------------------------------------------------------------
+// Internal function
+// Skins the vertices in the range [firstVertex, lastVertex) using the
+// given palettes.  The first vertex must be a multiple of four.
+// prepareSkin() must have been called first, and finishSkin() must be
+// called once all vertices have been skinned.  Disjoint ranges may be
+// skinned from different threads at the same time.
+// ------------------------------------------------------------------------
+void vsSkeletonMeshGeometry::skinVertices(float *bonePalette,
+                                          float *itBonePalette,
+                                          int firstVertex, int lastVertex)
+{
+    float *vertexOut;
+    float *normalOut;
+    int vertexCount;
+    int i, j, k;
+    int laneCount;
+    float result[6][4];
+
+    // Get the output arrays (OSG stores these as packed floats)
+    vertexCount = dataListSize[VS_GEOMETRY_VERTEX_COORDS];
+    if (vertexCount == 0)
+        return;
+    vertexOut = (float *)
+        &((*((osg::Vec3Array *)dataList[VS_GEOMETRY_VERTEX_COORDS]))[0]);
+    normalOut = (float *)
+        &((*((osg::Vec3Array *)dataList[VS_GEOMETRY_NORMALS]))[0]);
+
+    // Clamp the range to the mesh
+    if (lastVertex > vertexCount)
+        lastVertex = vertexCount;
+
+    // Process the vertices in groups of four
+    for (i = firstVertex; i < lastVertex; i += 4)
+    {
+#ifdef VS_SKIN_USE_SSE
+
+        __m128 zero, one;
+        __m128 vx, vy, vz;
+        __m128 nx, ny, nz;
+        __m128 position[3];
+        __m128 normal[3];
+        __m128 weight;
+        __m128 col0, col1, col2, col3;
+        __m128 lengthSq, scale, mask;
+        int base[4];
+        int r;
+
+        // Load the original positions and normals for all four vertices
+        vx = _mm_loadu_ps(&skinVertexData[0][i]);
+        vy = _mm_loadu_ps(&skinVertexData[1][i]);
+        vz = _mm_loadu_ps(&skinVertexData[2][i]);
+        nx = _mm_loadu_ps(&skinNormalData[0][i]);
+        ny = _mm_loadu_ps(&skinNormalData[1][i]);
+        nz = _mm_loadu_ps(&skinNormalData[2][i]);
+
+        // Clear the accumulators
+        zero = _mm_setzero_ps();
+        one = _mm_set1_ps(1.0f);
+        for (r = 0; r < 3; r++)
+        {
+            position[r] = zero;
+            normal[r] = zero;
+        }
+
+        // Accumulate the weighted, transformed positions and normals for
+        // each influence
+        for (k = 0; k < VS_SKIN_MAX_INFLUENCES; k++)
+        {
+            // Skip this influence if none of the four vertices use it
+            weight = _mm_loadu_ps(&skinWeightData[k][i]);
+            if (_mm_movemask_ps(_mm_cmpneq_ps(weight, zero)) == 0)
+                continue;
+
+            // Find each vertex's bone in the palettes
+            for (j = 0; j < 4; j++)
+                base[j] = skinBoneData[k][i + j] * VS_SKIN_PALETTE_STRIDE;
+
+            // Work on one output row at a time.  Transposing the four
+            // bones' rows gives one register per matrix column, lined up
+            // with the vertex components.
+            for (r = 0; r < 3; r++)
+            {
+                // Transform the positions
+                col0 = _mm_loadu_ps(&bonePalette[base[0] + r * 4]);
+                col1 = _mm_loadu_ps(&bonePalette[base[1] + r * 4]);
+                col2 = _mm_loadu_ps(&bonePalette[base[2] + r * 4]);
+                col3 = _mm_loadu_ps(&bonePalette[base[3] + r * 4]);
+                _MM_TRANSPOSE4_PS(col0, col1, col2, col3);
+                position[r] = _mm_add_ps(position[r], _mm_mul_ps(weight,
+                    _mm_add_ps(_mm_add_ps(_mm_mul_ps(col0, vx),
+                    _mm_mul_ps(col1, vy)), _mm_add_ps(_mm_mul_ps(col2, vz),
+                    col3))));
+
+                // Transform the normals using the inverse transpose
+                // matrices (the translation column doesn't apply)
+                col0 = _mm_loadu_ps(&itBonePalette[base[0] + r * 4]);
+                col1 = _mm_loadu_ps(&itBonePalette[base[1] + r * 4]);
+                col2 = _mm_loadu_ps(&itBonePalette[base[2] + r * 4]);
+                col3 = _mm_loadu_ps(&itBonePalette[base[3] + r * 4]);
+                _MM_TRANSPOSE4_PS(col0, col1, col2, col3);
+                normal[r] = _mm_add_ps(normal[r], _mm_mul_ps(weight,
+                    _mm_add_ps(_mm_add_ps(_mm_mul_ps(col0, nx),
+                    _mm_mul_ps(col1, ny)), _mm_mul_ps(col2, nz))));
+            }
+        }
+
+        // Re-normalize the normals (leaving any zero-length normals alone)
+        lengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(normal[0], normal[0]),
+            _mm_mul_ps(normal[1], normal[1])),
+            _mm_mul_ps(normal[2], normal[2]));
+        mask = _mm_cmpgt_ps(lengthSq, zero);
+        scale = _mm_div_ps(one, _mm_sqrt_ps(lengthSq));
+        scale = _mm_or_ps(_mm_and_ps(mask, scale), _mm_andnot_ps(mask, one));
+
+        // Stash the results so we can interleave them into the output
+        for (r = 0; r < 3; r++)
+        {
+            _mm_storeu_ps(result[r], position[r]);
+            _mm_storeu_ps(result[r + 3], _mm_mul_ps(normal[r], scale));
+        }
+
+#else
+
+        float *matrix;
+        float weight;
+        float x, y, z;
+        float lengthSq, scale;
+        int bone;
+
+        // Clear the results
+        memset(result, 0, sizeof(result));
+
+        // Handle each of the four vertices in turn
+        for (j = 0; j < 4; j++)
+        {
+            // Get the original position
+            x = skinVertexData[0][i + j];
+            y = skinVertexData[1][i + j];
+            z = skinVertexData[2][i + j];
+
+            // Accumulate the weighted, transformed position for each
+            // influence
+            for (k = 0; k < VS_SKIN_MAX_INFLUENCES; k++)
+            {
+                weight = skinWeightData[k][i + j];
+                if (weight == 0.0f)
+                    continue;
+
+                bone = skinBoneData[k][i + j];
+                matrix = &bonePalette[bone * VS_SKIN_PALETTE_STRIDE];
+                result[0][j] += weight * (matrix[0] * x + matrix[1] * y +
+                    matrix[2] * z + matrix[3]);
+                result[1][j] += weight * (matrix[4] * x + matrix[5] * y +
+                    matrix[6] * z + matrix[7]);
+                result[2][j] += weight * (matrix[8] * x + matrix[9] * y +
+                    matrix[10] * z + matrix[11]);
+            }
+
+            // Get the original normal
+            x = skinNormalData[0][i + j];
+            y = skinNormalData[1][i + j];
+            z = skinNormalData[2][i + j];
+
+            // Accumulate the weighted, transformed normal for each influence
+            for (k = 0; k < VS_SKIN_MAX_INFLUENCES; k++)
+            {
+                weight = skinWeightData[k][i + j];
+                if (weight == 0.0f)
+                    continue;
+
+                bone = skinBoneData[k][i + j];
+                matrix = &itBonePalette[bone * VS_SKIN_PALETTE_STRIDE];
+                result[3][j] += weight * (matrix[0] * x + matrix[1] * y +
+                    matrix[2] * z);
+                result[4][j] += weight * (matrix[4] * x + matrix[5] * y +
+                    matrix[6] * z);
+                result[5][j] += weight * (matrix[8] * x + matrix[9] * y +
+                    matrix[10] * z);
+            }
+
+            // Re-normalize the normal
+            lengthSq = result[3][j] * result[3][j] +
+                result[4][j] * result[4][j] + result[5][j] * result[5][j];
+            if (lengthSq > 0.0f)
+            {
+                scale = 1.0f / sqrtf(lengthSq);
+                result[3][j] *= scale;
+                result[4][j] *= scale;
+                result[5][j] *= scale;
+            }
+        }
+
+#endif
+
+        // Figure out how many of the four vertices are real (the last group
+        // may be padding)
+        laneCount = lastVertex - i;
+        if (laneCount > 4)
+            laneCount = 4;
+
+        // Write the final vertices and normals to the OSG arrays
+        for (j = 0; j < laneCount; j++)
+        {
+            vertexOut[(i + j) * 3 + 0] = result[0][j];
+            vertexOut[(i + j) * 3 + 1] = result[1][j];
+            vertexOut[(i + j) * 3 + 2] = result[2][j];
+            normalOut[(i + j) * 3 + 0] = result[3][j];
+            normalOut[(i + j) * 3 + 1] = result[4][j];
+            normalOut[(i + j) * 3 + 2] = result[5][j];
+        }
+    }
+}
+
+// ------------------------------------------------------------------------
+// Internal function
+// Lets OSG know that the skinned vertices and normals have changed.  This
+// must be called from the main thread once skinning is complete.
+// ------------------------------------------------------------------------
+void vsSkeletonMeshGeometry::finishSkin()
+{
+    notifyOSGDataChanged(VS_GEOMETRY_VERTEX_COORDS);
+    notifyOSGDataChanged(VS_GEOMETRY_NORMALS);
+}
+
+// ------------------------------------------------------------------------
+// Internal function
+// Returns a pointer to the packed floating-point data of the specified
+// list, and the number of elements and components per element in it.
+// VS_GEOMETRY_SKIN_VERTEX_COORDS and VS_GEOMETRY_SKIN_NORMALS return the
+// original (unskinned) vertices and normals.  Returns NULL if the list is
+// empty or not available.
+// ------------------------------------------------------------------------
+float *vsSkeletonMeshGeometry::getRawDataList(int whichData, int *dataCount,
+                                              int *componentCount)
+{
+    // Return the original data lists directly
+    if (whichData == VS_GEOMETRY_SKIN_VERTEX_COORDS)
+    {
+        *dataCount = originalVertexList->size();
+        *componentCount = 3;
+        if (*dataCount == 0)
+            return NULL;
+        return (float *)(originalVertexList->getDataPointer());
+    }
+    else if (whichData == VS_GEOMETRY_SKIN_NORMALS)
+    {
+        *dataCount = originalNormalList->size();
+        *componentCount = 3;
+        if (*dataCount == 0)
+            return NULL;
+        return (float *)(originalNormalList->getDataPointer());
+    }
+
+    // Any other list is handled normally
+    return vsGeometryBase::getRawDataList(whichData, dataCount,
+        componentCount);
+}
+
+// ------------------------------------------------------------------------
+// Internal function
+// Resizes the specified list and copies all of the data for it from the
+// given buffer.  As with setDataList(), the vertices and normals must be
+// set using VS_GEOMETRY_SKIN_VERTEX_COORDS and VS_GEOMETRY_SKIN_NORMALS,
+// which set both the original and skinned lists.
+// ------------------------------------------------------------------------
+void vsSkeletonMeshGeometry::setRawDataList(int whichData, float *dataBuffer,
+                                            int dataCount)
+{
+    osg::Vec3Array *originalList;
+
+    // The skinned vertex coordinates and normals can't be set directly
+    if ((whichData == VS_GEOMETRY_VERTEX_COORDS) ||
+        (whichData == VS_GEOMETRY_NORMALS))
+    {
+        printf("vsSkeletonMeshGeometry::setRawDataList: Cannot set vertex "
+            "coords or normals; they are generated based on bone "
+            "positions.\n");
+        return;
+    }
+
+    // Handle the original data lists
+    if ((whichData == VS_GEOMETRY_SKIN_VERTEX_COORDS) ||
+        (whichData == VS_GEOMETRY_SKIN_NORMALS))
+    {
+        // Resize both the original and skinned lists
+        setDataListSize(whichData, dataCount);
+
+        // Figure out which lists we're setting
+        if (whichData == VS_GEOMETRY_SKIN_VERTEX_COORDS)
+        {
+            whichData = VS_GEOMETRY_VERTEX_COORDS;
+            originalList = originalVertexList;
+        }
+        else
+        {
+            whichData = VS_GEOMETRY_NORMALS;
+            originalList = originalNormalList;
+        }
+
+        // Make sure the resize worked
+        if ((dataListSize[whichData] != dataCount) ||
+            ((int)originalList->size() != dataCount))
+            return;
+
+        // Copy the data into both lists (the skinned list starts out the
+        // same as the original)
+        if (dataCount > 0)
+        {
+            memcpy(originalList->getDataPointer(), dataBuffer,
+                sizeof(float) * 3 * dataCount);
+            memcpy(getDataPointer(whichData), dataBuffer,
+                sizeof(float) * 3 * dataCount);
+        }
+
+        // The skinning copy of the vertex data is now out of date
+        skinDataDirty = true;
+
+        // Let the appropriate OSG data array know that it's data has changed
+        notifyOSGDataChanged(whichData);
+        return;
+    }
+
+    // Any other list is set normally
+    vsGeometryBase::setRawDataList(whichData, dataBuffer, dataCount);
+
+    // The skinning copy of the vertex data is now out of date
+    skinDataDirty = true;
+}
+
+// ------------------------------------------------------------------------
+// Frees the structure-of-arrays copy of the vertex data
+// ------------------------------------------------------------------------
+void vsSkeletonMeshGeometry::deleteSkinData()
+{
+    int i;
+
+    // Delete each of the lists
+    for (i = 0; i < 3; i++)
+    {
+        if (skinVertexData[i] != NULL)
+            delete [] skinVertexData[i];
+        skinVertexData[i] = NULL;
+        if (skinNormalData[i] != NULL)
+            delete [] skinNormalData[i];
+        skinNormalData[i] = NULL;
+    }
+    for (i = 0; i < VS_SKIN_MAX_INFLUENCES; i++)
+    {
+        if (skinWeightData[i] != NULL)
+            delete [] skinWeightData[i];
+        skinWeightData[i] = NULL;
+        if (skinBoneData[i] != NULL)
+            delete [] skinBoneData[i];
+        skinBoneData[i] = NULL;
+    }
+
+    // No data now
+    skinDataSize = 0;
+}
+
+// ------------------------------------------------------------------------
+// Rebuilds the structure-of-arrays copy of the original vertices,
+// normals, weights and bone indices that the palette skinning path works
+// from.  Influences that refer to a bone outside of the palette are given
+// a weight of zero.  Returns false if the mesh's lists don't match up.
+// ------------------------------------------------------------------------
+bool vsSkeletonMeshGeometry::updateSkinData(int boneCount)
+{
+    osg::Vec4Array *weightList;
+    osg::Vec4Array *boneList;
+    int vertexListSize;
+    int normalListSize;
+    int weightListSize;
+    int boneListSize;
+    int paddedSize;
+    int i, k;
+    int bone;
+
+    // Get the list sizes
+    vertexListSize = dataListSize[VS_GEOMETRY_VERTEX_COORDS];
+    normalListSize = dataListSize[VS_GEOMETRY_NORMALS];
+    weightListSize = dataListSize[VS_GEOMETRY_VERTEX_WEIGHTS];
+    boneListSize = dataListSize[VS_GEOMETRY_BONE_INDICES];
+
+    // All of the relevant lists must be the same size
+    if ((vertexListSize != normalListSize) ||
+        (normalListSize != weightListSize) ||
+        (weightListSize != boneListSize))
+    {
+        printf("vsSkeletonMeshGeometry::applySkin:  List size mismatch!\n");
+        printf("    vertices = %d\n", vertexListSize);
+        printf("    normals  = %d\n", normalListSize);
+        printf("    weights  = %d\n", weightListSize);
+        printf("    bone idx = %d\n", boneListSize);
+        return false;
+    }
+
+    // Pad the lists out to a multiple of four vertices
+    paddedSize = (vertexListSize + 3) & ~3;
+
+    // Reallocate the lists if the size changed
+    if (paddedSize != skinDataSize)
+    {
+        deleteSkinData();
+        for (i = 0; i < 3; i++)
+        {
+            skinVertexData[i] = new float[paddedSize];
+            skinNormalData[i] = new float[paddedSize];
+        }
+        for (k = 0; k < VS_SKIN_MAX_INFLUENCES; k++)
+        {
+            skinWeightData[k] = new float[paddedSize];
+            skinBoneData[k] = new int[paddedSize];
+        }
+        skinDataSize = paddedSize;
+    }
+
+    // Get the weight and bone index lists
+    weightList = (osg::Vec4Array *) dataList[VS_GEOMETRY_VERTEX_WEIGHTS];
+    boneList = (osg::Vec4Array *) dataList[VS_GEOMETRY_BONE_INDICES];
+
+    // Split the data out into separate lists
+    for (i = 0; i < paddedSize; i++)
+    {
+        // Padding vertices have no influences
+        if (i >= vertexListSize)
+        {
+            for (k = 0; k < 3; k++)
+            {
+                skinVertexData[k][i] = 0.0f;
+                skinNormalData[k][i] = 0.0f;
+            }
+            for (k = 0; k < VS_SKIN_MAX_INFLUENCES; k++)
+            {
+                skinWeightData[k][i] = 0.0f;
+                skinBoneData[k][i] = 0;
+            }
+            continue;
+        }
+
+        // Copy the original vertex and normal
+        for (k = 0; k < 3; k++)
+        {
+            skinVertexData[k][i] = (*originalVertexList)[i][k];
+            skinNormalData[k][i] = (*originalNormalList)[i][k];
+        }
+
+        // Copy the influences, dropping any that reference a bone that
+        // isn't in the palette
+        for (k = 0; k < VS_SKIN_MAX_INFLUENCES; k++)
+        {
+            bone = (int)((*boneList)[i][k]);
+            if ((bone >= 0) && (bone < boneCount))
+            {
+                skinWeightData[k][i] = (*weightList)[i][k];
+                skinBoneData[k][i] = bone;
+            }
+            else
+            {
+                skinWeightData[k][i] = 0.0f;
+                skinBoneData[k][i] = 0;
+            }
+        }
+    }
+
+    // The skinning data is now current
+    skinBoneCount = boneCount;
+    skinDataDirty = false;
+    return true;
+}
+
 // ------------------------------------------------------------------------
 // This method resets the mesh to the original vertex and normal
 // coordinates.  That is, it resets the mesh to its default pose, as if
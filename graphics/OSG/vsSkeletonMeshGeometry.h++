@@ -34,6 +34,13 @@
 
 #define VS_GEOMETRY_BONE_INDICES       VS_GEOMETRY_USER_DATA1
 
+// Number of floats used by each bone in a flattened skin matrix palette
+// (the top three rows of the bone's matrix, stored row by row)
+#define VS_SKIN_PALETTE_STRIDE         12
+
+// Maximum number of bone influences per vertex
+#define VS_SKIN_MAX_INFLUENCES         4
+
 class VESS_SYM vsSkeletonMeshGeometry : public vsGeometryBase
 {
 protected:
@@ -41,6 +48,34 @@ protected:
     osg::Vec3Array      *originalVertexList;
     osg::Vec3Array      *originalNormalList;
 
+    // Structure-of-arrays copy of the original vertex data, used by the
+    // palette-based software skinning path.  Each list is padded to a
+    // multiple of four vertices
+    float               *skinVertexData[3];
+    float               *skinNormalData[3];
+    float               *skinWeightData[VS_SKIN_MAX_INFLUENCES];
+    int                 *skinBoneData[VS_SKIN_MAX_INFLUENCES];
+    int                 skinDataSize;
+    int                 skinBoneCount;
+    bool                skinDataDirty;
+
+    void                deleteSkinData();
+    bool                updateSkinData(int boneCount);
+
+VS_INTERNAL:
+
+    bool                  prepareSkin(int boneCount);
+    int                   getSkinVertexCount();
+    void                  skinVertices(float *bonePalette,
+                                       float *itBonePalette,
+                                       int firstVertex, int lastVertex);
+    void                  finishSkin();
+
+    virtual float         *getRawDataList(int whichData, int *dataCount,
+                                          int *componentCount);
+    virtual void          setRawDataList(int whichData, float *dataBuffer,
+                                         int dataCount);
+
 public:
 
                           vsSkeletonMeshGeometry();
@@ -68,6 +103,8 @@ public:
 
     void                  applySkin(atArray *boneMatrices,
                                     atArray *ITBoneMatrices);
+    void                  applySkin(float *bonePalette,
+                                    float *itBonePalette, int boneCount);
     void                  resetSkin();
 
 };
@@ -29,18 +29,45 @@
 #include "vsTransformAttribute.h++"
 #include "vsSwitchAttribute.h++"
 #include "vsSequenceAttribute.h++"
+#include "vsThreadPool.h++"
+#include <stdlib.h>
+#include <string.h>
+
+// Information about a batch of intersectors for the thread pool
+struct vsSphereIntersectBatch
+{
+    vsSphereIntersect    **intersectList;
+    vsNode               *targetNode;
+};
 
 // ------------------------------------------------------------------------
 // Constructor - Initializes the sphere list
 // ------------------------------------------------------------------------
 vsSphereIntersect::vsSphereIntersect()
 {
+    int i;
+
     // Initialize the sphere list
     sphereListSize = 0;
 
     // Initialize the list of nodes in the current intersection path
     pathsEnabled = 0;
-    currentPath = new vsList();
+    currentPath = NULL;
+    currentPathLength = 0;
+    currentPathSize = 0;
+
+    // No intersection paths recorded yet
+    for (i = 0; i < VS_SPH_ISECT_MAX_SPHERES; i++)
+    {
+        hitGeometry[i] = NULL;
+        hitPath[i] = NULL;
+        hitPathLength[i] = 0;
+        hitPathSize[i] = 0;
+    }
+
+    // The triangle candidate list is allocated as needed
+    candidateList = NULL;
+    candidateListSize = 0;
 
     // Initialize grouping traversal modes
     switchTravMode = VS_SPH_ISECT_SWITCH_CURRENT;
@@ -53,8 +80,20 @@ vsSphereIntersect::vsSphereIntersect()
 // ------------------------------------------------------------------------
 vsSphereIntersect::~vsSphereIntersect()
 {
-   // Clean up the list containing the current traversal path
-   delete currentPath;
+    int i;
+
+    // Clean up the list containing the current traversal path
+    if (currentPath != NULL)
+        free(currentPath);
+
+    // Clean up the saved intersection paths
+    for (i = 0; i < VS_SPH_ISECT_MAX_SPHERES; i++)
+        if (hitPath[i] != NULL)
+            free(hitPath[i]);
+
+    // Clean up the triangle candidate list
+    if (candidateList != NULL)
+        free(candidateList);
 }
 
 // ------------------------------------------------------------------------
@@ -576,8 +615,9 @@ atVector vsSphereIntersect::getNormal(vsGeometry *geometry, int aIndex,
 
 // ------------------------------------------------------------------------
 // VESS internal function.  Tests the given sphere in the sphere list with
-// the given vsGeometry object.  Updates the appropriate intersection
-// result object in the results list as necessary
+// the given vsGeometry object.  Records the closest intersection for the
+// sphere as necessary.  Only the triangles that the geometry's triangle
+// hierarchy reports as being near the sphere are tested.
 // ------------------------------------------------------------------------
 void vsSphereIntersect::intersectWithGeometry(int sphIndex, 
                                               vsGeometry *geometry)
@@ -585,10 +625,15 @@ void vsSphereIntersect::intersectWithGeometry(int sphIndex,
     vsSphere *sphere;
     atVector center;
     double radius;
-    int i, j;
-    int primCount;
-    int triCount;
-    int lengthSum;
+    vsTriangleBVH *triangleBVH;
+    vsTriangleBVHTriangle *triangle;
+    atMatrix invXform;
+    atVector localCenter;
+    double localRadius;
+    double scaleSqr;
+    int candidateCount;
+    int i, j, k;
+    int candidate;
     atVector a, b, c;
     int aIndex, bIndex, cIndex;
     atVector point;
@@ -600,235 +645,137 @@ void vsSphereIntersect::intersectWithGeometry(int sphIndex,
     double localSqrDist;
     int closestPrim;
     atVector closestNormal;
-    int closestVertIndices[3];
-    vsIntersectResult *sectResult;
-    vsList *sectPath;
     atVector distVec;
-    vsNode *currentNode;
 
     // Get the center point and radius of the sphere
     sphere = (vsSphere *)sphereList.getEntry(sphIndex);
     center = sphere->getCenterPoint();
     radius = sphere->getRadius();
 
-    // Get the number of primitives in the geometry
-    primCount = geometry->getPrimitiveCount();
+    // Get the geometry's triangle hierarchy.  If there isn't one, the
+    // geometry doesn't have any triangles (this method doesn't work with
+    // points or lines)
+    triangleBVH = geometry->getTriangleBVH();
+    if (triangleBVH == NULL)
+        return;
+
+    // Transform the sphere into the geometry's local coordinates.  The
+    // radius is scaled by the Frobenius norm of the inverse transform,
+    // which bounds the largest scale factor the transform can apply, so the
+    // local sphere is guaranteed to contain the transformed original.
+    invXform = currentXform.getInverse();
+    localCenter = invXform.getPointXform(center);
+    scaleSqr = 0.0;
+    for (i = 0; i < 3; i++)
+        for (j = 0; j < 3; j++)
+            scaleSqr += AT_SQR(invXform[i][j]);
+    localRadius = radius * sqrt(scaleSqr);
+
+    // Find the triangles that might touch the sphere
+    candidateCount = triangleBVH->findSphereTriangles(localCenter,
+        localRadius, &candidateList, &candidateListSize);
+
+    // Sort the candidates back into their order in the geometry, so that
+    // ties between equally close triangles are resolved the same way
+    // regardless of how the hierarchy was built (there are usually only a
+    // handful of candidates, so an insertion sort is fine)
+    for (i = 1; i < candidateCount; i++)
+    {
+        candidate = candidateList[i];
+        k = triangleBVH->getTriangle(candidate)->triangleIndex;
+        j = i - 1;
+        while ((j >= 0) &&
+            (triangleBVH->getTriangle(candidateList[j])->triangleIndex > k))
+        {
+            candidateList[j + 1] = candidateList[j];
+            j--;
+        }
+        candidateList[j + 1] = candidate;
+    }
 
     // Initialize the local square distance variable (used to remember the
     // closest point so far) to a large number
     localSqrDist = 1.0e9;
 
-    // Initialize the length accumulator (this is used so we don't
-    // have to sum the lengths array up to the current i to compute the 
-    // index of the next triangle's first vertex in the j loop below)
-    lengthSum = 0;
-
-    // For each primitive
-    for (i = 0; i < primCount; i++)
+    // Intersect the sphere with each candidate triangle
+    for (i = 0; i < candidateCount; i++)
     {
-        // We need to triangulate each primitive if not already using
-        // triangles.  First, compute the number of triangles.
-        switch (geometry->getPrimitiveType())
+        // Get the triangle and the indices of its vertices
+        triangle = triangleBVH->getTriangle(candidateList[i]);
+        aIndex = triangle->vertexIndex[0];
+        bIndex = triangle->vertexIndex[1];
+        cIndex = triangle->vertexIndex[2];
+
+        // The hierarchy reverses every other strip triangle the way OSG
+        // does, but sphere intersection has always taken strip triangles
+        // in the order their vertices appear in the strip (which decides
+        // the direction of normals computed from the triangle), so put
+        // those triangles back the way they were
+        if (triangle->windingSwapped)
         {
-            case VS_GEOMETRY_TYPE_POINTS:
-            case VS_GEOMETRY_TYPE_LINES:
-            case VS_GEOMETRY_TYPE_LINE_STRIPS:
-            case VS_GEOMETRY_TYPE_LINE_LOOPS:
-                // This method does not work with points or lines
-                // JPD:  This wouldn't be hard to implement at all, we should
-                //       do so at some point
-                return;
-                break;
- 
-            case VS_GEOMETRY_TYPE_TRIS:
-                // Trivial case, one triangle per triangle
-                triCount = 1;
-                break;
-
-            case VS_GEOMETRY_TYPE_TRI_STRIPS:
-            case VS_GEOMETRY_TYPE_TRI_FANS:
-                // Look up the vertex count in the lengths array and
-                // subtract 2 to get the number of triangles
-                triCount = geometry->getPrimitiveLength(i) - 2;
-                break;
-
-            case VS_GEOMETRY_TYPE_QUADS:
-                // 2 triangles per quad
-                triCount = 2;
-                break;
-
-            case VS_GEOMETRY_TYPE_QUAD_STRIPS:
-                // Look up the vertex count in the lengths array.
-                // Number of quads is (numVertices - 2) / 2 and
-                // number of triangles is number of quads * 2, so
-                // number of triangles is simply numVertices - 2
-                triCount = geometry->getPrimitiveLength(i) - 2;
-                break;
-
-            case VS_GEOMETRY_TYPE_POLYS:
-                // Look up the vertex count in the lengths array and
-                // subtract 2 to get the primitive count (essentially same as 
-                // a tri fan).
-                triCount = geometry->getPrimitiveLength(i) - 2;
-                break;
-
-            default:
-                // Invalid primitive type
-                printf("vsSphereIntersect::intersectWithGeometry: "
-                    "Invalid primitive type in geometry\n");
-                return;
-                break;
+            bIndex = triangle->vertexIndex[2];
+            cIndex = triangle->vertexIndex[1];
         }
 
-        // Now intersect the sphere with each triangle of the primitive
-        for (j = 0; j < triCount; j++)
-        {
-            // Extract the jth triangle from the primitive.  This is 
-            // slightly different for each kind of primitive
-            switch (geometry->getPrimitiveType())
-            {
-                case VS_GEOMETRY_TYPE_TRIS:
-                    // Get indices for the three vertices of the triangle
-                    aIndex = 3*i;
-                    bIndex = 3*i + 1;
-                    cIndex = 3*i + 2;
-                    break;
-
-                case VS_GEOMETRY_TYPE_TRI_STRIPS:
-                    // Get the indices of the jth triangle
-                    aIndex = lengthSum + j;
-                    bIndex = lengthSum + j + 1;
-                    cIndex = lengthSum + j + 2;
-                    break;
-
-                case VS_GEOMETRY_TYPE_TRI_FANS:
-                    // Get the indices of the jth triangle
-                    aIndex = lengthSum;
-                    bIndex = lengthSum + j + 1;
-                    cIndex = lengthSum + j + 2;
-                    break;
-
-                case VS_GEOMETRY_TYPE_QUADS:
-                    // Get the indices of the jth triangle
-                    aIndex = 4*i;
-                    bIndex = 4*i + j + 1;
-                    cIndex = 4*i + j + 2;
-                    break;
-
-                case VS_GEOMETRY_TYPE_QUAD_STRIPS:
-                    // Get the indices of the jth triangle
-                    aIndex = lengthSum + j;
-                    bIndex = lengthSum + j + 1;
-                    cIndex = lengthSum + j + 2;
-                    break;
-
-                case VS_GEOMETRY_TYPE_POLYS:
-                    // Get the indices of the jth triangle
-                    aIndex = lengthSum;
-                    bIndex = lengthSum + j + 1;
-                    cIndex = lengthSum + j + 2;
-                    break;
-
-                default:
-                    // Invalid primitive type
-                    printf("vsSphereIntersect::intersectWithGeometry: "
-                        "Invalid primitive type in geometry\n");
-                    return;
-                    break;
-            }
-
-            // See if this geometry is indexed
-            if (geometry->getIndexListSize() > 0)
-            {
-                // For each vertex, fetch the index into the vertex array, as
-                // indicated by the index into the index array
-                aIndex = geometry->getIndex(aIndex);
-                bIndex = geometry->getIndex(bIndex);
-                cIndex = geometry->getIndex(cIndex);
-
-                // Now, fetch the actual vertices
-                a = geometry->getData(VS_GEOMETRY_VERTEX_COORDS, aIndex);
-                b = geometry->getData(VS_GEOMETRY_VERTEX_COORDS, bIndex);
-                c = geometry->getData(VS_GEOMETRY_VERTEX_COORDS, cIndex);
-            }
-            else
-            {
-                // Not indexed, so fetch the vertices directly
-                a = geometry->getData(VS_GEOMETRY_VERTEX_COORDS, aIndex);
-                b = geometry->getData(VS_GEOMETRY_VERTEX_COORDS, bIndex);
-                c = geometry->getData(VS_GEOMETRY_VERTEX_COORDS, cIndex);
-            }
-
-            // Transform the vertices using the transformation matrix
-            // we've accumulated during our traversal
-            a = currentXform.getPointXform(a);
-            b = currentXform.getPointXform(b);
-            c = currentXform.getPointXform(c);
+        // Fetch the vertices and transform them using the transformation
+        // matrix we've accumulated during our traversal
+        a = currentXform.getPointXform(triangleBVH->getVertex(aIndex));
+        b = currentXform.getPointXform(triangleBVH->getVertex(bIndex));
+        c = currentXform.getPointXform(triangleBVH->getVertex(cIndex));
 
-            // Intersect the sphere and triangle
-            result = getClosestPoint(center, a, b, c, &point);
+        // Intersect the sphere and triangle
+        result = getClosestPoint(center, a, b, c, &point);
 
-            // Make sure the closest point is valid (i.e.: ensure that the
-            // triangle we picked was not collinear)
-            if (result)
+        // Make sure the closest point is valid (i.e.: ensure that the
+        // triangle we picked was not collinear)
+        if (result)
+        {
+            // Compute the squared distance and keep track of this 
+            // triangle if it comes as close or closer than any other 
+            // so far.  If it's equally close as another point, use
+            // the normal to break ties.
+            sqrDist = (point - center).getMagnitudeSquared();
+            if (fabs(sqrDist - localSqrDist) < 1.0E-6)
             {
-                // Compute the squared distance and keep track of this 
-                // triangle if it comes as close or closer than any other 
-                // so far.  If it's equally close as another point, use
-                // the normal to break ties.
-                sqrDist = (point - center).getMagnitudeSquared();
-                if (fabs(sqrDist - localSqrDist) < 1.0E-6)
+                // Get the intersection normal
+                normal = getNormal(geometry, aIndex, bIndex, cIndex,
+                    triangle->primitiveIndex);
+
+                // Compute a vector from the intersection point to the
+                // center of the intersecting sphere (call this the
+                // distance vector)
+                distVec = center - point;
+                distVec.normalize();
+
+                // Compute the dot products of the current normal and
+                // the previous closest point's normal with the distance
+                // vector.
+                oldDot = closestNormal.getDotProduct(distVec);
+                newDot = normal.getDotProduct(distVec);
+
+                // The normal that more closely matches the distance 
+                // vector corresponds to the primitive that is facing
+                // the intersection sphere more directly.  We want to
+                // report this primitive as the intersecting primitive.
+                if (newDot > oldDot)
                 {
-                    // Get the intersection normal
-                    normal = getNormal(geometry, aIndex, bIndex, cIndex, i);
-
-                    // Compute a vector from the intersection point to the
-                    // center of the intersecting sphere (call this the
-                    // distance vector)
-                    distVec = center - point;
-                    distVec.normalize();
-
-                    // Compute the dot products of the current normal and
-                    // the previous closest point's normal with the distance
-                    // vector.
-                    oldDot = closestNormal.getDotProduct(distVec);
-                    newDot = normal.getDotProduct(distVec);
-
-                    // The normal that more closely matches the distance 
-                    // vector corresponds to the primitive that is facing
-                    // the intersection sphere more directly.  We want to
-                    // report this primitive as the intersecting primitive.
-                    if (newDot > oldDot)
-                    {
-                        // Record point, normal distance, and primitive
-                        closestPoint = point;
-                        closestNormal = normal;
-                        localSqrDist = sqrDist;
-                        closestPrim = i;
-                        closestVertIndices[0] = aIndex;
-                        closestVertIndices[1] = bIndex;
-                        closestVertIndices[2] = cIndex;
-                    }
-                }
-                else if (sqrDist < localSqrDist)
-                {
-                    // Record point, normal, distance, and primitive
+                    // Record point, normal distance, and primitive
                     closestPoint = point;
-                    closestNormal = 
-                        getNormal(geometry, aIndex, bIndex, cIndex, i);
+                    closestNormal = normal;
                     localSqrDist = sqrDist;
-                    closestPrim = i;
-                    closestVertIndices[0] = aIndex;
-                    closestVertIndices[1] = bIndex;
-                    closestVertIndices[2] = cIndex;
+                    closestPrim = triangle->primitiveIndex;
                 }
             }
+            else if (sqrDist < localSqrDist)
+            {
+                // Record point, normal, distance, and primitive
+                closestPoint = point;
+                closestNormal = getNormal(geometry, aIndex, bIndex, cIndex,
+                    triangle->primitiveIndex);
+                localSqrDist = sqrDist;
+                closestPrim = triangle->primitiveIndex;
+            }
         }
-
-        // Finished with primitive i, add the length of the primitive to
-        // the length accumulator so we know where to start for the next
-        // primitive
-        lengthSum += geometry->getPrimitiveLength(i);
     }
 
     // Evaluate the closest point and see if we've found a closer intersection
@@ -836,27 +783,29 @@ void vsSphereIntersect::intersectWithGeometry(int sphIndex,
     if ((localSqrDist < closestSqrDist[sphIndex]) && 
         (localSqrDist < AT_SQR(radius)))
     {
-        // Create a new intersection result for this intersection
-        sectResult = new vsIntersectResult(closestPoint, closestNormal,
-                                           currentXform, geometry,
-                                           closestPrim);
+        // Remember the details of this intersection (the result object
+        // is created once the traversal is finished)
+        hitGeometry[sphIndex] = geometry;
+        hitPoint[sphIndex] = closestPoint;
+        hitNormal[sphIndex] = closestNormal;
+        hitXform[sphIndex] = currentXform;
+        hitPrim[sphIndex] = closestPrim;
 
-        // Replace any existing result in the list with the new result
-        resultList.setEntry(sphIndex, sectResult);
-                                            
         // Handle the intersection path, if it's enabled
         if (pathsEnabled)
         {
-            // Get the intersection path
-            sectPath = sectResult->getPath();
-
-            // Copy the current path into the sphere's intersect path slot
-            currentNode = (vsNode *) currentPath->getFirstEntry();
-            while (currentNode != NULL)
+            // Make sure there's room for the path
+            if (hitPathSize[sphIndex] < currentPathLength)
             {
-                sectPath->addEntry(currentNode);
-                currentNode = (vsNode *) currentPath->getNextEntry();
+                hitPathSize[sphIndex] = currentPathSize;
+                hitPath[sphIndex] = (vsNode **)realloc(hitPath[sphIndex],
+                    sizeof(vsNode *) * hitPathSize[sphIndex]);
             }
+
+            // Copy the current path into the sphere's intersect path slot
+            memcpy(hitPath[sphIndex], currentPath,
+                sizeof(vsNode *) * currentPathLength);
+            hitPathLength[sphIndex] = currentPathLength;
         }
 
         // Remember this distance as the closest distance for the current
@@ -899,7 +848,18 @@ void vsSphereIntersect::intersectSpheres(vsNode *targetNode)
     // Next, see if paths are enabled and add this node onto the
     // path
     if (pathsEnabled)
-        currentPath->addEntry(targetNode);
+    {
+        // Make sure there's room in the path first
+        if (currentPathLength >= currentPathSize)
+        {
+            currentPathSize = (currentPathSize * 2) + 16;
+            currentPath = (vsNode **)realloc(currentPath,
+                sizeof(vsNode *) * currentPathSize);
+        }
+
+        currentPath[currentPathLength] = targetNode;
+        currentPathLength++;
+    }
 
     // See if this is a leaf node or internal node of the graph
     if (targetNode->getNodeType() == VS_NODE_TYPE_GEOMETRY)
@@ -918,20 +878,20 @@ void vsSphereIntersect::intersectSpheres(vsNode *targetNode)
         }
 
         // See if the intersector's bounding sphere intersects with the 
-        // bounding box.  If not, we need go no farther. 
+        // bounding box.  If not, we need go no farther (but we still have
+        // to fall through so this node comes off of the current path)
         osgBox = osgGeode->getDrawable(0)->getBoundingBox();
-        if (!intersectWithBox(boundSphere, osgBox))
+        if (intersectWithBox(boundSphere, osgBox))
         {
-            return;
-        }
-        
-        // Test the individual spheres against the bounding box and
-        // then against the geometry, if the bounding box test passes
-        for (i = 0; i < sphereListSize; i++)
-        {
-            if (intersectWithBox(*(vsSphere *)sphereList.getEntry(i), osgBox))
+            // Test the individual spheres against the bounding box and
+            // then against the geometry, if the bounding box test passes
+            for (i = 0; i < sphereListSize; i++)
             {
-                intersectWithGeometry(i, (vsGeometry *)targetNode);
+                if (intersectWithBox(*(vsSphere *)sphereList.getEntry(i),
+                    osgBox))
+                {
+                    intersectWithGeometry(i, (vsGeometry *)targetNode);
+                }
             }
         }
     }
@@ -1058,10 +1018,7 @@ void vsSphereIntersect::intersectSpheres(vsNode *targetNode)
 
     // Remove the current node from the current path
     if (pathsEnabled)
-    {
-        currentPath->getLastEntry();
-        currentPath->removeCurrentEntry();
-    }
+        currentPathLength--;
 }
 
 // ------------------------------------------------------------------------
@@ -1294,32 +1251,31 @@ int vsSphereIntersect::getLODTravMode()
 }
 
 // ------------------------------------------------------------------------
-// Initiates an intersection traversal over the indicated geometry tree.
-// The results of the traversal are stored and can be retrieved with the
-// getIsect* functions.
+// Private function.  Prepares for an intersection traversal, clearing out
+// the previous results.  Returns false if there is nothing to intersect.
 // ------------------------------------------------------------------------
-void vsSphereIntersect::intersect(vsNode *targetNode)
+bool vsSphereIntersect::startIntersection()
 {
     vsSphere sphereArray[VS_SPH_ISECT_MAX_SPHERES];
     int i;
-    vsSphere nodeBound;
-    atVector center;
-    double radius;
 
     // Make sure we have at least one sphere to intersect with
     if (sphereListSize <= 0)
-        return;
+        return false;
 
     // Clean up the current intersection results list
     resultList.removeAllEntries();
 
-    // Initialize the current transform
+    // Initialize the current transform and path
     currentXform.setIdentity();
+    currentPathLength = 0;
 
     // Initialize the closest distance variables
     for (i = 0; i < sphereListSize; i++)
     {
         closestSqrDist[i] = 1.0e9;
+        hitGeometry[i] = NULL;
+        hitPathLength[i] = 0;
     }
 
     // Construct a bounding sphere around the intersection spheres
@@ -1329,13 +1285,125 @@ void vsSphereIntersect::intersect(vsNode *targetNode)
     }
     boundSphere.encloseSpheres(sphereArray, sphereListSize);
 
-    // Get the bounding sphere for the target node
-    targetNode->getBoundSphere(&center, &radius);
-    nodeBound.setSphere(center, radius);
+    return true;
+}
+
+// ------------------------------------------------------------------------
+// Private function.  Creates the intersection result objects for the
+// closest intersections found during the traversal
+// ------------------------------------------------------------------------
+void vsSphereIntersect::finishIntersection()
+{
+    vsIntersectResult *sectResult;
+    vsList *sectPath;
+    int i, j;
+
+    for (i = 0; i < sphereListSize; i++)
+    {
+        // Skip spheres that didn't hit anything
+        if (hitGeometry[i] == NULL)
+            continue;
+
+        // Create a new intersection result for this intersection
+        sectResult = new vsIntersectResult(hitPoint[i], hitNormal[i],
+                                           hitXform[i], hitGeometry[i],
+                                           hitPrim[i]);
+
+        // Copy the intersection path, if it's enabled
+        if (pathsEnabled)
+        {
+            sectPath = sectResult->getPath();
+            for (j = 0; j < hitPathLength[i]; j++)
+                sectPath->addEntry(hitPath[i][j]);
+        }
+
+        // Store the result in the list
+        resultList.setEntry(i, sectResult);
+    }
+}
+
+// ------------------------------------------------------------------------
+// Initiates an intersection traversal over the indicated geometry tree.
+// The results of the traversal are stored and can be retrieved with the
+// getIsect* functions.
+// ------------------------------------------------------------------------
+void vsSphereIntersect::intersect(vsNode *targetNode)
+{
+    // Set up for the traversal, and make sure there's something to do
+    if (!startIntersection())
+        return;
 
-    // Check the bounding spheres of the node and the intersectors and 
-    // call the recursive intersect method, if necessary
+    // Call the recursive intersect method
     intersectSpheres(targetNode);
+
+    // Create the intersection results
+    finishIntersection();
+}
+
+// ------------------------------------------------------------------------
+// Private static function.  Thread pool task that runs the traversals for
+// a range of intersectors in a batch
+// ------------------------------------------------------------------------
+void vsSphereIntersect::batchTaskFunc(void *userData, int first, int last)
+{
+    vsSphereIntersectBatch *batch;
+    vsSphereIntersect *intersector;
+    int i;
+
+    // Get the batch
+    batch = (vsSphereIntersectBatch *)userData;
+
+    // Run the traversal for each intersector that has spheres
+    for (i = first; i < last; i++)
+    {
+        intersector = batch->intersectList[i];
+        if ((intersector != NULL) && (intersector->sphereListSize > 0))
+            intersector->intersectSpheres(batch->targetNode);
+    }
+}
+
+// ------------------------------------------------------------------------
+// Static function.  Runs the intersection traversals for a whole list of
+// intersectors against the same geometry tree.  This is equivalent to
+// calling intersect() on each one, but if useThreads is true, the
+// traversals are spread across the shared thread pool.  The traversals
+// only read the scene, so the tree must not be modified until this method
+// returns.  The result objects are created afterwards on the calling
+// thread.
+// ------------------------------------------------------------------------
+void vsSphereIntersect::intersectBatch(vsSphereIntersect **intersectList,
+                                       int intersectCount,
+                                       vsNode *targetNode, bool useThreads)
+{
+    vsSphereIntersectBatch batch;
+    int i;
+
+    // Make sure there's something to do
+    if ((intersectCount <= 0) || (targetNode == NULL))
+        return;
+
+    // Set up each intersector for the traversal
+    for (i = 0; i < intersectCount; i++)
+        if (intersectList[i] != NULL)
+            intersectList[i]->startIntersection();
+
+    // OSG computes bounding volumes lazily, so make sure they're all up to
+    // date before the threads start reading them
+    targetNode->getBoundSphere(NULL, NULL);
+
+    // Run the traversals, one intersector per task
+    batch.intersectList = intersectList;
+    batch.targetNode = targetNode;
+    if (useThreads)
+        vsThreadPool::getDefaultPool()->parallelFor(intersectCount, 1,
+            batchTaskFunc, &batch);
+    else
+        batchTaskFunc(&batch, 0, intersectCount);
+
+    // Create the results
+    for (i = 0; i < intersectCount; i++)
+        if (intersectList[i] != NULL)
+            intersectList[i]->finishIntersection();
 }
 
 // ------------------------------------------------------------------------
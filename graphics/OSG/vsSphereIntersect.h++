@@ -73,7 +73,13 @@ private:
     unsigned int       intersectMask;
 
     atMatrix           currentXform;
-    vsList             *currentPath;
+
+    // Nodes on the path from the target node to the node currently being
+    // traversed (kept as a plain array so that the traversal doesn't need
+    // to reference or unreference any nodes)
+    vsNode             **currentPath;
+    int                currentPathLength;
+    int                currentPathSize;
 
     // Parametric coordinates used during computation of the closest point
     // on a triangle, and subsequent intersection evaluation 
@@ -88,6 +94,22 @@ private:
     // so far on the current traversal
     double             closestSqrDist[VS_SPH_ISECT_MAX_SPHERES];
 
+    // Details of the closest intersection found so far for each sphere.
+    // These are turned into vsIntersectResult objects once the traversal
+    // is finished.
+    vsGeometry         *hitGeometry[VS_SPH_ISECT_MAX_SPHERES];
+    atVector           hitPoint[VS_SPH_ISECT_MAX_SPHERES];
+    atVector           hitNormal[VS_SPH_ISECT_MAX_SPHERES];
+    atMatrix           hitXform[VS_SPH_ISECT_MAX_SPHERES];
+    int                hitPrim[VS_SPH_ISECT_MAX_SPHERES];
+    vsNode             **hitPath[VS_SPH_ISECT_MAX_SPHERES];
+    int                hitPathLength[VS_SPH_ISECT_MAX_SPHERES];
+    int                hitPathSize[VS_SPH_ISECT_MAX_SPHERES];
+
+    // Triangles returned by the last triangle hierarchy query
+    int                *candidateList;
+    int                candidateListSize;
+
     // Intersection subroutines
     void               computePointInRegion(int regionNum);
     bool               getClosestPoint(atVector testPoint, atVector A,
@@ -100,6 +122,11 @@ private:
                                              vsGeometry *geometry);
     void               intersectSpheres(vsNode *targetNode);
 
+    bool               startIntersection();
+    void               finishIntersection();
+
+    static void        batchTaskFunc(void *userData, int first, int last);
+
 public:
 
                         vsSphereIntersect();
@@ -128,6 +155,9 @@ public:
     int                 getLODTravMode();
 
     void                intersect(vsNode *targetNode);
+    static void         intersectBatch(vsSphereIntersect **intersectList,
+                                       int intersectCount,
+                                       vsNode *targetNode, bool useThreads);
 
     vsIntersectResult   *getIntersection(int sphNum);
 };
@@ -0,0 +1,215 @@
+//------------------------------------------------------------------------
+//
+//    VIRTUAL ENVIRONMENT SOFTWARE SANDBOX (VESS)
+//
+//    Copyright (c) 2001, University of Central Florida
+//
+//       See the file LICENSE for license information
+//
+//    E-mail:  vess@ist.ucf.edu
+//    WWW:     http://vess.ist.ucf.edu/
+//
+//------------------------------------------------------------------------
+//
+//    VESS Module:  vsTriangleBVHIntersector.c++
+//
+//    Description:  OSG line segment intersector that uses the triangle
+//                  hierarchy cached by each VESS geometry object instead
+//                  of testing every triangle in the drawable
+//
+//    Author(s):    agent
+//
+//------------------------------------------------------------------------
+
+#include "vsTriangleBVHIntersector.h++"
+#include "vsGeometryBase.h++"
+#include <stdlib.h>
+
+// ------------------------------------------------------------------------
+// Internal function
+// Constructor.  Sets up the segment to intersect with
+// ------------------------------------------------------------------------
+vsTriangleBVHIntersector::vsTriangleBVHIntersector(const osg::Vec3d &start,
+                                                   const osg::Vec3d &end)
+    : osgUtil::LineSegmentIntersector(start, end)
+{
+}
+
+// ------------------------------------------------------------------------
+// Internal function
+// Destructor
+// ------------------------------------------------------------------------
+vsTriangleBVHIntersector::~vsTriangleBVHIntersector()
+{
+}
+
+// ------------------------------------------------------------------------
+// Internal function
+// Creates a copy of this intersector with the segment transformed into
+// the local coordinates of the subgraph the visitor is about to enter.
+// This is called by the IntersectionVisitor as it passes transforms.
+// ------------------------------------------------------------------------
+osgUtil::Intersector *vsTriangleBVHIntersector::clone(
+    osgUtil::IntersectionVisitor &iv)
+{
+    osg::ref_ptr<osgUtil::Intersector> baseClone;
+    osgUtil::LineSegmentIntersector *segmentClone;
+    vsTriangleBVHIntersector *newIntersector;
+
+    // Let the base class work out the transformed segment, then create
+    // one of our own intersectors with it
+    baseClone = osgUtil::LineSegmentIntersector::clone(iv);
+    segmentClone = (osgUtil::LineSegmentIntersector *)baseClone.get();
+    newIntersector = new vsTriangleBVHIntersector(segmentClone->getStart(),
+        segmentClone->getEnd());
+
+    // Intersections found by the copy are reported to this intersector
+    newIntersector->_parent = this;
+    newIntersector->setIntersectionLimit(getIntersectionLimit());
+
+    return newIntersector;
+}
+
+// ------------------------------------------------------------------------
+// Internal function
+// Intersects the segment with the given drawable.  If the drawable
+// belongs to a static VESS geometry, the geometry's triangle hierarchy is
+// used to find the hits, otherwise OSG's usual intersection is used.  The
+// intersections are reported in the same form as OSG's, so they can be
+// handled the same way.
+// ------------------------------------------------------------------------
+void vsTriangleBVHIntersector::intersect(osgUtil::IntersectionVisitor &iv,
+                                         osg::Drawable *drawable)
+{
+    vsGeometryDrawableData *drawableData;
+    vsGeometryBase *geometry;
+    vsTriangleBVH *triangleBVH;
+    osg::Vec3d clipStart, clipEnd;
+    double segmentLength, startRatio, clipRatio;
+    vsTriangleBVHHit *hitList;
+    int hitListSize;
+    int hitCount;
+    int nearestHit;
+    vsTriangleBVHTriangle *triangle;
+    atVector startPt, endPt;
+    atVector a, b, c;
+    osg::Vec3 normal;
+    osgUtil::LineSegmentIntersector::Intersection hit;
+    int i, j;
+
+    // Don't bother if we already have all the intersections we need
+    if (reachedLimit())
+        return;
+
+    // Look up the VESS geometry that owns this drawable (VESS geometry
+    // leaves a pointer back to itself in its drawable's user data)
+    geometry = NULL;
+    drawableData =
+        dynamic_cast<vsGeometryDrawableData *>(drawable->getUserData());
+    if (drawableData != NULL)
+        geometry = drawableData->geometry;
+
+    // Only static geometry keeps a triangle hierarchy around (the
+    // vertices of other kinds of geometry usually change every frame), so
+    // use OSG's intersection for anything else
+    triangleBVH = NULL;
+    if ((geometry != NULL) &&
+        (geometry->getNodeType() == VS_NODE_TYPE_GEOMETRY))
+        triangleBVH = geometry->getTriangleBVH();
+    if (triangleBVH == NULL)
+    {
+        osgUtil::LineSegmentIntersector::intersect(iv, drawable);
+        return;
+    }
+
+    // Dummy traversals don't look for intersections
+    if (iv.getDoDummyTraversal())
+        return;
+
+    // Clip the segment to the drawable's bounding box, as OSG does.  If it
+    // misses the box entirely, it can't hit any of the triangles.
+    clipStart = getStart();
+    clipEnd = getEnd();
+    if (!intersectAndClip(clipStart, clipEnd, drawable->getBoundingBox()))
+        return;
+
+    // Work out where the clipped segment lies along the original one, so
+    // we can report the hits' ratios along the original segment
+    segmentLength = (getEnd() - getStart()).length();
+    if (segmentLength > 0.0)
+    {
+        startRatio = (clipStart - getStart()).length() / segmentLength;
+        clipRatio = (clipEnd - clipStart).length() / segmentLength;
+    }
+    else
+    {
+        startRatio = 0.0;
+        clipRatio = 1.0;
+    }
+
+    // Find all the triangles that the clipped segment crosses
+    startPt.set(clipStart.x(), clipStart.y(), clipStart.z());
+    endPt.set(clipEnd.x(), clipEnd.y(), clipEnd.z());
+    hitList = NULL;
+    hitListSize = 0;
+    hitCount = triangleBVH->findSegmentHits(startPt, endPt, &hitList,
+        &hitListSize);
+
+    // Convert the hit ratios back to the original segment
+    for (i = 0; i < hitCount; i++)
+        hitList[i].ratio = startRatio + hitList[i].ratio * clipRatio;
+
+    // If we're limited in how many intersections to report, only report
+    // the nearest one on this drawable
+    nearestHit = 0;
+    if (getIntersectionLimit() != osgUtil::Intersector::NO_LIMIT)
+    {
+        for (i = 1; i < hitCount; i++)
+            if (hitList[i].ratio < hitList[nearestHit].ratio)
+                nearestHit = i;
+        if (hitCount > 1)
+            hitCount = nearestHit + 1;
+    }
+
+    // Report each hit
+    for (i = nearestHit; i < hitCount; i++)
+    {
+        // Get the triangle that was hit
+        triangle = triangleBVH->getTriangle(hitList[i].triangle);
+        a = triangleBVH->getVertex(triangle->vertexIndex[0]);
+        b = triangleBVH->getVertex(triangle->vertexIndex[1]);
+        c = triangleBVH->getVertex(triangle->vertexIndex[2]);
+
+        // Compute the triangle's normal the same way OSG does
+        normal = osg::Vec3(b[AT_X] - a[AT_X], b[AT_Y] - a[AT_Y],
+            b[AT_Z] - a[AT_Z]) ^ osg::Vec3(c[AT_X] - a[AT_X],
+            c[AT_Y] - a[AT_Y], c[AT_Z] - a[AT_Z]);
+        normal.normalize();
+
+        // Fill in the intersection
+        hit.ratio = hitList[i].ratio;
+        hit.nodePath = iv.getNodePath();
+        hit.drawable = drawable;
+        hit.matrix = iv.getModelMatrix();
+        hit.localIntersectionPoint = getStart() * (1.0 - hit.ratio) +
+            getEnd() * hit.ratio;
+        hit.localIntersectionNormal = normal;
+        hit.indexList.clear();
+        hit.ratioList.clear();
+        for (j = 0; j < 3; j++)
+        {
+            hit.indexList.push_back(triangle->vertexIndex[j]);
+            hit.ratioList.push_back(hitList[i].vertexWeight[j]);
+        }
+
+        // OSG numbers the primitives by triangle, so we do the same
+        hit.primitiveIndex = triangle->triangleIndex;
+
+        // Add the intersection to the list
+        insertIntersection(hit);
+    }
+
+    // Clean up
+    if (hitList != NULL)
+        free(hitList);
+}
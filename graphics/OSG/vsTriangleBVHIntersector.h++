@@ -0,0 +1,47 @@
+//------------------------------------------------------------------------
+//
+//    VIRTUAL ENVIRONMENT SOFTWARE SANDBOX (VESS)
+//
+//    Copyright (c) 2001, University of Central Florida
+//
+//       See the file LICENSE for license information
+//
+//    E-mail:  vess@ist.ucf.edu
+//    WWW:     http://vess.ist.ucf.edu/
+//
+//------------------------------------------------------------------------
+//
+//    VESS Module:  vsTriangleBVHIntersector.h++
+//
+//    Description:  OSG line segment intersector that uses the triangle
+//                  hierarchy cached by each VESS geometry object instead
+//                  of testing every triangle in the drawable
+//
+//    Author(s):    agent
+//
+//------------------------------------------------------------------------
+
+#ifndef VS_TRIANGLE_BVH_INTERSECTOR_HPP
+#define VS_TRIANGLE_BVH_INTERSECTOR_HPP
+
+#include "vsGlobals.h++"
+
+#include <osgUtil/LineSegmentIntersector>
+#include <osgUtil/IntersectionVisitor>
+#include <osg/Drawable>
+
+class VESS_SYM vsTriangleBVHIntersector : public osgUtil::LineSegmentIntersector
+{
+VS_INTERNAL:
+
+                    vsTriangleBVHIntersector(const osg::Vec3d &start,
+                                             const osg::Vec3d &end);
+    virtual         ~vsTriangleBVHIntersector();
+
+    virtual osgUtil::Intersector    *clone(osgUtil::IntersectionVisitor &iv);
+
+    virtual void    intersect(osgUtil::IntersectionVisitor &iv,
+                              osg::Drawable *drawable);
+};
+
+#endif
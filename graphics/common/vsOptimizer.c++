@@ -25,14 +25,64 @@
 #include "vsStateAttribute.h++"
 #include "vsDecalAttribute.h++"
 #include "vsLODAttribute.h++"
+#include "vsThreadPool.h++"
+#include <stdlib.h>
+
+// Describes a batch of geometry objects whose data is being optimized
+// by the thread pool
+struct vsOptimizerGeometryBatch
+{
+    vsOptimizer    *optimizer;
+    vsGeometry     **geometryList;
+    int            geometryCount;
+    int            passes;
+};
+
+// Describes a group of geometry objects that are being merged into a
+// single destination geometry
+struct vsOptimizerMerge
+{
+    vsGeometry     *destGeometry;
+    vsArray        *sourceList;
+};
+
+// Describes a batch of merges being performed by the thread pool
+struct vsOptimizerMergeBatch
+{
+    vsOptimizerMerge    *mergeList;
+    int                 mergeCount;
+};
 
 // ------------------------------------------------------------------------
-// Constructor - Turns all optimizations on
+// Static function
+// Compares two geometry objects by address (used to sort the list of
+// geometry objects with qsort, so duplicates can be found)
+// ------------------------------------------------------------------------
+static int compareGeometryAddresses(const void *first, const void *second)
+{
+    vsGeometry *firstGeo, *secondGeo;
+
+    // Get the two geometry objects
+    firstGeo = *((vsGeometry **)first);
+    secondGeo = *((vsGeometry **)second);
+
+    // Order them by address
+    if (firstGeo < secondGeo)
+        return -1;
+    else if (firstGeo > secondGeo)
+        return 1;
+    else
+        return 0;
+}
+
+// ------------------------------------------------------------------------
+// Constructor - Turns all optimizations on, except for vertex welding
 // ------------------------------------------------------------------------
 vsOptimizer::vsOptimizer()
 {
-    // Default optimizations to perform are all of them
-    passMask = VS_OPTIMIZER_ALL;
+    // Default optimizations to perform are all of them, except welding,
+    // which has to be asked for
+    passMask = VS_OPTIMIZER_ALL & ~VS_OPTIMIZER_WELD_VERTICES;
 }
 
 // ------------------------------------------------------------------------
@@ -55,9 +105,20 @@ const char *vsOptimizer::getClassName()
 // ------------------------------------------------------------------------
 void vsOptimizer::optimize(vsNode *rootNode)
 {
+    // Condense the data lists of all of the geometry in the scene first.
+    // Each geometry object is handled separately, so they're all done in
+    // parallel.
+    optimizeGeometryData(rootNode,
+        passMask & (VS_OPTIMIZER_CONDENSE_COLORS |
+            VS_OPTIMIZER_CONDENSE_NORMALS));
+
     // Call the recursive optimization function, starting at the
     // given scene root node
     optimizeNode(rootNode);
+
+    // Now that the geometry has been merged, weld the vertices of the
+    // remaining geometry objects (again, in parallel)
+    optimizeGeometryData(rootNode, passMask & VS_OPTIMIZER_WELD_VERTICES);
 }
 
 // ------------------------------------------------------------------------
@@ -83,23 +144,12 @@ int vsOptimizer::getOptimizations()
 void vsOptimizer::optimizeNode(vsNode *node)
 {
     int loop;
-    vsGeometry *geometryNode;
     vsComponent *componentNode;
 
     // Select optimizations based on node type. We don't do any sort of
-    // optimization on vsScenes or vsDynamicGeometries.
-    if (node->getNodeType() == VS_NODE_TYPE_GEOMETRY)
-    {
-        // Geometry type cast, for convenience
-        geometryNode = (vsGeometry *)node;
-
-        // Data compression optimization (colors and normals)
-        if (passMask & VS_OPTIMIZER_CONDENSE_COLORS)
-            condenseGeoData(geometryNode, VS_GEOMETRY_COLORS);
-        if (passMask & VS_OPTIMIZER_CONDENSE_NORMALS)
-            condenseGeoData(geometryNode, VS_GEOMETRY_NORMALS);
-    }
-    else if (node->getNodeType() == VS_NODE_TYPE_COMPONENT)
+    // optimization on vsScenes or vsDynamicGeometries, and the data within
+    // the geometry nodes is optimized separately (see optimize())
+    if (node->getNodeType() == VS_NODE_TYPE_COMPONENT)
     {
         // Component type cast, for convenience
         componentNode = (vsComponent *)node;
@@ -158,6 +208,117 @@ void vsOptimizer::optimizeNode(vsNode *node)
     
 }
 
+// ------------------------------------------------------------------------
+// Recursive function - adds the given node to the list if it is a
+// geometry node, or searches its children if it's a component
+// ------------------------------------------------------------------------
+void vsOptimizer::findGeometry(vsNode *node, vsArray *geometryList)
+{
+    vsComponent *componentNode;
+    int loop;
+
+    // Check the node type. We don't do any sort of optimization on
+    // vsScenes or vsDynamicGeometries.
+    if (node->getNodeType() == VS_NODE_TYPE_GEOMETRY)
+    {
+        // Add the geometry to the list
+        geometryList->addEntry(node);
+    }
+    else if (node->getNodeType() == VS_NODE_TYPE_COMPONENT)
+    {
+        // Search the component's children
+        componentNode = (vsComponent *)node;
+        for (loop = 0; loop < componentNode->getChildCount(); loop++)
+            findGeometry(componentNode->getChild(loop), geometryList);
+    }
+}
+
+// ------------------------------------------------------------------------
+// Runs the given geometry data optimizations (condensing colors and
+// normals, and welding vertices) on every geometry object in the scene
+// rooted at the given node.  The optimizations only affect the data
+// within each geometry object, so the geometry objects are processed in
+// parallel on the thread pool.
+// ------------------------------------------------------------------------
+void vsOptimizer::optimizeGeometryData(vsNode *rootNode, int passes)
+{
+    vsArray geometryArray;
+    vsOptimizerGeometryBatch batch;
+    int loop;
+
+    // Don't bother if there's nothing to do
+    if (passes == 0)
+        return;
+
+    // Find all of the geometry in the scene
+    findGeometry(rootNode, &geometryArray);
+    if (geometryArray.getNumEntries() == 0)
+        return;
+
+    // Copy the geometry objects into the batch, and sort them, so we can
+    // weed out the ones that appear more than once in the scene (each
+    // object must only be processed once)
+    batch.optimizer = this;
+    batch.passes = passes;
+    batch.geometryList = (vsGeometry **)
+        malloc(sizeof(vsGeometry *) * geometryArray.getNumEntries());
+    for (loop = 0; loop < geometryArray.getNumEntries(); loop++)
+        batch.geometryList[loop] = (vsGeometry *)geometryArray.getEntry(loop);
+    qsort(batch.geometryList, geometryArray.getNumEntries(),
+        sizeof(vsGeometry *), compareGeometryAddresses);
+    batch.geometryCount = 1;
+    for (loop = 1; loop < geometryArray.getNumEntries(); loop++)
+    {
+        if (batch.geometryList[loop] !=
+            batch.geometryList[batch.geometryCount - 1])
+        {
+            batch.geometryList[batch.geometryCount] =
+                batch.geometryList[loop];
+            batch.geometryCount++;
+        }
+    }
+
+    // Optimize the geometry objects in parallel
+    vsThreadPool::getDefaultPool()->parallelFor(batch.geometryCount, 1,
+        geometryTaskFunc, &batch);
+
+    // Clean up
+    free(batch.geometryList);
+}
+
+// ------------------------------------------------------------------------
+// Static function
+// Thread pool task that runs the geometry data optimizations on a range
+// of geometry objects from a batch
+// ------------------------------------------------------------------------
+void vsOptimizer::geometryTaskFunc(void *userData, int first, int last)
+{
+    vsOptimizerGeometryBatch *batch;
+    vsGeometry *geometryNode;
+    int loop;
+
+    // Get the batch
+    batch = (vsOptimizerGeometryBatch *)userData;
+
+    // Optimize each geometry object in the range
+    for (loop = first; loop < last; loop++)
+    {
+        geometryNode = batch->geometryList[loop];
+
+        // Data compression optimization (colors and normals)
+        if (batch->passes & VS_OPTIMIZER_CONDENSE_COLORS)
+            batch->optimizer->condenseGeoData(geometryNode,
+                VS_GEOMETRY_COLORS);
+        if (batch->passes & VS_OPTIMIZER_CONDENSE_NORMALS)
+            batch->optimizer->condenseGeoData(geometryNode,
+                VS_GEOMETRY_NORMALS);
+
+        // Vertex welding optimization
+        if (batch->passes & VS_OPTIMIZER_WELD_VERTICES)
+            geometryNode->optimizeVertices();
+    }
+}
+
 // ------------------------------------------------------------------------
 // For each child of this component, check to see if that child is also
 // a component, and if so, if that component has zero or one children of
@@ -520,7 +681,9 @@ void vsOptimizer::mergeLODs(vsComponent *componentNode)
 
 // ------------------------------------------------------------------------
 // Attempts to merge multiple geometry objects that are children of this
-// component
+// component.  The children to merge are found first, then each group of
+// similar children is merged into its first member.  The groups don't
+// share any geometry, so they're merged in parallel.
 // ------------------------------------------------------------------------
 void vsOptimizer::mergeGeometry(vsComponent *componentNode)
 {
@@ -528,6 +691,8 @@ void vsOptimizer::mergeGeometry(vsComponent *componentNode)
     vsNode *firstNode, *secondNode;
     vsGeometry *firstGeo, *secondGeo;
     vsNode *parent;
+    vsOptimizerMergeBatch batch;
+    int mergeIndex;
 
     // If there's a grouping category attribute on this component, then it's
     // not safe to rearrange the component's children, as would be needed
@@ -535,8 +700,17 @@ void vsOptimizer::mergeGeometry(vsComponent *componentNode)
     if (componentNode->getCategoryAttribute(VS_ATTRIBUTE_CATEGORY_GROUPING, 0))
         return;
 
+    // There can't be more merge groups than there are children
+    batch.mergeList = (vsOptimizerMerge *)
+        malloc(sizeof(vsOptimizerMerge) * (componentNode->getChildCount() + 1));
+    batch.mergeCount = 0;
+
     // Compare each pair of children for merge compatability
     for (loop = 0; loop < componentNode->getChildCount(); loop++)
+    {
+        // We haven't found anything to merge with this child yet
+        mergeIndex = -1;
+
         for (sloop = loop+1; sloop < componentNode->getChildCount(); sloop++)
         {
             // Pick two children of the component
@@ -556,18 +730,29 @@ void vsOptimizer::mergeGeometry(vsComponent *componentNode)
                 // and merge them if they are
                 if (isSimilarGeometry(firstGeo, secondGeo))
                 {
-                    // Remove the second geometry object from its parents,
-                    // and add its geometry to the first geometry object
+                    // Start a new merge group for the first geometry
+                    // object if we need to
+                    if (mergeIndex < 0)
+                    {
+                        mergeIndex = batch.mergeCount;
+                        batch.mergeList[mergeIndex].destGeometry = firstGeo;
+                        batch.mergeList[mergeIndex].sourceList =
+                            new vsArray();
+                        batch.mergeCount++;
+                    }
+
+                    // Add the second geometry object to the group (this
+                    // keeps it around until its geometry is added to the
+                    // first object)
+                    batch.mergeList[mergeIndex].sourceList->
+                        addEntry(secondGeo);
+
+                    // Remove the second geometry object from its parents
                     while (secondGeo->getParentCount() > 0)
                     {
                         parent = secondGeo->getParent(0);
                         parent->removeChild(secondGeo);
                     }
-                    addGeometry(firstGeo, secondGeo);
-
-                    // The second geometry object is now unneeded; get rid
-                    // of it.
-                    vsObject::checkDelete(secondGeo);
 
                     // Back up one child, so that we don't skip over the
                     // child that was just moved into the spot that
@@ -576,6 +761,35 @@ void vsOptimizer::mergeGeometry(vsComponent *componentNode)
                 }
             }
         }
+    }
+
+    // Merge the groups of geometry
+    vsThreadPool::getDefaultPool()->parallelFor(batch.mergeCount, 1,
+        mergeTaskFunc, &batch);
+
+    // The merged geometry objects are now unneeded; get rid of them (they
+    // are deleted as their lists let go of them)
+    for (loop = 0; loop < batch.mergeCount; loop++)
+        delete batch.mergeList[loop].sourceList;
+    free(batch.mergeList);
+}
+
+// ------------------------------------------------------------------------
+// Static function
+// Thread pool task that merges a range of geometry groups from a batch
+// ------------------------------------------------------------------------
+void vsOptimizer::mergeTaskFunc(void *userData, int first, int last)
+{
+    vsOptimizerMergeBatch *batch;
+    int loop;
+
+    // Get the batch
+    batch = (vsOptimizerMergeBatch *)userData;
+
+    // Merge each group in the range
+    for (loop = first; loop < last; loop++)
+        addGeometry(batch->mergeList[loop].destGeometry,
+            batch->mergeList[loop].sourceList);
 }
 
 // ------------------------------------------------------------------------
@@ -605,6 +819,12 @@ bool vsOptimizer::isSimilarGeometry(vsGeometry *firstGeo, vsGeometry *secondGeo)
     if (strlen(secondGeo->getName()) > 0)
         return false;
 
+    // Indexed geometry can't be merged (the vertices of the second
+    // geometry would need their indices adjusted)
+    if ((firstGeo->getIndexListSize() > 0) ||
+        (secondGeo->getIndexListSize() > 0))
+        return false;
+
     // Compare primitive types
     firstVal = firstGeo->getPrimitiveType();
     secondVal = secondGeo->getPrimitiveType();
@@ -710,161 +930,150 @@ bool vsOptimizer::isSimilarGeometry(vsGeometry *firstGeo, vsGeometry *secondGeo)
 }
 
 // ------------------------------------------------------------------------
-// Adds the geometry within the second geometry object to the first one.
-// The second geometry object is unchanged.
+// Static function
+// Adds the geometry within each of the geometry objects in the source
+// list to the destination object.  The source objects are unchanged.
+// Each of the destination's data lists is resized only once, and the
+// data is copied in bulk.
 // ------------------------------------------------------------------------
-void vsOptimizer::addGeometry(vsGeometry *destGeo, vsGeometry *srcGeo)
+void vsOptimizer::addGeometry(vsGeometry *destGeo, vsArray *sourceList)
 {
-    int loop;
-    int srcPrimCount, destPrimCount;
-    int srcVertCount, destVertCount;
-    atVector tempData;
-    int tempLength;
-    
+    int loop, sloop;
+    vsGeometry *srcGeo;
+    int srcCount;
+    int *srcPrimCount, *srcVertCount;
+    int destPrimCount, destVertCount;
+    int totalPrimCount, totalVertCount;
+    int primOffset, vertOffset;
+    int normalBinding, colorBinding, texBinding;
+    int *lengths;
+    bool variableLength;
+
     // Don't trust the vertex data list size values; determine the actual
     // (used) vertex counts by summing together the lengths of the primitives
     // of each geometry.
-    srcPrimCount = srcGeo->getPrimitiveCount();
     destPrimCount = destGeo->getPrimitiveCount();
-    srcVertCount = 0;
-    for (loop = 0; loop < srcPrimCount; loop++)
-        srcVertCount += srcGeo->getPrimitiveLength(loop);
     destVertCount = 0;
     for (loop = 0; loop < destPrimCount; loop++)
         destVertCount += destGeo->getPrimitiveLength(loop);
-
-    // * Copy vertex coordinates
-    // Set the vertex list size to the sum of both geometry's
-    // vertex counts
-    destGeo->setDataListSize(VS_GEOMETRY_VERTEX_COORDS,
-        srcVertCount + destVertCount);
-
-    // Copy the vertex coordinates
-    for (loop = 0; loop < srcVertCount; loop++)
-    {
-        tempData = srcGeo->getData(VS_GEOMETRY_VERTEX_COORDS, loop);
-        destGeo->setData(VS_GEOMETRY_VERTEX_COORDS, loop + destVertCount,
-            tempData);
-    }
-    
-    // * Copy normals
-    // Check the binding value
-    if (destGeo->getBinding(VS_GEOMETRY_NORMALS) ==
-        VS_GEOMETRY_BIND_PER_PRIMITIVE)
-    {
-        // Per-primitive normal binding
-
-        // Set the normal list size to the sum of both geometry's
-        // primitive counts
-        destGeo->setDataListSize(VS_GEOMETRY_NORMALS,
-            srcPrimCount + destPrimCount);
-
-        // Copy the primitive normals
-        for (loop = 0; loop < srcPrimCount; loop++)
-        {
-            tempData = srcGeo->getData(VS_GEOMETRY_NORMALS, loop);
-            destGeo->setData(VS_GEOMETRY_NORMALS, loop + destPrimCount,
-                tempData);
-        }
-    }
-    else if (destGeo->getBinding(VS_GEOMETRY_NORMALS) ==
-        VS_GEOMETRY_BIND_PER_VERTEX)
+    totalPrimCount = destPrimCount;
+    totalVertCount = destVertCount;
+
+    // Do the same for each of the source geometry objects
+    srcCount = sourceList->getNumEntries();
+    srcPrimCount = (int *)malloc(sizeof(int) * (srcCount + 1));
+    srcVertCount = (int *)malloc(sizeof(int) * (srcCount + 1));
+    for (loop = 0; loop < srcCount; loop++)
     {
-        // Per-vertex normal binding
-
-        // Set the normal list size to the sum of both geometry's
-        // vertex counts
-        destGeo->setDataListSize(VS_GEOMETRY_NORMALS,
-            srcVertCount + destVertCount);
-
-        // Copy the vertex normals
-        for (loop = 0; loop < srcVertCount; loop++)
-        {
-            tempData = srcGeo->getData(VS_GEOMETRY_NORMALS, loop);
-            destGeo->setData(VS_GEOMETRY_NORMALS, loop + destVertCount,
-                tempData);
-        }
+        srcGeo = (vsGeometry *)sourceList->getEntry(loop);
+        srcPrimCount[loop] = srcGeo->getPrimitiveCount();
+        srcVertCount[loop] = 0;
+        for (sloop = 0; sloop < srcPrimCount[loop]; sloop++)
+            srcVertCount[loop] += srcGeo->getPrimitiveLength(sloop);
+
+        totalPrimCount += srcPrimCount[loop];
+        totalVertCount += srcVertCount[loop];
     }
-    
-    // * Copy colors
-    // Check the binding value
-    if (destGeo->getBinding(VS_GEOMETRY_COLORS) ==
-        VS_GEOMETRY_BIND_PER_PRIMITIVE)
-    {
-        // Per-primitive color binding
-
-        // Set the color list size to the sum of both geometry's
-        // primitive counts
-        destGeo->setDataListSize(VS_GEOMETRY_COLORS,
-            srcPrimCount + destPrimCount);
 
-        // Copy the primitive colors
-        for (loop = 0; loop < srcPrimCount; loop++)
-        {
-            tempData = srcGeo->getData(VS_GEOMETRY_COLORS, loop);
-            destGeo->setData(VS_GEOMETRY_COLORS, loop + destPrimCount,
-                tempData);
-        }
-    }
-    else if (destGeo->getBinding(VS_GEOMETRY_COLORS) ==
-        VS_GEOMETRY_BIND_PER_VERTEX)
+    // Get the data bindings (the geometry objects are known to have the
+    // same bindings)
+    normalBinding = destGeo->getBinding(VS_GEOMETRY_NORMALS);
+    colorBinding = destGeo->getBinding(VS_GEOMETRY_COLORS);
+    texBinding = destGeo->getBinding(VS_GEOMETRY_TEXTURE_COORDS);
+
+    // * Resize the data lists
+    // Set the vertex list size to the sum of all geometry's vertex counts
+    destGeo->setDataListSize(VS_GEOMETRY_VERTEX_COORDS, totalVertCount);
+
+    // Set the normal and color list sizes to the sum of all geometry's
+    // primitive or vertex counts, depending on the binding
+    if (normalBinding == VS_GEOMETRY_BIND_PER_PRIMITIVE)
+        destGeo->setDataListSize(VS_GEOMETRY_NORMALS, totalPrimCount);
+    else if (normalBinding == VS_GEOMETRY_BIND_PER_VERTEX)
+        destGeo->setDataListSize(VS_GEOMETRY_NORMALS, totalVertCount);
+    if (colorBinding == VS_GEOMETRY_BIND_PER_PRIMITIVE)
+        destGeo->setDataListSize(VS_GEOMETRY_COLORS, totalPrimCount);
+    else if (colorBinding == VS_GEOMETRY_BIND_PER_VERTEX)
+        destGeo->setDataListSize(VS_GEOMETRY_COLORS, totalVertCount);
+
+    // Texture coordinates can only be per-vertex or off
+    if (texBinding == VS_GEOMETRY_BIND_PER_VERTEX)
+        destGeo->setDataListSize(VS_GEOMETRY_TEXTURE_COORDS, totalVertCount);
+
+    // * Copy the data from each source geometry to the end of the lists
+    primOffset = destPrimCount;
+    vertOffset = destVertCount;
+    for (loop = 0; loop < srcCount; loop++)
     {
-        // Per-vertex color binding
-
-        // Set the color list size to the sum of both geometry's
-        // vertex counts
-        destGeo->setDataListSize(VS_GEOMETRY_COLORS,
-            srcVertCount + destVertCount);
-
-        // Copy the vertex colors
-        for (loop = 0; loop < srcVertCount; loop++)
-        {
-            tempData = srcGeo->getData(VS_GEOMETRY_COLORS, loop);
-            destGeo->setData(VS_GEOMETRY_COLORS, loop + destVertCount,
-                tempData);
-        }
+        srcGeo = (vsGeometry *)sourceList->getEntry(loop);
+
+        // Copy the vertex coordinates
+        destGeo->copyDataRange(VS_GEOMETRY_VERTEX_COORDS, vertOffset,
+            srcGeo, 0, srcVertCount[loop]);
+
+        // Copy the normals
+        if (normalBinding == VS_GEOMETRY_BIND_PER_PRIMITIVE)
+            destGeo->copyDataRange(VS_GEOMETRY_NORMALS, primOffset,
+                srcGeo, 0, srcPrimCount[loop]);
+        else if (normalBinding == VS_GEOMETRY_BIND_PER_VERTEX)
+            destGeo->copyDataRange(VS_GEOMETRY_NORMALS, vertOffset,
+                srcGeo, 0, srcVertCount[loop]);
+
+        // Copy the colors
+        if (colorBinding == VS_GEOMETRY_BIND_PER_PRIMITIVE)
+            destGeo->copyDataRange(VS_GEOMETRY_COLORS, primOffset,
+                srcGeo, 0, srcPrimCount[loop]);
+        else if (colorBinding == VS_GEOMETRY_BIND_PER_VERTEX)
+            destGeo->copyDataRange(VS_GEOMETRY_COLORS, vertOffset,
+                srcGeo, 0, srcVertCount[loop]);
+
+        // Copy the texture coordinates
+        if (texBinding == VS_GEOMETRY_BIND_PER_VERTEX)
+            destGeo->copyDataRange(VS_GEOMETRY_TEXTURE_COORDS, vertOffset,
+                srcGeo, 0, srcVertCount[loop]);
+
+        // Move on to the next geometry's position
+        primOffset += srcPrimCount[loop];
+        vertOffset += srcVertCount[loop];
     }
-    
-    // * Copy texture coordinates
-    // Check the binding value (can only be per-vertex or off)
-    if (destGeo->getBinding(VS_GEOMETRY_TEXTURE_COORDS) ==
-        VS_GEOMETRY_BIND_PER_VERTEX)
-    {
-        // Per-vertex texture coordinate binding
 
-        // Set the texture coordinate list size to the sum of both geometry's
-        // vertex counts
-        destGeo->setDataListSize(VS_GEOMETRY_TEXTURE_COORDS,
-            srcVertCount + destVertCount);
-
-        // Copy the vertex texture coordinates
-        for (loop = 0; loop < srcVertCount; loop++)
-        {
-            tempData = srcGeo->getData(VS_GEOMETRY_TEXTURE_COORDS, loop);
-            destGeo->setData(VS_GEOMETRY_TEXTURE_COORDS, loop + destVertCount,
-                tempData);
-        }
-    }
-    
     // * Copy primitive counts/lengths
-    // Set the primitive list size to the sum of both geometry's
-    // primitive counts
-    destGeo->setPrimitiveCount(destPrimCount + srcPrimCount);
     // Only need to copy the actual primitive length data if the type is
     // not one of the fixed-length types
-    if ((destGeo->getPrimitiveType() != VS_GEOMETRY_TYPE_POINTS) &&
-        (destGeo->getPrimitiveType() != VS_GEOMETRY_TYPE_LINES) &&
-        (destGeo->getPrimitiveType() != VS_GEOMETRY_TYPE_TRIS) &&
-        (destGeo->getPrimitiveType() != VS_GEOMETRY_TYPE_QUADS))
+    variableLength =
+        ((destGeo->getPrimitiveType() != VS_GEOMETRY_TYPE_POINTS) &&
+         (destGeo->getPrimitiveType() != VS_GEOMETRY_TYPE_LINES) &&
+         (destGeo->getPrimitiveType() != VS_GEOMETRY_TYPE_TRIS) &&
+         (destGeo->getPrimitiveType() != VS_GEOMETRY_TYPE_QUADS));
+    if (variableLength)
     {
-        // Copy the primitive lengths
-        for (loop = 0; loop < srcPrimCount; loop++)
+        // Gather up the primitive lengths of all of the geometry
+        lengths = (int *)malloc(sizeof(int) * (totalPrimCount + 1));
+        destGeo->getPrimitiveLengths(lengths);
+        primOffset = destPrimCount;
+        for (loop = 0; loop < srcCount; loop++)
         {
-            tempLength = srcGeo->getPrimitiveLength(loop);
-            destGeo->setPrimitiveLength(loop + destPrimCount, tempLength);
+            srcGeo = (vsGeometry *)sourceList->getEntry(loop);
+            srcGeo->getPrimitiveLengths(&lengths[primOffset]);
+            primOffset += srcPrimCount[loop];
         }
+
+        // Set the primitive list size to the sum of all geometry's
+        // primitive counts, and set all the lengths at once
+        destGeo->setPrimitiveCount(totalPrimCount);
+        destGeo->setPrimitiveLengths(lengths);
+        free(lengths);
+    }
+    else
+    {
+        // Set the primitive list size to the sum of all geometry's
+        // primitive counts
+        destGeo->setPrimitiveCount(totalPrimCount);
     }
 
+    // Clean up
+    free(srcPrimCount);
+    free(srcVertCount);
 }
 
 // ------------------------------------------------------------------------
@@ -26,6 +26,7 @@
 #include "vsAttribute.h++"
 #include "vsGeometry.h++"
 #include "vsComponent.h++"
+#include "vsArray.h++"
 
 #define VS_OPTIMIZER_PROMOTE_ATTRIBUTES 0x01
 #define VS_OPTIMIZER_MERGE_GEOMETRY     0x02
@@ -36,6 +37,12 @@
 #define VS_OPTIMIZER_CONDENSE_COLORS    0x40
 #define VS_OPTIMIZER_CONDENSE_NORMALS   0x80
 
+// Welding is opt-in:  it isn't part of the default set of passes (it
+// changes each geometry's vertex layout, since it expands per-primitive
+// data to per-vertex before indexing and reordering the vertices), so it
+// has to be turned on with setOptimizations()
+#define VS_OPTIMIZER_WELD_VERTICES      0x100
+
 #define VS_OPTIMIZER_ALL                0xFFFFFFFF
 
 class VESS_SYM vsOptimizer : public vsObject
@@ -46,6 +53,10 @@ private:
 
     void        optimizeNode(vsNode *node);
 
+    void        findGeometry(vsNode *node, vsArray *geometryList);
+    void        optimizeGeometryData(vsNode *rootNode, int passes);
+    static void geometryTaskFunc(void *userData, int first, int last);
+
     void        cleanChildren(vsComponent *componentNode);
     void        zapComponent(vsComponent *targetComponent);
 
@@ -55,7 +66,8 @@ private:
 
     void        mergeGeometry(vsComponent *componentNode);
     bool        isSimilarGeometry(vsGeometry *firstGeo, vsGeometry *secondGeo);
-    void        addGeometry(vsGeometry *destGeo, vsGeometry *srcGeo);
+    static void mergeTaskFunc(void *userData, int first, int last);
+    static void addGeometry(vsGeometry *destGeo, vsArray *sourceList);
 
     void        condenseGeoData(vsGeometry *geometry, int whichData);
 
@@ -0,0 +1,1900 @@
+//------------------------------------------------------------------------
+//
+//    VIRTUAL ENVIRONMENT SOFTWARE SANDBOX (VESS)
+//
+//    Copyright (c) 2001, University of Central Florida
+//
+//       See the file LICENSE for license information
+//
+//    E-mail:  vess@ist.ucf.edu
+//    WWW:     http://vess.ist.ucf.edu/
+//
+//------------------------------------------------------------------------
+//
+//    VESS Module:  vsSceneCache.c++
+//
+//    Description:  Binary cache file for scenes that are expensive to
+//                  load.  A loader writes the scene it built into the
+//                  cache, and later loads map the cache file into memory
+//                  and rebuild the scene from it directly, as long as the
+//                  source file hasn't changed.
+//
+//    Author(s):    agent
+//
+//------------------------------------------------------------------------
+
+#include "vsSceneCache.h++"
+#include "vsComponent.h++"
+#include "vsGeometry.h++"
+#include "vsSkeletonMeshGeometry.h++"
+#include "vsTransformAttribute.h++"
+#include "vsLODAttribute.h++"
+#include "vsDecalAttribute.h++"
+#include "vsMaterialAttribute.h++"
+#include "vsTextureAttribute.h++"
+#include "vsTransparencyAttribute.h++"
+#include "vsBackfaceAttribute.h++"
+#include "vsShadingAttribute.h++"
+#include "vsWireframeAttribute.h++"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <sys/stat.h>
+
+#ifdef WIN32
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+// Marks the beginning of a cache file
+#define VS_SCENE_CACHE_MAGIC       "VSSCACHE"
+
+// Used to detect cache files written on a machine with a different byte
+// order
+#define VS_SCENE_CACHE_BYTE_ORDER  0x01020304
+
+// Everything in the cache is aligned to this many bytes, so the data
+// lists can be used directly from the mapped file
+#define VS_SCENE_CACHE_ALIGNMENT   8
+
+// ------------------------------------------------------------------------
+// Static function
+// Hashes an object's address for the table of objects in the cache
+// ------------------------------------------------------------------------
+static size_t hashObjectAddress(vsObject *object)
+{
+    size_t address;
+
+    // Objects are at least 8-byte aligned, so drop the low bits, then
+    // spread the rest of them around
+    address = ((size_t)object) >> 3;
+    return (address ^ (address >> 16)) * 2654435761u;
+}
+
+// ------------------------------------------------------------------------
+// Static function
+// Returns the size in bytes of a texture image with the given size and
+// format, or -1 if the format isn't recognized
+// ------------------------------------------------------------------------
+static int getImageDataSize(int xSize, int ySize, int dataFormat)
+{
+    // The compressed formats store 4x4 blocks of pixels
+    switch (dataFormat)
+    {
+        case VS_TEXTURE_DFORMAT_INTENSITY:
+            return xSize * ySize;
+        case VS_TEXTURE_DFORMAT_INTENSITY_ALPHA:
+            return xSize * ySize * 2;
+        case VS_TEXTURE_DFORMAT_RGB:
+            return xSize * ySize * 3;
+        case VS_TEXTURE_DFORMAT_RGBA:
+        case VS_TEXTURE_DFORMAT_BGRA:
+            return xSize * ySize * 4;
+        case VS_TEXTURE_DFORMAT_DXT1:
+        case VS_TEXTURE_DFORMAT_DXT1_ALPHA:
+            return ((xSize + 3) / 4) * ((ySize + 3) / 4) * 8;
+        case VS_TEXTURE_DFORMAT_DXT3:
+        case VS_TEXTURE_DFORMAT_DXT5:
+            return ((xSize + 3) / 4) * ((ySize + 3) / 4) * 16;
+    }
+
+    return -1;
+}
+
+// ------------------------------------------------------------------------
+// Constructor
+// ------------------------------------------------------------------------
+vsSceneCache::vsSceneCache()
+{
+    // Not writing or reading anything yet
+    writeBuffer = NULL;
+    writeSize = 0;
+    writeCapacity = 0;
+    writing = false;
+
+    mapData = NULL;
+    mapSize = 0;
+    mapFileHandle = NULL;
+    mapHandle = NULL;
+    readOffset = 0;
+    reading = false;
+
+    cacheError = false;
+
+    // No objects in the cache yet
+    objectCount = 0;
+    objectTable = NULL;
+    objectTableIndex = NULL;
+    objectTableSize = 0;
+}
+
+// ------------------------------------------------------------------------
+// Destructor
+// ------------------------------------------------------------------------
+vsSceneCache::~vsSceneCache()
+{
+    // Abandon any unfinished read or write
+    reset();
+}
+
+// ------------------------------------------------------------------------
+// Gets a string representation of this object's class name
+// ------------------------------------------------------------------------
+const char *vsSceneCache::getClassName()
+{
+    return "vsSceneCache";
+}
+
+// ------------------------------------------------------------------------
+// Static function
+// Returns the name of the cache file for the given source file (the
+// cache file sits next to the source file)
+// ------------------------------------------------------------------------
+atString vsSceneCache::getCacheFilename(const char *sourceFile)
+{
+    char *filename;
+    atString result;
+
+    // Add the cache extension to the source file's name
+    filename = (char *)malloc(strlen(sourceFile) +
+        strlen(VS_SCENE_CACHE_EXTENSION) + 1);
+    strcpy(filename, sourceFile);
+    strcat(filename, VS_SCENE_CACHE_EXTENSION);
+    result.setString(filename);
+    free(filename);
+
+    return result;
+}
+
+// ------------------------------------------------------------------------
+// Starts writing a new cache file for the given source file.  The
+// validation mode determines how the cache is checked against the source
+// file when it's read, and the settings key should identify any loader
+// settings that affect the scene (a cache written with different
+// settings won't be used).  Nothing is written to the file until
+// finishWrite() is called.  Returns false if the source file can't be
+// examined.
+// ------------------------------------------------------------------------
+bool vsSceneCache::beginWrite(const char *cacheFile, const char *sourceFile,
+                              int validation, u_int settingsKey)
+{
+    // Abandon anything we were in the middle of
+    reset();
+
+    // Set up the header
+    memset(&cacheHeader, 0, sizeof(cacheHeader));
+    memcpy(cacheHeader.magic, VS_SCENE_CACHE_MAGIC, sizeof(cacheHeader.magic));
+    cacheHeader.version = VS_SCENE_CACHE_VERSION;
+    cacheHeader.byteOrder = VS_SCENE_CACHE_BYTE_ORDER;
+    cacheHeader.settingsKey = settingsKey;
+    cacheHeader.validation = validation;
+
+    // Record the information about the source file that we'll use to
+    // validate the cache
+    if (!getSourceInfo(sourceFile, validation, &cacheHeader))
+    {
+        printf("vsSceneCache::beginWrite: Unable to examine source file "
+            "%s\n", sourceFile);
+        return false;
+    }
+
+    // Start writing
+    cacheFilename.setString(cacheFile);
+    writing = true;
+    return true;
+}
+
+// ------------------------------------------------------------------------
+// Writes everything that was stored in the cache to the cache file.  The
+// file is written under a temporary name and renamed when complete, so
+// a partially-written cache is never read.  Returns false if anything
+// couldn't be stored or the file couldn't be written.
+// ------------------------------------------------------------------------
+bool vsSceneCache::finishWrite()
+{
+    atString tempFilename;
+    char *filename;
+    FILE *cacheFile;
+    bool result;
+
+    // Make sure we're writing, and that everything could be stored
+    if ((!writing) || (cacheError))
+    {
+        reset();
+        return false;
+    }
+
+    // Finish the header
+    cacheHeader.dataSize = writeSize;
+    cacheHeader.dataHash = hashData(writeBuffer, writeSize);
+    cacheHeader.headerHash = hashData((unsigned char *)&cacheHeader,
+        offsetof(vsSceneCacheHeader, headerHash));
+
+    // Create the temporary file's name
+    filename = (char *)malloc(strlen(cacheFilename.getString()) + 5);
+    strcpy(filename, cacheFilename.getString());
+    strcat(filename, ".tmp");
+    tempFilename.setString(filename);
+    free(filename);
+
+    // Write the header and data
+    result = false;
+    cacheFile = fopen(tempFilename.getString(), "wb");
+    if (cacheFile != NULL)
+    {
+        result = (fwrite(&cacheHeader, sizeof(cacheHeader), 1, cacheFile) == 1);
+        if ((result) && (writeSize > 0))
+            result = (fwrite(writeBuffer, writeSize, 1, cacheFile) == 1);
+        if (fclose(cacheFile) != 0)
+            result = false;
+    }
+
+    // Move the new file into place
+    if (result)
+    {
+#ifdef WIN32
+        // Windows won't rename over an existing file
+        remove(cacheFilename.getString());
+#endif
+        result = (rename(tempFilename.getString(),
+            cacheFilename.getString()) == 0);
+    }
+
+    // Clean up if anything went wrong
+    if (!result)
+    {
+        printf("vsSceneCache::finishWrite: Unable to write cache file %s\n",
+            cacheFilename.getString());
+        remove(tempFilename.getString());
+    }
+
+    // Done writing
+    reset();
+    return result;
+}
+
+// ------------------------------------------------------------------------
+// Opens the cache file for the given source file, and makes sure that it
+// is up to date.  The validation mode and settings key must match the
+// ones the cache was written with.  Only the header is checked (against
+// its own hash and the size of the file), so the rest of the cache is
+// only paged in as it's read, unless the cache is validated by hash, in
+// which case the hash of the whole cache is checked too.  Returns false
+// if there is no usable cache, in which case the scene should be loaded
+// from the source file.
+// ------------------------------------------------------------------------
+bool vsSceneCache::beginRead(const char *cacheFile, const char *sourceFile,
+                             int validation, u_int settingsKey)
+{
+    vsSceneCacheHeader sourceHeader;
+    bool valid;
+
+    // Abandon anything we were in the middle of
+    reset();
+
+    // Map the cache file into memory (it's fine if it doesn't exist yet)
+    mapData = mapFile(cacheFile, &mapSize, &mapFileHandle, &mapHandle);
+    if ((mapData == NULL) || (mapSize < sizeof(vsSceneCacheHeader)))
+    {
+        reset();
+        return false;
+    }
+
+    // Make sure the cache was written by this version of the code, on
+    // this kind of machine, with the same settings
+    memcpy(&cacheHeader, mapData, sizeof(cacheHeader));
+    valid = ((hashData((unsigned char *)&cacheHeader,
+                  offsetof(vsSceneCacheHeader, headerHash)) ==
+                  cacheHeader.headerHash) &&
+             (memcmp(cacheHeader.magic, VS_SCENE_CACHE_MAGIC,
+                  sizeof(cacheHeader.magic)) == 0) &&
+             (cacheHeader.version == VS_SCENE_CACHE_VERSION) &&
+             (cacheHeader.byteOrder == VS_SCENE_CACHE_BYTE_ORDER) &&
+             (cacheHeader.settingsKey == settingsKey) &&
+             (cacheHeader.validation == (u_int)validation) &&
+             (cacheHeader.dataSize == mapSize - sizeof(cacheHeader)));
+
+    // Make sure the source file hasn't changed since the cache was written
+    if (valid)
+    {
+        memset(&sourceHeader, 0, sizeof(sourceHeader));
+        valid = getSourceInfo(sourceFile, validation, &sourceHeader);
+        if (valid)
+        {
+            // The file's size must always match, along with its time stamp
+            // or its contents
+            valid = (sourceHeader.sourceSize == cacheHeader.sourceSize);
+            if (validation == VS_SCENE_CACHE_VALIDATE_HASH)
+                valid = valid &&
+                    (sourceHeader.sourceHash == cacheHeader.sourceHash);
+            else
+                valid = valid &&
+                    (sourceHeader.sourceTime == cacheHeader.sourceTime);
+        }
+    }
+
+    // When validating by hash, make sure the cache itself is intact (this
+    // reads the whole file, so it's skipped otherwise)
+    if ((valid) && (validation == VS_SCENE_CACHE_VALIDATE_HASH))
+        valid = (hashData(&mapData[sizeof(cacheHeader)],
+            cacheHeader.dataSize) == cacheHeader.dataHash);
+
+    // Give up if the cache can't be used
+    if (!valid)
+    {
+        reset();
+        return false;
+    }
+
+    // Start reading just after the header
+    readOffset = sizeof(cacheHeader);
+    reading = true;
+    return true;
+}
+
+// ------------------------------------------------------------------------
+// Closes the cache file.  Objects read from the cache are released at
+// this point, so any that are needed must be referenced first.  Returns
+// false if anything couldn't be read properly, in which case the objects
+// that were read shouldn't be used.
+// ------------------------------------------------------------------------
+bool vsSceneCache::finishRead()
+{
+    bool result;
+
+    // Everything must have been read without error
+    result = reading && (!cacheError);
+
+    // Done reading
+    reset();
+    return result;
+}
+
+// ------------------------------------------------------------------------
+// Returns whether the cache is being written or read, and no errors have
+// occurred yet
+// ------------------------------------------------------------------------
+bool vsSceneCache::isValid()
+{
+    return (writing || reading) && (!cacheError);
+}
+
+// ------------------------------------------------------------------------
+// Stores an integer in the cache
+// ------------------------------------------------------------------------
+void vsSceneCache::writeInt(int value)
+{
+    writeBytes(&value, sizeof(value));
+}
+
+// ------------------------------------------------------------------------
+// Stores a floating-point value in the cache
+// ------------------------------------------------------------------------
+void vsSceneCache::writeDouble(double value)
+{
+    writeBytes(&value, sizeof(value));
+}
+
+// ------------------------------------------------------------------------
+// Stores an array of floating-point values in the cache
+// ------------------------------------------------------------------------
+void vsSceneCache::writeDoubles(double *values, int count)
+{
+    if (count > 0)
+        writeBytes(values, sizeof(double) * count);
+}
+
+// ------------------------------------------------------------------------
+// Stores a string in the cache (NULL is stored as an empty string)
+// ------------------------------------------------------------------------
+void vsSceneCache::writeString(const char *string)
+{
+    int length;
+
+    // Store the length, followed by the characters
+    if (string == NULL)
+        length = 0;
+    else
+        length = strlen(string);
+    writeInt(length);
+    if (length > 0)
+        writeBytes(string, length);
+}
+
+// ------------------------------------------------------------------------
+// Stores a vector in the cache
+// ------------------------------------------------------------------------
+void vsSceneCache::writeVector(atVector vector)
+{
+    double values[4];
+    int i;
+
+    // We only handle the usual sizes of vector
+    if (vector.getSize() > 4)
+    {
+        printf("vsSceneCache::writeVector: Vector is too large\n");
+        cacheError = true;
+        return;
+    }
+
+    // Store the size, followed by the elements
+    writeInt(vector.getSize());
+    for (i = 0; i < vector.getSize(); i++)
+        values[i] = vector[i];
+    writeDoubles(values, vector.getSize());
+}
+
+// ------------------------------------------------------------------------
+// Stores a matrix in the cache
+// ------------------------------------------------------------------------
+void vsSceneCache::writeMatrix(atMatrix matrix)
+{
+    double values[16];
+    int i, j;
+
+    // Store the matrix's elements in row order
+    for (i = 0; i < 4; i++)
+        for (j = 0; j < 4; j++)
+            values[i * 4 + j] = matrix[i][j];
+    writeDoubles(values, 16);
+}
+
+// ------------------------------------------------------------------------
+// Stores the given node in the cache, along with all of its attributes
+// and children.  A node that is already in the cache is only stored as a
+// reference to the earlier copy, so instanced subgraphs stay instanced.
+// Only components, geometry and skeleton mesh geometry can be stored.
+// ------------------------------------------------------------------------
+void vsSceneCache::writeNode(vsNode *node)
+{
+    // Store the node's data, unless it's already in the cache
+    if (!writeReference(node))
+        writeNodeData(node);
+}
+
+// ------------------------------------------------------------------------
+// Stores the given skeleton in the cache, including its bones.  A
+// skeleton that is already in the cache is only stored as a reference.
+// ------------------------------------------------------------------------
+void vsSceneCache::writeSkeleton(vsSkeleton *skeleton)
+{
+    int index;
+
+    // Store a reference if the skeleton is NULL or already stored
+    if (skeleton == NULL)
+    {
+        writeInt(VS_SCENE_CACHE_NULL_OBJECT);
+        return;
+    }
+    index = findObject(skeleton);
+    if (index >= 0)
+    {
+        writeInt(index);
+        return;
+    }
+
+    // Store the skeleton's data.  The skeleton can only be created once
+    // its nodes are read back, so it's added to the cache after them.
+    writeInt(VS_SCENE_CACHE_NEW_OBJECT);
+    writeSkeletonData(skeleton);
+    addObject(skeleton);
+}
+
+// ------------------------------------------------------------------------
+// Stores the given skin in the cache, including its mesh and skeleton.  A
+// skin that is already in the cache is only stored as a reference.
+// ------------------------------------------------------------------------
+void vsSceneCache::writeSkin(vsSkin *skin)
+{
+    int index;
+
+    // Store a reference if the skin is NULL or already stored
+    if (skin == NULL)
+    {
+        writeInt(VS_SCENE_CACHE_NULL_OBJECT);
+        return;
+    }
+    index = findObject(skin);
+    if (index >= 0)
+    {
+        writeInt(index);
+        return;
+    }
+
+    // Store the skin's data, and add it to the cache after the objects
+    // that it uses
+    writeInt(VS_SCENE_CACHE_NEW_OBJECT);
+    writeSkinData(skin);
+    addObject(skin);
+}
+
+// ------------------------------------------------------------------------
+// Reads an integer from the cache
+// ------------------------------------------------------------------------
+int vsSceneCache::readInt()
+{
+    void *data;
+    int value;
+
+    // Get the value, if it's there
+    data = readBytes(sizeof(value));
+    if (data == NULL)
+        return 0;
+    memcpy(&value, data, sizeof(value));
+
+    return value;
+}
+
+// ------------------------------------------------------------------------
+// Reads a floating-point value from the cache
+// ------------------------------------------------------------------------
+double vsSceneCache::readDouble()
+{
+    void *data;
+    double value;
+
+    // Get the value, if it's there
+    data = readBytes(sizeof(value));
+    if (data == NULL)
+        return 0.0;
+    memcpy(&value, data, sizeof(value));
+
+    return value;
+}
+
+// ------------------------------------------------------------------------
+// Reads an array of floating-point values from the cache
+// ------------------------------------------------------------------------
+void vsSceneCache::readDoubles(double *values, int count)
+{
+    void *data;
+
+    // Nothing to do for an empty array
+    if (count <= 0)
+        return;
+
+    // Get the values, if they're there (zero them if not)
+    data = readBytes(sizeof(double) * count);
+    if (data == NULL)
+        memset(values, 0, sizeof(double) * count);
+    else
+        memcpy(values, data, sizeof(double) * count);
+}
+
+// ------------------------------------------------------------------------
+// Reads a string from the cache
+// ------------------------------------------------------------------------
+atString vsSceneCache::readString()
+{
+    int length;
+    char *data;
+    char *string;
+    atString result;
+
+    // Get the length of the string
+    length = readInt();
+    if (length < 0)
+    {
+        cacheError = true;
+        return result;
+    }
+
+    // Get the characters, and terminate them
+    if (length > 0)
+    {
+        data = (char *)readBytes(length);
+        if (data != NULL)
+        {
+            string = (char *)malloc(length + 1);
+            memcpy(string, data, length);
+            string[length] = 0;
+            result.setString(string);
+            free(string);
+        }
+    }
+
+    return result;
+}
+
+// ------------------------------------------------------------------------
+// Reads a vector from the cache
+// ------------------------------------------------------------------------
+atVector vsSceneCache::readVector()
+{
+    double values[4];
+    int size;
+    atVector result;
+    int i;
+
+    // Get the vector's size
+    size = readInt();
+    if ((size < 0) || (size > 4))
+    {
+        cacheError = true;
+        return result;
+    }
+
+    // Get the elements
+    readDoubles(values, size);
+    result.setSize(size);
+    for (i = 0; i < size; i++)
+        result[i] = values[i];
+
+    return result;
+}
+
+// ------------------------------------------------------------------------
+// Reads a matrix from the cache
+// ------------------------------------------------------------------------
+atMatrix vsSceneCache::readMatrix()
+{
+    double values[16];
+    atMatrix result;
+    int i, j;
+
+    // Get the matrix's elements in row order
+    readDoubles(values, 16);
+    for (i = 0; i < 4; i++)
+        for (j = 0; j < 4; j++)
+            result[i][j] = values[i * 4 + j];
+
+    return result;
+}
+
+// ------------------------------------------------------------------------
+// Reads a node (and its subgraph) from the cache
+// ------------------------------------------------------------------------
+vsNode *vsSceneCache::readNode()
+{
+    vsObject *object;
+
+    // Return the earlier copy if the node has been read already
+    if (readReference(&object))
+        return (vsNode *)object;
+
+    // Read the new node
+    return readNodeData();
+}
+
+// ------------------------------------------------------------------------
+// Reads a skeleton from the cache
+// ------------------------------------------------------------------------
+vsSkeleton *vsSceneCache::readSkeleton()
+{
+    vsObject *object;
+    vsSkeleton *skeleton;
+
+    // Return the earlier copy if the skeleton has been read already
+    if (readReference(&object))
+        return (vsSkeleton *)object;
+
+    // Read the new skeleton, and add it to the cache's objects
+    skeleton = readSkeletonData();
+    if (skeleton != NULL)
+        addObject(skeleton);
+
+    return skeleton;
+}
+
+// ------------------------------------------------------------------------
+// Reads a skin from the cache
+// ------------------------------------------------------------------------
+vsSkin *vsSceneCache::readSkin()
+{
+    vsObject *object;
+    vsSkin *skin;
+
+    // Return the earlier copy if the skin has been read already
+    if (readReference(&object))
+        return (vsSkin *)object;
+
+    // Read the new skin, and add it to the cache's objects
+    skin = readSkinData();
+    if (skin != NULL)
+        addObject(skin);
+
+    return skin;
+}
+
+// ------------------------------------------------------------------------
+// Static function
+// Maps the given file into memory (read-only).  Returns NULL if the file
+// can't be mapped.
+// ------------------------------------------------------------------------
+unsigned char *vsSceneCache::mapFile(const char *filename, size_t *size,
+                                     void **fileHandle, void **mapHandle)
+{
+    unsigned char *data;
+
+    *size = 0;
+    *fileHandle = NULL;
+    *mapHandle = NULL;
+
+#ifdef WIN32
+    HANDLE file, mapping;
+    LARGE_INTEGER fileSize;
+
+    // Open the file
+    file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return NULL;
+
+    // Get its size (an empty file can't be mapped)
+    if ((!GetFileSizeEx(file, &fileSize)) || (fileSize.QuadPart == 0))
+    {
+        CloseHandle(file);
+        return NULL;
+    }
+
+    // Map it
+    mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL)
+    {
+        CloseHandle(file);
+        return NULL;
+    }
+    data = (unsigned char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == NULL)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return NULL;
+    }
+
+    // Keep the handles, so we can close them when we unmap the file
+    *size = (size_t)fileSize.QuadPart;
+    *fileHandle = file;
+    *mapHandle = mapping;
+#else
+    int fd;
+    struct stat fileInfo;
+
+    // Open the file
+    fd = open(filename, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    // Get its size (an empty file can't be mapped)
+    if ((fstat(fd, &fileInfo) != 0) || (fileInfo.st_size == 0))
+    {
+        close(fd);
+        return NULL;
+    }
+
+    // Map it.  The mapping stays valid after the file is closed.
+    data = (unsigned char *)mmap(NULL, fileInfo.st_size, PROT_READ,
+        MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == (unsigned char *)MAP_FAILED)
+        return NULL;
+
+    *size = fileInfo.st_size;
+#endif
+
+    return data;
+}
+
+// ------------------------------------------------------------------------
+// Static function
+// Unmaps a file mapped by mapFile()
+// ------------------------------------------------------------------------
+void vsSceneCache::unmapFile(unsigned char *data, size_t size,
+                             void *fileHandle, void *mapHandle)
+{
+    // Nothing to do if nothing was mapped
+    if (data == NULL)
+        return;
+
+#ifdef WIN32
+    UnmapViewOfFile(data);
+    CloseHandle((HANDLE)mapHandle);
+    CloseHandle((HANDLE)fileHandle);
+#else
+    munmap(data, size);
+#endif
+}
+
+// ------------------------------------------------------------------------
+// Static function
+// Computes a 64-bit FNV-1a hash of the given data
+// ------------------------------------------------------------------------
+unsigned long long vsSceneCache::hashData(unsigned char *data, size_t size)
+{
+    unsigned long long hash;
+    size_t i;
+
+    hash = 14695981039346656037ULL;
+    for (i = 0; i < size; i++)
+    {
+        hash ^= data[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+// ------------------------------------------------------------------------
+// Static function
+// Fills in the size and modification time of the given source file in
+// the header, and also the hash of its contents if that's how the cache
+// is validated.  Returns false if the file can't be examined.
+// ------------------------------------------------------------------------
+bool vsSceneCache::getSourceInfo(const char *sourceFile, int validation,
+                                 vsSceneCacheHeader *header)
+{
+    struct stat fileInfo;
+    unsigned char *data;
+    size_t size;
+    void *fileHandle, *mapHandle;
+
+    // Get the file's size and time stamp
+    if (stat(sourceFile, &fileInfo) != 0)
+        return false;
+    header->sourceSize = fileInfo.st_size;
+    header->sourceTime = fileInfo.st_mtime;
+
+    // Hash the file's contents, if needed
+    header->sourceHash = 0;
+    if ((validation == VS_SCENE_CACHE_VALIDATE_HASH) &&
+        (fileInfo.st_size > 0))
+    {
+        data = mapFile(sourceFile, &size, &fileHandle, &mapHandle);
+        if (data == NULL)
+            return false;
+        header->sourceHash = hashData(data, size);
+        unmapFile(data, size, fileHandle, mapHandle);
+    }
+
+    return true;
+}
+
+// ------------------------------------------------------------------------
+// Private function
+// Abandons any write or read in progress, and releases everything
+// ------------------------------------------------------------------------
+void vsSceneCache::reset()
+{
+    // Discard any data that hasn't been written
+    if (writeBuffer != NULL)
+        free(writeBuffer);
+    writeBuffer = NULL;
+    writeSize = 0;
+    writeCapacity = 0;
+    writing = false;
+
+    // Unmap the cache file
+    unmapFile(mapData, mapSize, mapFileHandle, mapHandle);
+    mapData = NULL;
+    mapSize = 0;
+    mapFileHandle = NULL;
+    mapHandle = NULL;
+    readOffset = 0;
+    reading = false;
+
+    cacheError = false;
+
+    // Release the objects read from the cache, and forget the objects
+    // written to it
+    objectList.removeAllEntries();
+    objectCount = 0;
+    if (objectTable != NULL)
+    {
+        free(objectTable);
+        free(objectTableIndex);
+    }
+    objectTable = NULL;
+    objectTableIndex = NULL;
+    objectTableSize = 0;
+}
+
+// ------------------------------------------------------------------------
+// Private function
+// Returns the index of the given object among the objects already written
+// to the cache, or -1 if it hasn't been written
+// ------------------------------------------------------------------------
+int vsSceneCache::findObject(vsObject *object)
+{
+    size_t slot;
+
+    // Nothing has been written if there's no table
+    if (objectTableSize == 0)
+        return -1;
+
+    // Search the table, starting from the object's hash slot
+    slot = hashObjectAddress(object) & (objectTableSize - 1);
+    while (objectTable[slot] != NULL)
+    {
+        if (objectTable[slot] == object)
+            return objectTableIndex[slot];
+
+        slot = (slot + 1) & (objectTableSize - 1);
+    }
+
+    return -1;
+}
+
+// ------------------------------------------------------------------------
+// Private function
+// Adds an object to the cache's objects, giving it the next index.  When
+// writing, the object is added to the table used to find it again.  When
+// reading, it's added to the list used to look up references to it (this
+// also keeps it around until the read is finished).
+// ------------------------------------------------------------------------
+void vsSceneCache::addObject(vsObject *object)
+{
+    vsObject **oldTable;
+    int *oldIndex;
+    int oldSize;
+    size_t slot;
+    int i;
+
+    // When reading, just add the object to the list
+    if (reading)
+    {
+        objectList.setEntry(objectCount, object);
+        objectCount++;
+        return;
+    }
+
+    // Grow the table if it's getting full (keep it at most half full)
+    if ((objectCount + 1) * 2 > objectTableSize)
+    {
+        // Create the new table
+        oldTable = objectTable;
+        oldIndex = objectTableIndex;
+        oldSize = objectTableSize;
+        if (objectTableSize == 0)
+            objectTableSize = 256;
+        else
+            objectTableSize *= 2;
+        objectTable =
+            (vsObject **)calloc(objectTableSize, sizeof(vsObject *));
+        objectTableIndex = (int *)malloc(objectTableSize * sizeof(int));
+
+        // Move the objects over
+        for (i = 0; i < oldSize; i++)
+        {
+            if (oldTable[i] != NULL)
+            {
+                slot = hashObjectAddress(oldTable[i]) & (objectTableSize - 1);
+                while (objectTable[slot] != NULL)
+                    slot = (slot + 1) & (objectTableSize - 1);
+                objectTable[slot] = oldTable[i];
+                objectTableIndex[slot] = oldIndex[i];
+            }
+        }
+
+        // Get rid of the old table
+        if (oldTable != NULL)
+        {
+            free(oldTable);
+            free(oldIndex);
+        }
+    }
+
+    // Add the object
+    slot = hashObjectAddress(object) & (objectTableSize - 1);
+    while (objectTable[slot] != NULL)
+        slot = (slot + 1) & (objectTableSize - 1);
+    objectTable[slot] = object;
+    objectTableIndex[slot] = objectCount;
+    objectCount++;
+}
+
+// ------------------------------------------------------------------------
+// Private function
+// Adds the given data to the data being written, padded to the cache's
+// alignment
+// ------------------------------------------------------------------------
+void vsSceneCache::writeBytes(const void *data, size_t size)
+{
+    size_t paddedSize;
+
+    // Don't bother if we're not writing, or if the cache is already bad
+    if ((!writing) || (cacheError))
+        return;
+
+    // Grow the buffer if we need to
+    paddedSize = (size + VS_SCENE_CACHE_ALIGNMENT - 1) &
+        ~((size_t)VS_SCENE_CACHE_ALIGNMENT - 1);
+    if (writeSize + paddedSize > writeCapacity)
+    {
+        if (writeCapacity == 0)
+            writeCapacity = 65536;
+        while (writeSize + paddedSize > writeCapacity)
+            writeCapacity *= 2;
+        writeBuffer = (unsigned char *)realloc(writeBuffer, writeCapacity);
+    }
+
+    // Copy the data, and zero the padding
+    memcpy(&writeBuffer[writeSize], data, size);
+    memset(&writeBuffer[writeSize + size], 0, paddedSize - size);
+    writeSize += paddedSize;
+}
+
+// ------------------------------------------------------------------------
+// Private function
+// Returns a pointer to the next piece of data of the given size in the
+// mapped cache file, and moves past it.  Returns NULL (and flags the
+// cache as bad) if there isn't that much data left.
+// ------------------------------------------------------------------------
+void *vsSceneCache::readBytes(size_t size)
+{
+    size_t paddedSize;
+    void *result;
+
+    // Don't bother if we're not reading, or if the cache is already bad
+    if ((!reading) || (cacheError))
+        return NULL;
+
+    // Make sure the data is there
+    paddedSize = (size + VS_SCENE_CACHE_ALIGNMENT - 1) &
+        ~((size_t)VS_SCENE_CACHE_ALIGNMENT - 1);
+    if ((paddedSize < size) || (paddedSize > mapSize - readOffset))
+    {
+        printf("vsSceneCache::readBytes: Cache file is truncated\n");
+        cacheError = true;
+        return NULL;
+    }
+
+    // Return the data and move past it
+    result = &mapData[readOffset];
+    readOffset += paddedSize;
+    return result;
+}
+
+// ------------------------------------------------------------------------
+// Private function
+// Writes a reference to the given object.  Returns true if the reference
+// is all that's needed (the object is NULL or has already been written).
+// Otherwise, the object is added to the cache, and the caller must write
+// its data next.
+// ------------------------------------------------------------------------
+bool vsSceneCache::writeReference(vsObject *object)
+{
+    int index;
+
+    // Handle NULL objects
+    if (object == NULL)
+    {
+        writeInt(VS_SCENE_CACHE_NULL_OBJECT);
+        return true;
+    }
+
+    // Refer to the earlier copy of the object if there is one
+    index = findObject(object);
+    if (index >= 0)
+    {
+        writeInt(index);
+        return true;
+    }
+
+    // This is a new object
+    writeInt(VS_SCENE_CACHE_NEW_OBJECT);
+    addObject(object);
+    return false;
+}
+
+// ------------------------------------------------------------------------
+// Private function
+// Reads a reference to an object.  Returns true and sets the object
+// parameter if the reference is to a NULL or earlier object.  Returns
+// false if the object's data comes next (the caller must read it).
+// ------------------------------------------------------------------------
+bool vsSceneCache::readReference(vsObject **object)
+{
+    int index;
+
+    // Get the reference
+    *object = NULL;
+    index = readInt();
+
+    // A new object's data comes next
+    if ((index == VS_SCENE_CACHE_NEW_OBJECT) && (!cacheError))
+        return false;
+
+    // Look up earlier objects
+    if ((index >= 0) && (index < objectCount))
+        *object = (vsObject *)objectList.getEntry(index);
+    else if (index != VS_SCENE_CACHE_NULL_OBJECT)
+        cacheError = true;
+
+    return true;
+}
+
+// ------------------------------------------------------------------------
+// Private function
+// Writes the data for a new node
+// ------------------------------------------------------------------------
+void vsSceneCache::writeNodeData(vsNode *node)
+{
+    int nodeType;
+    vsAttribute *attribute;
+    int i;
+
+    // Make sure we can handle this kind of node
+    nodeType = node->getNodeType();
+    if ((nodeType != VS_NODE_TYPE_COMPONENT) &&
+        (nodeType != VS_NODE_TYPE_GEOMETRY) &&
+        (nodeType != VS_NODE_TYPE_SKELETON_MESH_GEOMETRY))
+    {
+        printf("vsSceneCache::writeNodeData: %s nodes can't be cached\n",
+            node->getClassName());
+        cacheError = true;
+        return;
+    }
+
+    // Write the settings common to all nodes
+    writeInt(nodeType);
+    writeString(node->getName());
+    writeInt((int)node->getIntersectValue());
+
+    // Write the children or geometry
+    if (nodeType == VS_NODE_TYPE_COMPONENT)
+    {
+        writeInt(node->getChildCount());
+        for (i = 0; i < node->getChildCount(); i++)
+            writeNode(node->getChild(i));
+    }
+    else
+        writeGeometryData((vsGeometryBase *)node);
+
+    // Write the attributes (after the children, since some attributes
+    // can only be set up once the children are there)
+    writeInt(node->getAttributeCount());
+    for (i = 0; i < node->getAttributeCount(); i++)
+    {
+        attribute = node->getAttribute(i);
+        if (!writeReference(attribute))
+            writeAttributeData(attribute, node);
+    }
+}
+
+// ------------------------------------------------------------------------
+// Private function
+// Writes the primitives, data lists and indices of a geometry node.  The
+// data lists are written as blocks of floats, so they can be copied
+// straight into the geometry when they're read.
+// ------------------------------------------------------------------------
+void vsSceneCache::writeGeometryData(vsGeometryBase *geometry)
+{
+    bool skinned;
+    int *lengths;
+    int whichData, listType;
+    float *data;
+    int count, components;
+    int binding;
+    u_int *indices;
+
+    // Render bins are shared objects that we don't store
+    if (geometry->getRenderBin() != NULL)
+    {
+        printf("vsSceneCache::writeGeometryData: Geometry with render bins "
+            "can't be cached\n");
+        cacheError = true;
+        return;
+    }
+
+    // Skeleton mesh geometry keeps its original vertices and normals in
+    // separate lists
+    skinned =
+        (geometry->getNodeType() == VS_NODE_TYPE_SKELETON_MESH_GEOMETRY);
+
+    // Write the primitives
+    writeInt(geometry->getPrimitiveType());
+    writeInt(geometry->getPrimitiveCount());
+    if (geometry->getPrimitiveCount() > 0)
+    {
+        lengths = (int *)malloc(sizeof(int) * geometry->getPrimitiveCount());
+        geometry->getPrimitiveLengths(lengths);
+        writeBytes(lengths, sizeof(int) * geometry->getPrimitiveCount());
+        free(lengths);
+    }
+
+    // Write the lighting setting
+    writeInt(geometry->isLightingEnabled());
+
+    // Write each data list that has data in it (conventional lists first,
+    // then generic ones)
+    for (whichData = 0; whichData < VS_GEOMETRY_LIST_COUNT * 2; whichData++)
+    {
+        // Use the original vertices and normals of skeleton mesh geometry
+        listType = whichData;
+        if ((skinned) && (whichData == VS_GEOMETRY_VERTEX_COORDS))
+            listType = VS_GEOMETRY_SKIN_VERTEX_COORDS;
+        else if ((skinned) && (whichData == VS_GEOMETRY_NORMALS))
+            listType = VS_GEOMETRY_SKIN_NORMALS;
+
+        // Skip empty lists
+        data = geometry->getRawDataList(listType, &count, &components);
+        if (data == NULL)
+            continue;
+
+        // Get the list's binding
+        if (skinned)
+            binding = ((vsSkeletonMeshGeometry *)geometry)->
+                getBinding(whichData);
+        else
+            binding = geometry->getBinding(whichData);
+
+        // Write the list
+        writeInt(whichData);
+        writeInt(binding);
+        writeInt(count);
+        writeInt(components);
+        writeBytes(data, sizeof(float) * components * count);
+    }
+
+    // Mark the end of the lists
+    writeInt(-1);
+
+    // Write the indices
+    writeInt(geometry->getIndexListSize());
+    if (geometry->getIndexListSize() > 0)
+    {
+        indices = (u_int *)malloc(sizeof(u_int) *
+            geometry->getIndexListSize());
+        geometry->getIndexList(indices);
+        writeBytes(indices, sizeof(u_int) * geometry->getIndexListSize());
+        free(indices);
+    }
+}
+
+// ------------------------------------------------------------------------
+// Private function
+// Writes the data for a new attribute attached to the given node
+// ------------------------------------------------------------------------
+void vsSceneCache::writeAttributeData(vsAttribute *attribute, vsNode *node)
+{
+    int type;
+    vsTransformAttribute *transformAttr;
+    vsLODAttribute *lodAttr;
+    vsMaterialAttribute *materialAttr;
+    vsTextureAttribute *textureAttr;
+    vsTransparencyAttribute *transparencyAttr;
+    double color[3];
+    int side, whichColor;
+    unsigned char *imageData;
+    int xSize, ySize, dataFormat;
+    int imageSize;
+    int i;
+
+    // Write the settings common to all attributes
+    type = attribute->getAttributeType();
+    writeInt(type);
+    writeString(attribute->getName());
+
+    // Write the settings for the specific type of attribute
+    switch (type)
+    {
+        case VS_ATTRIBUTE_TYPE_TRANSFORM:
+            transformAttr = (vsTransformAttribute *)attribute;
+            writeMatrix(transformAttr->getPreTransform());
+            writeMatrix(transformAttr->getDynamicTransform());
+            writeMatrix(transformAttr->getPostTransform());
+            break;
+
+        case VS_ATTRIBUTE_TYPE_LOD:
+            // Write the center and the range of each child
+            lodAttr = (vsLODAttribute *)attribute;
+            writeVector(lodAttr->getCenter());
+            writeInt(node->getChildCount());
+            for (i = 0; i < node->getChildCount(); i++)
+                writeDouble(lodAttr->getRangeEnd(i));
+            break;
+
+        case VS_ATTRIBUTE_TYPE_DECAL:
+            // Decals have no settings
+            break;
+
+        case VS_ATTRIBUTE_TYPE_MATERIAL:
+            // Write the front and back materials
+            materialAttr = (vsMaterialAttribute *)attribute;
+            for (side = VS_MATERIAL_SIDE_FRONT; side <= VS_MATERIAL_SIDE_BACK;
+                side++)
+            {
+                for (whichColor = VS_MATERIAL_COLOR_AMBIENT;
+                    whichColor <= VS_MATERIAL_COLOR_EMISSIVE; whichColor++)
+                {
+                    materialAttr->getColor(side, whichColor, &color[0],
+                        &color[1], &color[2]);
+                    writeDoubles(color, 3);
+                }
+                writeDouble(materialAttr->getAlpha(side));
+                writeDouble(materialAttr->getShininess(side));
+                writeInt(materialAttr->getColorMode(side));
+            }
+            break;
+
+        case VS_ATTRIBUTE_TYPE_TEXTURE:
+            textureAttr = (vsTextureAttribute *)attribute;
+            writeInt(textureAttr->getTextureUnit());
+
+            // Write the image (if there is one)
+            textureAttr->getImage(&imageData, &xSize, &ySize, &dataFormat);
+            imageSize = 0;
+            if (imageData != NULL)
+            {
+                imageSize = getImageDataSize(xSize, ySize, dataFormat);
+                if (imageSize < 0)
+                {
+                    printf("vsSceneCache::writeAttributeData: Texture image "
+                        "format can't be cached\n");
+                    cacheError = true;
+                    return;
+                }
+            }
+            writeInt(imageSize);
+            if (imageSize > 0)
+            {
+                writeInt(xSize);
+                writeInt(ySize);
+                writeInt(dataFormat);
+                writeBytes(imageData, imageSize);
+            }
+
+            // Write the texture settings
+            writeInt(textureAttr->getBoundaryMode(VS_TEXTURE_DIRECTION_S));
+            writeInt(textureAttr->getBoundaryMode(VS_TEXTURE_DIRECTION_T));
+            writeInt(textureAttr->getApplyMode());
+            writeInt(textureAttr->getMagFilter());
+            writeInt(textureAttr->getMinFilter());
+            writeVector(textureAttr->getBaseColor());
+            writeInt(textureAttr->getGenMode());
+            writeMatrix(textureAttr->getTextureMatrix());
+            break;
+
+        case VS_ATTRIBUTE_TYPE_TRANSPARENCY:
+            transparencyAttr = (vsTransparencyAttribute *)attribute;
+            writeInt(transparencyAttr->isEnabled());
+            writeInt(transparencyAttr->getQuality());
+            writeInt(transparencyAttr->isOcclusionEnabled());
+            break;
+
+        case VS_ATTRIBUTE_TYPE_BACKFACE:
+            writeInt(((vsBackfaceAttribute *)attribute)->isEnabled());
+            break;
+
+        case VS_ATTRIBUTE_TYPE_SHADING:
+            writeInt(((vsShadingAttribute *)attribute)->getShading());
+            break;
+
+        case VS_ATTRIBUTE_TYPE_WIREFRAME:
+            writeInt(((vsWireframeAttribute *)attribute)->isEnabled());
+            break;
+
+        default:
+            printf("vsSceneCache::writeAttributeData: %s attributes can't "
+                "be cached\n", attribute->getClassName());
+            cacheError = true;
+            break;
+    }
+}
+
+// ------------------------------------------------------------------------
+// Private function
+// Writes the data for a new skeleton
+// ------------------------------------------------------------------------
+void vsSceneCache::writeSkeletonData(vsSkeleton *skeleton)
+{
+    int i;
+
+    // Write the skeleton's subgraph, then each of its bones (which will
+    // just be references to nodes in the subgraph)
+    writeNode(skeleton->getRoot());
+    writeInt(skeleton->getBoneCount());
+    for (i = 0; i < skeleton->getBoneCount(); i++)
+        writeNode(skeleton->getBone(i));
+
+    // Write the skeleton's offset
+    writeMatrix(skeleton->getOffsetMatrix());
+}
+
+// ------------------------------------------------------------------------
+// Private function
+// Writes the data for a new skin
+// ------------------------------------------------------------------------
+void vsSceneCache::writeSkinData(vsSkin *skin)
+{
+    atArray *matrixList;
+    atMatrix *matrix;
+    int i;
+
+    // Write the skin's mesh, and its skeleton
+    writeNode(skin->getRootComponent());
+    writeSkeleton(skin->getSkeleton());
+
+    // Write the bone space matrices (some bones may not have one)
+    matrixList = skin->getBoneSpaceMatrixList();
+    writeInt(matrixList->getNumEntries());
+    for (i = 0; i < matrixList->getNumEntries(); i++)
+    {
+        matrix = (atMatrix *)matrixList->getEntry(i);
+        writeInt(matrix != NULL);
+        if (matrix != NULL)
+            writeMatrix(*matrix);
+    }
+}
+
+// ------------------------------------------------------------------------
+// Private function
+// Reads the data for a new node, and creates it
+// ------------------------------------------------------------------------
+vsNode *vsSceneCache::readNodeData()
+{
+    int nodeType;
+    vsNode *node;
+    vsNode *child;
+    atString name;
+    int count;
+    int i;
+
+    // Create the right kind of node
+    nodeType = readInt();
+    if (nodeType == VS_NODE_TYPE_COMPONENT)
+        node = new vsComponent();
+    else if (nodeType == VS_NODE_TYPE_GEOMETRY)
+        node = new vsGeometry();
+    else if (nodeType == VS_NODE_TYPE_SKELETON_MESH_GEOMETRY)
+        node = new vsSkeletonMeshGeometry();
+    else
+    {
+        cacheError = true;
+        return NULL;
+    }
+
+    // Add the node to the cache's objects before reading anything else,
+    // so that references to it can be found
+    addObject(node);
+
+    // Read the settings common to all nodes
+    name = readString();
+    if (name.getLength() > 0)
+        node->setName(name.getString());
+    node->setIntersectValue((unsigned int)readInt());
+
+    // Read the children or geometry
+    if (nodeType == VS_NODE_TYPE_COMPONENT)
+    {
+        count = readInt();
+        for (i = 0; (i < count) && (!cacheError); i++)
+        {
+            child = readNode();
+            if (child != NULL)
+                node->addChild(child);
+        }
+    }
+    else
+        readGeometryData((vsGeometryBase *)node);
+
+    // Read the attributes
+    count = readInt();
+    for (i = 0; (i < count) && (!cacheError); i++)
+        readAttribute(node);
+
+    return node;
+}
+
+// ------------------------------------------------------------------------
+// Private function
+// Reads the primitives, data lists and indices of a geometry node.  Each
+// data list is copied into the geometry in a single block.
+// ------------------------------------------------------------------------
+void vsSceneCache::readGeometryData(vsGeometryBase *geometry)
+{
+    bool skinned;
+    int primitiveCount;
+    int *lengths;
+    int whichData, listType;
+    int binding;
+    int count, components;
+    int storedCount, storedComponents;
+    float *data;
+    int indexCount;
+    u_int *indices;
+
+    // Skeleton mesh geometry keeps its original vertices and normals in
+    // separate lists
+    skinned =
+        (geometry->getNodeType() == VS_NODE_TYPE_SKELETON_MESH_GEOMETRY);
+
+    // Read the primitives
+    geometry->setPrimitiveType(readInt());
+    primitiveCount = readInt();
+    if ((primitiveCount < 0) || (primitiveCount > VS_GEOMETRY_MAX_LIST_INDEX))
+    {
+        cacheError = true;
+        return;
+    }
+    if (primitiveCount > 0)
+    {
+        lengths = (int *)readBytes(sizeof(int) * primitiveCount);
+        if (lengths == NULL)
+            return;
+        geometry->setPrimitiveCount(primitiveCount);
+        geometry->setPrimitiveLengths(lengths);
+    }
+
+    // Read the lighting setting
+    if (readInt())
+        geometry->enableLighting();
+    else
+        geometry->disableLighting();
+
+    // Read the data lists
+    whichData = readInt();
+    while ((whichData != -1) && (!cacheError))
+    {
+        // Read the list's settings, and make sure they're sane
+        binding = readInt();
+        count = readInt();
+        components = readInt();
+        if ((whichData < 0) || (whichData >= VS_GEOMETRY_LIST_COUNT * 2) ||
+            (count < 0) || (count > VS_GEOMETRY_MAX_LIST_INDEX) ||
+            (components < 1) || (components > 4))
+        {
+            cacheError = true;
+            return;
+        }
+
+        // Get the data
+        data = (float *)readBytes(sizeof(float) * components * count);
+        if (data == NULL)
+            return;
+
+        // Set the list's data, using the original lists for the vertices
+        // and normals of skeleton mesh geometry
+        listType = whichData;
+        if ((skinned) && (whichData == VS_GEOMETRY_VERTEX_COORDS))
+            listType = VS_GEOMETRY_SKIN_VERTEX_COORDS;
+        else if ((skinned) && (whichData == VS_GEOMETRY_NORMALS))
+            listType = VS_GEOMETRY_SKIN_NORMALS;
+        geometry->setRawDataList(listType, data, count);
+
+        // Make sure the data fit the list
+        geometry->getRawDataList(listType, &storedCount, &storedComponents);
+        if ((storedCount != count) || (storedComponents != components))
+        {
+            printf("vsSceneCache::readGeometryData: Data list doesn't "
+                "match the geometry\n");
+            cacheError = true;
+            return;
+        }
+
+        // Set the list's binding
+        if (skinned)
+            ((vsSkeletonMeshGeometry *)geometry)->setBinding(whichData,
+                binding);
+        else
+            geometry->setBinding(whichData, binding);
+
+        // Next list
+        whichData = readInt();
+    }
+
+    // Read the indices
+    indexCount = readInt();
+    if ((indexCount < 0) || (indexCount > VS_GEOMETRY_MAX_LIST_INDEX))
+    {
+        cacheError = true;
+        return;
+    }
+    if (indexCount > 0)
+    {
+        indices = (u_int *)readBytes(sizeof(u_int) * indexCount);
+        if (indices == NULL)
+            return;
+        geometry->setIndexListSize(indexCount);
+        geometry->setIndexList(indices);
+    }
+}
+
+// ------------------------------------------------------------------------
+// Private function
+// Reads an attribute and attaches it to the given node
+// ------------------------------------------------------------------------
+void vsSceneCache::readAttribute(vsNode *node)
+{
+    vsObject *object;
+    vsAttribute *attribute;
+    int type;
+    atString name;
+    vsTransformAttribute *transformAttr;
+    vsLODAttribute *lodAttr;
+    vsMaterialAttribute *materialAttr;
+    vsTextureAttribute *textureAttr;
+    vsTransparencyAttribute *transparencyAttr;
+    vsBackfaceAttribute *backfaceAttr;
+    vsShadingAttribute *shadingAttr;
+    vsWireframeAttribute *wireframeAttr;
+    atVector center;
+    double color[3];
+    int side, whichColor;
+    unsigned char *imageData;
+    unsigned char *imageCopy;
+    int xSize, ySize, dataFormat;
+    int imageSize;
+    int count;
+    int i;
+
+    // See if the attribute has been read already
+    if (readReference(&object))
+    {
+        // Attach the earlier copy (or a copy of it, if the attribute
+        // can't be shared)
+        attribute = (vsAttribute *)object;
+        if (attribute == NULL)
+            cacheError = true;
+        else if (attribute->canAttach())
+            node->addAttribute(attribute);
+        else
+            node->addAttribute(attribute->clone());
+
+        return;
+    }
+
+    // Read the settings common to all attributes
+    type = readInt();
+    name = readString();
+
+    // Create the attribute, and read the settings for its type
+    attribute = NULL;
+    switch (type)
+    {
+        case VS_ATTRIBUTE_TYPE_TRANSFORM:
+            transformAttr = new vsTransformAttribute();
+            transformAttr->setPreTransform(readMatrix());
+            transformAttr->setDynamicTransform(readMatrix());
+            transformAttr->setPostTransform(readMatrix());
+            attribute = transformAttr;
+            break;
+
+        case VS_ATTRIBUTE_TYPE_LOD:
+            // The LOD ranges can only be set once the attribute is
+            // attached, so we take care of that ourselves
+            lodAttr = new vsLODAttribute();
+            addObject(lodAttr);
+            if (name.getLength() > 0)
+                lodAttr->setName(name.getString());
+            node->addAttribute(lodAttr);
+
+            // Read the center and the range of each child
+            lodAttr->setCenter(readVector());
+            count = readInt();
+            for (i = 0; (i < count) && (!cacheError); i++)
+                lodAttr->setRangeEnd(i, readDouble());
+            return;
+
+        case VS_ATTRIBUTE_TYPE_DECAL:
+            attribute = new vsDecalAttribute();
+            break;
+
+        case VS_ATTRIBUTE_TYPE_MATERIAL:
+            // Read the front and back materials
+            materialAttr = new vsMaterialAttribute();
+            for (side = VS_MATERIAL_SIDE_FRONT; side <= VS_MATERIAL_SIDE_BACK;
+                side++)
+            {
+                for (whichColor = VS_MATERIAL_COLOR_AMBIENT;
+                    whichColor <= VS_MATERIAL_COLOR_EMISSIVE; whichColor++)
+                {
+                    readDoubles(color, 3);
+                    materialAttr->setColor(side, whichColor, color[0],
+                        color[1], color[2]);
+                }
+                materialAttr->setAlpha(side, readDouble());
+                materialAttr->setShininess(side, readDouble());
+                materialAttr->setColorMode(side, readInt());
+            }
+            attribute = materialAttr;
+            break;
+
+        case VS_ATTRIBUTE_TYPE_TEXTURE:
+            textureAttr = new vsTextureAttribute(readInt());
+
+            // Read the image (if there is one).  The texture takes
+            // ownership of the image data, so it gets its own copy.
+            imageSize = readInt();
+            if (imageSize > 0)
+            {
+                xSize = readInt();
+                ySize = readInt();
+                dataFormat = readInt();
+                imageData = (unsigned char *)readBytes(imageSize);
+                if ((imageData != NULL) &&
+                    (getImageDataSize(xSize, ySize, dataFormat) == imageSize))
+                {
+                    imageCopy = (unsigned char *)malloc(imageSize);
+                    memcpy(imageCopy, imageData, imageSize);
+                    textureAttr->setImage(imageCopy, xSize, ySize,
+                        dataFormat);
+                }
+                else
+                    cacheError = true;
+            }
+
+            // Read the texture settings
+            textureAttr->setBoundaryMode(VS_TEXTURE_DIRECTION_S, readInt());
+            textureAttr->setBoundaryMode(VS_TEXTURE_DIRECTION_T, readInt());
+            textureAttr->setApplyMode(readInt());
+            textureAttr->setMagFilter(readInt());
+            textureAttr->setMinFilter(readInt());
+            textureAttr->setBaseColor(readVector());
+            textureAttr->setGenMode(readInt());
+            textureAttr->setTextureMatrix(readMatrix());
+            attribute = textureAttr;
+            break;
+
+        case VS_ATTRIBUTE_TYPE_TRANSPARENCY:
+            transparencyAttr = new vsTransparencyAttribute();
+            if (readInt())
+                transparencyAttr->enable();
+            else
+                transparencyAttr->disable();
+            transparencyAttr->setQuality(readInt());
+            if (readInt())
+                transparencyAttr->enableOcclusion();
+            else
+                transparencyAttr->disableOcclusion();
+            attribute = transparencyAttr;
+            break;
+
+        case VS_ATTRIBUTE_TYPE_BACKFACE:
+            backfaceAttr = new vsBackfaceAttribute();
+            if (readInt())
+                backfaceAttr->enable();
+            else
+                backfaceAttr->disable();
+            attribute = backfaceAttr;
+            break;
+
+        case VS_ATTRIBUTE_TYPE_SHADING:
+            shadingAttr = new vsShadingAttribute();
+            shadingAttr->setShading(readInt());
+            attribute = shadingAttr;
+            break;
+
+        case VS_ATTRIBUTE_TYPE_WIREFRAME:
+            wireframeAttr = new vsWireframeAttribute();
+            if (readInt())
+                wireframeAttr->enable();
+            else
+                wireframeAttr->disable();
+            attribute = wireframeAttr;
+            break;
+
+        default:
+            cacheError = true;
+            return;
+    }
+
+    // Add the attribute to the cache's objects, name it, and attach it
+    addObject(attribute);
+    if (name.getLength() > 0)
+        attribute->setName(name.getString());
+    node->addAttribute(attribute);
+}
+
+// ------------------------------------------------------------------------
+// Private function
+// Reads the data for a new skeleton, and creates it
+// ------------------------------------------------------------------------
+vsSkeleton *vsSceneCache::readSkeletonData()
+{
+    vsNode *root;
+    int boneCount;
+    atArray *boneList;
+    vsNode *bone;
+    atMatrix offset;
+    vsSkeleton *skeleton;
+    int i;
+
+    // Read the skeleton's subgraph
+    root = readNode();
+
+    // Read the bones
+    boneCount = readInt();
+    if (boneCount < 0)
+        cacheError = true;
+    boneList = new atArray();
+    for (i = 0; (i < boneCount) && (!cacheError); i++)
+    {
+        bone = readNode();
+        if ((bone != NULL) && (bone->getNodeType() == VS_NODE_TYPE_COMPONENT))
+            boneList->setEntry(i, bone);
+    }
+
+    // Read the offset
+    offset = readMatrix();
+
+    // Make sure we got everything
+    if ((cacheError) || (root == NULL) ||
+        (root->getNodeType() != VS_NODE_TYPE_COMPONENT))
+    {
+        // The bones belong to the cache's objects, so take them out of
+        // the array before deleting it
+        for (i = 0; i < boneList->getNumEntries(); i++)
+            boneList->setEntry(i, NULL);
+        delete boneList;
+        cacheError = true;
+        return NULL;
+    }
+
+    // Create the skeleton (it takes the bone list)
+    skeleton = new vsSkeleton(boneList, boneCount, (vsComponent *)root);
+    skeleton->setOffsetMatrix(offset);
+
+    return skeleton;
+}
+
+// ------------------------------------------------------------------------
+// Private function
+// Reads the data for a new skin, and creates it
+// ------------------------------------------------------------------------
+vsSkin *vsSceneCache::readSkinData()
+{
+    vsNode *root;
+    vsSkeleton *skeleton;
+    atArray *matrixList;
+    atMatrix *matrix;
+    int count;
+    vsSkin *skin;
+    int i;
+
+    // Read the skin's mesh, and its skeleton
+    root = readNode();
+    skeleton = readSkeleton();
+
+    // Read the bone space matrices
+    count = readInt();
+    if (count < 0)
+        cacheError = true;
+    matrixList = new atArray();
+    for (i = 0; (i < count) && (!cacheError); i++)
+    {
+        if (readInt())
+        {
+            matrix = new atMatrix();
+            *matrix = readMatrix();
+            matrixList->setEntry(i, matrix);
+        }
+    }
+
+    // Create the skin if we got everything (it copies the matrices)
+    skin = NULL;
+    if ((!cacheError) && (root != NULL) &&
+        (root->getNodeType() == VS_NODE_TYPE_COMPONENT))
+        skin = new vsSkin((vsComponent *)root, skeleton, matrixList);
+    else
+        cacheError = true;
+
+    // Clean up
+    delete matrixList;
+
+    return skin;
+}
@@ -0,0 +1,181 @@
+//------------------------------------------------------------------------
+//
+//    VIRTUAL ENVIRONMENT SOFTWARE SANDBOX (VESS)
+//
+//    Copyright (c) 2001, University of Central Florida
+//
+//       See the file LICENSE for license information
+//
+//    E-mail:  vess@ist.ucf.edu
+//    WWW:     http://vess.ist.ucf.edu/
+//
+//------------------------------------------------------------------------
+//
+//    VESS Module:  vsSceneCache.h++
+//
+//    Description:  Binary cache file for scenes that are expensive to
+//                  load.  A loader writes the scene it built into the
+//                  cache, and later loads map the cache file into memory
+//                  and rebuild the scene from it directly, as long as the
+//                  source file hasn't changed.
+//
+//    Author(s):    agent
+//
+//------------------------------------------------------------------------
+
+#ifndef VS_SCENE_CACHE_HPP
+#define VS_SCENE_CACHE_HPP
+
+#include "vsObject.h++"
+#include "vsArray.h++"
+#include "vsNode.h++"
+#include "vsAttribute.h++"
+#include "vsGeometryBase.h++"
+#include "vsSkeleton.h++"
+#include "vsSkin.h++"
+#include "atMatrix.h++"
+#include "atVector.h++"
+#include "atString.h++"
+#include <sys/types.h>
+
+// Version of the cache file format.  Cache files with any other version
+// are ignored (and replaced the next time the scene is cached)
+#define VS_SCENE_CACHE_VERSION       2
+
+// Extension added to the name of a source file to get the name of its
+// cache file
+#define VS_SCENE_CACHE_EXTENSION     ".vsc"
+
+// Reference values used in place of an object's index in the cache
+#define VS_SCENE_CACHE_NULL_OBJECT   -1
+#define VS_SCENE_CACHE_NEW_OBJECT    -2
+
+enum vsSceneCacheValidation
+{
+    VS_SCENE_CACHE_VALIDATE_TIMESTAMP,
+    VS_SCENE_CACHE_VALIDATE_HASH
+};
+
+struct VESS_SYM vsSceneCacheHeader
+{
+    char                  magic[8];
+    u_int                 version;
+    u_int                 byteOrder;
+    u_int                 settingsKey;
+    u_int                 validation;
+    long long             sourceSize;
+    long long             sourceTime;
+    unsigned long long    sourceHash;
+    unsigned long long    dataSize;
+    unsigned long long    dataHash;
+
+    // Hash of all of the fields above, checked on every read (the data
+    // hash is only checked when validating by hash, since it means
+    // reading the whole file)
+    unsigned long long    headerHash;
+};
+
+class VESS_SYM vsSceneCache : public vsObject
+{
+private:
+
+    atString              cacheFilename;
+
+    vsSceneCacheHeader    cacheHeader;
+
+    unsigned char         *writeBuffer;
+    size_t                writeSize;
+    size_t                writeCapacity;
+    bool                  writing;
+
+    unsigned char         *mapData;
+    size_t                mapSize;
+    void                  *mapFileHandle;
+    void                  *mapHandle;
+    size_t                readOffset;
+    bool                  reading;
+
+    bool                  cacheError;
+
+    vsArray               objectList;
+    int                   objectCount;
+    vsObject              **objectTable;
+    int                   *objectTableIndex;
+    int                   objectTableSize;
+
+    static unsigned char  *mapFile(const char *filename, size_t *size,
+                                   void **fileHandle, void **mapHandle);
+    static void           unmapFile(unsigned char *data, size_t size,
+                                    void *fileHandle, void *mapHandle);
+    static bool           getSourceInfo(const char *sourceFile,
+                                        int validation,
+                                        vsSceneCacheHeader *header);
+
+    void                  reset();
+
+    int                   findObject(vsObject *object);
+    void                  addObject(vsObject *object);
+
+    void                  writeBytes(const void *data, size_t size);
+    void                  *readBytes(size_t size);
+
+    bool                  writeReference(vsObject *object);
+    bool                  readReference(vsObject **object);
+
+    void                  writeNodeData(vsNode *node);
+    void                  writeGeometryData(vsGeometryBase *geometry);
+    void                  writeAttributeData(vsAttribute *attribute,
+                                             vsNode *node);
+    void                  writeSkeletonData(vsSkeleton *skeleton);
+    void                  writeSkinData(vsSkin *skin);
+
+    vsNode                *readNodeData();
+    void                  readGeometryData(vsGeometryBase *geometry);
+    void                  readAttribute(vsNode *node);
+    vsSkeleton            *readSkeletonData();
+    vsSkin                *readSkinData();
+
+public:
+
+                          vsSceneCache();
+    virtual               ~vsSceneCache();
+
+    virtual const char    *getClassName();
+
+    static atString       getCacheFilename(const char *sourceFile);
+    static unsigned long long    hashData(unsigned char *data, size_t size);
+
+    bool                  beginWrite(const char *cacheFile,
+                                     const char *sourceFile,
+                                     int validation, u_int settingsKey);
+    bool                  finishWrite();
+
+    bool                  beginRead(const char *cacheFile,
+                                    const char *sourceFile,
+                                    int validation, u_int settingsKey);
+    bool                  finishRead();
+
+    bool                  isValid();
+
+    void                  writeInt(int value);
+    void                  writeDouble(double value);
+    void                  writeDoubles(double *values, int count);
+    void                  writeString(const char *string);
+    void                  writeVector(atVector vector);
+    void                  writeMatrix(atMatrix matrix);
+    void                  writeNode(vsNode *node);
+    void                  writeSkeleton(vsSkeleton *skeleton);
+    void                  writeSkin(vsSkin *skin);
+
+    int                   readInt();
+    double                readDouble();
+    void                  readDoubles(double *values, int count);
+    atString              readString();
+    atVector              readVector();
+    atMatrix              readMatrix();
+    vsNode                *readNode();
+    vsSkeleton            *readSkeleton();
+    vsSkin                *readSkin();
+};
+
+#endif
@@ -21,6 +21,86 @@
 //------------------------------------------------------------------------
 
 #include "vsSkin.h++"
+#include "vsThreadPool.h++"
+
+// Describes one mesh in a batch of meshes being skinned together
+struct vsSkinBatchEntry
+{
+    vsSkeletonMeshGeometry    *mesh;
+    float                     *bonePalette;
+    float                     *itBonePalette;
+    int                       firstGroup;
+    int                       groupCount;
+};
+
+// Describes a whole batch of meshes for the thread pool
+struct vsSkinBatch
+{
+    vsSkinBatchEntry          *entries;
+    int                       entryCount;
+};
+
+// ------------------------------------------------------------------------
+// Static function
+// Thread pool task that skins a range of four-vertex groups from a batch
+// of meshes.  The groups of all meshes in the batch are numbered
+// consecutively, so a range may span several meshes.
+// ------------------------------------------------------------------------
+static void skinBatchTaskFunc(void *userData, int first, int last)
+{
+    vsSkinBatch *batch;
+    vsSkinBatchEntry *entry;
+    int low, high, mid;
+    int start, end;
+
+    // Get the batch
+    batch = (vsSkinBatch *)userData;
+
+    // Binary search for the mesh containing the first group
+    low = 0;
+    high = batch->entryCount - 1;
+    while (low < high)
+    {
+        mid = (low + high + 1) / 2;
+        if (batch->entries[mid].firstGroup <= first)
+            low = mid;
+        else
+            high = mid - 1;
+    }
+
+    // Skin each mesh that overlaps the range
+    while ((first < last) && (low < batch->entryCount))
+    {
+        // Figure out which part of this mesh is in the range
+        entry = &batch->entries[low];
+        start = first - entry->firstGroup;
+        end = last - entry->firstGroup;
+        if (end > entry->groupCount)
+            end = entry->groupCount;
+
+        // Skin those vertices
+        if (end > start)
+            entry->mesh->skinVertices(entry->bonePalette,
+                entry->itBonePalette, start * 4, end * 4);
+
+        // Move on to the next mesh
+        first = entry->firstGroup + entry->groupCount;
+        low++;
+    }
+}
+
+// ------------------------------------------------------------------------
+// Static function
+// Copies the top three rows of the given matrix into a skin palette entry
+// ------------------------------------------------------------------------
+static void flattenMatrix(atMatrix *matrix, float *paletteEntry)
+{
+    int row, col;
+
+    for (row = 0; row < 3; row++)
+        for (col = 0; col < 4; col++)
+            paletteEntry[row * 4 + col] = (float)((*matrix)[row][col]);
+}
 
 //------------------------------------------------------------------------
 // Constructor
@@ -71,6 +151,11 @@ vsSkin::vsSkin(vsComponent *newRoot, vsSkeleton *newSkeleton,
     skinMatrixList = NULL;
     skinITMatrixList = NULL;
 
+    // Initialize the flattened matrix palettes
+    skinPalette = NULL;
+    skinITPalette = NULL;
+    paletteBoneCount = 0;
+
     // Initialize the array that flags whether or not a given bone is in use
     boneUsed = NULL;
 
@@ -129,6 +214,11 @@ vsSkin::vsSkin(vsSkin *original)
     skinMatrixList = NULL;
     skinITMatrixList = NULL;
 
+    // Initialize the flattened matrix palettes
+    skinPalette = NULL;
+    skinITPalette = NULL;
+    paletteBoneCount = 0;
+
     // Initialize the array that flags whether or not a given bone is in use
     boneUsed = NULL;
 
@@ -166,6 +256,12 @@ vsSkin::~vsSkin()
     if (skinITMatrixList != NULL)
         delete skinITMatrixList;
 
+    // Delete the matrix palettes
+    if (skinPalette != NULL)
+        delete [] skinPalette;
+    if (skinITPalette != NULL)
+        delete [] skinITPalette;
+
     // Clean up the list of bones in use
     if (boneUsed != NULL)
         delete [] boneUsed;
@@ -255,6 +351,35 @@ void vsSkin::findUsedBones()
     }
 }
 
+// ------------------------------------------------------------------------
+// (Re)creates the flattened skin matrix palettes used for software
+// skinning, with every entry starting out as identity
+// ------------------------------------------------------------------------
+void vsSkin::createPalettes()
+{
+    atMatrix ident;
+    int i;
+
+    // Get rid of any old palettes
+    if (skinPalette != NULL)
+        delete [] skinPalette;
+    if (skinITPalette != NULL)
+        delete [] skinITPalette;
+
+    // Create a palette entry for each bone in the skeleton
+    paletteBoneCount = skeleton->getBoneCount();
+    skinPalette = new float[paletteBoneCount * VS_SKIN_PALETTE_STRIDE];
+    skinITPalette = new float[paletteBoneCount * VS_SKIN_PALETTE_STRIDE];
+
+    // Start all of the entries as identity
+    ident.setIdentity();
+    for (i = 0; i < paletteBoneCount; i++)
+    {
+        flattenMatrix(&ident, &skinPalette[i * VS_SKIN_PALETTE_STRIDE]);
+        flattenMatrix(&ident, &skinITPalette[i * VS_SKIN_PALETTE_STRIDE]);
+    }
+}
+
 // ------------------------------------------------------------------------
 // Returns the number of sub-meshes in this mesh
 // ------------------------------------------------------------------------
@@ -317,6 +442,9 @@ void vsSkin::setSkeleton(vsSkeleton *newSkeleton)
         skinITMatrixList->setEntry(i, newMatrix);
     }
 
+    // Create the flattened versions of the final matrix lists
+    createPalettes();
+
     // Finally, figure out which bones are used by this skin
     findUsedBones();
 }
@@ -330,6 +458,16 @@ vsSkeleton *vsSkin::getSkeleton()
     return skeleton;
 }
 
+// ------------------------------------------------------------------------
+// Return the list of bone space matrices (the inverse of each bone's
+// matrix in the skin's bind pose).  Bones that the skin doesn't have a
+// matrix for have no entry in the list.
+// ------------------------------------------------------------------------
+atArray *vsSkin::getBoneSpaceMatrixList()
+{
+    return boneSpaceMatrixList;
+}
+
 // ------------------------------------------------------------------------
 // Return whether or not this skin uses the given bone
 // ------------------------------------------------------------------------
@@ -372,6 +510,33 @@ atMatrix vsSkin::getSkinMatrix(int boneIndex)
     }
 }
 
+// ------------------------------------------------------------------------
+// Returns the flattened skin matrices, VS_SKIN_PALETTE_STRIDE floats per
+// bone (the top three rows of each matrix).  These are refreshed along
+// with the skin matrices by update().
+// ------------------------------------------------------------------------
+float *vsSkin::getSkinPalette()
+{
+    return skinPalette;
+}
+
+// ------------------------------------------------------------------------
+// Returns the flattened inverse transpose skin matrices, laid out the same
+// way as the skin palette
+// ------------------------------------------------------------------------
+float *vsSkin::getSkinITPalette()
+{
+    return skinITPalette;
+}
+
+// ------------------------------------------------------------------------
+// Returns the number of bones in the skin palettes
+// ------------------------------------------------------------------------
+int vsSkin::getPaletteBoneCount()
+{
+    return paletteBoneCount;
+}
+
 // ------------------------------------------------------------------------
 // Update the skin matrices by combining the skeleton's bone matrices with
 // the skin's bone space matrices.  Also create the inverse transpose
@@ -424,8 +589,79 @@ void vsSkin::update()
             // in the matrix)
             *finalITMatrix = finalMatrix->getInverseRigid();
             finalITMatrix->transpose();
+
+            // Copy both matrices into the software skinning palettes
+            flattenMatrix(finalMatrix,
+                &skinPalette[i * VS_SKIN_PALETTE_STRIDE]);
+            flattenMatrix(finalITMatrix,
+                &skinITPalette[i * VS_SKIN_PALETTE_STRIDE]);
+        }
+    }
+}
+
+// ------------------------------------------------------------------------
+// Static function
+// Skins all of the submeshes of the given skins in a single pass.  The
+// vertices of all the meshes are split into one list of work items and
+// spread across the default thread pool, so many small meshes are handled
+// as efficiently as one large one.
+// ------------------------------------------------------------------------
+void vsSkin::applySkinList(vsSkin **skins, int skinCount)
+{
+    vsSkinBatch batch;
+    vsSkinBatchEntry *entry;
+    vsSkeletonMeshGeometry *mesh;
+    int meshCount;
+    int totalGroups;
+    int i, j;
+
+    // Count the meshes involved
+    meshCount = 0;
+    for (i = 0; i < skinCount; i++)
+        meshCount += skins[i]->subMeshCount;
+    if (meshCount == 0)
+        return;
+
+    // Build the list of meshes to skin
+    batch.entries = new vsSkinBatchEntry[meshCount];
+    batch.entryCount = 0;
+    totalGroups = 0;
+    for (i = 0; i < skinCount; i++)
+    {
+        // Skip skins that don't have a skeleton yet
+        if (skins[i]->skinPalette == NULL)
+            continue;
+
+        for (j = 0; j < skins[i]->subMeshCount; j++)
+        {
+            // Get the mesh and make sure its skinning data is ready (this
+            // has to happen here, before we go multithreaded)
+            mesh = skins[i]->getSubMesh(j);
+            if (!mesh->prepareSkin(skins[i]->paletteBoneCount))
+                continue;
+
+            // Add the mesh's vertices to the list of work items
+            entry = &batch.entries[batch.entryCount];
+            entry->mesh = mesh;
+            entry->bonePalette = skins[i]->skinPalette;
+            entry->itBonePalette = skins[i]->skinITPalette;
+            entry->firstGroup = totalGroups;
+            entry->groupCount = (mesh->getSkinVertexCount() + 3) / 4;
+            totalGroups += entry->groupCount;
+            batch.entryCount++;
         }
     }
+
+    // Skin everything
+    vsThreadPool::getDefaultPool()->parallelFor(totalGroups,
+        VS_SKIN_GROUPS_PER_TASK, skinBatchTaskFunc, &batch);
+
+    // Let OSG know that the meshes have changed
+    for (i = 0; i < batch.entryCount; i++)
+        batch.entries[i].mesh->finishSkin();
+
+    // Clean up
+    delete [] batch.entries;
 }
 
 // ------------------------------------------------------------------------
@@ -434,14 +670,46 @@ void vsSkin::update()
 // ------------------------------------------------------------------------
 void vsSkin::applySkin()
 {
-    int index;
+    vsSkin *thisSkin;
 
-    // Cycle through the submeshes and apply the skin on them.
-    for (index = 0; index < subMeshCount; index++)
+    // Skin all the submeshes together
+    thisSkin = this;
+    applySkinList(&thisSkin, 1);
+}
+
+// ------------------------------------------------------------------------
+// Static function
+// Applies the skin transforms of every vsSkin in the given array in one
+// batch.  Use this instead of calling applySkin() on each skin when many
+// skinned characters are updated in the same frame.
+// ------------------------------------------------------------------------
+void vsSkin::applySkins(vsArray *skins)
+{
+    vsSkin **skinList;
+    int skinCount;
+    int i;
+
+    // Nothing to do without any skins
+    if ((skins == NULL) || (skins->getNumEntries() == 0))
+        return;
+
+    // Gather the skins into a plain list
+    skinList = new vsSkin *[skins->getNumEntries()];
+    skinCount = 0;
+    for (i = 0; i < (int)skins->getNumEntries(); i++)
     {
-        ((vsSkeletonMeshGeometry *) meshList->getEntry(index))->applySkin(
-            skinMatrixList, skinITMatrixList);
+        if (skins->getEntry(i) != NULL)
+        {
+            skinList[skinCount] = (vsSkin *)skins->getEntry(i);
+            skinCount++;
+        }
     }
+
+    // Skin them all at once
+    applySkinList(skinList, skinCount);
+
+    // Clean up
+    delete [] skinList;
 }
 
 // ------------------------------------------------------------------------
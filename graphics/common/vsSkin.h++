@@ -29,6 +29,10 @@
 #include "vsArray.h++"
 #include "atArray.h++"
 
+// Number of four-vertex groups handed to each thread pool task when
+// skinning (shared by vsSkin and vsSkeletonMeshGeometry)
+#define VS_SKIN_GROUPS_PER_TASK 256
+
 class VESS_SYM vsSkin : public vsUpdatable
 {
 private:
@@ -43,10 +47,17 @@ private:
     atArray                   *skinMatrixList;
     atArray                   *skinITMatrixList;
 
+    float                     *skinPalette;
+    float                     *skinITPalette;
+    int                       paletteBoneCount;
+
     bool                      *boneUsed;
 
     void                      findSubmeshes(vsNode *node);
     void                      findUsedBones();
+    void                      createPalettes();
+
+    static void               applySkinList(vsSkin **skins, int skinCount);
 
 public:
 
@@ -65,13 +76,18 @@ public:
 
     void                      setSkeleton(vsSkeleton *newSkeleton);
     vsSkeleton                *getSkeleton();
+    atArray                   *getBoneSpaceMatrixList();
 
     bool                      usesBone(int boneIndex);
     atMatrix                  getSkinMatrix(int boneIndex);
+    float                     *getSkinPalette();
+    float                     *getSkinITPalette();
+    int                       getPaletteBoneCount();
 
     virtual void              update();
 
     void                      applySkin();
+    static void               applySkins(vsArray *skins);
     void                      reset();
 };
 
@@ -0,0 +1,532 @@
+//------------------------------------------------------------------------
+//
+//    VIRTUAL ENVIRONMENT SOFTWARE SANDBOX (VESS)
+//
+//    Copyright (c) 2001, University of Central Florida
+//
+//       See the file LICENSE for license information
+//
+//    E-mail:  vess@ist.ucf.edu
+//    WWW:     http://vess.ist.ucf.edu/
+//
+//------------------------------------------------------------------------
+//
+//    VESS Module:  vsTriangleBVH.c++
+//
+//    Description:  Bounding volume hierarchy over the triangles of a
+//                  single geometry object, used to speed up sphere and
+//                  line segment intersection tests
+//
+//    Author(s):    agent
+//
+//------------------------------------------------------------------------
+
+#include "vsTriangleBVH.h++"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <float.h>
+
+// ------------------------------------------------------------------------
+// Constructor - Copies the given vertices (three floats each) and
+// triangles, and builds the hierarchy over the triangles.  The triangles
+// are reordered as the hierarchy is built, but each keeps its
+// triangleIndex and primitiveIndex so the caller can identify it.
+// ------------------------------------------------------------------------
+vsTriangleBVH::vsTriangleBVH(float *vertices, int numVertices,
+                             vsTriangleBVHTriangle *triangles,
+                             int numTriangles)
+{
+    // Copy the vertices
+    vertexCount = numVertices;
+    vertexList = new float[vertexCount * 3 + 1];
+    memcpy(vertexList, vertices, sizeof(float) * vertexCount * 3);
+
+    // Copy the triangles
+    triangleCount = numTriangles;
+    triangleList = new vsTriangleBVHTriangle[triangleCount + 1];
+    memcpy(triangleList, triangles,
+        sizeof(vsTriangleBVHTriangle) * triangleCount);
+
+    // A binary tree with one or more triangles per leaf never needs more
+    // than twice as many nodes as triangles
+    nodeList = new vsTriangleBVHNode[triangleCount * 2 + 1];
+    nodeCount = 0;
+
+    // Build the hierarchy (if there's anything to build it over)
+    if (triangleCount > 0)
+        buildNode(0, triangleCount, 0);
+}
+
+// ------------------------------------------------------------------------
+// Destructor
+// ------------------------------------------------------------------------
+vsTriangleBVH::~vsTriangleBVH()
+{
+    delete [] vertexList;
+    delete [] triangleList;
+    delete [] nodeList;
+}
+
+// ------------------------------------------------------------------------
+// Gets a string representation of this object's class name
+// ------------------------------------------------------------------------
+const char *vsTriangleBVH::getClassName()
+{
+    return "vsTriangleBVH";
+}
+
+// ------------------------------------------------------------------------
+// Private function
+// Computes the bounding box of the given triangle
+// ------------------------------------------------------------------------
+void vsTriangleBVH::getTriangleBounds(int triangle, float *boxMin,
+                                      float *boxMax)
+{
+    float *vertex;
+    int i, axis;
+
+    // Start with the first vertex, then expand by the other two
+    vertex = &vertexList[triangleList[triangle].vertexIndex[0] * 3];
+    for (axis = 0; axis < 3; axis++)
+        boxMin[axis] = boxMax[axis] = vertex[axis];
+    for (i = 1; i < 3; i++)
+    {
+        vertex = &vertexList[triangleList[triangle].vertexIndex[i] * 3];
+        for (axis = 0; axis < 3; axis++)
+        {
+            if (vertex[axis] < boxMin[axis])
+                boxMin[axis] = vertex[axis];
+            if (vertex[axis] > boxMax[axis])
+                boxMax[axis] = vertex[axis];
+        }
+    }
+}
+
+// ------------------------------------------------------------------------
+// Private function
+// Computes the centroid of the given triangle
+// ------------------------------------------------------------------------
+void vsTriangleBVH::getTriangleCentroid(int triangle, float *centroid)
+{
+    float *a, *b, *c;
+    int axis;
+
+    // Average the three vertices
+    a = &vertexList[triangleList[triangle].vertexIndex[0] * 3];
+    b = &vertexList[triangleList[triangle].vertexIndex[1] * 3];
+    c = &vertexList[triangleList[triangle].vertexIndex[2] * 3];
+    for (axis = 0; axis < 3; axis++)
+        centroid[axis] = (a[axis] + b[axis] + c[axis]) / 3.0f;
+}
+
+// ------------------------------------------------------------------------
+// Private function
+// Recursively builds the node covering the given range of triangles.
+// Nodes are stored depth-first, so a node's left child always directly
+// follows it in the node list.  Returns the index of the new node.
+// ------------------------------------------------------------------------
+int vsTriangleBVH::buildNode(int firstTriangle, int count, int depth)
+{
+    vsTriangleBVHNode *node;
+    vsTriangleBVHTriangle tempTriangle;
+    float triMin[3], triMax[3];
+    float centroidMin[3], centroidMax[3];
+    float centroid[3];
+    float extent, splitValue;
+    int nodeIndex;
+    int axis, splitAxis;
+    int i, mid;
+    int rightChild;
+
+    // Claim the next node
+    nodeIndex = nodeCount;
+    nodeCount++;
+    node = &nodeList[nodeIndex];
+
+    // Compute the bounds of the triangles and their centroids
+    for (axis = 0; axis < 3; axis++)
+    {
+        node->boxMin[axis] = centroidMin[axis] = FLT_MAX;
+        node->boxMax[axis] = centroidMax[axis] = -FLT_MAX;
+    }
+    for (i = firstTriangle; i < firstTriangle + count; i++)
+    {
+        getTriangleBounds(i, triMin, triMax);
+        getTriangleCentroid(i, centroid);
+        for (axis = 0; axis < 3; axis++)
+        {
+            if (triMin[axis] < node->boxMin[axis])
+                node->boxMin[axis] = triMin[axis];
+            if (triMax[axis] > node->boxMax[axis])
+                node->boxMax[axis] = triMax[axis];
+            if (centroid[axis] < centroidMin[axis])
+                centroidMin[axis] = centroid[axis];
+            if (centroid[axis] > centroidMax[axis])
+                centroidMax[axis] = centroid[axis];
+        }
+    }
+
+    // Make this a leaf if there are few enough triangles, or if we've
+    // gone as deep as we can
+    if ((count <= VS_BVH_MAX_LEAF_SIZE) || (depth >= VS_BVH_MAX_DEPTH - 1))
+    {
+        node->firstTriangle = firstTriangle;
+        node->triangleCount = count;
+        node->rightChild = -1;
+        return nodeIndex;
+    }
+
+    // Split along the axis where the centroids are most spread out
+    splitAxis = 0;
+    extent = centroidMax[0] - centroidMin[0];
+    for (axis = 1; axis < 3; axis++)
+    {
+        if (centroidMax[axis] - centroidMin[axis] > extent)
+        {
+            splitAxis = axis;
+            extent = centroidMax[axis] - centroidMin[axis];
+        }
+    }
+
+    // Partition the triangles about the middle of the centroid bounds
+    splitValue = (centroidMin[splitAxis] + centroidMax[splitAxis]) * 0.5f;
+    mid = firstTriangle;
+    for (i = firstTriangle; i < firstTriangle + count; i++)
+    {
+        getTriangleCentroid(i, centroid);
+        if (centroid[splitAxis] < splitValue)
+        {
+            tempTriangle = triangleList[i];
+            triangleList[i] = triangleList[mid];
+            triangleList[mid] = tempTriangle;
+            mid++;
+        }
+    }
+
+    // If all of the centroids landed on one side (they're all in the same
+    // place), just split the list in half
+    if ((mid == firstTriangle) || (mid == firstTriangle + count))
+        mid = firstTriangle + count / 2;
+
+    // This is an interior node
+    node->firstTriangle = firstTriangle;
+    node->triangleCount = 0;
+
+    // Build the children (the left child is always the next node, note
+    // that the node list doesn't move, so our node pointer stays valid)
+    buildNode(firstTriangle, mid - firstTriangle, depth + 1);
+    rightChild = buildNode(mid, firstTriangle + count - mid, depth + 1);
+    node->rightChild = rightChild;
+
+    return nodeIndex;
+}
+
+// ------------------------------------------------------------------------
+// Returns the number of triangles in the hierarchy
+// ------------------------------------------------------------------------
+int vsTriangleBVH::getTriangleCount()
+{
+    return triangleCount;
+}
+
+// ------------------------------------------------------------------------
+// Returns the triangle at the given position in the hierarchy (this is
+// the value returned by the find methods, not the triangle's original
+// index, which is stored in the triangle itself)
+// ------------------------------------------------------------------------
+vsTriangleBVHTriangle *vsTriangleBVH::getTriangle(int index)
+{
+    // Make sure the index is valid
+    if ((index < 0) || (index >= triangleCount))
+    {
+        printf("vsTriangleBVH::getTriangle: Index out of bounds\n");
+        return NULL;
+    }
+
+    return &triangleList[index];
+}
+
+// ------------------------------------------------------------------------
+// Returns the vertex with the given index
+// ------------------------------------------------------------------------
+atVector vsTriangleBVH::getVertex(int index)
+{
+    // Make sure the index is valid
+    if ((index < 0) || (index >= vertexCount))
+    {
+        printf("vsTriangleBVH::getVertex: Index out of bounds\n");
+        return atVector(0.0, 0.0, 0.0);
+    }
+
+    return atVector(vertexList[index * 3], vertexList[index * 3 + 1],
+        vertexList[index * 3 + 2]);
+}
+
+// ------------------------------------------------------------------------
+// Finds all triangles whose bounding boxes touch the given sphere, and
+// stores their indices in the result list, which is grown with realloc()
+// as needed.  Returns the number of triangles found.  This method may be
+// called from several threads at once.
+// ------------------------------------------------------------------------
+int vsTriangleBVH::findSphereTriangles(atVector center, double radius,
+                                       int **resultList, int *resultListSize)
+{
+    int stack[VS_BVH_MAX_DEPTH + 1];
+    int stackSize;
+    vsTriangleBVHNode *node;
+    double sphere[3];
+    double sqrRadius;
+    double sqrDist;
+    float triMin[3], triMax[3];
+    int resultCount;
+    int nodeIndex;
+    int axis, i;
+
+    // Nothing to find in an empty hierarchy
+    if (triangleCount == 0)
+        return 0;
+
+    // Get the sphere's center and squared radius
+    for (axis = 0; axis < 3; axis++)
+        sphere[axis] = center[axis];
+    sqrRadius = radius * radius;
+
+    // Start at the root
+    resultCount = 0;
+    stack[0] = 0;
+    stackSize = 1;
+    while (stackSize > 0)
+    {
+        // Get the next node
+        stackSize--;
+        nodeIndex = stack[stackSize];
+        node = &nodeList[nodeIndex];
+
+        // Compute the squared distance from the sphere's center to the box
+        sqrDist = 0.0;
+        for (axis = 0; axis < 3; axis++)
+        {
+            if (sphere[axis] < node->boxMin[axis])
+                sqrDist += (sphere[axis] - node->boxMin[axis]) *
+                    (sphere[axis] - node->boxMin[axis]);
+            else if (sphere[axis] > node->boxMax[axis])
+                sqrDist += (sphere[axis] - node->boxMax[axis]) *
+                    (sphere[axis] - node->boxMax[axis]);
+        }
+
+        // Skip this node if the sphere doesn't touch it
+        if (sqrDist > sqrRadius)
+            continue;
+
+        if (node->rightChild < 0)
+        {
+            // Leaf node, check the individual triangle boxes
+            for (i = node->firstTriangle;
+                 i < node->firstTriangle + node->triangleCount; i++)
+            {
+                // Compute the squared distance to the triangle's box
+                getTriangleBounds(i, triMin, triMax);
+                sqrDist = 0.0;
+                for (axis = 0; axis < 3; axis++)
+                {
+                    if (sphere[axis] < triMin[axis])
+                        sqrDist += (sphere[axis] - triMin[axis]) *
+                            (sphere[axis] - triMin[axis]);
+                    else if (sphere[axis] > triMax[axis])
+                        sqrDist += (sphere[axis] - triMax[axis]) *
+                            (sphere[axis] - triMax[axis]);
+                }
+
+                // Add the triangle to the results if it's close enough
+                if (sqrDist <= sqrRadius)
+                {
+                    // Grow the result list if necessary
+                    if (resultCount >= *resultListSize)
+                    {
+                        *resultListSize = (*resultListSize * 2) + 16;
+                        *resultList = (int *)realloc(*resultList,
+                            sizeof(int) * (*resultListSize));
+                    }
+
+                    (*resultList)[resultCount] = i;
+                    resultCount++;
+                }
+            }
+        }
+        else
+        {
+            // Interior node, visit both children
+            stack[stackSize++] = node->rightChild;
+            stack[stackSize++] = nodeIndex + 1;
+        }
+    }
+
+    return resultCount;
+}
+
+// ------------------------------------------------------------------------
+// Finds every triangle crossed by the line segment from start to end (in
+// either direction), and stores each triangle's index, the ratio along
+// the segment where the crossing occurs, and the weights of the
+// triangle's vertices at the crossing point in the hit list,
+// which is grown with realloc() as needed.  Returns the number of hits.
+// The hits are not sorted.  This method may be called from several
+// threads at once.
+// ------------------------------------------------------------------------
+int vsTriangleBVH::findSegmentHits(atVector start, atVector end,
+                                   vsTriangleBVHHit **hitList,
+                                   int *hitListSize)
+{
+    int stack[VS_BVH_MAX_DEPTH + 1];
+    int stackSize;
+    vsTriangleBVHNode *node;
+    double origin[3], direction[3], invDirection[3];
+    double tNear, tFar, t0, t1, temp;
+    double edge1[3], edge2[3], pVec[3], tVec[3], qVec[3];
+    double det, invDet, u, v, ratio;
+    float *a, *b, *c;
+    int hitCount;
+    int nodeIndex;
+    int axis, i;
+
+    // Nothing to hit in an empty hierarchy
+    if (triangleCount == 0)
+        return 0;
+
+    // Get the segment as an origin and direction (the direction covers the
+    // whole segment, so the parameter runs from 0 to 1)
+    for (axis = 0; axis < 3; axis++)
+    {
+        origin[axis] = start[axis];
+        direction[axis] = end[axis] - start[axis];
+        if (direction[axis] != 0.0)
+            invDirection[axis] = 1.0 / direction[axis];
+        else
+            invDirection[axis] = DBL_MAX;
+    }
+
+    // Start at the root
+    hitCount = 0;
+    stack[0] = 0;
+    stackSize = 1;
+    while (stackSize > 0)
+    {
+        // Get the next node
+        stackSize--;
+        nodeIndex = stack[stackSize];
+        node = &nodeList[nodeIndex];
+
+        // Clip the segment against the node's box (slab test)
+        tNear = 0.0;
+        tFar = 1.0;
+        for (axis = 0; axis < 3; axis++)
+        {
+            if (direction[axis] == 0.0)
+            {
+                // Parallel to this slab, so we must start inside it
+                if ((origin[axis] < node->boxMin[axis]) ||
+                    (origin[axis] > node->boxMax[axis]))
+                    tNear = 2.0;
+            }
+            else
+            {
+                // Find where we cross the two planes of this slab
+                t0 = (node->boxMin[axis] - origin[axis]) * invDirection[axis];
+                t1 = (node->boxMax[axis] - origin[axis]) * invDirection[axis];
+                if (t0 > t1)
+                {
+                    temp = t0;
+                    t0 = t1;
+                    t1 = temp;
+                }
+                if (t0 > tNear)
+                    tNear = t0;
+                if (t1 < tFar)
+                    tFar = t1;
+            }
+        }
+
+        // Skip this node if the segment misses it
+        if (tNear > tFar)
+            continue;
+
+        if (node->rightChild < 0)
+        {
+            // Leaf node, test the segment against each triangle
+            for (i = node->firstTriangle;
+                 i < node->firstTriangle + node->triangleCount; i++)
+            {
+                // Get the triangle's vertices
+                a = &vertexList[triangleList[i].vertexIndex[0] * 3];
+                b = &vertexList[triangleList[i].vertexIndex[1] * 3];
+                c = &vertexList[triangleList[i].vertexIndex[2] * 3];
+
+                // Compute the triangle's edges, and the determinant
+                for (axis = 0; axis < 3; axis++)
+                {
+                    edge1[axis] = b[axis] - a[axis];
+                    edge2[axis] = c[axis] - a[axis];
+                    tVec[axis] = origin[axis] - a[axis];
+                }
+                pVec[0] = direction[1] * edge2[2] - direction[2] * edge2[1];
+                pVec[1] = direction[2] * edge2[0] - direction[0] * edge2[2];
+                pVec[2] = direction[0] * edge2[1] - direction[1] * edge2[0];
+                det = edge1[0] * pVec[0] + edge1[1] * pVec[1] +
+                    edge1[2] * pVec[2];
+
+                // Skip the triangle if the segment is parallel to it (or
+                // the triangle is degenerate)
+                if (fabs(det) < 1.0e-12)
+                    continue;
+                invDet = 1.0 / det;
+
+                // Compute and check the first barycentric coordinate
+                u = (tVec[0] * pVec[0] + tVec[1] * pVec[1] +
+                    tVec[2] * pVec[2]) * invDet;
+                if ((u < 0.0) || (u > 1.0))
+                    continue;
+
+                // Compute and check the second barycentric coordinate
+                qVec[0] = tVec[1] * edge1[2] - tVec[2] * edge1[1];
+                qVec[1] = tVec[2] * edge1[0] - tVec[0] * edge1[2];
+                qVec[2] = tVec[0] * edge1[1] - tVec[1] * edge1[0];
+                v = (direction[0] * qVec[0] + direction[1] * qVec[1] +
+                    direction[2] * qVec[2]) * invDet;
+                if ((v < 0.0) || (u + v > 1.0))
+                    continue;
+
+                // Compute where along the segment we hit the triangle
+                ratio = (edge2[0] * qVec[0] + edge2[1] * qVec[1] +
+                    edge2[2] * qVec[2]) * invDet;
+                if ((ratio < 0.0) || (ratio > 1.0))
+                    continue;
+
+                // Grow the hit list if necessary
+                if (hitCount >= *hitListSize)
+                {
+                    *hitListSize = (*hitListSize * 2) + 16;
+                    *hitList = (vsTriangleBVHHit *)realloc(*hitList,
+                        sizeof(vsTriangleBVHHit) * (*hitListSize));
+                }
+
+                // Record the hit
+                (*hitList)[hitCount].triangle = i;
+                (*hitList)[hitCount].ratio = ratio;
+                (*hitList)[hitCount].vertexWeight[0] = 1.0 - u - v;
+                (*hitList)[hitCount].vertexWeight[1] = u;
+                (*hitList)[hitCount].vertexWeight[2] = v;
+                hitCount++;
+            }
+        }
+        else
+        {
+            // Interior node, visit both children
+            stack[stackSize++] = node->rightChild;
+            stack[stackSize++] = nodeIndex + 1;
+        }
+    }
+
+    return hitCount;
+}
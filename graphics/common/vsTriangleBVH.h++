@@ -0,0 +1,102 @@
+//------------------------------------------------------------------------
+//
+//    VIRTUAL ENVIRONMENT SOFTWARE SANDBOX (VESS)
+//
+//    Copyright (c) 2001, University of Central Florida
+//
+//       See the file LICENSE for license information
+//
+//    E-mail:  vess@ist.ucf.edu
+//    WWW:     http://vess.ist.ucf.edu/
+//
+//------------------------------------------------------------------------
+//
+//    VESS Module:  vsTriangleBVH.h++
+//
+//    Description:  Bounding volume hierarchy over the triangles of a
+//                  single geometry object, used to speed up sphere and
+//                  line segment intersection tests
+//
+//    Author(s):    agent
+//
+//------------------------------------------------------------------------
+
+#ifndef VS_TRIANGLE_BVH_HPP
+#define VS_TRIANGLE_BVH_HPP
+
+#include "vsObject.h++"
+#include "atVector.h++"
+
+// Maximum number of triangles stored in a leaf of the hierarchy
+#define VS_BVH_MAX_LEAF_SIZE 4
+
+// Maximum depth of the hierarchy (also sizes the traversal stacks)
+#define VS_BVH_MAX_DEPTH     64
+
+struct VESS_SYM vsTriangleBVHNode
+{
+    float    boxMin[3];
+    float    boxMax[3];
+    int      firstTriangle;
+    int      triangleCount;
+    int      rightChild;
+};
+
+struct VESS_SYM vsTriangleBVHTriangle
+{
+    int      vertexIndex[3];
+    int      primitiveIndex;
+    int      triangleIndex;
+    bool     windingSwapped;
+};
+
+struct VESS_SYM vsTriangleBVHHit
+{
+    int      triangle;
+    double   ratio;
+    double   vertexWeight[3];
+};
+
+class VESS_SYM vsTriangleBVH : public vsObject
+{
+private:
+
+    float                    *vertexList;
+    int                      vertexCount;
+
+    vsTriangleBVHTriangle    *triangleList;
+    int                      triangleCount;
+
+    vsTriangleBVHNode        *nodeList;
+    int                      nodeCount;
+
+    void                     getTriangleBounds(int triangle, float *boxMin,
+                                               float *boxMax);
+    void                     getTriangleCentroid(int triangle,
+                                                 float *centroid);
+    int                      buildNode(int firstTriangle, int count,
+                                       int depth);
+
+public:
+
+                             vsTriangleBVH(float *vertices, int numVertices,
+                                           vsTriangleBVHTriangle *triangles,
+                                           int numTriangles);
+    virtual                  ~vsTriangleBVH();
+
+    virtual const char       *getClassName();
+
+    int                      getTriangleCount();
+    vsTriangleBVHTriangle    *getTriangle(int index);
+    atVector                 getVertex(int index);
+
+    int                      findSphereTriangles(atVector center,
+                                                 double radius,
+                                                 int **resultList,
+                                                 int *resultListSize);
+    int                      findSegmentHits(atVector start, atVector end,
+                                             vsTriangleBVHHit **hitList,
+                                             int *hitListSize);
+};
+
+#endif
@@ -0,0 +1,404 @@
+//------------------------------------------------------------------------
+//
+//    VIRTUAL ENVIRONMENT SOFTWARE SANDBOX (VESS)
+//
+//    Copyright (c) 2001, University of Central Florida
+//
+//       See the file LICENSE for license information
+//
+//    E-mail:  vess@ist.ucf.edu
+//    WWW:     http://vess.ist.ucf.edu/
+//
+//------------------------------------------------------------------------
+//
+//    VESS Module:  vsVertexCacheOptimizer.c++
+//
+//    Description:  Utility functions that reorder indexed geometry to
+//                  make better use of the graphics hardware's
+//                  post-transform vertex cache and of memory when the
+//                  vertices are fetched
+//
+//    Author(s):    agent
+//
+//------------------------------------------------------------------------
+
+#include "vsVertexCacheOptimizer.h++"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Scoring constants for the triangle ordering.  These are the values
+// suggested by Tom Forsyth in "Linear-Speed Vertex Cache Optimisation"
+#define VS_VCACHE_DECAY_POWER      1.5f
+#define VS_VCACHE_LAST_TRI_SCORE   0.75f
+#define VS_VCACHE_VALENCE_SCALE    2.0f
+#define VS_VCACHE_VALENCE_POWER    0.5f
+
+// ------------------------------------------------------------------------
+// Static function
+// Computes how desirable it is to use the given vertex next, based on
+// where it is in the simulated cache and how many triangles still need
+// it.  Vertices that are recently used, and vertices with few triangles
+// left, score higher.
+// ------------------------------------------------------------------------
+static float computeVertexScore(int cachePosition, int remainingTriangles)
+{
+    float score;
+
+    // A vertex that isn't needed by any more triangles isn't worth anything
+    if (remainingTriangles <= 0)
+        return -1.0f;
+
+    // Score the cache position
+    score = 0.0f;
+    if (cachePosition >= 0)
+    {
+        // The vertices of the last triangle get a fixed score (so the order
+        // they were used in doesn't matter), the rest drop off with their
+        // age in the cache
+        if (cachePosition < 3)
+            score = VS_VCACHE_LAST_TRI_SCORE;
+        else
+        {
+            score = 1.0f - (float)(cachePosition - 3) /
+                (float)(VS_VCACHE_SIZE - 3);
+            score = powf(score, VS_VCACHE_DECAY_POWER);
+        }
+    }
+
+    // Boost vertices that have only a few triangles left, so we don't leave
+    // lone triangles behind to pick up later
+    score += VS_VCACHE_VALENCE_SCALE *
+        powf((float)remainingTriangles, -VS_VCACHE_VALENCE_POWER);
+
+    return score;
+}
+
+// ------------------------------------------------------------------------
+// Static function
+// Reorders the triangles of an indexed triangle list so that vertices
+// are reused while they're still in the post-transform vertex cache.
+// This is a greedy, linear-time algorithm; at each step, the triangle
+// with the best score among those touching the cached vertices is drawn
+// next.  The index list is modified in place.  Returns false if the
+// index list can't be optimized (the list is left untouched in that case).
+// ------------------------------------------------------------------------
+bool vsVertexCacheOptimizer::optimizeTriangleOrder(u_int *indexList,
+                                                   int indexCount,
+                                                   int vertexCount)
+{
+    int triangleCount;
+    int *vertexTriStart;
+    int *vertexTriCount;
+    int *vertexTriList;
+    int *vertexCachePos;
+    float *vertexScore;
+    float *triangleScore;
+    bool *triangleAdded;
+    u_int *newIndexList;
+    int cache[VS_VCACHE_SIZE + 3];
+    int newCache[VS_VCACHE_SIZE + 3];
+    int cacheCount, newCacheCount;
+    int bestTriangle;
+    float bestScore;
+    int nextTriangle;
+    int outputCount;
+    int vertex, triangle;
+    int *triList;
+    int i, j, k;
+
+    // We need at least two triangles to make any difference
+    triangleCount = indexCount / 3;
+    if ((indexList == NULL) || (triangleCount < 2) || (vertexCount <= 0))
+        return false;
+
+    // Make sure all of the indices are valid
+    for (i = 0; i < triangleCount * 3; i++)
+    {
+        if (indexList[i] >= (u_int)vertexCount)
+        {
+            printf("vsVertexCacheOptimizer::optimizeTriangleOrder:  Index "
+                "out of range\n");
+            return false;
+        }
+    }
+
+    // Count the triangles that use each vertex
+    vertexTriCount = (int *)calloc(vertexCount, sizeof(int));
+    for (i = 0; i < triangleCount * 3; i++)
+        vertexTriCount[indexList[i]]++;
+
+    // Lay out the list of triangles for each vertex in one big array
+    vertexTriStart = (int *)malloc(sizeof(int) * vertexCount);
+    vertexTriStart[0] = 0;
+    for (i = 1; i < vertexCount; i++)
+        vertexTriStart[i] = vertexTriStart[i-1] + vertexTriCount[i-1];
+
+    // Fill in the triangle lists (use the counts as cursors while we do, so
+    // they end up back where they started)
+    vertexTriList = (int *)malloc(sizeof(int) * triangleCount * 3);
+    memset(vertexTriCount, 0, sizeof(int) * vertexCount);
+    for (i = 0; i < triangleCount * 3; i++)
+    {
+        vertex = indexList[i];
+        vertexTriList[vertexTriStart[vertex] + vertexTriCount[vertex]] = i / 3;
+        vertexTriCount[vertex]++;
+    }
+
+    // Nothing is in the cache yet, so score all of the vertices on their
+    // valence alone
+    vertexCachePos = (int *)malloc(sizeof(int) * vertexCount);
+    vertexScore = (float *)malloc(sizeof(float) * vertexCount);
+    for (i = 0; i < vertexCount; i++)
+    {
+        vertexCachePos[i] = -1;
+        vertexScore[i] = computeVertexScore(-1, vertexTriCount[i]);
+    }
+
+    // Score all the triangles, and find the best one to start with
+    triangleScore = (float *)malloc(sizeof(float) * triangleCount);
+    triangleAdded = (bool *)calloc(triangleCount, sizeof(bool));
+    bestTriangle = -1;
+    bestScore = -1.0f;
+    for (i = 0; i < triangleCount; i++)
+    {
+        triangleScore[i] = vertexScore[indexList[i*3]] +
+            vertexScore[indexList[i*3 + 1]] + vertexScore[indexList[i*3 + 2]];
+        if (triangleScore[i] > bestScore)
+        {
+            bestScore = triangleScore[i];
+            bestTriangle = i;
+        }
+    }
+
+    // Add triangles to the new list one at a time
+    newIndexList = (u_int *)malloc(sizeof(u_int) * triangleCount * 3);
+    cacheCount = 0;
+    nextTriangle = 0;
+    for (outputCount = 0; outputCount < triangleCount; outputCount++)
+    {
+        // If none of the triangles touching the cache are left, just take
+        // the next triangle that hasn't been added yet
+        if (bestTriangle < 0)
+        {
+            while (triangleAdded[nextTriangle])
+                nextTriangle++;
+            bestTriangle = nextTriangle;
+        }
+
+        // Add the triangle to the new list
+        triangle = bestTriangle;
+        triangleAdded[triangle] = true;
+        for (i = 0; i < 3; i++)
+            newIndexList[outputCount*3 + i] = indexList[triangle*3 + i];
+
+        // Remove the triangle from the triangle lists of its vertices (the
+        // lists are unordered, so swap the last triangle into its place)
+        for (i = 0; i < 3; i++)
+        {
+            vertex = indexList[triangle*3 + i];
+            triList = &vertexTriList[vertexTriStart[vertex]];
+            for (j = 0; j < vertexTriCount[vertex]; j++)
+            {
+                if (triList[j] == triangle)
+                {
+                    triList[j] = triList[vertexTriCount[vertex] - 1];
+                    vertexTriCount[vertex]--;
+                    break;
+                }
+            }
+        }
+
+        // Move the triangle's vertices to the front of the cache, followed
+        // by the rest of the cache in its original order
+        newCacheCount = 0;
+        for (i = 0; i < 3; i++)
+        {
+            vertex = indexList[triangle*3 + i];
+            for (j = 0; j < newCacheCount; j++)
+                if (newCache[j] == vertex)
+                    break;
+            if (j == newCacheCount)
+                newCache[newCacheCount++] = vertex;
+        }
+        for (i = 0; i < cacheCount; i++)
+        {
+            vertex = cache[i];
+            for (j = 0; j < 3; j++)
+                if (indexList[triangle*3 + j] == (u_int)vertex)
+                    break;
+            if (j == 3)
+                newCache[newCacheCount++] = vertex;
+        }
+
+        // Anything past the end of the cache falls out of it
+        for (i = VS_VCACHE_SIZE; i < newCacheCount; i++)
+            vertexCachePos[newCache[i]] = -1;
+
+        // Update the cache
+        if (newCacheCount > VS_VCACHE_SIZE)
+            cacheCount = VS_VCACHE_SIZE;
+        else
+            cacheCount = newCacheCount;
+        for (i = 0; i < cacheCount; i++)
+        {
+            cache[i] = newCache[i];
+            vertexCachePos[cache[i]] = i;
+        }
+
+        // Rescore all of the vertices whose cache position changed
+        for (i = 0; i < newCacheCount; i++)
+        {
+            vertex = newCache[i];
+            vertexScore[vertex] = computeVertexScore(vertexCachePos[vertex],
+                vertexTriCount[vertex]);
+        }
+
+        // Rescore the triangles that use those vertices, and pick the best
+        // one to add next
+        bestTriangle = -1;
+        bestScore = -1.0f;
+        for (i = 0; i < newCacheCount; i++)
+        {
+            vertex = newCache[i];
+            triList = &vertexTriList[vertexTriStart[vertex]];
+            for (j = 0; j < vertexTriCount[vertex]; j++)
+            {
+                // Total up the scores of this triangle's vertices
+                k = triList[j];
+                triangleScore[k] = vertexScore[indexList[k*3]] +
+                    vertexScore[indexList[k*3 + 1]] +
+                    vertexScore[indexList[k*3 + 2]];
+
+                // See if it's the best so far
+                if (triangleScore[k] > bestScore)
+                {
+                    bestScore = triangleScore[k];
+                    bestTriangle = k;
+                }
+            }
+        }
+    }
+
+    // Copy the new triangle order to the index list
+    memcpy(indexList, newIndexList, sizeof(u_int) * triangleCount * 3);
+
+    // Clean up
+    free(newIndexList);
+    free(triangleAdded);
+    free(triangleScore);
+    free(vertexScore);
+    free(vertexCachePos);
+    free(vertexTriList);
+    free(vertexTriStart);
+    free(vertexTriCount);
+
+    return true;
+}
+
+// ------------------------------------------------------------------------
+// Static function
+// Renumbers the vertices used by the given index list in the order in
+// which they're first used, so that the vertex data will be read in
+// order as the geometry is drawn.  The index list is modified in place.
+// The vertexRemap array (which must hold vertexCount entries) receives
+// the new index of each old vertex, or -1 if the vertex isn't used at
+// all.  Returns the number of vertices that are used.
+// ------------------------------------------------------------------------
+int vsVertexCacheOptimizer::optimizeVertexOrder(u_int *indexList,
+                                                int indexCount,
+                                                int vertexCount,
+                                                int *vertexRemap)
+{
+    int newVertexCount;
+    u_int vertex;
+    int i;
+
+    // None of the vertices have been renumbered yet
+    for (i = 0; i < vertexCount; i++)
+        vertexRemap[i] = -1;
+
+    // Number the vertices as we find them in the index list, and change
+    // the index list to match
+    newVertexCount = 0;
+    for (i = 0; i < indexCount; i++)
+    {
+        // Make sure the index is valid
+        vertex = indexList[i];
+        if (vertex >= (u_int)vertexCount)
+        {
+            printf("vsVertexCacheOptimizer::optimizeVertexOrder:  Index out "
+                "of range\n");
+            continue;
+        }
+
+        // Give the vertex a new number if it doesn't have one already
+        if (vertexRemap[vertex] < 0)
+        {
+            vertexRemap[vertex] = newVertexCount;
+            newVertexCount++;
+        }
+
+        // Renumber the index
+        indexList[i] = vertexRemap[vertex];
+    }
+
+    // Return the number of vertices that are actually used
+    return newVertexCount;
+}
+
+// ------------------------------------------------------------------------
+// Static function
+// Simulates drawing the given list of indexed triangles through a FIFO
+// post-transform cache of the given size, and returns the average number
+// of cache misses (vertex shader runs) per triangle.  This is 3.0 with no
+// vertex reuse at all, and approaches 0.5 for a large, well-ordered
+// regular mesh.
+// ------------------------------------------------------------------------
+double vsVertexCacheOptimizer::getCacheMissRatio(u_int *indexList,
+                                                 int indexCount,
+                                                 int cacheSize)
+{
+    int triangleCount;
+    u_int vertexCount;
+    int *vertexEntryTime;
+    int missCount;
+    int i;
+
+    // Make sure we have some triangles and a cache to work with
+    triangleCount = indexCount / 3;
+    if ((indexList == NULL) || (triangleCount < 1))
+        return 0.0;
+    if (cacheSize < 1)
+        return 3.0;
+
+    // Find out how many vertices there are
+    vertexCount = 0;
+    for (i = 0; i < triangleCount * 3; i++)
+        if (indexList[i] >= vertexCount)
+            vertexCount = indexList[i] + 1;
+
+    // Keep track of when each vertex entered the cache (a vertex is still
+    // in the FIFO if fewer than cacheSize misses have happened since then)
+    vertexEntryTime = (int *)malloc(sizeof(int) * vertexCount);
+    for (i = 0; i < (int)vertexCount; i++)
+        vertexEntryTime[i] = -cacheSize - 1;
+
+    // Run the indices through the cache
+    missCount = 0;
+    for (i = 0; i < triangleCount * 3; i++)
+    {
+        if ((missCount - vertexEntryTime[indexList[i]]) > cacheSize)
+        {
+            vertexEntryTime[indexList[i]] = missCount;
+            missCount++;
+        }
+    }
+
+    // Clean up
+    free(vertexEntryTime);
+
+    // Return the average misses per triangle
+    return (double)missCount / (double)triangleCount;
+}
@@ -0,0 +1,53 @@
+//------------------------------------------------------------------------
+//
+//    VIRTUAL ENVIRONMENT SOFTWARE SANDBOX (VESS)
+//
+//    Copyright (c) 2001, University of Central Florida
+//
+//       See the file LICENSE for license information
+//
+//    E-mail:  vess@ist.ucf.edu
+//    WWW:     http://vess.ist.ucf.edu/
+//
+//------------------------------------------------------------------------
+//
+//    VESS Module:  vsVertexCacheOptimizer.h++
+//
+//    Description:  Utility functions that reorder indexed geometry to
+//                  make better use of the graphics hardware's
+//                  post-transform vertex cache and of memory when the
+//                  vertices are fetched
+//
+//    Author(s):    agent
+//
+//------------------------------------------------------------------------
+
+#ifndef VS_VERTEX_CACHE_OPTIMIZER_HPP
+#define VS_VERTEX_CACHE_OPTIMIZER_HPP
+
+#include "vsGlobals.h++"
+#include <sys/types.h>
+
+// Size of the vertex cache that triangles are ordered for.  This doesn't
+// have to match the hardware exactly; the ordering works well for any
+// cache at least this big.
+#define VS_VCACHE_SIZE             32
+
+// Size of the FIFO cache simulated when measuring an ordering (typical of
+// older hardware, and a reasonable worst case for newer hardware)
+#define VS_VCACHE_DEFAULT_FIFO     16
+
+class VESS_SYM vsVertexCacheOptimizer
+{
+public:
+
+    static bool      optimizeTriangleOrder(u_int *indexList, int indexCount,
+                                           int vertexCount);
+    static int       optimizeVertexOrder(u_int *indexList, int indexCount,
+                                         int vertexCount, int *vertexRemap);
+
+    static double    getCacheMissRatio(u_int *indexList, int indexCount,
+                                       int cacheSize);
+};
+
+#endif
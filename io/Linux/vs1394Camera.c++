@@ -1006,6 +1006,7 @@ void *vs1394Camera::captureLoop(void *userData)
 {
     vs1394Camera *camera;
     vsTimer *videoTimer;
+    unsigned char *frameBuffer;
 
     // Store the pointer to the camera.
     camera = (vs1394Camera *)userData;
@@ -1029,10 +1030,20 @@ void *vs1394Camera::captureLoop(void *userData)
         // Get a new frame from the camera
         if (dc1394_dma_single_capture(&camera->cameraInfo) == DC1394_SUCCESS)
         {
-            // Stuff the data into the video stream.
-            camera->videoQueue->enqueue(
-                (char *)camera->cameraInfo.capture_buffer,
-                videoTimer->getElapsed());
+            // Claim a frame slot in the video stream.  The DMA buffer has
+            // to go back to the driver right away, so the image is copied
+            // into the slot once here, and consumers then lease the slot
+            // directly instead of copying it out again.  If the consumers
+            // are holding every slot, this frame is dropped.
+            frameBuffer = camera->videoQueue->acquireWriteFrame();
+            if (frameBuffer != NULL)
+            {
+                // Fill the slot and publish it
+                memcpy(frameBuffer, camera->cameraInfo.capture_buffer,
+                    camera->videoQueue->getBytesPerImage());
+                camera->videoQueue->commitWriteFrame(
+                    videoTimer->getElapsed());
+            }
 
             // We're already done with the buffer, so free it.
             dc1394_dma_done_with_buffer(&camera->cameraInfo);
@@ -568,8 +568,7 @@ void vsAscensionSerialTrackingSystem::serverLoop()
             posVec = tracker[i]->getPositionVec();
             ornQuat = tracker[i]->getOrientationQuat();
 
-            sharedData->storeVectorData(i, posVec);
-            sharedData->storeQuatData(i, ornQuat);
+            sharedData->storeData(i, posVec, ornQuat);
         }
     }
 
@@ -2339,8 +2338,7 @@ void vsAscensionSerialTrackingSystem::update()
         {
             // Copy the data from shared memory
             posVec.setSize(3);
-            sharedData->retrieveVectorData(i, &posVec);
-            sharedData->retrieveQuatData(i, &ornQuat);
+            sharedData->retrieveData(i, &posVec, &ornQuat, NULL);
 
             // Apply the new data to the vsMotionTracker
             tracker[i]->setPosition(posVec);
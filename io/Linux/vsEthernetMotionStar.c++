@@ -235,8 +235,7 @@ void vsEthernetMotionStar::serverLoop()
             posVec = tracker[i]->getPositionVec();
             ornQuat = tracker[i]->getOrientationQuat();
 
-            sharedData->storeVectorData(i, posVec);
-            sharedData->storeQuatData(i, ornQuat);
+            sharedData->storeData(i, posVec, ornQuat);
         }
     }
 
@@ -1717,8 +1716,7 @@ void vsEthernetMotionStar::update()
         {
             // Copy tracker data from shared memory
             posVec.setSize(3);
-            sharedData->retrieveVectorData(i, &posVec);
-            sharedData->retrieveQuatData(i, &ornQuat);
+            sharedData->retrieveData(i, &posVec, &ornQuat, NULL);
 
             // Apply the new data to the vsMotionTracker
             tracker[i]->setPosition(posVec);
@@ -280,8 +280,7 @@ void vsFastrak::serverLoop()
             posVec = tracker[i]->getPositionVec();
             ornQuat = tracker[i]->getOrientationQuat();
 
-            sharedData->storeVectorData(i, posVec);
-            sharedData->storeQuatData(i, ornQuat);
+            sharedData->storeData(i, posVec, ornQuat);
         }
     }
 
@@ -1421,8 +1420,7 @@ void vsFastrak::update()
         {
             // Copy tracker data from shared memory
             posVec.setSize(3);
-            sharedData->retrieveVectorData(i, &posVec);
-            sharedData->retrieveQuatData(i, &ornQuat);
+            sharedData->retrieveData(i, &posVec, &ornQuat, NULL);
 
             // Apply the new data to the vsMotionTracker
             tracker[i]->setPosition(posVec);
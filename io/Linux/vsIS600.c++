@@ -281,8 +281,7 @@ void vsIS600::serverLoop()
             posVec = tracker[i]->getPositionVec();
             ornQuat = tracker[i]->getOrientationQuat();
 
-            sharedData->storeVectorData(i, posVec);
-            sharedData->storeQuatData(i, ornQuat);
+            sharedData->storeData(i, posVec, ornQuat);
         }
     }
 
@@ -1558,8 +1557,7 @@ void vsIS600::update()
         {
             // Copy tracker data from shared memory
             posVec.setSize(3);
-            sharedData->retrieveVectorData(i, &posVec);
-            sharedData->retrieveQuatData(i, &ornQuat);
+            sharedData->retrieveData(i, &posVec, &ornQuat, NULL);
 
             // Apply the data to the vsMotionTracker
             tracker[i]->setPosition(posVec);
@@ -1250,8 +1250,7 @@ void vsPolaris::serverLoop()
             posVec = tracker[i]->getPositionVec();
             ornQuat = tracker[i]->getOrientationQuat();
 
-            sharedData->storeVectorData(i, posVec);
-            sharedData->storeQuatData(i, ornQuat);
+            sharedData->storeData(i, posVec, ornQuat);
         }
     }
 
@@ -1797,8 +1796,7 @@ void vsPolaris::update()
         {
             // Copy the data from shared memory
             posVec.setSize(3);
-            sharedData->retrieveVectorData(i, &posVec);
-            sharedData->retrieveQuatData(i, &ornQuat);
+            sharedData->retrieveData(i, &posVec, &ornQuat, NULL);
 
             // Apply the new data to the vsMotionTracker
             tracker[i]->setPosition(posVec);
@@ -14,25 +14,43 @@
 //    VESS Module:  vsSharedInputData.c++
 //
 //    Description:  A class to handle exchange of vsMotionTracker data
-//                  between concurrent processes via shared memory
+//                  between concurrent processes via shared memory.  Each
+//                  entry keeps a short history of time-stamped samples,
+//                  guarded by sequence counters, so the reader never
+//                  waits on (or makes a system call because of) the
+//                  writer.
 //
 //    Author(s):    Jason Daly
 //
 //------------------------------------------------------------------------
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include "vsSharedInputData.h++"
+#include "vsAtomic.h++"
 
 // ------------------------------------------------------------------------
-// Acquire a shared memory segment and semaphore id for the specified 
-// number of vsMotionTrackers.  If master is true, this process is 
-// responsible for creating the necessary structures.
+// Static function
+// Fills in the sample used before any data has been published
+// ------------------------------------------------------------------------
+static void setDefaultSample(vsInputData *sample)
+{
+    // Zero position, identity orientation
+    memset(sample, 0, sizeof(vsInputData));
+    sample->quatData[AT_W] = 1.0;
+}
+
+// ------------------------------------------------------------------------
+// Acquire a shared memory segment for the specified number of
+// vsMotionTrackers.  If master is true, this process is responsible for
+// creating the necessary structures.
 // ------------------------------------------------------------------------
 vsSharedInputData::vsSharedInputData(key_t ipcKey, int trackerCount,
                                      bool master)
 {
-    union semun zero;
-    int         i;
+    int i;
 
     // Initialize variables
     server = master;
@@ -41,17 +59,18 @@ vsSharedInputData::vsSharedInputData(key_t ipcKey, int trackerCount,
     // Get (or create) shared memory segment
     if (server)
     {
-        shmID = shmget(ipcKey, sizeof(vsInputData) * numEntries,
+        shmID = shmget(ipcKey, sizeof(vsSharedInputEntry) * numEntries,
             0666 | IPC_CREAT);
     }
     else
     {
-        shmID = shmget(ipcKey, sizeof(vsInputData) * numEntries, 0);
+        shmID = shmget(ipcKey, sizeof(vsSharedInputEntry) * numEntries, 0);
 
         // Keep trying until successful
         while (shmID == -1)
         {
-            shmID = shmget(ipcKey, sizeof(vsInputData) * numEntries, 0);
+            shmID = shmget(ipcKey, sizeof(vsSharedInputEntry) * numEntries,
+                0);
         }
     }
 
@@ -63,77 +82,48 @@ vsSharedInputData::vsSharedInputData(key_t ipcKey, int trackerCount,
     }
 
     // Attach the data structure to the shared memory segment
-    data = (vsInputData *)shmat(shmID, NULL, 0);
+    data = (vsSharedInputEntry *)shmat(shmID, NULL, 0);
 
     // Check to see if the data segment we get back is valid
     if ((long )data == -1)
     {
         printf("vsSharedInputData::vsSharedInputData: "
             "Unable to attach to shared memory segment\n");
+        data = NULL;
     }
 
-    // Initialize the data structure
-    for (i = 0; i < numEntries; i++)
-    {
-        data[i].vectData[0] = 0.0;
-        data[i].vectData[1] = 0.0;
-        data[i].vectData[2] = 0.0;
-        data[i].vectData[3] = 0.0;
-        data[i].quatData[0] = 0.0;
-        data[i].quatData[1] = 0.0;
-        data[i].quatData[2] = 0.0;
-        data[i].quatData[3] = 1.0;
-    }
+    // Initialize the shared data structure if we're the server.  The
+    // client must not touch it, as the server may already be publishing
+    // (a new segment is zero-filled, which is the same as an empty
+    // history, so it doesn't matter if the client attaches first).
+    if ((server) && (data != NULL))
+        memset(data, 0, sizeof(vsSharedInputEntry) * numEntries);
 
-    // Get (or create) the associated semaphores
-    if (server)
-    {
-        semID = semget(ipcKey, numEntries, 0666 | IPC_CREAT);
-    }
-    else
-    {
-        semID = semget(ipcKey, numEntries, 0);
-        while (semID == -1)
-        {
-            semID = semget(ipcKey, numEntries, 0);
-        }
-    }
-
-    // Print an error if we fail to create the semaphores
-    if (semID == -1)
-    {
-        printf("vsSharedInputData::vsSharedInputData: "
-            "Unable to create semaphores\n");
-    }
-
-    // Initialize the semaphores to zero
-    if (server)
-    {
-        zero.val = 0;
-
-        for (i = 0; i < numEntries; i++)
-        {
-            semctl(semID, i, SETVAL, zero);
-        }
-    }
+    // Initialize the data being assembled for each entry
+    pendingData = (vsInputData *)malloc(sizeof(vsInputData) * numEntries);
+    for (i = 0; i < numEntries; i++)
+        setDefaultSample(&pendingData[i]);
 }
 
 // ------------------------------------------------------------------------
-// Detach from shared memory.  If this instance is the server, release the 
-// shared memory segment and semaphores.
+// Detach from shared memory.  If this instance is the server, release the
+// shared memory segment.
 // ------------------------------------------------------------------------
 vsSharedInputData::~vsSharedInputData()
 {
     // Detach from shared memory
-    shmdt((void *)data);
-    
+    if (data != NULL)
+        shmdt((void *)data);
+
     // Clean up shared memory if we're the server process
     if (server)
     {
-        // Remove the shared memory and semaphores
+        // Remove the shared memory
         shmctl(shmID, IPC_RMID, NULL);
-        semctl(semID, numEntries, IPC_RMID, NULL);
     }
+
+    // Free the local data
+    free(pendingData);
 }
 
 // ------------------------------------------------------------------------
@@ -145,141 +135,360 @@ const char *vsSharedInputData::getClassName()
 }
 
 // ------------------------------------------------------------------------
-// Stores the atVector's data in specified shared memory slot
+// Static function
+// Returns the current time in seconds from the monotonic clock used to
+// time stamp the samples.  Times passed to storeData() and
+// retrieveInterpolatedData() should come from here.
 // ------------------------------------------------------------------------
-void vsSharedInputData::storeVectorData(int index, atVector vector)
+double vsSharedInputData::getCurrentTime()
+{
+    struct timespec now;
+
+    // Read the monotonic clock (it isn't affected by changes to the
+    // system time, so samples always move forward in time)
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec * 1.0E-9;
+}
+
+// ------------------------------------------------------------------------
+// Publishes a new position and orientation for the specified entry, time
+// stamped with the current time
+// ------------------------------------------------------------------------
+void vsSharedInputData::storeData(int index, atVector vector, atQuat quat)
 {
-    struct sembuf semOps[2];
-    int           i;
+    storeData(index, vector, quat, getCurrentTime());
+}
+
+// ------------------------------------------------------------------------
+// Publishes a new position and orientation for the specified entry, with
+// the given time stamp (from getCurrentTime())
+// ------------------------------------------------------------------------
+void vsSharedInputData::storeData(int index, atVector vector, atQuat quat,
+                                  double timestamp)
+{
+    int i;
 
     // Validate the index before proceeding
-    if (index < numEntries)
+    if ((index >= 0) && (index < numEntries))
     {
-        // Set up the semaphore operations
-        semOps[0].sem_num = index;
-        semOps[0].sem_op = 0;
-        semOps[0].sem_flg = 0;
-        semOps[1].sem_num = index;
-        semOps[1].sem_op = 1;
-        semOps[1].sem_flg = 0;
-
-        // Test-and-set the associated semaphore
-        semop(semID, semOps, 2);
-
-        // Copy the data
-        for (i = 0; i < vector.getSize(); i++)
-            data[index].vectData[i] = vector[i];
-
-        // Release the semaphore
-        semOps[0].sem_num = index;
-        semOps[0].sem_op = -1;
-        semOps[0].sem_flg = 0;
-        semop(semID, semOps, 1);
+        // Assemble the sample
+        for (i = 0; (i < vector.getSize()) && (i < 4); i++)
+            pendingData[index].vectData[i] = vector[i];
+        pendingData[index].quatData[AT_X] = quat[AT_X];
+        pendingData[index].quatData[AT_Y] = quat[AT_Y];
+        pendingData[index].quatData[AT_Z] = quat[AT_Z];
+        pendingData[index].quatData[AT_W] = quat[AT_W];
+        pendingData[index].timestamp = timestamp;
+
+        // Publish it
+        publishSample(index, &pendingData[index]);
     }
 }
 
+// ------------------------------------------------------------------------
+// Publishes a new position for the specified entry, keeping the last
+// orientation stored.  Use storeData() to publish both at once.
+// ------------------------------------------------------------------------
+void vsSharedInputData::storeVectorData(int index, atVector vector)
+{
+    int i;
+
+    // Validate the index before proceeding
+    if ((index >= 0) && (index < numEntries))
+    {
+        // Update the position, and publish the sample
+        for (i = 0; (i < vector.getSize()) && (i < 4); i++)
+            pendingData[index].vectData[i] = vector[i];
+        pendingData[index].timestamp = getCurrentTime();
+        publishSample(index, &pendingData[index]);
+    }
+}
 
 // ------------------------------------------------------------------------
-// Stores the atQuat's data in specified shared memory slot
+// Publishes a new orientation for the specified entry, keeping the last
+// position stored.  Use storeData() to publish both at once.
 // ------------------------------------------------------------------------
 void vsSharedInputData::storeQuatData(int index, atQuat quat)
 {
-    struct sembuf semOps[2];
-
     // Validate the index before proceeding
-    if (index < numEntries)
+    if ((index >= 0) && (index < numEntries))
     {
-        // Set up the semaphore operations
-        semOps[0].sem_num = index;
-        semOps[0].sem_op = 0;
-        semOps[0].sem_flg = 0;
-        semOps[1].sem_num = index;
-        semOps[1].sem_op = 1;
-        semOps[1].sem_flg = 0;
-
-        // Test-and-set the associated semaphore
-        semop(semID, semOps, 2);
-
-        // Copy the data
-        data[index].quatData[AT_X] = quat[AT_X];
-        data[index].quatData[AT_Y] = quat[AT_Y];
-        data[index].quatData[AT_Z] = quat[AT_Z];
-        data[index].quatData[AT_W] = quat[AT_W];
-
-        // Release the semaphore
-        semOps[0].sem_num = index;
-        semOps[0].sem_op = -1;
-        semOps[0].sem_flg = 0;
-        semop(semID, semOps, 1);
+        // Update the orientation, and publish the sample
+        pendingData[index].quatData[AT_X] = quat[AT_X];
+        pendingData[index].quatData[AT_Y] = quat[AT_Y];
+        pendingData[index].quatData[AT_Z] = quat[AT_Z];
+        pendingData[index].quatData[AT_W] = quat[AT_W];
+        pendingData[index].timestamp = getCurrentTime();
+        publishSample(index, &pendingData[index]);
     }
 }
 
 // ------------------------------------------------------------------------
-// Retrieves the atVector's data from specified shared memory slot
+// Retrieves the newest position and orientation (and their time stamp)
+// for the specified entry.  Any of the result pointers may be NULL.
+// Returns false if nothing has been published for the entry yet, in
+// which case a zero position and identity orientation are returned.
+// This never waits for the writer.
 // ------------------------------------------------------------------------
-void vsSharedInputData::retrieveVectorData(int index, atVector *vector)
+bool vsSharedInputData::retrieveData(int index, atVector *vector,
+                                     atQuat *quat, double *timestamp)
 {
-    struct sembuf semOps[2];
-    int           i;
+    vsInputData sample;
+    bool result;
+    int i;
 
     // Validate the index before proceeding
-    if (index < numEntries)
+    if ((index < 0) || (index >= numEntries))
+        return false;
+
+    // Get the newest sample
+    result = readNewestSample(index, &sample);
+
+    // Copy the data
+    if (vector != NULL)
     {
-        // Set up the semaphore operations
-        semOps[0].sem_num = index;
-        semOps[0].sem_op = 0;
-        semOps[0].sem_flg = 0;
-        semOps[1].sem_num = index;
-        semOps[1].sem_op = 1;
-        semOps[1].sem_flg = 0;
-
-        // Test-and-set the associated semaphore
-        semop(semID, semOps, 2);
-
-        // Copy the data
-        for (i = 0; i < vector->getSize(); i++)
-            (*(vector))[i] = data[index].vectData[i];
-
-        // Release the semaphore
-        semOps[0].sem_num = index;
-        semOps[0].sem_op = -1;
-        semOps[0].sem_flg = 0;
-        semop(semID, semOps, 1);
+        for (i = 0; (i < vector->getSize()) && (i < 4); i++)
+            (*(vector))[i] = sample.vectData[i];
     }
+    if (quat != NULL)
+        quat->set(sample.quatData[AT_X], sample.quatData[AT_Y],
+            sample.quatData[AT_Z], sample.quatData[AT_W]);
+    if (timestamp != NULL)
+        *timestamp = sample.timestamp;
+
+    return result;
 }
 
 // ------------------------------------------------------------------------
-// Retrieves the atQuat's data from specified shared memory slot
+// Retrieves the position and orientation of the specified entry at the
+// given time (from getCurrentTime()), interpolated between the two
+// samples in the history on either side of it.  Times past the newest
+// sample get the newest sample (the data is never extrapolated), and
+// times before the oldest sample get the oldest one.  Returns false if
+// nothing has been published for the entry yet.  This never waits for
+// the writer.
 // ------------------------------------------------------------------------
-void vsSharedInputData::retrieveQuatData(int index, atQuat *quat)
+bool vsSharedInputData::retrieveInterpolatedData(int index, double time,
+                                                 atVector *vector,
+                                                 atQuat *quat)
 {
-    struct sembuf semOps[2];
+    u_int count;
+    u_int age;
+    vsInputData sample, older, newer;
+    bool haveOlder, haveNewer;
+    double parameter;
+    atQuat olderQuat, newerQuat, resultQuat;
+    int i;
 
     // Validate the index before proceeding
-    if (index < numEntries)
+    if ((index < 0) || (index >= numEntries) || (data == NULL))
+        return false;
+
+    // Walk back through the history, from the newest sample, until we
+    // find one at or before the requested time.  The slot after the
+    // newest sample may be being written, so we can't go back any
+    // further than that.
+    count = (u_int)vsAtomicLoadAcquire(&data[index].sampleCount);
+    haveOlder = false;
+    haveNewer = false;
+    age = 0;
+    while ((!haveOlder) && (age < VS_SHARED_INPUT_HISTORY - 1) &&
+        (age < count))
     {
-        // Set up the semaphore operations
-        semOps[0].sem_num = index;
-        semOps[0].sem_op = 0;
-        semOps[0].sem_flg = 0;
-        semOps[1].sem_num = index;
-        semOps[1].sem_op = 1;
-        semOps[1].sem_flg = 0;
-
-        // Test-and-set the associated semaphore
-        semop(semID, semOps, 2);
-
-        // Copy the data
-        (*(quat))[AT_X] = data[index].quatData[AT_X];
-        (*(quat))[AT_Y] = data[index].quatData[AT_Y];
-        (*(quat))[AT_Z] = data[index].quatData[AT_Z];
-        (*(quat))[AT_W] = data[index].quatData[AT_W]; 
-
-        // Release the semaphore
-        semOps[0].sem_num = index;
-        semOps[0].sem_op = -1;
-        semOps[0].sem_flg = 0;
-        semop(semID, semOps, 1);
+        // Read the sample.  If it has been overwritten, so have all the
+        // samples before it, so stop here.
+        if (!readSample(index, count - 1 - age, &sample))
+            break;
+
+        // See which side of the requested time the sample is on
+        if (sample.timestamp <= time)
+        {
+            older = sample;
+            haveOlder = true;
+        }
+        else
+        {
+            newer = sample;
+            haveNewer = true;
+        }
+
+        // Next older sample
+        age++;
+    }
+
+    // Figure out what to return
+    if ((!haveOlder) && (!haveNewer))
+    {
+        // Nothing available, return the defaults
+        setDefaultSample(&sample);
+        parameter = 0.0;
+        older = sample;
+        newer = sample;
+    }
+    else if (!haveOlder)
+    {
+        // The time is before anything we have, use the oldest sample
+        older = newer;
+        parameter = 0.0;
+    }
+    else if (!haveNewer)
+    {
+        // The time is past the newest sample, use it as is
+        newer = older;
+        parameter = 0.0;
+    }
+    else if (newer.timestamp > older.timestamp)
+    {
+        // Interpolate between the samples
+        parameter = (time - older.timestamp) /
+            (newer.timestamp - older.timestamp);
     }
+    else
+        parameter = 0.0;
+
+    // Interpolate the position linearly
+    if (vector != NULL)
+    {
+        for (i = 0; (i < vector->getSize()) && (i < 4); i++)
+            (*(vector))[i] = older.vectData[i] * (1.0 - parameter) +
+                newer.vectData[i] * parameter;
+    }
+
+    // Interpolate the orientation spherically
+    if (quat != NULL)
+    {
+        olderQuat.set(older.quatData[AT_X], older.quatData[AT_Y],
+            older.quatData[AT_Z], older.quatData[AT_W]);
+        if (parameter > 0.0)
+        {
+            newerQuat.set(newer.quatData[AT_X], newer.quatData[AT_Y],
+                newer.quatData[AT_Z], newer.quatData[AT_W]);
+            resultQuat = olderQuat.slerp(newerQuat, parameter);
+            *quat = resultQuat.getNormalized();
+        }
+        else
+            *quat = olderQuat;
+    }
+
+    return (haveOlder || haveNewer);
 }
 
+// ------------------------------------------------------------------------
+// Retrieves the newest position for the specified entry.  Use
+// retrieveData() to get the position and orientation from the same
+// sample.
+// ------------------------------------------------------------------------
+void vsSharedInputData::retrieveVectorData(int index, atVector *vector)
+{
+    retrieveData(index, vector, NULL, NULL);
+}
+
+// ------------------------------------------------------------------------
+// Retrieves the newest orientation for the specified entry.  Use
+// retrieveData() to get the position and orientation from the same
+// sample.
+// ------------------------------------------------------------------------
+void vsSharedInputData::retrieveQuatData(int index, atQuat *quat)
+{
+    retrieveData(index, NULL, quat, NULL);
+}
+
+// ------------------------------------------------------------------------
+// Protected function
+// Writes the given sample into the next slot of the entry's history, and
+// makes it the newest sample.  Only one process (the server) may write to
+// an entry, so no locking is needed; the sequence counter just tells the
+// readers when the slot is being changed.
+// ------------------------------------------------------------------------
+void vsSharedInputData::publishSample(int index, vsInputData *sample)
+{
+    vsSharedInputEntry *entry;
+    u_int sampleNumber;
+    int slot;
+
+    // Make sure we have shared memory
+    if (data == NULL)
+        return;
+
+    // Get the number of the new sample, and the slot it goes in
+    entry = &data[index];
+    sampleNumber = (u_int)entry->sampleCount;
+    slot = sampleNumber & (VS_SHARED_INPUT_HISTORY - 1);
+
+    // Mark the slot as being written
+    entry->sequence[slot] = (int)(sampleNumber * 2 + 1);
+    vsMemoryBarrier();
+
+    // Write the sample
+    memcpy(&entry->sample[slot], sample, sizeof(vsInputData));
+    vsMemoryBarrier();
+
+    // Mark the slot as complete, then publish it as the newest sample
+    entry->sequence[slot] = (int)(sampleNumber * 2 + 2);
+    vsMemoryBarrier();
+    entry->sampleCount = (int)(sampleNumber + 1);
+}
+
+// ------------------------------------------------------------------------
+// Protected function
+// Reads the given sample from the entry's history.  Returns false if the
+// slot no longer holds that sample (or the sample is being overwritten
+// while we read it).
+// ------------------------------------------------------------------------
+bool vsSharedInputData::readSample(int index, u_int sampleNumber,
+                                   vsInputData *sample)
+{
+    vsSharedInputEntry *entry;
+    int slot;
+    int expected;
+
+    // Get the slot that holds the sample, and the sequence value it has
+    // once the sample is complete
+    entry = &data[index];
+    slot = sampleNumber & (VS_SHARED_INPUT_HISTORY - 1);
+    expected = (int)(sampleNumber * 2 + 2);
+
+    // Make sure the slot holds the sample before we read it
+    if (vsAtomicLoadAcquire(&entry->sequence[slot]) != expected)
+        return false;
+
+    // Copy the sample
+    memcpy(sample, &entry->sample[slot], sizeof(vsInputData));
+
+    // Make sure the writer didn't start changing the slot while we were
+    // copying it
+    vsMemoryBarrier();
+    return (vsAtomicLoadAcquire(&entry->sequence[slot]) == expected);
+}
+
+// ------------------------------------------------------------------------
+// Protected function
+// Reads the newest complete sample of the entry.  If the writer manages
+// to overwrite it while we read it (which means it has published a whole
+// history's worth of samples in the meantime), the next older sample is
+// tried instead, up to the size of the history, so this always finishes
+// in a bounded number of steps.  Returns false (and the default sample)
+// if there is no sample to read.
+// ------------------------------------------------------------------------
+bool vsSharedInputData::readNewestSample(int index, vsInputData *sample)
+{
+    u_int count;
+    u_int age;
+
+    // Make sure we have shared memory
+    if (data != NULL)
+    {
+        // Try the newest sample first, then older ones
+        count = (u_int)vsAtomicLoadAcquire(&data[index].sampleCount);
+        for (age = 0; (age < VS_SHARED_INPUT_HISTORY - 1) && (age < count);
+            age++)
+        {
+            if (readSample(index, count - 1 - age, sample))
+                return true;
+        }
+    }
+
+    // Nothing to read
+    setDefaultSample(sample);
+    return false;
+}
@@ -14,7 +14,11 @@
 //    VESS Module:  vsSharedInputData.h++
 //
 //    Description:  A class to handle exchange of vsMotionTracker data
-//                  between concurrent processes via shared memory
+//                  between concurrent processes via shared memory.  Each
+//                  entry keeps a short history of time-stamped samples,
+//                  guarded by sequence counters, so the reader never
+//                  waits on (or makes a system call because of) the
+//                  writer.
 //
 //    Author(s):    Jason Daly
 //
@@ -26,43 +30,61 @@
 #include <sys/types.h>
 #include <sys/ipc.h>
 #include <sys/shm.h>
-#include <sys/sem.h>
 
 #include "atVector.h++"
 #include "atQuat.h++"
 #include "vsObject.h++"
 
-#ifdef _XOPEN_SOURCE
-union semun {
-    int             val;
-    struct semid_ds *buf;
-    unsigned short  *array;
-};
-#endif
+// Number of samples kept for each entry (must be a power of two).  The
+// sample being written at any moment can't be read, so this allows
+// interpolating over the last (history - 1) samples.
+#define VS_SHARED_INPUT_HISTORY    8
 
 typedef struct
 {
     double vectData[4];
     double quatData[4];
+    double timestamp;
 } vsInputData;
 
+typedef struct
+{
+    // Number of samples published so far (the newest sample is number
+    // sampleCount - 1)
+    volatile int    sampleCount;
+
+    // Sequence counter for each slot in the history.  While sample n is
+    // being written to a slot, its counter is 2n + 1, and once the sample
+    // is complete, it's 2n + 2.
+    volatile int    sequence[VS_SHARED_INPUT_HISTORY];
+
+    vsInputData     sample[VS_SHARED_INPUT_HISTORY];
+} vsSharedInputEntry;
+
 class vsSharedInputData : public vsObject
 {
 protected:
 
-    vsInputData    *data;
+    vsSharedInputEntry    *data;
 
-    // Shared memory and semaphore ID's
+    // Shared memory ID
     int            shmID;
-    int            semID;
 
-    // Number of DeviceData entries in shared memory segment
-    // (also the number of semaphores)
+    // Number of entries in shared memory segment
     int            numEntries;
 
+    // Data being assembled for each entry by storeVectorData() and
+    // storeQuatData() (kept locally, not in shared memory)
+    vsInputData    *pendingData;
+
     // Indicates whether this process is the data server
     bool           server;
 
+    void           publishSample(int index, vsInputData *sample);
+    bool           readSample(int index, u_int sampleNumber,
+                              vsInputData *sample);
+    bool           readNewestSample(int index, vsInputData *sample);
+
 public:
 
                  vsSharedInputData(key_t key, int entryCount, bool master);
@@ -70,9 +92,20 @@ public:
 
     virtual const char    *getClassName();
 
+    static double    getCurrentTime();
+
+    void         storeData(int index, atVector vector, atQuat quat);
+    void         storeData(int index, atVector vector, atQuat quat,
+                           double timestamp);
+
     void         storeVectorData(int index, atVector vector);
     void         storeQuatData(int index, atQuat quat);
 
+    bool         retrieveData(int index, atVector *vector, atQuat *quat,
+                              double *timestamp);
+    bool         retrieveInterpolatedData(int index, double time,
+                                          atVector *vector, atQuat *quat);
+
     void         retrieveVectorData(int index, atVector *vector);
     void         retrieveQuatData(int index, atQuat *quat);
 };
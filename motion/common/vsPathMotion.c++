@@ -57,8 +57,11 @@ vsPathMotion::vsPathMotion(vsKinematics *kinematics)
     upDirection.set(0.0, 0.0, 0.0);
 
     // Set the current number of key points to zero; the segmentList
-    // growable array has already been initialized
+    // growable array has already been initialized.  The points aren't
+    // compiled into a track until the path is first played.
     pointCount = 0;
+    pointListValid = true;
+    pathTrack = NULL;
 
     // Set the 'current' values to zeroed defaults
     currentPos.set(0.0, 0.0, 0.0);
@@ -69,6 +72,11 @@ vsPathMotion::vsPathMotion(vsKinematics *kinematics)
     currentSegmentTime = 0.0;
     totalTime = 0.0;
     totalPathTime = 0.0;
+
+    // Not transitioning into the path
+    transitioning = false;
+    transitionTime = 0.0;
+    transitionElapsed = 0.0;
 }
 
 // ------------------------------------------------------------------------
@@ -76,10 +84,6 @@ vsPathMotion::vsPathMotion(vsKinematics *kinematics)
 // ------------------------------------------------------------------------
 vsPathMotion::vsPathMotion(vsPathMotion *original)
 {
-    int index;
-    vsPathMotionSegment *tempSeg;
-    vsPathMotionSegment *tempNewSeg;
-    
     // Copy the kinematics pointer over. (The PathMotions will reference
     // the same kinematics object.)
     objectKin = original->objectKin;
@@ -105,10 +109,12 @@ vsPathMotion::vsPathMotion(vsPathMotion *original)
     lookPoint = original->lookPoint;
     upDirection = original->upDirection;
     
-    // Set up the point list with the correct number of points (we'll
-    // replace the actual point entries below)
-    pointCount = 0;
-    setPointListSize(original->pointList.getNumEntries()); 
+    // Share the original's compiled track instead of copying its points.
+    // We'll only make our own copy of the points if they're changed.
+    pointCount = original->pointCount;
+    pointListValid = false;
+    pathTrack = original->getTrack();
+    pathTrack->ref();
 
     // Copy the current position and orientation
     currentPos = original->currentPos;
@@ -119,26 +125,13 @@ vsPathMotion::vsPathMotion(vsPathMotion *original)
     currentSegmentTime = original->currentSegmentTime;
     totalTime = original->totalTime;
     totalPathTime = original->totalPathTime;
-    
-    // Copy the data for each path point
-    for(index = 0; index < pointCount; index++)
-    {
-        // Get the segment data structure from the original path motion.
-        tempSeg = (vsPathMotionSegment*) (original->pointList.getEntry(index));
-        
-        // Make sure the segment is not NULL. If it is, we've reached the end
-        // of the list, so break out of this loop.
-        if (tempSeg == NULL)
-        {
-            break;
-        }
-        
-        // Clone the point data at this segment, and put it in our list
-        // at the correct position (this will replace the empty point that
-        // we created above)
-        tempNewSeg = tempSeg->clone();
-        pointList.setEntry(index, tempNewSeg);
-    }
+
+    // Copy the transition state
+    transitioning = original->transitioning;
+    transitionTime = original->transitionTime;
+    transitionElapsed = original->transitionElapsed;
+    transitionStartPos = original->transitionStartPos;
+    transitionStartOri = original->transitionStartOri;
 }
             
 // ------------------------------------------------------------------------
@@ -150,6 +143,10 @@ vsPathMotion::~vsPathMotion()
     // Unreference the kinematics object, and delete it if it is no
     // longer in use
     vsObject::unrefDelete(objectKin);
+
+    // Release the compiled track (it may be shared with other paths)
+    if (pathTrack != NULL)
+        vsObject::unrefDelete(pathTrack);
 }
 
 // ------------------------------------------------------------------------
@@ -306,6 +303,9 @@ void vsPathMotion::setPointListSize(int size)
         return;
     }
 
+    // Make sure we have our own copy of the points to change
+    makePointListEditable();
+
     // Compare the requested size of the point list to the current one;
     // don't do anything if the requested size is the same as the current
     // size.
@@ -365,6 +365,9 @@ void vsPathMotion::setPosition(int point, atVector position)
         return;
     }
 
+    // Make sure we have our own copy of the points to change
+    makePointListEditable();
+
     // Get the segment structure from the points array
     segData = (vsPathMotionSegment *)(pointList.getEntry(point));
 
@@ -387,6 +390,9 @@ void vsPathMotion::setOrientation(int point, atQuat orientation)
         return;
     }
 
+    // Make sure we have our own copy of the points to change
+    makePointListEditable();
+
     // Get the segment structure from the points array
     segData = (vsPathMotionSegment *)(pointList.getEntry(point));
 
@@ -410,6 +416,9 @@ void vsPathMotion::setTime(int point, double seconds)
         return;
     }
 
+    // Make sure we have our own copy of the points to change
+    makePointListEditable();
+
     // Get the segment structure from the points array
     segData = (vsPathMotionSegment *)(pointList.getEntry(point));
 
@@ -435,6 +444,9 @@ void vsPathMotion::setPauseTime(int point, double seconds)
         return;
     }
 
+    // Make sure we have our own copy of the points to change
+    makePointListEditable();
+
     // Get the segment structure from the points array
     segData = (vsPathMotionSegment *)(pointList.getEntry(point));
 
@@ -457,6 +469,11 @@ atVector vsPathMotion::getPosition(int point)
         return atVector(0.0, 0.0, 0.0);
     }
 
+    // If the points have been compiled into a track, get the data from
+    // there
+    if (!pointListValid)
+        return pathTrack->getKey(point)->position;
+
     // Get the segment structure from the points array
     segData = (vsPathMotionSegment *)(pointList.getEntry(point));
 
@@ -479,6 +496,11 @@ atQuat vsPathMotion::getOrientation(int point)
         return atQuat(0.0, 0.0, 0.0, 0.0);
     }
 
+    // If the points have been compiled into a track, get the data from
+    // there
+    if (!pointListValid)
+        return pathTrack->getKey(point)->orientation;
+
     // Get the segment structure from the points array
     segData = (vsPathMotionSegment *)(pointList.getEntry(point));
 
@@ -502,6 +524,11 @@ double vsPathMotion::getTime(int point)
         return 0.0;
     }
 
+    // If the points have been compiled into a track, get the data from
+    // there
+    if (!pointListValid)
+        return pathTrack->getKey(point)->travelTime;
+
     // Get the segment structure from the points array
     segData = (vsPathMotionSegment *)(pointList.getEntry(point));
 
@@ -527,6 +554,11 @@ double vsPathMotion::getPauseTime(int point)
         return 0.0;
     }
 
+    // If the points have been compiled into a track, get the data from
+    // there
+    if (!pointListValid)
+        return pathTrack->getKey(point)->pauseTime;
+
     // Get the segment structure from the points array
     segData = (vsPathMotionSegment *)(pointList.getEntry(point));
 
@@ -559,6 +591,9 @@ void vsPathMotion::autoSetTimes(double totalPathSeconds)
         return;
     }
 
+    // Make sure we have our own copy of the points to change
+    makePointListEditable();
+
     // Create an array to hold the length of each path segment, and
     // initialize the total length of the path to zero
     segmentLengths = (double *)(malloc(pointCount * sizeof(double)));
@@ -688,6 +723,9 @@ void vsPathMotion::pause()
 void vsPathMotion::stop()
 {
     currentPlayMode = VS_PATH_STOPPED;
+
+    // Stopping also cancels any transition into the path
+    transitioning = false;
 }
 
 // ------------------------------------------------------------------------
@@ -706,6 +744,97 @@ int vsPathMotion::getCurrentSegment()
     return currentSegmentIdx;
 }
 
+// ------------------------------------------------------------------------
+// Starts a smooth transition into this path from the kinematics' current
+// pose.  For the given number of seconds of play time, the path blends
+// from that pose to its first key point without moving along the path;
+// after that, it plays normally.  Stopping the path cancels the
+// transition.
+// ------------------------------------------------------------------------
+void vsPathMotion::startTransition(double seconds)
+{
+    // A transition with no length is no transition at all, and neither is
+    // a transition into a path with no points (update() never gets as far
+    // as blending toward it, so the transition would never finish)
+    if ((seconds <= 0.0) || (pointCount < 1))
+    {
+        transitioning = false;
+        return;
+    }
+
+    // Remember where we're starting from
+    transitionStartPos = objectKin->getPosition();
+    transitionStartOri = objectKin->getOrientation();
+
+    // Start the blend
+    transitionTime = seconds;
+    transitionElapsed = 0.0;
+    transitioning = true;
+}
+
+// ------------------------------------------------------------------------
+// Returns whether the path is still transitioning into its first point
+// ------------------------------------------------------------------------
+bool vsPathMotion::isTransitioning()
+{
+    return transitioning;
+}
+
+// ------------------------------------------------------------------------
+// Returns the compiled, read-only track holding the path's key points,
+// compiling it if the points have changed since it was last compiled.
+// Copies of this path share the same track.
+// ------------------------------------------------------------------------
+vsPathMotionTrack *vsPathMotion::getTrack()
+{
+    // Compile the points if we don't have an up-to-date track
+    if (pathTrack == NULL)
+    {
+        pathTrack = new vsPathMotionTrack(&pointList, pointCount);
+        pathTrack->ref();
+
+        // The track holds everything we need now, so we can drop the
+        // editable copy of the points (it will be recreated if the points
+        // are changed again)
+        pointList.removeAllEntries();
+        pointListValid = false;
+    }
+
+    return pathTrack;
+}
+
+// ------------------------------------------------------------------------
+// Replaces the path's key points with the given compiled track.  The
+// track is shared, not copied, so any number of paths can use the same
+// track.  The path is stopped, since its current position in the old
+// points is meaningless now.
+// ------------------------------------------------------------------------
+void vsPathMotion::setTrack(vsPathMotionTrack *track)
+{
+    // Make sure we have a track
+    if (track == NULL)
+    {
+        printf("vsPathMotion::setTrack: NULL track\n");
+        return;
+    }
+
+    // Reference the new track first, in case it's the one we have now
+    track->ref();
+
+    // Release the old track and any editable copy of the points
+    if (pathTrack != NULL)
+        vsObject::unrefDelete(pathTrack);
+    pointList.removeAllEntries();
+
+    // Use the new track's points
+    pathTrack = track;
+    pointCount = pathTrack->getKeyCount();
+    pointListValid = false;
+
+    // Start from the beginning of the new points
+    stop();
+}
+
 // ------------------------------------------------------------------------
 // Sets any or all of the data in the object from the instructions
 // contained in the specified external data file
@@ -912,12 +1041,11 @@ void vsPathMotion::update()
 // ------------------------------------------------------------------------
 void vsPathMotion::update(double deltaTime)
 {
-    vsPathMotionSegment *prevSeg, *currentSeg, *nextSeg, *nextNextSeg;
-    atVector prevSegPos, currentSegPos, nextSegPos, nextNextSegPos;
-    atVector *prevSegPosPt, *currentSegPosPt, *nextSegPosPt, *nextNextSegPosPt;
-    atQuat prevSegOri, currentSegOri, nextSegOri, nextNextSegOri;
-    atQuat *prevSegOriPt, *currentSegOriPt, *nextSegOriPt, *nextNextSegOriPt;
-    double frameTime, segmentTotalTime;
+    vsPathMotionTrack *track;
+    vsPathMotionKey *prevKey, *currentKey, *nextKey, *nextNextKey;
+    atVector *prevKeyPosPt, *currentKeyPosPt, *nextKeyPosPt, *nextNextKeyPosPt;
+    atQuat *prevKeyOriPt, *currentKeyOriPt, *nextKeyOriPt, *nextNextKeyOriPt;
+    double frameTime, segmentTotalTime, segmentTravelTime;
     atVector newPosition;
     atQuat newOrientation;
     double parameter;
@@ -927,9 +1055,24 @@ void vsPathMotion::update(double deltaTime)
         return;
 
     // If there aren't any points defined, then there's nothing we can do;
-    // abort.
+    // abort.  There's nothing to transition into either, so make sure we
+    // don't report a transition that can never finish.
     if (pointCount < 1)
+    {
+        transitioning = false;
         return;
+    }
+
+    // Get the compiled key points
+    track = getTrack();
+
+    // If we're transitioning into the path, blend toward the start of the
+    // path instead of moving along it
+    if (transitioning)
+    {
+        updateTransition(track, deltaTime);
+        return;
+    }
 
     // If the current play mode is PLAYING, then update the time of the
     // path based on the draw time from the last frame
@@ -939,14 +1082,14 @@ void vsPathMotion::update(double deltaTime)
         frameTime = deltaTime;
 
         // Get the data for the current segment
-        currentSeg = (vsPathMotionSegment *)
-            (pointList.getEntry(currentSegmentIdx));
+        currentKey = track->getKey(currentSegmentIdx);
 
         // Determine how much time we actually need to spend on this
         // segment, counting in temporary pauses
-        segmentTotalTime = currentSeg->getTravelTime();
-        if (currentSeg->getPauseTime() > 0.0)
-            segmentTotalTime += currentSeg->getPauseTime();
+        segmentTotalTime = getKeyTravelTime(currentKey, currentSegmentIdx,
+            deltaTime);
+        if (currentKey->pauseTime > 0.0)
+            segmentTotalTime += currentKey->pauseTime;
 
         // Add the 'time last frame' value to the time spent on the
         // current segment
@@ -982,45 +1125,34 @@ void vsPathMotion::update(double deltaTime)
                 // on the path to the end of the path
                 currentPlayMode = VS_PATH_STOPPED;
                 currentSegmentIdx = pointCount - 1;
-                currentSeg = (vsPathMotionSegment *)
-                    (pointList.getEntry(currentSegmentIdx));
-                currentSegmentTime = currentSeg->getTravelTime();
-                if (currentSeg->getPauseTime() > 0.0)
-                    currentSegmentTime += currentSeg->getPauseTime();
+                currentKey = track->getKey(currentSegmentIdx);
+                currentSegmentTime = getKeyTravelTime(currentKey,
+                    currentSegmentIdx, deltaTime);
+                if (currentKey->pauseTime > 0.0)
+                    currentSegmentTime += currentKey->pauseTime;
                 break;
             }
 
             // Get the data corresponding to the new segment
-            currentSeg = (vsPathMotionSegment *)
-                (pointList.getEntry(currentSegmentIdx));
+            currentKey = track->getKey(currentSegmentIdx);
 
             // If the new segment has a negative pause time, then go
             // into 'pause indefinitely' mode. Set the current time on the
             // segment to zero, so that the computation step will place
             // the position and orientation at the beginning of this
             // segment.
-            if (currentSeg->getPauseTime() < 0.0)
+            if (currentKey->pauseTime < 0.0)
             {
                 currentPlayMode = VS_PATH_PAUSED;
                 currentSegmentTime = 0.0;
             }
 
-            // Check if we're on the last segment of the path (the part of
-            // the path after the last point), and if we're in RESTART
-            // cycle mode. Since there can't be any actual path to travel
-            // in this case, force the travel time for that segment to be
-            // zero. (There _is_ still a segment there, as there is the
-            // possibility that a delay time can be set there.)
-            if ((currentSegmentIdx == (pointCount - 1)) &&
-                (cycleMode == VS_PATH_CYCLE_RESTART))
-            {
-                currentSeg->setTravelTime(0.0);
-            }
-
-            // Calculate the new segment total path time
-            segmentTotalTime = currentSeg->getTravelTime();
-            if (currentSeg->getPauseTime() > 0.0)
-                segmentTotalTime += currentSeg->getPauseTime();
+            // Calculate the new segment total path time (the travel time
+            // is zero for the last segment in RESTART mode)
+            segmentTotalTime = getKeyTravelTime(currentKey,
+                currentSegmentIdx, deltaTime);
+            if (currentKey->pauseTime > 0.0)
+                segmentTotalTime += currentKey->pauseTime;
 
         } // if (currentSegmentTime >= segmentTotalTime)
         
@@ -1059,45 +1191,34 @@ void vsPathMotion::update(double deltaTime)
                 // on the path to the end of the path
                 currentPlayMode = VS_PATH_STOPPED;
                 currentSegmentIdx = pointCount - 1;
-                currentSeg = (vsPathMotionSegment *)
-                    (pointList.getEntry(currentSegmentIdx));
-                currentSegmentTime = currentSeg->getTravelTime();
-                if (currentSeg->getPauseTime() > 0.0)
-                    currentSegmentTime += currentSeg->getPauseTime();
+                currentKey = track->getKey(currentSegmentIdx);
+                currentSegmentTime = getKeyTravelTime(currentKey,
+                    currentSegmentIdx, deltaTime);
+                if (currentKey->pauseTime > 0.0)
+                    currentSegmentTime += currentKey->pauseTime;
                 break;
             }
 
             // Get the data corresponding to the new segment
-            currentSeg = (vsPathMotionSegment *)
-                (pointList.getEntry(currentSegmentIdx));
+            currentKey = track->getKey(currentSegmentIdx);
 
             // If the new segment has a negative pause time, then go
             // into 'pause indefinitely' mode. Set the current time on the
             // segment to zero, so that the computation step will place
             // the position and orientation at the beginning of this
             // segment.
-            if (currentSeg->getPauseTime() < 0.0)
+            if (currentKey->pauseTime < 0.0)
             {
                 currentPlayMode = VS_PATH_PAUSED;
                 currentSegmentTime = 0.0;
             }
 
-            // Check if we're on the first segment of the path (the part of
-            // the path before the first point), and if we're in RESTART
-            // cycle mode. Since there can't be any actual path to travel
-            // in this case, force the travel time for that segment to be
-            // zero. (There _is_ still a segment there, as there is the
-            // possibility that a delay time can be set there.)
-            if ((currentSegmentIdx == 0) &&
-                (cycleMode == VS_PATH_CYCLE_RESTART))
-            {
-                currentSeg->setTravelTime(0.0);
-            }
-
-            // Calculate the new segment total path time
-            segmentTotalTime = currentSeg->getTravelTime();
-            if (currentSeg->getPauseTime() > 0.0)
-                segmentTotalTime += currentSeg->getPauseTime();
+            // Calculate the new segment total path time (the travel time
+            // is zero for the first segment in RESTART mode)
+            segmentTotalTime = getKeyTravelTime(currentKey,
+                currentSegmentIdx, deltaTime);
+            if (currentKey->pauseTime > 0.0)
+                segmentTotalTime += currentKey->pauseTime;
 
         }
     } // if (currentPlayMode == VS_PATH_PLAYING)
@@ -1112,64 +1233,53 @@ void vsPathMotion::update(double deltaTime)
     // path.
     if(deltaTime >= 0)
     {
-        prevSeg = getSegmentData(currentSegmentIdx - 1);
-        currentSeg = getSegmentData(currentSegmentIdx);
-        nextSeg = getSegmentData(currentSegmentIdx + 1);
-        nextNextSeg = getSegmentData(currentSegmentIdx + 2);
+        prevKey = getKeyData(track, currentSegmentIdx - 1);
+        currentKey = getKeyData(track, currentSegmentIdx);
+        nextKey = getKeyData(track, currentSegmentIdx + 1);
+        nextNextKey = getKeyData(track, currentSegmentIdx + 2);
     }
     // Otherwise, the delta-time is negative, so get the segments as if we're
     // going backwards.
     else
     {
-        prevSeg = getSegmentData(currentSegmentIdx + 1);
-        currentSeg = getSegmentData(currentSegmentIdx);
-        nextSeg = getSegmentData(currentSegmentIdx - 1);
-        nextNextSeg = getSegmentData(currentSegmentIdx - 2);
+        prevKey = getKeyData(track, currentSegmentIdx + 1);
+        currentKey = getKeyData(track, currentSegmentIdx);
+        nextKey = getKeyData(track, currentSegmentIdx - 1);
+        nextNextKey = getKeyData(track, currentSegmentIdx - 2);
     }
 
     // Compute the interpolation parameter, which in this case is the
     // amount of time spent on this segment (minus the pause time, if any)
-    // over the total travel time for the segment.
-    if (currentSeg->getPauseTime() > 0.0)
-        parameter = (currentSegmentTime - currentSeg->getPauseTime()) /
-            currentSeg->getTravelTime();
+    // over the total travel time for the segment.  A segment with no
+    // travel time holds at its start for the key's pause, and is at its
+    // end once the pause is over.
+    segmentTravelTime = getKeyTravelTime(currentKey, currentSegmentIdx,
+        deltaTime);
+    if (segmentTravelTime <= 0.0)
+    {
+        if ((currentKey->pauseTime > 0.0) &&
+            (currentSegmentTime < currentKey->pauseTime))
+            parameter = 0.0;
+        else
+            parameter = 1.0;
+    }
+    else if (currentKey->pauseTime > 0.0)
+        parameter = (currentSegmentTime - currentKey->pauseTime) /
+            segmentTravelTime;
     else
-        parameter = currentSegmentTime / currentSeg->getTravelTime();
+        parameter = currentSegmentTime / segmentTravelTime;
             
     if (parameter < 0.0)
         parameter = 0.0;
     else if (parameter > 1.0)
         parameter = 1.0;
 
-    // Get the positions from the segments
-    if (prevSeg)
-    {
-        prevSegPos = prevSeg->getPosition();
-        prevSegPosPt = &prevSegPos;
-    }
-    else
-        prevSegPosPt = NULL;
-    if (currentSeg)
-    {
-        currentSegPos = currentSeg->getPosition();
-        currentSegPosPt = &currentSegPos;
-    }
-    else
-        currentSegPosPt = NULL;
-    if (nextSeg)
-    {
-        nextSegPos = nextSeg->getPosition();
-        nextSegPosPt = &nextSegPos;
-    }
-    else
-        nextSegPosPt = NULL;
-    if (nextNextSeg)
-    {
-        nextNextSegPos = nextNextSeg->getPosition();
-        nextNextSegPosPt = &nextNextSegPos;
-    }
-    else
-        nextNextSegPosPt = NULL;
+    // Get the positions from the keys (the keys are read-only, so we can
+    // point straight at their data)
+    prevKeyPosPt = (prevKey ? &prevKey->position : NULL);
+    currentKeyPosPt = (currentKey ? &currentKey->position : NULL);
+    nextKeyPosPt = (nextKey ? &nextKey->position : NULL);
+    nextNextKeyPosPt = (nextNextKey ? &nextNextKey->position : NULL);
 
     // Interpolate the position based on the interpolation mode
     switch (posMode)
@@ -1179,50 +1289,26 @@ void vsPathMotion::update(double deltaTime)
             break;
 
         case VS_PATH_POS_IMODE_LINEAR:
-            newPosition = interpolatePosLinear(currentSegPosPt, nextSegPosPt,
+            newPosition = interpolatePosLinear(currentKeyPosPt, nextKeyPosPt,
                 parameter);
             break;
 
         case VS_PATH_POS_IMODE_ROUNDED:
-            newPosition = interpolatePosRoundCorner(prevSegPosPt,
-                currentSegPosPt, nextSegPosPt, nextNextSegPosPt, parameter);
+            newPosition = interpolatePosRoundCorner(prevKeyPosPt,
+                currentKeyPosPt, nextKeyPosPt, nextNextKeyPosPt, parameter);
             break;
 
         case VS_PATH_POS_IMODE_SPLINE:
-            newPosition = interpolatePosSpline(prevSegPosPt, currentSegPosPt,
-                nextSegPosPt, nextNextSegPosPt, parameter);
+            newPosition = interpolatePosSpline(prevKeyPosPt, currentKeyPosPt,
+                nextKeyPosPt, nextNextKeyPosPt, parameter);
             break;
     }
 
-    // Get the orientations from the segments
-    if (prevSeg)
-    {
-        prevSegOri = prevSeg->getOrientation();
-        prevSegOriPt = &prevSegOri;
-    }
-    else
-        prevSegOriPt = NULL;
-    if (currentSeg)
-    {
-        currentSegOri = currentSeg->getOrientation();
-        currentSegOriPt = &currentSegOri;
-    }
-    else
-        currentSegOriPt = NULL;
-    if (nextSeg)
-    {
-        nextSegOri = nextSeg->getOrientation();
-        nextSegOriPt = &nextSegOri;
-    }
-    else
-        nextSegOriPt = NULL;
-    if (nextNextSeg)
-    {
-        nextNextSegOri = nextNextSeg->getOrientation();
-        nextNextSegOriPt = &nextNextSegOri;
-    }
-    else
-        nextNextSegOriPt = NULL;
+    // Get the orientations from the keys
+    prevKeyOriPt = (prevKey ? &prevKey->orientation : NULL);
+    currentKeyOriPt = (currentKey ? &currentKey->orientation : NULL);
+    nextKeyOriPt = (nextKey ? &nextKey->orientation : NULL);
+    nextNextKeyOriPt = (nextNextKey ? &nextNextKey->orientation : NULL);
 
     // Then interpolate the orientation based on the interpolation mode
     switch (oriMode)
@@ -1232,18 +1318,18 @@ void vsPathMotion::update(double deltaTime)
             break;
 
         case VS_PATH_ORI_IMODE_SLERP:
-            newOrientation = interpolateOriSlerp(currentSegOriPt, nextSegOriPt,
+            newOrientation = interpolateOriSlerp(currentKeyOriPt, nextKeyOriPt,
                 parameter);
             break;
 
         case VS_PATH_ORI_IMODE_NLERP:
-            newOrientation = interpolateOriNlerp(currentSegOriPt, nextSegOriPt,
+            newOrientation = interpolateOriNlerp(currentKeyOriPt, nextKeyOriPt,
                 parameter);
             break;
 
         case VS_PATH_ORI_IMODE_SPLINE:
-            newOrientation = interpolateOriSpline(prevSegOriPt, currentSegOriPt,
-                nextSegOriPt, nextNextSegOriPt, parameter);
+            newOrientation = interpolateOriSpline(prevKeyOriPt, currentKeyOriPt,
+                nextKeyOriPt, nextNextKeyOriPt, parameter);
             break;
 
         case VS_PATH_ORI_IMODE_ATPOINT:
@@ -1960,7 +2046,7 @@ atQuat vsPathMotion::quatHalfway(atQuat a, atQuat b, atQuat c)
 
 // ------------------------------------------------------------------------
 // Private function
-// Helper function used by update and autoSetTimes functions
+// Helper function used by the autoSetTimes function
 // ------------------------------------------------------------------------
 vsPathMotionSegment *vsPathMotion::getSegmentData(int idx)
 {
@@ -1983,6 +2069,137 @@ vsPathMotionSegment *vsPathMotion::getSegmentData(int idx)
         (pointList.getEntry((idx + pointCount) % pointCount));
 }
 
+// ------------------------------------------------------------------------
+// Private function
+// Helper function used by the update function.  Returns the compiled key
+// data for the specified point index, handling out-of-bounds indices the
+// same way as getSegmentData()
+// ------------------------------------------------------------------------
+vsPathMotionKey *vsPathMotion::getKeyData(vsPathMotionTrack *track, int idx)
+{
+    // If in-bounds, always return something usable
+    if ((idx >= 0) && (idx < pointCount))
+        return track->getKey(idx);
+
+    // If out-of-bounds and in RESTART mode, return NULL
+    if (cycleMode == VS_PATH_CYCLE_RESTART)
+        return NULL;
+
+    // Out-of-bounds and CLOSED LOOP; wrap around.
+    return track->getKey((idx + pointCount) % pointCount);
+}
+
+// ------------------------------------------------------------------------
+// Private function
+// Returns the travel time of the given key's segment while playing in the
+// given direction.  In RESTART cycle mode, there is no actual path to
+// travel after the last point (or before the first point, when going
+// backwards), so the travel time of that segment is zero.  (There _is_
+// still a segment there, as there is the possibility that a delay time
+// can be set there.)
+// ------------------------------------------------------------------------
+double vsPathMotion::getKeyTravelTime(vsPathMotionKey *key, int idx,
+                                      double deltaTime)
+{
+    if ((cycleMode == VS_PATH_CYCLE_RESTART) &&
+        (((deltaTime >= 0.0) && (idx == (pointCount - 1))) ||
+         ((deltaTime < 0.0) && (idx == 0))))
+        return 0.0;
+
+    return key->travelTime;
+}
+
+// ------------------------------------------------------------------------
+// Private function
+// Makes sure the path has its own editable copy of the key points, and
+// releases the compiled track, since it won't match the points once they
+// are changed
+// ------------------------------------------------------------------------
+void vsPathMotion::makePointListEditable()
+{
+    vsPathMotionSegment *segData;
+    vsPathMotionKey *key;
+    int index;
+
+    // Recreate the segments from the track if we don't have them
+    if (!pointListValid)
+    {
+        for (index = 0; index < pointCount; index++)
+        {
+            // Copy the key into a new segment
+            key = pathTrack->getKey(index);
+            segData = new vsPathMotionSegment();
+            segData->setPosition(key->position);
+            segData->setOrientation(key->orientation);
+            segData->setTravelTime(key->travelTime);
+            segData->setPauseTime(key->pauseTime);
+
+            // Add it to the list
+            pointList.setEntry(index, segData);
+        }
+
+        pointListValid = true;
+    }
+
+    // Release the track
+    if (pathTrack != NULL)
+    {
+        vsObject::unrefDelete(pathTrack);
+        pathTrack = NULL;
+    }
+}
+
+// ------------------------------------------------------------------------
+// Private function
+// Blends the kinematics from the pose it had when the transition started
+// to the first point of the path, and ends the transition once the
+// transition time has passed
+// ------------------------------------------------------------------------
+void vsPathMotion::updateTransition(vsPathMotionTrack *track,
+                                    double deltaTime)
+{
+    vsPathMotionKey *firstKey;
+    double parameter;
+    atVector newPosition;
+    atQuat newOrientation;
+
+    // Only move the transition along while we're playing
+    if ((currentPlayMode == VS_PATH_PLAYING) && (deltaTime > 0.0))
+        transitionElapsed += deltaTime;
+
+    // Compute the blend parameter
+    parameter = transitionElapsed / transitionTime;
+    if (parameter > 1.0)
+        parameter = 1.0;
+
+    // Blend toward the first point of the path (leaving alone anything
+    // the path doesn't interpolate)
+    firstKey = track->getKey(0);
+    if (posMode == VS_PATH_POS_IMODE_NONE)
+        newPosition = objectKin->getPosition();
+    else
+        newPosition = interpolatePosLinear(&transitionStartPos,
+            &firstKey->position, parameter);
+    if (oriMode == VS_PATH_ORI_IMODE_NONE)
+        newOrientation = objectKin->getOrientation();
+    else
+        newOrientation = interpolateOriSlerp(&transitionStartOri,
+            &firstKey->orientation, parameter);
+
+    // Apply the blended pose to the kinematics, and keep a copy of it
+    objectKin->setPosition(newPosition);
+    currentPos = newPosition;
+    if (!AT_EQUAL(newOrientation.getMagnitude(), 0.0))
+    {
+        objectKin->setOrientation(newOrientation);
+        currentOri = newOrientation;
+    }
+
+    // See if the transition is finished
+    if (parameter >= 1.0)
+        transitioning = false;
+}
+
 // ------------------------------------------------------------------------
 // Return the vsKinematics controlled by this path motion
 // ------------------------------------------------------------------------
@@ -29,6 +29,7 @@
 #include "vsKinematics.h++"
 #include "vsMotionModel.h++"
 #include "vsPathMotionSegment.h++"
+#include "vsPathMotionTrack.h++"
 
 #define VS_PATH_WAIT_FOREVER  -1
 #define VS_PATH_CYCLE_FOREVER 0
@@ -87,6 +88,8 @@ private:
 
     int                pointCount;
     vsArray            pointList;
+    bool               pointListValid;
+    vsPathMotionTrack  *pathTrack;
 
     atVector           currentPos;
     atQuat             currentOri;
@@ -96,6 +99,12 @@ private:
     double             totalTime;
     double             totalPathTime;
 
+    bool               transitioning;
+    double             transitionTime;
+    double             transitionElapsed;
+    atVector           transitionStartPos;
+    atQuat             transitionStartOri;
+
     double             calcSegLengthLinear(atVector *vec1, atVector *vec2);
     double             calcSegLengthRoundCorner(atVector *vec0, atVector *vec1,
                                                 atVector *vec2, atVector *vec3);
@@ -127,6 +136,13 @@ private:
     atQuat             quatHalfway(atQuat a, atQuat b, atQuat c);
 
     vsPathMotionSegment    *getSegmentData(int idx);
+    vsPathMotionKey        *getKeyData(vsPathMotionTrack *track, int idx);
+    double                 getKeyTravelTime(vsPathMotionKey *key, int idx,
+                                            double deltaTime);
+
+    void                   makePointListEditable();
+    void                   updateTransition(vsPathMotionTrack *track,
+                                            double deltaTime);
 
 public:
 
@@ -178,6 +194,12 @@ public:
 
     int                   getCurrentSegment();
 
+    void                  startTransition(double seconds);
+    bool                  isTransitioning();
+
+    vsPathMotionTrack     *getTrack();
+    void                  setTrack(vsPathMotionTrack *track);
+
     void                  configureFromFile(char *filename);
 
     virtual void          update();
@@ -37,7 +37,7 @@ vsPathMotionManager::vsPathMotionManager()
     cycleCount = 1;
     currentCycleCount = 0;
 
-    pathMotionSequencer = new vsSequencer();
+    // No path motions yet
     pathMotionCount = 0;
 }
 
@@ -58,8 +58,8 @@ vsPathMotionManager::vsPathMotionManager(vsPathMotionManager *original)
     currentCycleCount = original->currentCycleCount;
    
     // Go through the list of vsPathMotion's in the original manager and
-    // use their copy constructors to make ours.
-    pathMotionSequencer = new vsSequencer();
+    // use their copy constructors to make ours (the copies share the
+    // original path data, so this is cheap)
     pathMotionCount = 0;
     
     // Create all the new vsPathMotion's.
@@ -79,7 +79,7 @@ vsPathMotionManager::vsPathMotionManager(vsPathMotionManager *original)
 //------------------------------------------------------------------------
 vsPathMotionManager::~vsPathMotionManager()
 {
-    delete pathMotionSequencer;
+    // The path motion list unreferences the path motions when it goes away
 }
 
 // ------------------------------------------------------------------------
@@ -103,7 +103,7 @@ void vsPathMotionManager::setCycleMode(int mode)
     for (index = 0; index < pathMotionCount; index++)
     {
         ((vsPathMotion *)
-            pathMotionSequencer->getUpdatable(index))->setCycleMode(cycleMode);
+            pathMotionList.getEntry(index))->setCycleMode(cycleMode);
     }
 }
 
@@ -124,7 +124,7 @@ void vsPathMotionManager::setCycleCount(int cycles)
         for (index = 0; index < pathMotionCount; index++)
         {
             ((vsPathMotion *)
-                pathMotionSequencer->getUpdatable(index))->setCycleCount(
+                pathMotionList.getEntry(index))->setCycleCount(
                 cycles);
         }
     }
@@ -164,7 +164,7 @@ void vsPathMotionManager::startResume()
     for (index = 0; index < pathMotionCount; index++)
     {
         ((vsPathMotion *)
-            pathMotionSequencer->getUpdatable(index))->startResume();
+            pathMotionList.getEntry(index))->startResume();
     }
 }
 
@@ -180,7 +180,7 @@ void vsPathMotionManager::pause()
     // Set all the vsPathMotions to pause.
     for (index = 0; index < pathMotionCount; index++)
     {
-        ((vsPathMotion *) pathMotionSequencer->getUpdatable(index))->pause();
+        ((vsPathMotion *) pathMotionList.getEntry(index))->pause();
     }
 }
 
@@ -196,7 +196,7 @@ void vsPathMotionManager::stop()
     // Set all the vsPathMotions to stop.
     for (index = 0; index < pathMotionCount; index++)
     {
-        ((vsPathMotion *) pathMotionSequencer->getUpdatable(index))->stop();
+        ((vsPathMotion *) pathMotionList.getEntry(index))->stop();
     }
 }
 
@@ -209,11 +209,15 @@ int vsPathMotionManager::getPlayMode()
 }
 
 //------------------------------------------------------------------------
-// Updates the sequencer containing all the vsPathMotion objects.
+// Updates all the vsPathMotion objects.
 //------------------------------------------------------------------------
 void vsPathMotionManager::update()
 {
-    pathMotionSequencer->update();
+    int index;
+
+    // Loop through the list
+    for (index = 0; index < pathMotionCount; index++)
+        ((vsPathMotion *) pathMotionList.getEntry(index))->update();
 }
 
 //------------------------------------------------------------------------
@@ -227,7 +231,7 @@ void vsPathMotionManager::update(double deltaTime)
     for (index = 0; index < pathMotionCount; index++)
     {   
         // Update the path motion with the delta time.
-        ((vsPathMotion *) pathMotionSequencer->getUpdatable(index))->
+        ((vsPathMotion *) pathMotionList.getEntry(index))->
                update(deltaTime);
     }
 }
@@ -237,8 +241,8 @@ void vsPathMotionManager::update(double deltaTime)
 //------------------------------------------------------------------------
 void vsPathMotionManager::addPathMotion(vsPathMotion *pathMotion)
 {
-    pathMotionSequencer->addUpdatable(pathMotion, "");
-    pathMotionCount = pathMotionSequencer->getUpdatableCount();
+    pathMotionList.addEntry(pathMotion);
+    pathMotionCount = pathMotionList.getNumEntries();
 }
 
 //------------------------------------------------------------------------
@@ -246,8 +250,11 @@ void vsPathMotionManager::addPathMotion(vsPathMotion *pathMotion)
 //------------------------------------------------------------------------
 void vsPathMotionManager::removePathMotion(vsPathMotion *pathMotion)
 {
-    pathMotionSequencer->removeUpdatable(pathMotion);
-    pathMotionCount = pathMotionSequencer->getUpdatableCount();
+    // Remove the path motion, or complain if we don't have it
+    if (!pathMotionList.removeEntry(pathMotion))
+        printf("vsPathMotionManager::removePathMotion: Path motion not "
+            "found!\n");
+    pathMotionCount = pathMotionList.getNumEntries();
 }
 
 //------------------------------------------------------------------------
@@ -255,7 +262,7 @@ void vsPathMotionManager::removePathMotion(vsPathMotion *pathMotion)
 //------------------------------------------------------------------------
 vsPathMotion *vsPathMotionManager::getPathMotion(int index)
 {
-    return ((vsPathMotion *) pathMotionSequencer->getUpdatable(index));
+    return ((vsPathMotion *) pathMotionList.getEntry(index));
 }
 
 //------------------------------------------------------------------------
@@ -278,7 +285,7 @@ bool vsPathMotionManager::isDone()
     {
         // If this path motion is still continuing, then the path motion as a
         // whole is still going, and therefore this group is not done yet.
-        if (((vsPathMotion *) pathMotionSequencer->getUpdatable(index))->
+        if (((vsPathMotion *) pathMotionList.getEntry(index))->
                getPlayMode() != VS_PATH_STOPPED)
         {
             return false;
@@ -289,3 +296,42 @@ bool vsPathMotionManager::isDone()
     // PathMotion's is finished.
     return true;
 }
+
+//------------------------------------------------------------------------
+// Starts a smooth transition into this group of path motions from the
+// current pose of their kinematics.  Each path motion blends to its first
+// point over the given number of seconds, then plays normally.
+//------------------------------------------------------------------------
+void vsPathMotionManager::startTransition(double seconds)
+{
+    int index;
+
+    // Start the transition on each path motion
+    for (index = 0; index < pathMotionCount; index++)
+    {
+        ((vsPathMotion *) pathMotionList.getEntry(index))->
+               startTransition(seconds);
+    }
+}
+
+//------------------------------------------------------------------------
+// Check whether any of the PathMotion's are still transitioning in.
+//------------------------------------------------------------------------
+bool vsPathMotionManager::isTransitioning()
+{
+    int index;
+
+    // Loop through the list
+    for (index = 0; index < pathMotionCount; index++)
+    {
+        // If any path motion is still transitioning, the group is
+        if (((vsPathMotion *) pathMotionList.getEntry(index))->
+               isTransitioning())
+        {
+            return true;
+        }
+    }
+
+    // None of the path motions are transitioning
+    return false;
+}
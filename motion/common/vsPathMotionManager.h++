@@ -25,7 +25,7 @@
 
 #include "vsUpdatable.h++"
 #include "vsPathMotion.h++"
-#include "vsSequencer.h++"
+#include "vsArray.h++"
 
 class VESS_SYM vsPathMotionManager : public vsUpdatable
 {
@@ -37,7 +37,7 @@ private:
     int                cycleCount;
     int                currentCycleCount;
 
-    vsSequencer        *pathMotionSequencer;
+    vsArray            pathMotionList;
     int                pathMotionCount;
 
 public:
@@ -59,6 +59,9 @@ public:
     int                   getPlayMode();
     bool                  isDone();
 
+    void                  startTransition(double seconds);
+    bool                  isTransitioning();
+
     virtual void          update();
     virtual void          update(double deltaTime);
 
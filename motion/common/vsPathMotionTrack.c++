@@ -0,0 +1,119 @@
+//------------------------------------------------------------------------
+//
+//    VIRTUAL ENVIRONMENT SOFTWARE SANDBOX (VESS)
+//
+//    Copyright (c) 2001, University of Central Florida
+//
+//       See the file LICENSE for license information
+//
+//    E-mail:  vess@ist.ucf.edu
+//    WWW:     http://vess.ist.ucf.edu/
+//
+//------------------------------------------------------------------------
+//
+//    VESS Module:  vsPathMotionTrack.c++
+//
+//    Description:  Read-only, compiled copy of the key points of a
+//                  vsPathMotion path, stored contiguously so that it can
+//                  be shared by all copies of the path
+//
+//    Author(s):    agent
+//
+//------------------------------------------------------------------------
+
+#include "vsPathMotionTrack.h++"
+#include "vsPathMotionSegment.h++"
+
+// ------------------------------------------------------------------------
+// Constructor.  Copies the data from the given list of path segments.
+// The track can't be changed after this.
+// ------------------------------------------------------------------------
+vsPathMotionTrack::vsPathMotionTrack(vsArray *segmentList, int segmentCount)
+{
+    vsPathMotionSegment *segment;
+    int i;
+
+    // Allocate the keys
+    keyCount = segmentCount;
+    if (keyCount > 0)
+        keyList = new vsPathMotionKey[keyCount];
+    else
+        keyList = NULL;
+
+    // Copy each segment's data
+    for (i = 0; i < keyCount; i++)
+    {
+        segment = (vsPathMotionSegment *)segmentList->getEntry(i);
+        if (segment != NULL)
+        {
+            keyList[i].position = segment->getPosition();
+            keyList[i].orientation = segment->getOrientation();
+            keyList[i].travelTime = segment->getTravelTime();
+            keyList[i].pauseTime = segment->getPauseTime();
+        }
+        else
+        {
+            // Use the same defaults as a new segment
+            keyList[i].position.set(0.0, 0.0, 0.0);
+            keyList[i].orientation.set(0.0, 0.0, 0.0, 1.0);
+            keyList[i].travelTime = 0.0;
+            keyList[i].pauseTime = 0.0;
+        }
+    }
+}
+
+// ------------------------------------------------------------------------
+// Constructor.  Copies the given list of key points.
+// ------------------------------------------------------------------------
+vsPathMotionTrack::vsPathMotionTrack(vsPathMotionKey *keys, int count)
+{
+    int i;
+
+    // Allocate the keys
+    keyCount = count;
+    if (keyCount > 0)
+        keyList = new vsPathMotionKey[keyCount];
+    else
+        keyList = NULL;
+
+    // Copy the keys
+    for (i = 0; i < keyCount; i++)
+        keyList[i] = keys[i];
+}
+
+// ------------------------------------------------------------------------
+// Destructor
+// ------------------------------------------------------------------------
+vsPathMotionTrack::~vsPathMotionTrack()
+{
+    if (keyList != NULL)
+        delete [] keyList;
+}
+
+// ------------------------------------------------------------------------
+// Gets a string representation of this object's class name
+// ------------------------------------------------------------------------
+const char *vsPathMotionTrack::getClassName()
+{
+    return "vsPathMotionTrack";
+}
+
+// ------------------------------------------------------------------------
+// Returns the number of key points in the track
+// ------------------------------------------------------------------------
+int vsPathMotionTrack::getKeyCount()
+{
+    return keyCount;
+}
+
+// ------------------------------------------------------------------------
+// Returns the key point at the given index, or NULL if the index is out
+// of bounds.  The key must not be modified.
+// ------------------------------------------------------------------------
+vsPathMotionKey *vsPathMotionTrack::getKey(int index)
+{
+    if ((index < 0) || (index >= keyCount))
+        return NULL;
+
+    return &keyList[index];
+}
@@ -0,0 +1,61 @@
+//------------------------------------------------------------------------
+//
+//    VIRTUAL ENVIRONMENT SOFTWARE SANDBOX (VESS)
+//
+//    Copyright (c) 2001, University of Central Florida
+//
+//       See the file LICENSE for license information
+//
+//    E-mail:  vess@ist.ucf.edu
+//    WWW:     http://vess.ist.ucf.edu/
+//
+//------------------------------------------------------------------------
+//
+//    VESS Module:  vsPathMotionTrack.h++
+//
+//    Description:  Read-only, compiled copy of the key points of a
+//                  vsPathMotion path, stored contiguously so that it can
+//                  be shared by all copies of the path
+//
+//    Author(s):    agent
+//
+//------------------------------------------------------------------------
+
+#ifndef VS_PATH_MOTION_TRACK_HPP
+#define VS_PATH_MOTION_TRACK_HPP
+
+#include "vsObject.h++"
+#include "vsArray.h++"
+#include "atVector.h++"
+#include "atQuat.h++"
+
+struct VESS_SYM vsPathMotionKey
+{
+    atVector    position;
+    atQuat      orientation;
+    double      travelTime;
+    double      pauseTime;
+};
+
+class VESS_SYM vsPathMotionTrack : public vsObject
+{
+private:
+
+    vsPathMotionKey       *keyList;
+    int                   keyCount;
+
+public:
+
+                          vsPathMotionTrack(vsArray *segmentList,
+                                            int segmentCount);
+                          vsPathMotionTrack(vsPathMotionKey *keys,
+                                            int count);
+    virtual               ~vsPathMotionTrack();
+
+    virtual const char    *getClassName();
+
+    int                   getKeyCount();
+    vsPathMotionKey       *getKey(int index);
+};
+
+#endif
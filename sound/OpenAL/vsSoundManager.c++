@@ -22,7 +22,9 @@
 //------------------------------------------------------------------------
 
 #include "vsSoundManager.h++"
+#include "vsAtomic.h++"
 #include "atTimer.h++"
+#include <sched.h>
 
 // Static instance variable
 vsSoundManager *vsSoundManager::instance = NULL;
@@ -33,33 +35,44 @@ vsSoundManager *vsSoundManager::instance = NULL;
 // ------------------------------------------------------------------------
 vsSoundManager::vsSoundManager()
 {
-    int i;
-
     // Initialize the soundPipe pointer to NULL
     soundPipe = NULL;
     
     // Initialize the soundListener pointer to NULL
     soundListener = NULL;
 
-    // Inintialize the sound source counter and array
+    // Create the list of sound sources (it grows as needed)
     numSoundSources = 0;
-    memset(soundSources, 0, sizeof(soundSources));
+    soundSourceListSize = VS_SDM_INITIAL_SOUNDS;
+    soundSources = (vsSoundSourceListItem *)
+        calloc(soundSourceListSize, sizeof(vsSoundSourceListItem));
 
     // Initialize the voice counter and array
     numVoices = 0;
     memset(voices, 0, sizeof(voices));
 
-    // Create the list of sound sources
-    for (i = 0; i < VS_SDM_MAX_SOUNDS; i++)
-    {
-        soundSources[i] = new vsSoundSourceListItem;
-        soundSources[i]->source = NULL;
-        soundSources[i]->gain = 0.0;
-    }
-    
-    // Create a mutex to synchronize traversals of the sound source list
-    // between threads
-    pthread_mutex_init(&sourceListMutex, NULL);
+    // Start with the default culling gain
+    cullGain = VS_SDM_DEFAULT_CULL_GAIN;
+
+    // Create the source thread's copy of the source list, and the (empty)
+    // queue of commands that keeps it in step with the main list
+    numThreadSources = 0;
+    threadSourceListSize = VS_SDM_INITIAL_SOUNDS;
+    threadSources = (vsSoundSourceAttribute **)
+        calloc(threadSourceListSize, sizeof(vsSoundSourceAttribute *));
+    threadActiveSource = NULL;
+    commandHead = 0;
+    commandTail = 0;
+
+    // The overflow list for the command queue is only created if the
+    // queue ever fills up
+    overflowCommands = NULL;
+    numOverflowCommands = 0;
+    overflowListSize = 0;
+    pthread_mutex_init(&overflowMutex, NULL);
+
+    // Set the source thread update rate to the default
+    setSourceUpdateRate(VS_SDM_SOURCE_THREAD_HZ);
 
     // Create a separate thread to asynchronously handle some of the sound
     // operations.  The main thread will be responsible for voice 
@@ -68,9 +81,6 @@ vsSoundManager::vsSoundManager()
     // updates, and playback state).
     sourceThreadDone = false;
     pthread_create(&sourceThread, NULL, sourceThreadFunc, (void *)this);
-
-    // Set the source thread update rate to the default
-    setSourceUpdateRate(VS_SDM_SOURCE_THREAD_HZ);
 }
 
 // ------------------------------------------------------------------------
@@ -82,7 +92,15 @@ vsSoundManager::~vsSoundManager()
     // Wait for the worker thread to terminate
     sourceThreadDone = true;
     pthread_join(sourceThread, NULL);
-    pthread_mutex_destroy(&sourceListMutex);
+
+    // Free the source lists
+    free(soundSources);
+    free(threadSources);
+
+    // Free the command overflow list and its mutex
+    if (overflowCommands != NULL)
+        free(overflowCommands);
+    pthread_mutex_destroy(&overflowMutex);
 
     // Reset the static instance variable to NULL
     instance = NULL;
@@ -94,6 +112,7 @@ vsSoundManager::~vsSoundManager()
 void *vsSoundManager::sourceThreadFunc(void *arg)
 {
     vsSoundManager *manager;
+    vsSoundSourceAttribute *source;
     int i;
     unsigned long threadTime;
     atTimer threadTimer;
@@ -109,29 +128,53 @@ void *vsSoundManager::sourceThreadFunc(void *arg)
         // Mark the thread timer to start measuring time for this loop
         threadTimer.mark();
 
-        // Acquire the source list mutex to keep the main thread from
-        // changing the source list around while we're traversing it
-        pthread_mutex_lock(&manager->sourceListMutex);
+        // Pick up any changes the main thread made to the source list
+        manager->processCommands();
 
-        // Iterate over the sound sources that we know about
-        for (i = 0; i < manager->numSoundSources; i++)
+        // Iterate over the sound sources that we know about.  The main
+        // thread never waits on this loop, except when it removes the one
+        // source we're updating at that moment.
+        i = 0;
+        while (i < manager->numThreadSources)
         {
+            // Announce which source we're about to update, then check for
+            // new commands.  Either we see a removal of this source that
+            // the main thread posted, or the main thread sees that we're
+            // working on the source and waits for us to finish with it
+            // (both sides issue a full barrier in between)
+            source = manager->threadSources[i];
+            manager->threadActiveSource = source;
+            vsMemoryBarrier();
+            if ((manager->commandHead !=
+                    vsAtomicLoad(&manager->commandTail)) ||
+                (vsAtomicLoad(&manager->numOverflowCommands) > 0))
+            {
+                // Stand down and bring the list up to date, then try this
+                // position again (it may hold a different source now)
+                manager->threadActiveSource = NULL;
+                vsMemoryBarrier();
+                manager->processCommands();
+                continue;
+            }
+
             // See if this source is a streaming source or not
-            if (manager->soundSources[i]->source->isStreaming())
+            if (source->isStreaming())
             {
                 // Update the sources streaming buffer (this implicitly
                 // deals with the playback state of the source as well)
-                manager->soundSources[i]->source->updateStream();
+                source->updateStream();
             }
             else
             {
                 // Just update the source's playback state
-                manager->soundSources[i]->source->updatePlayState();
+                source->updatePlayState();
             }
-        }
 
-        // Release the source list mutex
-        pthread_mutex_unlock(&manager->sourceListMutex);
+            // We're done with this source
+            vsMemoryBarrier();
+            manager->threadActiveSource = NULL;
+            i++;
+        }
 
         // Get the elapsed time for this loop in microseconds
         threadTime = (unsigned long)
@@ -146,108 +189,286 @@ void *vsSoundManager::sourceThreadFunc(void *arg)
 }
 
 // ------------------------------------------------------------------------
-// Protected function.  Sort the sound sources by play state, then by
-// priority, then by effective gain.  The sources will then be assigned
-// voices in list order.
+// Protected function.  Passes a change to the source list from the main
+// thread to the source thread.  The command queue has one writer (the
+// main thread) and one reader (the source thread), so no locking is
+// needed.  If the queue is full, the command goes on the overflow list
+// instead (and so do all commands after it, until the source thread
+// empties the list), so this never waits for the source thread.
+// ------------------------------------------------------------------------
+void vsSoundManager::postCommand(int commandType,
+                                 vsSoundSourceAttribute *src)
+{
+    int tail;
+
+    // If there's room in the queue, and nothing is waiting on the overflow
+    // list (which would have to be handled first), queue the command
+    tail = commandTail;
+    if ((vsAtomicLoad(&numOverflowCommands) == 0) &&
+        (tail - vsAtomicLoad(&commandHead) < VS_SDM_COMMAND_QUEUE_SIZE))
+    {
+        // Fill in the command
+        commandQueue[tail & (VS_SDM_COMMAND_QUEUE_SIZE - 1)].commandType =
+            commandType;
+        commandQueue[tail & (VS_SDM_COMMAND_QUEUE_SIZE - 1)].source = src;
+
+        // Publish it (the atomic add is also a full barrier)
+        vsAtomicAdd(&commandTail, 1);
+        return;
+    }
+
+    // Otherwise, add the command to the overflow list
+    pthread_mutex_lock(&overflowMutex);
+
+    // Make room for the command, if necessary
+    if (numOverflowCommands >= overflowListSize)
+    {
+        if (overflowListSize == 0)
+            overflowListSize = VS_SDM_COMMAND_QUEUE_SIZE;
+        else
+            overflowListSize *= 2;
+        overflowCommands = (vsSoundManagerCommand *)
+            realloc(overflowCommands,
+                overflowListSize * sizeof(vsSoundManagerCommand));
+    }
+
+    // Fill in the command and publish it (the atomic add is also a full
+    // barrier)
+    overflowCommands[numOverflowCommands].commandType = commandType;
+    overflowCommands[numOverflowCommands].source = src;
+    vsAtomicAdd(&numOverflowCommands, 1);
+
+    pthread_mutex_unlock(&overflowMutex);
+}
+
+// ------------------------------------------------------------------------
+// Protected function.  Called by the source thread to apply the commands
+// that the main thread has posted to the thread's list of sources.
 // ------------------------------------------------------------------------
-void vsSoundManager::sortSources()
+void vsSoundManager::processCommands()
 {
-    int i, numPass;
-    bool exch;
-    bool playing1, playing2;
-    int priority1, priority2;
-    vsSoundSourceListItem *tempSrc;
-    atVector listenerPos;
-
-    // Get the listener's position (for gain computation)
-    listenerPos = soundListener->getLastPosition();
-
-    // Acquire the source list mutex, since we're going to be changing the 
-    // source list around in the sort
-    pthread_mutex_lock(&sourceListMutex);
-
-    // Clear the source gains array to -1 (sourceGain[i] < 0 indicates
-    // that we haven't computed source i's gain yet)
-    for (i = 0; i < VS_SDM_MAX_SOUNDS; i++)
+    int i;
+
+    // Handle every command in the queue
+    processQueuedCommands();
+
+    // Handle any commands that overflowed the queue
+    if (vsAtomicLoad(&numOverflowCommands) > 0)
     {
-        soundSources[i]->gain = -1.0;
+        pthread_mutex_lock(&overflowMutex);
+
+        // Commands queued before the overflowed ones may have been posted
+        // since we last looked, so check the queue again before going on
+        processQueuedCommands();
+
+        // Handle the overflowed commands in order, and empty the list
+        for (i = 0; i < numOverflowCommands; i++)
+            applyCommand(&overflowCommands[i]);
+        vsMemoryBarrier();
+        numOverflowCommands = 0;
+
+        pthread_mutex_unlock(&overflowMutex);
     }
+}
 
-    // Bubble sort the sources, using all sort keys simultaneously.  This
-    // takes advantage of the fact that the sources' states will change
-    // little over each frame.
-    numPass = numSoundSources - 1;
-    exch = true;
+// ------------------------------------------------------------------------
+// Protected function.  Called by the source thread to apply the commands
+// in the command queue.
+// ------------------------------------------------------------------------
+void vsSoundManager::processQueuedCommands()
+{
+    int head, tail;
 
-    // Repeat until the list is sorted
-    while (exch)
+    // Handle every command posted so far
+    head = commandHead;
+    tail = vsAtomicLoad(&commandTail);
+    while (head != tail)
     {
-        // First, flag that we haven't made a change on this pass yet
-        exch = false;
+        applyCommand(&commandQueue[head & (VS_SDM_COMMAND_QUEUE_SIZE - 1)]);
+        head++;
+    }
+
+    // Release the queue entries we've used
+    vsMemoryBarrier();
+    commandHead = head;
+}
 
-        // Compare each contiguous pair of sources
-        for (i = 0; i < numPass; i++)
+// ------------------------------------------------------------------------
+// Protected function.  Applies one command to the source thread's list of
+// sources.
+// ------------------------------------------------------------------------
+void vsSoundManager::applyCommand(vsSoundManagerCommand *command)
+{
+    int i;
+
+    if (command->commandType == VS_SDM_COMMAND_ADD_SOURCE)
+    {
+        // Make room for the source, if necessary
+        if (numThreadSources >= threadSourceListSize)
         {
-            // See if the sources are playing
-            playing1 = soundSources[i]->source->isPlaying();
-            playing2 = soundSources[i+1]->source->isPlaying();
+            threadSourceListSize *= 2;
+            threadSources = (vsSoundSourceAttribute **)
+                realloc(threadSources, threadSourceListSize *
+                    sizeof(vsSoundSourceAttribute *));
+        }
 
-            // If only one source is playing, make sure it comes before
-            // the other source in the list
-            if (!playing1 && playing2)
-            {
-                tempSrc = soundSources[i];
-                soundSources[i] = soundSources[i+1];
-                soundSources[i+1] = tempSrc;
-                exch = true;
-            }
-            else if (playing1 == playing2)
-            {
-                // Get the priorities of the two sources
-                priority1 = soundSources[i]->source->getPriority();
-                priority2 = soundSources[i+1]->source->getPriority();
+        // Add the source to the end of the list
+        threadSources[numThreadSources] = command->source;
+        numThreadSources++;
+    }
+    else
+    {
+        // Find the source in the list
+        i = 0;
+        while ((i < numThreadSources) &&
+               (threadSources[i] != command->source))
+            i++;
 
-                // Swap the sources if the priorities are out of order
-                if (priority1 < priority2)
-                {
-                    tempSrc = soundSources[i];
-                    soundSources[i] = soundSources[i+1];
-                    soundSources[i+1] = tempSrc;
-                    exch = true;
-                }
-                else if (priority1 == priority2)
-                {
-                    // Get the effective gains of each source.  Use the
-                    // gains we've already computed, so we only compute the
-                    // gain for each source once.
-                    if (soundSources[i]->gain < 0.0)
-                        soundSources[i]->gain = soundSources[i]->source->
-                            getEffectiveGain(listenerPos);
-
-                    if (soundSources[i+1]->gain < 0.0)
-                        soundSources[i+1]->gain = soundSources[i+1]->source->
-                            getEffectiveGain(listenerPos);
-
-                    // Swap the sources if the first source is quieter than
-                    // the second
-                    if (soundSources[i]->gain < soundSources[i+1]->gain)
-                    {
-                        tempSrc = soundSources[i];
-                        soundSources[i] = soundSources[i+1];
-                        soundSources[i+1] = tempSrc;
-                        exch = true;
-                    }
-                }
-            }
+        // Remove it by moving the last source into its place (the order of
+        // this list doesn't matter)
+        if (i < numThreadSources)
+        {
+            numThreadSources--;
+            threadSources[i] = threadSources[numThreadSources];
         }
+    }
+}
+
+// ------------------------------------------------------------------------
+// Protected function.  Gathers the sort keys for voice management from
+// all sources in one pass.  The effective gain is only computed for
+// sources that are playing, and playing sources that are too quiet to
+// hear at the listener's position are culled (marked inaudible), unless
+// they're ALWAYS_ON.
+// ------------------------------------------------------------------------
+void vsSoundManager::computeSourceGains(atVector listenerPos)
+{
+    vsSoundSourceListItem *item;
+    int i;
+
+    for (i = 0; i < numSoundSources; i++)
+    {
+        item = &soundSources[i];
+
+        // Get the source's priority
+        item->priority = item->source->getPriority();
 
-        // Reduce the length of list considered for the next pass, because
-        // we know that the numPass'th element is in it's proper place
-        numPass--;
+        // Only playing sources need voices
+        if (item->source->isPlaying())
+        {
+            // Compute the source's gain at the listener, and see if it's
+            // loud enough to bother with
+            item->gain = item->source->getEffectiveGain(listenerPos);
+            item->audible = ((item->gain >= cullGain) ||
+                (item->priority == VS_SSRC_PRIORITY_ALWAYS_ON));
+        }
+        else
+        {
+            // Stopped sources sort to the end
+            item->gain = -1.0;
+            item->audible = false;
+        }
     }
+}
+
+// ------------------------------------------------------------------------
+// Static protected function.  Returns whether source 'a' is more deserving
+// of a voice than source 'b', ordering by audibility (play state and
+// culling), then by priority, then by effective gain
+// ------------------------------------------------------------------------
+bool vsSoundManager::isSourceAhead(vsSoundSourceListItem *a,
+                                   vsSoundSourceListItem *b)
+{
+    // Audible sources come first
+    if (a->audible != b->audible)
+        return a->audible;
+
+    // Then higher priorities
+    if (a->priority != b->priority)
+        return (a->priority > b->priority);
+
+    // Then louder sources
+    return (a->gain > b->gain);
+}
+
+// ------------------------------------------------------------------------
+// Protected function.  Partially orders the source list so that the
+// 'count' sources most deserving of a voice come first (in no particular
+// order among themselves).  This is a quickselect, so it takes linear
+// time on average, no matter how many sources there are.
+// ------------------------------------------------------------------------
+void vsSoundManager::selectSources(int count)
+{
+    vsSoundSourceListItem pivot;
+    vsSoundSourceListItem temp;
+    int target;
+    int left, right, mid;
+    int i, j;
+
+    // If every source fits (or none do), there's nothing to select
+    if ((count <= 0) || (count >= numSoundSources))
+        return;
+
+    // We want the source that belongs at position count - 1 in fully
+    // sorted order, with everything ahead of it before it
+    target = count - 1;
+    left = 0;
+    right = numSoundSources - 1;
+    while (left < right)
+    {
+        // Use the median of the first, middle, and last sources as the
+        // pivot, to avoid poor splits on lists that are already mostly in
+        // order (the common case from frame to frame)
+        mid = (left + right) / 2;
+        if (isSourceAhead(&soundSources[mid], &soundSources[left]))
+        {
+            temp = soundSources[mid];
+            soundSources[mid] = soundSources[left];
+            soundSources[left] = temp;
+        }
+        if (isSourceAhead(&soundSources[right], &soundSources[left]))
+        {
+            temp = soundSources[right];
+            soundSources[right] = soundSources[left];
+            soundSources[left] = temp;
+        }
+        if (isSourceAhead(&soundSources[right], &soundSources[mid]))
+        {
+            temp = soundSources[right];
+            soundSources[right] = soundSources[mid];
+            soundSources[mid] = temp;
+        }
+        pivot = soundSources[mid];
+
+        // Partition the range around the pivot
+        i = left;
+        j = right;
+        while (i <= j)
+        {
+            while (isSourceAhead(&soundSources[i], &pivot))
+                i++;
+            while (isSourceAhead(&pivot, &soundSources[j]))
+                j--;
+
+            if (i <= j)
+            {
+                temp = soundSources[i];
+                soundSources[i] = soundSources[j];
+                soundSources[j] = temp;
+                i++;
+                j--;
+            }
+        }
 
-    // Release the source list mutex
-    pthread_mutex_unlock(&sourceListMutex);
+        // Continue with whichever side holds the target position (if it's
+        // in neither, it's already in its final place)
+        if (target <= j)
+            right = j;
+        else if (target >= i)
+            left = i;
+        else
+            break;
+    }
 }
 
 // ------------------------------------------------------------------------
@@ -279,9 +500,6 @@ void vsSoundManager::setSoundPipe(vsSoundPipe *pipe)
     soundPipe = pipe;
     soundPipe->ref();
 
-    // Lock the source list mutex
-    pthread_mutex_lock(&sourceListMutex);
-
     // Determine the hardware voice limit by generating OpenAL voices
     // until OpenAL signals an error
     alError = false;
@@ -311,9 +529,6 @@ void vsSoundManager::setSoundPipe(vsSoundPipe *pipe)
         alDeleteSources(numVoices - voiceLimit, (ALuint *)&voices[voiceLimit]);
         numVoices = voiceLimit;
     }
-
-    // Release the source list mutex
-    pthread_mutex_unlock(&sourceListMutex);
 }
 
 // ------------------------------------------------------------------------
@@ -353,13 +568,23 @@ void vsSoundManager::removeSoundPipe(vsSoundPipe *pipe)
 // ------------------------------------------------------------------------
 void vsSoundManager::addSoundSource(vsSoundSourceAttribute *attr)
 {
-    // Acquire the source list mutex to make sure the worker thread isn't
-    // traversing the source list while we're altering it
-    pthread_mutex_lock(&sourceListMutex);
+    vsSoundSourceListItem *item;
+
+    // Make room for the source, if necessary
+    if (numSoundSources >= soundSourceListSize)
+    {
+        soundSourceListSize *= 2;
+        soundSources = (vsSoundSourceListItem *)realloc(soundSources,
+            soundSourceListSize * sizeof(vsSoundSourceListItem));
+    }
 
     // Add the sound source to the sources array and reference it
-    soundSources[numSoundSources]->source = attr;
-    soundSources[numSoundSources]->source->ref();
+    item = &soundSources[numSoundSources];
+    item->source = attr;
+    item->source->ref();
+    item->gain = 0.0;
+    item->priority = VS_SSRC_PRIORITY_NORMAL;
+    item->audible = false;
 
     // If we have a free voice available for the source, go ahead and
     // assign it one
@@ -369,84 +594,73 @@ void vsSoundManager::addSoundSource(vsSoundSourceAttribute *attr)
         numVoices--;
        
         // Assign the voice to the sound source
-        soundSources[numSoundSources]->source->
-            assignVoice(voices[numVoices]);
+        item->source->assignVoice(voices[numVoices]);
     }
 
     // Increment the number of sources
     numSoundSources++;
 
-    // Release the source list mutex
-    pthread_mutex_unlock(&sourceListMutex);
+    // Let the worker thread know about the new source
+    postCommand(VS_SDM_COMMAND_ADD_SOURCE, attr);
 }
 
 // ------------------------------------------------------------------------
-// Removes a vsSoundSourceAttribute from the manager
+// Removes a vsSoundSourceAttribute from the manager.  This is called as
+// the attribute is being destroyed, so it doesn't return until the worker
+// thread is guaranteed not to touch the attribute again.
 // ------------------------------------------------------------------------
 void vsSoundManager::removeSoundSource(vsSoundSourceAttribute *attr)
 {
-    int attrIndex, i;
-    vsSoundSourceListItem *deletedItem;
+    int attrIndex;
+    vsSoundSourceListItem *item;
 
     // Find the sound source in the array
     attrIndex = 0;
     while ((attrIndex < numSoundSources) && 
-        (soundSources[attrIndex]->source != attr))
+        (soundSources[attrIndex].source != attr))
     {
         attrIndex++;
     }
 
-    // If we found the attribute, remove it from the array
-    if (attrIndex < numSoundSources)
-    {
-        // Acquire the source list mutex to make sure the worker thread isn't
-        // traversing the source list while we're altering it
-        pthread_mutex_lock(&sourceListMutex);
-
-        // If the source is active, free up it's voice so other sources
-        // can use it
-        if (soundSources[attrIndex]->source->isActive())
-        {
-            // Lock the source before we take its voice away
-            soundSources[attrIndex]->source->lockSource();
+    // If we didn't find the attribute, there's nothing to do
+    if (attrIndex >= numSoundSources)
+        return;
 
-            // Get the source's voice ID and return it to the list of
-            // available voices
-            voices[numVoices] = soundSources[attrIndex]->source->getVoiceID();
-            numVoices++;
+    // If the source is active, free up it's voice so other sources
+    // can use it
+    item = &soundSources[attrIndex];
+    if (item->source->isActive())
+    {
+        // Lock the source before we take its voice away
+        item->source->lockSource();
 
-            // Revoke the source's voice ID
-            soundSources[attrIndex]->source->revokeVoice();
+        // Get the source's voice ID and return it to the list of
+        // available voices
+        voices[numVoices] = item->source->getVoiceID();
+        numVoices++;
 
-            // Release the source's lock
-            soundSources[attrIndex]->source->unlockSource();
-        }
+        // Revoke the source's voice ID
+        item->source->revokeVoice();
 
-        // Unreference the attribute
-        soundSources[attrIndex]->source->unref();
-
-        // Clear the data in the deleted list item
-        deletedItem = soundSources[attrIndex];
-        deletedItem->source = NULL;
-        deletedItem->gain = 0.0;
-        
-        // Decrement the number of sound sources in the list
-        numSoundSources--;
-        
-        // Slide the remaining list members down into the deleted item's
-        // place
-        for (i = attrIndex; i < numSoundSources; i++)
-        {
-            soundSources[i] = soundSources[i+1];
-        }
-        
-        // Finally, recycle the deleted sound source list item, by
-        // putting the deleted item back at the end of the list.
-        soundSources[numSoundSources] = deletedItem;
-
-        // Release the source list mutex
-        pthread_mutex_unlock(&sourceListMutex);
+        // Release the source's lock
+        item->source->unlockSource();
     }
+
+    // Unreference the attribute
+    item->source->unref();
+
+    // Remove the item by moving the last item into its place (the list
+    // is reordered for voice management every frame anyway)
+    numSoundSources--;
+    soundSources[attrIndex] = soundSources[numSoundSources];
+
+    // Tell the worker thread to drop the source, then wait until it isn't
+    // updating it.  Once the thread sees the command, it won't start
+    // updating the source again, so this wait is at most one source
+    // update long.
+    postCommand(VS_SDM_COMMAND_REMOVE_SOURCE, attr);
+    while (threadActiveSource == attr)
+        sched_yield();
 }
 
 // ------------------------------------------------------------------------
@@ -615,14 +829,14 @@ void vsSoundManager::setVoiceLimit(int newLimit)
             {
                 // See if the source is active (has a voice we can
                 // take)
-                if (soundSources[i]->source->isActive())
+                if (soundSources[i].source->isActive())
                 {
                     // Lock the source before we take it's voice away
-                    soundSources[i]->source->lockSource();
+                    soundSources[i].source->lockSource();
             
                     // Revoke the source's voice and delete it
-                    nextVoice = soundSources[i]->source->getVoiceID();
-                    soundSources[i]->source->revokeVoice();
+                    nextVoice = soundSources[i].source->getVoiceID();
+                    soundSources[i].source->revokeVoice();
                     alDeleteSources(1, &nextVoice);
 
                     // Make sure it was really deleted
@@ -630,7 +844,7 @@ void vsSoundManager::setVoiceLimit(int newLimit)
                         difference++;
 
                     // Release the source lock
-                    soundSources[i]->source->unlockSource();
+                    soundSources[i].source->unlockSource();
                 }
 
                 // Move to the next source
@@ -670,6 +884,33 @@ int vsSoundManager::getSourceUpdateRate()
     return (int)(1.0 / ((double)threadDelay / 1.0e6)) ;
 }
 
+// ------------------------------------------------------------------------
+// Sets the gain below which a playing source is considered inaudible at
+// the listener's position.  Inaudible sources aren't given voices (their
+// playback is emulated instead, as for any other swapped-out source),
+// unless they have ALWAYS_ON priority.  A gain of zero disables culling.
+// ------------------------------------------------------------------------
+void vsSoundManager::setCullingGain(double gain)
+{
+    // Negative gains make no sense
+    if (gain < 0.0)
+    {
+        printf("vsSoundManager::setCullingGain:  Culling gain must be 0 or "
+            "greater!\n");
+        gain = 0.0;
+    }
+
+    cullGain = gain;
+}
+
+// ------------------------------------------------------------------------
+// Returns the gain below which a playing source is considered inaudible
+// ------------------------------------------------------------------------
+double vsSoundManager::getCullingGain()
+{
+    return cullGain;
+}
+
 // ------------------------------------------------------------------------
 // Update all sources and the listener
 // ------------------------------------------------------------------------
@@ -687,7 +928,7 @@ void vsSoundManager::update()
     for (i = 0; i < numSoundSources; i++)
     {
         // Update the source (position, velocity, orientation)
-        soundSources[i]->source->update();
+        soundSources[i].source->update();
     }
 
     // Perform voice management.  If a listener and one or more sources
@@ -695,8 +936,12 @@ void vsSoundManager::update()
     // played, up to the sound library's voice limit.
     if ((soundListener) && (numSoundSources > 0))
     {
-        // Sort the sources by priority, then by effective gain
-        sortSources();
+        // Work out which sources are audible, and how loud they are
+        computeSourceGains(soundListener->getLastPosition());
+
+        // Bring the sources that should have voices to the front of the
+        // list (by play state, then priority, then effective gain)
+        selectSources(voiceLimit);
 
         // Now, traverse the list, making sure that only the sources
         // that should be active are active.  First, deactivate the
@@ -706,17 +951,17 @@ void vsSoundManager::update()
         {
             // Lock the source because we may be changing it's active state
             // here
-            soundSources[i]->source->lockSource();
+            soundSources[i].source->lockSource();
             
             // Check if the source is active
-            if (soundSources[i]->source->isActive())
+            if (soundSources[i].source->isActive())
             {
                 // See if this source is set to ALWAYS_ON priority.  If
                 // it is (and it's currently playing), then we have too many
                 // ALWAYS_ON sources in the scene.  Print an error (but swap
                 // it out anyway)
-                if ((soundSources[i]->source->isPlaying()) && 
-                   (soundSources[i]->source->getPriority() == 
+                if ((soundSources[i].source->isPlaying()) && 
+                   (soundSources[i].source->getPriority() == 
                         VS_SSRC_PRIORITY_ALWAYS_ON))
                 {
                     printf("vsSoundManager::update:  Too many ALWAYS_ON"
@@ -725,15 +970,15 @@ void vsSoundManager::update()
 
                 // Get the voice ID from the source, and add it to the
                 // list of available voices
-                voices[numVoices] = soundSources[i]->source->getVoiceID();
+                voices[numVoices] = soundSources[i].source->getVoiceID();
                 numVoices++;
 
                 // Revoke the source's voice, making the source inactive
-                soundSources[i]->source->revokeVoice();
+                soundSources[i].source->revokeVoice();
             }
 
             // Free the source mutex
-            soundSources[i]->source->unlockSource();
+            soundSources[i].source->unlockSource();
         }
 
         // Now, traverse the list of sources that should be active and
@@ -742,11 +987,12 @@ void vsSoundManager::update()
         while ((i < voiceLimit) && (i < numSoundSources))
         {
             // Lock the source, as we may be changing it's active state
-            soundSources[i]->source->lockSource();
+            soundSources[i].source->lockSource();
 
-            // Check if the source is inactive, but playing
-            if ((!soundSources[i]->source->isActive()) && 
-                (soundSources[i]->source->isPlaying()))
+            // Check if the source is inactive, but playing (and loud
+            // enough to hear)
+            if ((!soundSources[i].source->isActive()) && 
+                (soundSources[i].audible))
             {
                 // Sanity check:  make sure we have a voice to give
                 // the source (this should always be the case)
@@ -754,12 +1000,12 @@ void vsSoundManager::update()
                 {
                     // Assign an available voice to the source
                     numVoices--;
-                    soundSources[i]->source->assignVoice(voices[numVoices]);
+                    soundSources[i].source->assignVoice(voices[numVoices]);
                 }
             }
 
             // Free the source mutex
-            soundSources[i]->source->unlockSource();
+            soundSources[i].source->unlockSource();
 
             // Move on to the next source
             i++;
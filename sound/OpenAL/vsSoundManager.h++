@@ -29,15 +29,36 @@
 #include "vsSoundSourceAttribute.h++"
 #include "vsSoundListenerAttribute.h++"
 
-#define VS_SDM_MAX_SOUNDS          512
+#define VS_SDM_INITIAL_SOUNDS      512
 #define VS_SDM_DEFAULT_VOICE_LIMIT 32
 #define VS_SDM_MAX_VOICES          128
 #define VS_SDM_SOURCE_THREAD_HZ    60
 
+// Playing sources quieter than this (at the listener) aren't given voices
+#define VS_SDM_DEFAULT_CULL_GAIN   0.001
+
+// Number of entries in the command queue to the source thread (must be a
+// power of two)
+#define VS_SDM_COMMAND_QUEUE_SIZE  1024
+
+enum vsSoundManagerCommandType
+{
+    VS_SDM_COMMAND_ADD_SOURCE,
+    VS_SDM_COMMAND_REMOVE_SOURCE
+};
+
+struct vsSoundManagerCommand
+{
+    int                    commandType;
+    vsSoundSourceAttribute *source;
+};
+
 struct vsSoundSourceListItem
 {
     vsSoundSourceAttribute *source;
     double                 gain;
+    int                    priority;
+    bool                   audible;
 };
 
 class VESS_SYM vsSoundManager : public vsUpdatable
@@ -47,14 +68,36 @@ protected:
     static vsSoundManager          *instance;
 
     pthread_t                      sourceThread;
-    pthread_mutex_t                sourceListMutex;
-    bool                           sourceThreadDone;
+    volatile bool                  sourceThreadDone;
     int                            threadDelay;
 
+    // Source list changes from the main thread, in the order they were
+    // made, waiting to be picked up by the source thread
+    vsSoundManagerCommand          commandQueue[VS_SDM_COMMAND_QUEUE_SIZE];
+    volatile int                   commandHead;
+    volatile int                   commandTail;
+
+    // Commands that didn't fit in the queue (the list grows as needed, and
+    // is emptied by the source thread)
+    vsSoundManagerCommand          *overflowCommands;
+    volatile int                   numOverflowCommands;
+    int                            overflowListSize;
+    pthread_mutex_t                overflowMutex;
+
+    // The source thread's own list of sources, and the source it's
+    // currently updating
+    vsSoundSourceAttribute         **threadSources;
+    int                            numThreadSources;
+    int                            threadSourceListSize;
+    vsSoundSourceAttribute * volatile    threadActiveSource;
+
     vsSoundPipe                    *soundPipe;
 
-    vsSoundSourceListItem          *soundSources[VS_SDM_MAX_SOUNDS];
+    vsSoundSourceListItem          *soundSources;
     int                            numSoundSources;
+    int                            soundSourceListSize;
+
+    double                         cullGain;
 
     int                            voiceLimit;
     int                            hardwareVoiceLimit;
@@ -67,7 +110,17 @@ protected:
 
     static void                    *sourceThreadFunc(void *arg);
 
-    void                           sortSources();
+    void                           postCommand(int commandType,
+                                               vsSoundSourceAttribute *src);
+    void                           processCommands();
+    void                           processQueuedCommands();
+    void                           applyCommand(
+                                       vsSoundManagerCommand *command);
+
+    void                           computeSourceGains(atVector listenerPos);
+    static bool                    isSourceAhead(vsSoundSourceListItem *a,
+                                                 vsSoundSourceListItem *b);
+    void                           selectSources(int count);
 
 VS_INTERNAL:
 
@@ -93,6 +146,9 @@ public:
     void                     setSourceUpdateRate(int hz);
     int                      getSourceUpdateRate();
 
+    void                     setCullingGain(double gain);
+    double                   getCullingGain();
+
     void                     update();
 }; 
 #endif
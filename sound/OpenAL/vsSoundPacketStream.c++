@@ -21,6 +21,10 @@ vsSoundPacketStream::vsSoundPacketStream(int bufFormat, int bufFreq)
     // Initialize other data members
     sourceID = 0;
     sourceValid = false;
+
+    // Start with no spare buffers
+    bufferPoolCount = 0;
+    pthread_mutex_init(&poolMutex, NULL);
 }
 
 // ------------------------------------------------------------------------
@@ -30,6 +34,11 @@ vsSoundPacketStream::~vsSoundPacketStream()
 {
     // Flush any buffers currently queued
     flushBuffers();
+
+    // Delete the spare buffers
+    if (bufferPoolCount > 0)
+        alDeleteBuffers(bufferPoolCount, bufferPool);
+    pthread_mutex_destroy(&poolMutex);
 }
 
 // ------------------------------------------------------------------------
@@ -72,7 +81,6 @@ void vsSoundPacketStream::revokeSource()
 void vsSoundPacketStream::flushBuffers()
 {
     ALint numBuffers;
-    ALuint buffers[1024];
 
     // See if we currently have a valid source
     if (sourceValid)
@@ -80,17 +88,65 @@ void vsSoundPacketStream::flushBuffers()
         // Stop playback
         alSourceStop(sourceID);
 
-        // Check for queued buffers
+        // Check for queued buffers (once the source is stopped, they all
+        // count as processed)
         alGetSourceiv(sourceID, AL_BUFFERS_QUEUED, &numBuffers);
 
-        // Unqueue all buffers
-        alSourceUnqueueBuffers(sourceID, numBuffers, buffers);
+        // Unqueue all buffers and keep them for reuse
+        unqueueBuffers(numBuffers);
+    }
+}
+
+// ------------------------------------------------------------------------
+// Protected function -- Unqueues the given number of spent buffers from
+// the source, a batch at a time, and returns them to the pool for reuse
+// ------------------------------------------------------------------------
+void vsSoundPacketStream::unqueueBuffers(int count)
+{
+    ALuint buffers[VS_SPS_MAX_BATCH];
+    int batchCount;
+
+    // Handle the buffers a batch at a time
+    while (count > 0)
+    {
+        // Figure out how many buffers are in this batch
+        batchCount = count;
+        if (batchCount > VS_SPS_MAX_BATCH)
+            batchCount = VS_SPS_MAX_BATCH;
 
-        // Delete the buffers we just unqueued
-        alDeleteBuffers(numBuffers, buffers);
+        // Unqueue the batch and keep the buffers for reuse
+        alSourceUnqueueBuffers(sourceID, batchCount, buffers);
+        recycleBuffers(buffers, batchCount);
+        count -= batchCount;
     }
 }
 
+// ------------------------------------------------------------------------
+// Protected function -- Returns spent buffers to the pool for reuse.  Any
+// buffers that don't fit in the pool are deleted.
+// ------------------------------------------------------------------------
+void vsSoundPacketStream::recycleBuffers(ALuint *buffers, int count)
+{
+    int keepCount;
+
+    // Nothing to do without buffers
+    if (count <= 0)
+        return;
+
+    // Move as many buffers into the pool as will fit
+    pthread_mutex_lock(&poolMutex);
+    keepCount = VS_SPS_BUFFER_POOL_SIZE - bufferPoolCount;
+    if (keepCount > count)
+        keepCount = count;
+    memcpy(&bufferPool[bufferPoolCount], buffers, keepCount * sizeof(ALuint));
+    bufferPoolCount += keepCount;
+    pthread_mutex_unlock(&poolMutex);
+
+    // Delete the rest
+    if (count > keepCount)
+        alDeleteBuffers(count - keepCount, &buffers[keepCount]);
+}
+
 // ------------------------------------------------------------------------
 // Return the sound buffer type (a packet stream)
 // ------------------------------------------------------------------------
@@ -134,40 +190,77 @@ bool vsSoundPacketStream::isEmpty()
 // ------------------------------------------------------------------------
 bool vsSoundPacketStream::queueBuffer(void *audioData, u_long length)
 {
-    ALuint buffer;
+    // Queue the data as a batch of one
+    return queueBuffers(&audioData, &length, 1);
+}
+
+// ------------------------------------------------------------------------
+// Fills a buffer for each of the given packets of audio data and enqueues
+// them all for playback.  Spent buffers are reused when possible, and the
+// buffers are queued on the source in batches, so refilling the stream
+// with many small packets takes few OpenAL calls.  Returns true if
+// successful or false if not
+// ------------------------------------------------------------------------
+bool vsSoundPacketStream::queueBuffers(void **audioData, u_long *lengths,
+                                       int count)
+{
+    ALuint buffers[VS_SPS_MAX_BATCH];
+    int batchStart;
+    int batchCount;
+    int reuseCount;
+    int i;
 
     // If we have no source, fail
     if (!sourceValid)
         return false;
 
-    // Otherwise, create a new buffer for this data
-    alGenBuffers(1, &buffer);
-    alBufferData(buffer, bufferFormat, audioData, length, bufferFrequency);
+    // Handle the packets a batch at a time
+    for (batchStart = 0; batchStart < count; batchStart += batchCount)
+    {
+        // Figure out how many packets are in this batch
+        batchCount = count - batchStart;
+        if (batchCount > VS_SPS_MAX_BATCH)
+            batchCount = VS_SPS_MAX_BATCH;
+
+        // Take as many buffers as we can from the pool
+        pthread_mutex_lock(&poolMutex);
+        reuseCount = bufferPoolCount;
+        if (reuseCount > batchCount)
+            reuseCount = batchCount;
+        bufferPoolCount -= reuseCount;
+        memcpy(buffers, &bufferPool[bufferPoolCount],
+            reuseCount * sizeof(ALuint));
+        pthread_mutex_unlock(&poolMutex);
 
-    // Queue the buffer on the source
-    alSourceQueueBuffers(sourceID, 1, &buffer);
+        // Create new buffers for the rest
+        if (batchCount > reuseCount)
+            alGenBuffers(batchCount - reuseCount, &buffers[reuseCount]);
+
+        // Fill each buffer with its packet's data
+        for (i = 0; i < batchCount; i++)
+            alBufferData(buffers[i], bufferFormat, audioData[batchStart + i],
+                lengths[batchStart + i], bufferFrequency);
+
+        // Queue the whole batch on the source
+        alSourceQueueBuffers(sourceID, batchCount, buffers);
+    }
 
     return true;
 }
 
 // ------------------------------------------------------------------------
-// Updates the stream by removing and deleting processed buffers
+// Updates the stream by removing processed buffers (and recycling them)
 // ------------------------------------------------------------------------
 void vsSoundPacketStream::update()
 {
     ALint numBuffers;
-    ALuint buffers[1024];
 
     // If the source isn't valid, don't bother going farther
     if (!sourceValid)
         return;
 
-    // Look for processed buffers on the source's buffer queue
+    // Look for processed buffers on the source's buffer queue, and dequeue
+    // them for reuse
     alGetSourceiv(sourceID, AL_BUFFERS_PROCESSED, &numBuffers);
-    if (numBuffers > 0)
-    {
-        // Dequeue and delete each processed buffer
-        alSourceUnqueueBuffers(sourceID, numBuffers, buffers);
-        alDeleteBuffers(numBuffers, buffers);
-    }
+    unqueueBuffers(numBuffers);
 }
@@ -5,8 +5,15 @@
 // created and deleted dynamically, instead of using two persistent buffers
 
 #include <AL/al.h>
+#include <pthread.h>
 #include "vsSoundBuffer.h++"
 
+// Maximum number of spent OpenAL buffers kept around for reuse
+#define VS_SPS_BUFFER_POOL_SIZE    64
+
+// Maximum number of packets queued (or spent buffers unqueued) with a
+// single OpenAL call
+#define VS_SPS_MAX_BATCH           64
 
 class VESS_SYM vsSoundPacketStream : public vsSoundBuffer
 {
@@ -17,6 +24,15 @@ protected:
     ALuint    sourceID;
     bool      sourceValid;
 
+    // Spent OpenAL buffers, kept for reuse by later packets so we don't
+    // need to generate and delete a buffer for every packet
+    ALuint             bufferPool[VS_SPS_BUFFER_POOL_SIZE];
+    int                bufferPoolCount;
+    pthread_mutex_t    poolMutex;
+
+    void      unqueueBuffers(int count);
+    void      recycleBuffers(ALuint *buffers, int count);
+
 VS_INTERNAL:
 
     // Sets or revokes the OpenAL source to which we're streaming
@@ -51,6 +67,11 @@ public:
     // playing.  Return value indicates success or failure.
     bool                  queueBuffer(void *audioData, u_long length);
 
+    // Queues several packets of audio data at once.  Return value
+    // indicates success or failure.
+    bool                  queueBuffers(void **audioData, u_long *lengths,
+                                       int count);
+
     // Updates the stream (this method must be called regularly to handle
     // the source's buffer queue)
     void                  update();
@@ -514,7 +514,7 @@ void vsSoundSourceAttribute::unlockSource()
 void vsSoundSourceAttribute::updateStream()
 {
     int            buffersProcessed;
-    ALuint         bufferID;
+    ALuint         bufferIDs[2];
     int            state, queued;
 
     // Lock the source to keep it from being swapped in or out by voice
@@ -534,18 +534,20 @@ void vsSoundSourceAttribute::updateStream()
             // Swap buffers if the front buffer is done
             if (buffersProcessed > 0)
             {
-                // Unqueue the front buffer of the stream
-                bufferID = ((vsSoundStream *)soundBuffer)->getFrontBufferID();
-                alSourceUnqueueBuffers(sourceID, 1, &bufferID);
+                // Unqueue all of the spent buffers in one call (the front
+                // buffer, and the back buffer too if both were processed)
+                bufferIDs[0] =
+                    ((vsSoundStream *)soundBuffer)->getFrontBufferID();
+                bufferIDs[1] =
+                    ((vsSoundStream *)soundBuffer)->getBackBufferID();
+                if (buffersProcessed > 2)
+                    buffersProcessed = 2;
+                alSourceUnqueueBuffers(sourceID, buffersProcessed, bufferIDs);
+
                 if (buffersProcessed > 1)
                 {
-                    // If both buffers were processed (probably not good),
-                    // also unqueue the back buffer
-                    bufferID =
-                        ((vsSoundStream *)soundBuffer)->getBackBufferID();
-                    alSourceUnqueueBuffers(sourceID, 1, &bufferID);
-
-                    // Mark both stream buffers as empty
+                    // Both buffers were processed (probably not good), so
+                    // mark both stream buffers as empty
                     ((vsSoundStream *)soundBuffer)->flushBuffers();
                 }
                 else
@@ -76,17 +76,25 @@ ALuint vsSoundStream::getBackBufferID()
 // ------------------------------------------------------------------------
 void vsSoundStream::assignSource(int sid)
 {
+    ALuint readyBuffers[2];
+    int readyCount;
+
     // Remember the source ID and mark it valid
     sourceID = sid;
     sourceValid = true;
     
-    // Queue the stream buffers on the source, if they are ready
+    // Queue the stream buffers on the source (in one call), if they are
+    // ready
     if (alIsSource(sourceID))
     {
+        readyCount = 0;
         if (!frontBufferEmpty)
-            alSourceQueueBuffers(sourceID, 1, &frontBuffer);
+            readyBuffers[readyCount++] = frontBuffer;
         if (!backBufferEmpty)
-            alSourceQueueBuffers(sourceID, 1, &backBuffer);
+            readyBuffers[readyCount++] = backBuffer;
+
+        if (readyCount > 0)
+            alSourceQueueBuffers(sourceID, readyCount, readyBuffers);
     }
 }
 
@@ -110,7 +118,7 @@ void vsSoundStream::flushBuffers()
 
     // Create a set of zero data for each buffer
     zeroBuf = malloc(bufferSize);
-    memset(zeroBuf, 0, sizeof(zeroBuf));
+    memset(zeroBuf, 0, bufferSize);
 
     // Flush the front buffer
     frontBufferEmpty = true;
@@ -190,48 +198,63 @@ bool vsSoundStream::isEmpty()
 // ------------------------------------------------------------------------
 bool vsSoundStream::queueBuffer(void *audioData)
 {
+    // Queue the data as a batch of one
+    if (queueBuffers(&audioData, 1) == 1)
+        return true;
+
+    // Neither buffer is empty, so print an error
+    printf("vsSoundStream::queueBuffer:  no buffers available to receive"
+        " audio data\n");
+
+    // Return false to indicate the queue operation failed
+    return false;
+}
+
+// ------------------------------------------------------------------------
+// Fills the empty buffers (front first, then back) with the given chunks
+// of audio data, each of the size given in the constructor, and queues
+// them on the source with a single call.  Returns the number of chunks
+// that were used, which may be less than the count given if there aren't
+// enough empty buffers (zero if there are none).
+// ------------------------------------------------------------------------
+int vsSoundStream::queueBuffers(void **audioData, int count)
+{
+    ALuint filledBuffers[VS_SS_BUFFER_COUNT];
+    int filledCount;
+
     // Fill the front buffer if it's empty
-    if (frontBufferEmpty)
+    filledCount = 0;
+    if ((frontBufferEmpty) && (filledCount < count))
     {
         // Put the audio data in the front buffer using the format specified
         // in the constructor
-        alBufferData(frontBuffer, bufferFormat, audioData, bufferSize,
-            bufferFrequency);
-            
-        // Queue the buffer on the source if the source is valid
-        if (alIsSource(sourceID) && sourceValid)
-            alSourceQueueBuffers(sourceID, 1, &frontBuffer);
+        alBufferData(frontBuffer, bufferFormat, audioData[filledCount],
+            bufferSize, bufferFrequency);
 
         // Mark the front buffer as full
+        filledBuffers[filledCount] = frontBuffer;
         frontBufferEmpty = false;
-
-        // Return true to indicate the queue operation succeeded.
-        return true;
+        filledCount++;
     }
 
-    // Otherwise, fill the back buffer if it's empty
-    if (backBufferEmpty)
+    // Then fill the back buffer if it's empty
+    if ((backBufferEmpty) && (filledCount < count))
     {
         // Put the audio data in the back buffer using the format specified
         // in the constructor
-        alBufferData(backBuffer, bufferFormat, audioData, bufferSize,
-            bufferFrequency);
-            
-        // Queue the buffer on the source if the source is valid
-        if (alIsSource(sourceID) && sourceValid)
-            alSourceQueueBuffers(sourceID, 1, &backBuffer);
+        alBufferData(backBuffer, bufferFormat, audioData[filledCount],
+            bufferSize, bufferFrequency);
 
         // Mark the back buffer as full
+        filledBuffers[filledCount] = backBuffer;
         backBufferEmpty = false;
-
-        // Return true to indicate that the queue operation succeeded
-        return true;
+        filledCount++;
     }
 
-    // Neither buffer is empty, so print an error
-    printf("vsSoundStream::queueBuffer:  no buffers available to receive"
-        " audio data\n");
+    // Queue the buffers we filled on the source if the source is valid
+    if ((filledCount > 0) && (alIsSource(sourceID)) && (sourceValid))
+        alSourceQueueBuffers(sourceID, filledCount, filledBuffers);
 
-    // Return false to indicate the queue operation failed
-    return false;
+    // Return the number of chunks used
+    return filledCount;
 }
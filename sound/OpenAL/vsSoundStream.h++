@@ -16,6 +16,10 @@
 #define VS_SS_FORMAT_STEREO8  VS_SBUF_FORMAT_STEREO8
 #define VS_SS_FORMAT_STEREO16 VS_SBUF_FORMAT_STEREO16
 
+// Number of buffers in the stream (the most chunks of audio data that
+// can be queued at once)
+#define VS_SS_BUFFER_COUNT    2
+
 class VESS_SYM vsSoundStream : public vsSoundBuffer
 {
 protected:
@@ -76,6 +80,11 @@ public:
     // Fills the back buffer with the given audio data and queues it for
     // playing.  Return value indicates success or failure.
     bool                  queueBuffer(void *audioData);
+
+    // Fills as many of the empty buffers as possible from the given list
+    // of audio data chunks, and queues them for playing together.  Returns
+    // the number of chunks used.
+    int                   queueBuffers(void **audioData, int count);
 };
 
 #endif
@@ -43,6 +43,7 @@
 #include "vsWindowSystem.h++"
 #include "vsTextBuilder.h++"
 #include "vsScentManager.h++"
+#include "vsThreadPool.h++"
 
 #ifdef VS_SOUND_ENABLED
    #include "vsSoundManager.h++"
@@ -106,6 +107,7 @@ vsSystem::~vsSystem()
     vsViewpointAttribute::deleteMap();
     vsNode::deleteMap();
     vsTimer::deleteSystemTimer();
+    vsThreadPool::deleteDefaultPool();
     vsWindowSystem::deleteMap();
     vsScreen::done();
     vsPipe::done();
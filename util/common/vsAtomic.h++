@@ -0,0 +1,121 @@
+//------------------------------------------------------------------------
+//
+//    VIRTUAL ENVIRONMENT SOFTWARE SANDBOX (VESS)
+//
+//    Copyright (c) 2001, University of Central Florida
+//
+//       See the file LICENSE for license information
+//
+//    E-mail:  vess@ist.ucf.edu
+//    WWW:     http://vess.ist.ucf.edu/
+//
+//------------------------------------------------------------------------
+//
+//    VESS Module:  vsAtomic.h++
+//
+//    Description:  Small set of inline atomic integer operations, used
+//                  where taking a mutex would be too expensive
+//
+//    Author(s):    agent
+//
+//------------------------------------------------------------------------
+
+#ifndef VS_ATOMIC_HPP
+#define VS_ATOMIC_HPP
+
+#include "vsGlobals.h++"
+
+#ifdef WIN32
+    #include <windows.h>
+#endif
+
+//------------------------------------------------------------------------
+// Atomically adds the given amount to the value and returns the new value
+//------------------------------------------------------------------------
+inline int vsAtomicAdd(volatile int *value, int amount)
+{
+#ifdef WIN32
+    return InterlockedExchangeAdd((volatile LONG *)value, amount) + amount;
+#else
+    return __sync_add_and_fetch(value, amount);
+#endif
+}
+
+//------------------------------------------------------------------------
+// Atomically adds the given amount to the value and returns the value it
+// held before the addition
+//------------------------------------------------------------------------
+inline int vsAtomicFetchAdd(volatile int *value, int amount)
+{
+#ifdef WIN32
+    return InterlockedExchangeAdd((volatile LONG *)value, amount);
+#else
+    return __sync_fetch_and_add(value, amount);
+#endif
+}
+
+//------------------------------------------------------------------------
+// Atomically replaces the value with newValue if it currently holds
+// oldValue.  Returns true if the swap took place
+//------------------------------------------------------------------------
+inline bool vsAtomicCompareAndSwap(volatile int *value, int oldValue,
+                                   int newValue)
+{
+#ifdef WIN32
+    return (InterlockedCompareExchange((volatile LONG *)value, newValue,
+        oldValue) == oldValue);
+#else
+    return __sync_bool_compare_and_swap(value, oldValue, newValue);
+#endif
+}
+
+//------------------------------------------------------------------------
+// Reads the value with full memory barrier semantics
+//------------------------------------------------------------------------
+inline int vsAtomicLoad(volatile int *value)
+{
+#ifdef WIN32
+    return InterlockedExchangeAdd((volatile LONG *)value, 0);
+#else
+    return __sync_fetch_and_add(value, 0);
+#endif
+}
+
+//------------------------------------------------------------------------
+// Reads the value with acquire semantics (no later reads or writes can be
+// moved ahead of it).  Unlike vsAtomicLoad(), this is a plain read, so it
+// never takes ownership of the value's cache line away from the thread or
+// process writing it
+//------------------------------------------------------------------------
+inline int vsAtomicLoadAcquire(volatile int *value)
+{
+#if defined(WIN32)
+    int result;
+
+    result = *value;
+    MemoryBarrier();
+    return result;
+#elif defined(__ATOMIC_ACQUIRE)
+    return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+#else
+    int result;
+
+    result = *value;
+    __sync_synchronize();
+    return result;
+#endif
+}
+
+//------------------------------------------------------------------------
+// Issues a full memory barrier
+//------------------------------------------------------------------------
+inline void vsMemoryBarrier()
+{
+#ifdef WIN32
+    MemoryBarrier();
+#else
+    __sync_synchronize();
+#endif
+}
+
+#endif
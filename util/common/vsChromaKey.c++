@@ -21,7 +21,54 @@
 //------------------------------------------------------------------------
 
 #include <stdlib.h>
+#include <string.h>
 #include "vsChromaKey.h++"
+#include "vsThreadPool.h++"
+
+// Use the SSE2 keying kernel wherever the compiler supports it
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+    #define VS_CHROMAKEY_USE_SSE2
+    #include <emmintrin.h>
+#endif
+
+// Number of image rows handed to each thread pool task
+#define VS_CHROMAKEY_ROWS_PER_TASK    16
+
+// Number of pixels keyed at a time within a row
+#define VS_CHROMAKEY_RUN_LENGTH       256
+
+// Operations performed on an image by the chroma key
+enum vsChromaKeyOperation
+{
+    VS_CHROMAKEY_OP_CREATE_RGBA,
+    VS_CHROMAKEY_OP_CREATE_ALPHA,
+    VS_CHROMAKEY_OP_MODIFY_RGBA,
+    VS_CHROMAKEY_OP_MODIFY_ALPHA,
+    VS_CHROMAKEY_OP_COMBINE
+};
+
+// Describes an image operation for the thread pool.  The color channels
+// are read from the red, green, and blue pointers, which are either the
+// bytes of interleaved pixels ('pixelStride' apart) or separate channel
+// images (pixelStride of 1).
+struct vsChromaKeyJob
+{
+    vsChromaKey             *chromaKey;
+    vsChromaKeyOperation    operation;
+
+    unsigned char           *red;
+    unsigned char           *green;
+    unsigned char           *blue;
+    int                     pixelStride;
+    int                     inRowStride;
+
+    unsigned char           *background;
+    unsigned char           *output;
+    int                     outRowStride;
+
+    int                     imageWidth;
+};
 
 //------------------------------------------------------------------------
 // Constructor
@@ -148,52 +195,23 @@ void vsChromaKey::getEquationType(vsChromaKeyEquationType *equationType,
 void vsChromaKey::createAlphaFromColor(unsigned char *inputImage,
     int imageWidth, int imageHeight, unsigned char *outputImage)
 {
-    int row, column;
-    unsigned char red, green, blue, alpha;
-    unsigned char *inPtr, *outPtr;
-    int inRowExtra, outRowExtra;
-    int colorDiff;
-
-    // Set the running pointers to the start of the image buffers
-    inPtr = inputImage;
-    outPtr = outputImage;
-
-    // Calculate the amount that the row lengths exceed the word size
-    inRowExtra = (imageWidth * 3) % wordSize;
-    outRowExtra = (imageWidth * 4) % wordSize;
-
-    // Loop through all the rows of the image
-    for (row = 0; row < imageHeight; row++)
-    {
-        // Loop through every pixel of the row
-        for (column = 0; column < imageWidth; column++)
-        {
-            // Grab the pixel data
-            red = *(inPtr++);
-            green = *(inPtr++);
-            blue = *(inPtr++);
-
-            // Determine the 'difference' between the pixel color and this
-            // object's key color
-            colorDiff = calcDifference(red, green, blue);
-
-            // If the difference is below the threshold, then make the pixel
-            // transparent. Otherwise, it should be opaque.
-            alpha = ((colorDiff <= keyThreshold) ? 0 : 255);
-
-            // Write the pixel data to the output buffer
-            *(outPtr++) = red;
-            *(outPtr++) = green;
-            *(outPtr++) = blue;
-            *(outPtr++) = alpha;
-        }
-
-        // Pad the image buffers, if needed
-        if (inRowExtra != 0)
-            inPtr += (wordSize - inRowExtra);
-        if (outRowExtra != 0)
-            outPtr += (wordSize - outRowExtra);
-    }
+    vsChromaKeyJob job;
+
+    // Read the color channels interleaved from the input image, and write
+    // RGBA pixels to the output image
+    job.operation = VS_CHROMAKEY_OP_CREATE_RGBA;
+    job.red = &inputImage[0];
+    job.green = &inputImage[1];
+    job.blue = &inputImage[2];
+    job.pixelStride = 3;
+    job.inRowStride = getRowStride(imageWidth * 3);
+    job.background = NULL;
+    job.output = outputImage;
+    job.outRowStride = getRowStride(imageWidth * 4);
+    job.imageWidth = imageWidth;
+
+    // Process the image
+    runJob(&job, imageHeight);
 }
 
 //------------------------------------------------------------------------
@@ -207,55 +225,23 @@ void vsChromaKey::createAlphaFromColor(unsigned char *redChannel,
     unsigned char *greenChannel, unsigned char *blueChannel, int imageWidth,
     int imageHeight, unsigned char *outputAlphaChannel)
 {
-    int row, column;
-    unsigned char red, green, blue, alpha;
-    unsigned char *redPtr, *greenPtr, *bluePtr, *outPtr;
-    int inRowExtra, outRowExtra;
-    int colorDiff;
-
-    // Set the running pointers to the start of the image buffers
-    redPtr = redChannel;
-    greenPtr = greenChannel;
-    bluePtr = blueChannel;
-    outPtr = outputAlphaChannel;
-
-    // Calculate the amount that the row lengths exceed the word size
-    inRowExtra = (imageWidth * 1) % wordSize;
-    outRowExtra = (imageWidth * 1) % wordSize;
-
-    // Loop through all the rows of the image
-    for (row = 0; row < imageHeight; row++)
-    {
-        // Loop through every pixel of the row
-        for (column = 0; column < imageWidth; column++)
-        {
-            // Grab the pixel data
-            red = *(redPtr++);
-            green = *(greenPtr++);
-            blue = *(bluePtr++);
-
-            // Determine the 'difference' between the pixel color and this
-            // object's key color
-            colorDiff = calcDifference(red, green, blue);
-
-            // If the difference is below the threshold, then make the pixel
-            // transparent. Otherwise, it should be opaque.
-            alpha = ((colorDiff <= keyThreshold) ? 0 : 255);
-
-            // Write the pixel data to the output buffer
-            *(outPtr++) = alpha;
-        }
-
-        // Pad the image buffers, if needed
-        if (inRowExtra != 0)
-        {
-            redPtr += (wordSize - inRowExtra);
-            greenPtr += (wordSize - inRowExtra);
-            bluePtr += (wordSize - inRowExtra);
-        }
-        if (outRowExtra != 0)
-            outPtr += (wordSize - outRowExtra);
-    }
+    vsChromaKeyJob job;
+
+    // Read the color channels from their separate images, and write the
+    // alpha values to the output channel
+    job.operation = VS_CHROMAKEY_OP_CREATE_ALPHA;
+    job.red = redChannel;
+    job.green = greenChannel;
+    job.blue = blueChannel;
+    job.pixelStride = 1;
+    job.inRowStride = getRowStride(imageWidth);
+    job.background = NULL;
+    job.output = outputAlphaChannel;
+    job.outRowStride = getRowStride(imageWidth);
+    job.imageWidth = imageWidth;
+
+    // Process the image
+    runJob(&job, imageHeight);
 }
 
 //------------------------------------------------------------------------
@@ -266,48 +252,23 @@ void vsChromaKey::createAlphaFromColor(unsigned char *redChannel,
 void vsChromaKey::modifyAlphaFromColor(unsigned char *image, int imageWidth,
     int imageHeight)
 {
-    int row, column;
-    unsigned char red, green, blue, alpha;
-    unsigned char *imagePtr;
-    int rowExtra;
-    int colorDiff;
-
-    // Set the running pointers to the start of the image buffers
-    imagePtr = image;
-
-    // Calculate the amount that the row length exceeds the word size
-    rowExtra = (imageWidth * 4) % wordSize;
-
-    // Loop through all the rows of the image
-    for (row = 0; row < imageHeight; row++)
-    {
-        // Loop through every pixel of the row
-        for (column = 0; column < imageWidth; column++)
-        {
-            // Grab the pixel data
-            red = *(imagePtr++);
-            green = *(imagePtr++);
-            blue = *(imagePtr++);
-
-            // Determine the 'difference' between the pixel color and this
-            // object's key color
-            colorDiff = calcDifference(red, green, blue);
-
-            // If the difference is below the threshold, then make the pixel
-            // transparent. Otherwise, it should be opaque.
-            alpha = ((colorDiff <= keyThreshold) ? 0 : 255);
-
-            // Write the pixel data to the output buffer (if the value changed)
-            if (alpha == 0)
-                *(imagePtr++) = alpha;
-            else
-                imagePtr++;
-        }
-
-        // Pad the image buffer, if needed
-        if (rowExtra != 0)
-            imagePtr += (wordSize - rowExtra);
-    }
+    vsChromaKeyJob job;
+
+    // Read the color channels interleaved from the image, and update the
+    // alpha values in place
+    job.operation = VS_CHROMAKEY_OP_MODIFY_RGBA;
+    job.red = &image[0];
+    job.green = &image[1];
+    job.blue = &image[2];
+    job.pixelStride = 4;
+    job.inRowStride = getRowStride(imageWidth * 4);
+    job.background = NULL;
+    job.output = &image[3];
+    job.outRowStride = job.inRowStride;
+    job.imageWidth = imageWidth;
+
+    // Process the image
+    runJob(&job, imageHeight);
 }
 
 //------------------------------------------------------------------------
@@ -320,58 +281,23 @@ void vsChromaKey::modifyAlphaFromColor(unsigned char *redChannel,
     unsigned char *greenChannel, unsigned char *blueChannel,
     unsigned char *alphaChannel, int imageWidth, int imageHeight)
 {
-    int row, column;
-    unsigned char red, green, blue, alpha;
-    unsigned char *redPtr, *greenPtr, *bluePtr, *outPtr;
-    int inRowExtra, outRowExtra;
-    int colorDiff;
-
-    // Set the running pointers to the start of the image buffers
-    redPtr = redChannel;
-    greenPtr = greenChannel;
-    bluePtr = blueChannel;
-    outPtr = alphaChannel;
-
-    // Calculate the amount that the row lengths exceed the word size
-    inRowExtra = (imageWidth * 1) % wordSize;
-    outRowExtra = (imageWidth * 1) % wordSize;
-
-    // Loop through all the rows of the image
-    for (row = 0; row < imageHeight; row++)
-    {
-        // Loop through every pixel of the row
-        for (column = 0; column < imageWidth; column++)
-        {
-            // Grab the pixel data
-            red = *(redPtr++);
-            green = *(greenPtr++);
-            blue = *(bluePtr++);
-
-            // Determine the 'difference' between the pixel color and this
-            // object's key color
-            colorDiff = calcDifference(red, green, blue);
-
-            // If the difference is below the threshold, then make the pixel
-            // transparent. Otherwise, it should be opaque.
-            alpha = ((colorDiff <= keyThreshold) ? 0 : 255);
-
-            // Write the pixel data to the output buffer (if the value changed)
-            if (alpha == 0)
-                *(outPtr++) = alpha;
-            else
-                outPtr++;
-        }
-
-        // Pad the image buffers, if needed
-        if (inRowExtra != 0)
-        {
-            redPtr += (wordSize - inRowExtra);
-            greenPtr += (wordSize - inRowExtra);
-            bluePtr += (wordSize - inRowExtra);
-        }
-        if (outRowExtra != 0)
-            outPtr += (wordSize - outRowExtra);
-    }
+    vsChromaKeyJob job;
+
+    // Read the color channels from their separate images, and update the
+    // alpha channel in place
+    job.operation = VS_CHROMAKEY_OP_MODIFY_ALPHA;
+    job.red = redChannel;
+    job.green = greenChannel;
+    job.blue = blueChannel;
+    job.pixelStride = 1;
+    job.inRowStride = getRowStride(imageWidth);
+    job.background = NULL;
+    job.output = alphaChannel;
+    job.outRowStride = getRowStride(imageWidth);
+    job.imageWidth = imageWidth;
+
+    // Process the image
+    runJob(&job, imageHeight);
 }
 
 //------------------------------------------------------------------------
@@ -385,110 +311,342 @@ void vsChromaKey::combineImages(unsigned char *foregroundImage,
     unsigned char *backgroundImage, int imageWidth, int imageHeight,
     unsigned char *outputImage)
 {
-    int row, column;
-    unsigned char foreRed, foreGreen, foreBlue;
-    unsigned char backRed, backGreen, backBlue;
-    unsigned char outRed, outGreen, outBlue;
-    unsigned char *forePtr, *backPtr, *outPtr;
-    int inRowExtra, outRowExtra;
-    int colorDiff;
-
-    // Set the running pointers to the start of the image buffers
-    forePtr = foregroundImage;
-    backPtr = backgroundImage;
-    outPtr = outputImage;
-
-    // Calculate the amount that the row lengths exceed the word size
-    inRowExtra = (imageWidth * 3) % wordSize;
-    outRowExtra = (imageWidth * 3) % wordSize;
-
-    // Loop through all the rows of the image
-    for (row = 0; row < imageHeight; row++)
+    vsChromaKeyJob job;
+
+    // Key on the foreground image, and write the composite to the output
+    // image (all three images have the same layout)
+    job.operation = VS_CHROMAKEY_OP_COMBINE;
+    job.red = &foregroundImage[0];
+    job.green = &foregroundImage[1];
+    job.blue = &foregroundImage[2];
+    job.pixelStride = 3;
+    job.inRowStride = getRowStride(imageWidth * 3);
+    job.background = backgroundImage;
+    job.output = outputImage;
+    job.outRowStride = job.inRowStride;
+    job.imageWidth = imageWidth;
+
+    // Process the image
+    runJob(&job, imageHeight);
+}
+
+#ifdef VS_CHROMAKEY_USE_SSE2
+
+//------------------------------------------------------------------------
+// Static function
+// Computes the key mask for separate channel images sixteen pixels at a
+// time, using the sum or largest difference equation (the squared
+// differences don't fit in 16-bit lanes, so that equation is left to the
+// scalar loops).  Returns the number of pixels handled, which is a
+// multiple of sixteen; the caller finishes the rest.
+//------------------------------------------------------------------------
+static int keyMaskSSE2(unsigned char *red, unsigned char *green,
+    unsigned char *blue, int count, unsigned char keyRed,
+    unsigned char keyGreen, unsigned char keyBlue,
+    vsChromaKeyEquationType equation, int threshold, unsigned char *mask)
+{
+    __m128i kr, kg, kb;
+    __m128i r, g, b;
+    __m128i dr, dg, db;
+    __m128i zero, allOnes, wideThreshold, narrowThreshold;
+    __m128i sumLow, sumHigh, match;
+    int i;
+
+    // Broadcast the key color
+    kr = _mm_set1_epi8((char)keyRed);
+    kg = _mm_set1_epi8((char)keyGreen);
+    kb = _mm_set1_epi8((char)keyBlue);
+    zero = _mm_setzero_si128();
+    allOnes = _mm_cmpeq_epi8(zero, zero);
+
+    // Clamp the threshold to what the lanes can hold.  A negative
+    // threshold never matches, so -1 stands in for all of them.
+    if (threshold < -1)
+        threshold = -1;
+    else if (threshold > 32767)
+        threshold = 32767;
+    wideThreshold = _mm_set1_epi16((short)threshold);
+    if (threshold < 0)
+        narrowThreshold = zero;
+    else if (threshold > 255)
+        narrowThreshold = allOnes;
+    else
+        narrowThreshold = _mm_set1_epi8((char)threshold);
+
+    for (i = 0; i + 16 <= count; i += 16)
     {
-        // Loop through every pixel of the row
-        for (column = 0; column < imageWidth; column++)
-        {
-            // Grab the pixel data
-            foreRed = *(forePtr++);
-            foreGreen = *(forePtr++);
-            foreBlue = *(forePtr++);
-
-            backRed = *(backPtr++);
-            backGreen = *(backPtr++);
-            backBlue = *(backPtr++);
-
-            // Determine the 'difference' between the pixel color and this
-            // object's key color
-            colorDiff = calcDifference(foreRed, foreGreen, foreBlue);
-
-            // If the difference is below the threshold, then make the pixel
-            // match the background pixel. Otherwise, it should be the
-            // foreground color.
-            if (colorDiff <= keyThreshold)
-            {
-                outRed = backRed;
-                outGreen = backGreen;
-                outBlue = backBlue;
-            }
-            else
-            {
-                outRed = foreRed;
-                outGreen = foreGreen;
-                outBlue = foreBlue;
-            }
+        // Load sixteen pixels from each channel
+        r = _mm_loadu_si128((__m128i *)&red[i]);
+        g = _mm_loadu_si128((__m128i *)&green[i]);
+        b = _mm_loadu_si128((__m128i *)&blue[i]);
 
-            // Write the pixel data to the output buffer
-            *(outPtr++) = outRed;
-            *(outPtr++) = outGreen;
-            *(outPtr++) = outBlue;
-        }
+        // Absolute differences from the key color, as unsigned bytes
+        dr = _mm_or_si128(_mm_subs_epu8(r, kr), _mm_subs_epu8(kr, r));
+        dg = _mm_or_si128(_mm_subs_epu8(g, kg), _mm_subs_epu8(kg, g));
+        db = _mm_or_si128(_mm_subs_epu8(b, kb), _mm_subs_epu8(kb, b));
 
-        // Pad the image buffers, if needed
-        if (inRowExtra != 0)
+        if (equation == VS_CHROMAKEY_DIFF_SUM)
+        {
+            // Widen the differences to 16 bits and add them up
+            sumLow = _mm_add_epi16(_mm_add_epi16(
+                _mm_unpacklo_epi8(dr, zero), _mm_unpacklo_epi8(dg, zero)),
+                _mm_unpacklo_epi8(db, zero));
+            sumHigh = _mm_add_epi16(_mm_add_epi16(
+                _mm_unpackhi_epi8(dr, zero), _mm_unpackhi_epi8(dg, zero)),
+                _mm_unpackhi_epi8(db, zero));
+
+            // Find the sums over the threshold, narrow that back down to
+            // bytes, and invert it to get the matches
+            match = _mm_packs_epi16(
+                _mm_cmpgt_epi16(sumLow, wideThreshold),
+                _mm_cmpgt_epi16(sumHigh, wideThreshold));
+            match = _mm_xor_si128(match, allOnes);
+        }
+        else
         {
-            forePtr += (wordSize - inRowExtra);
-            backPtr += (wordSize - inRowExtra);
+            // Take the largest difference.  It's within the threshold if
+            // subtracting the threshold (with saturation) leaves zero.
+            dr = _mm_max_epu8(_mm_max_epu8(dr, dg), db);
+            match = _mm_cmpeq_epi8(_mm_subs_epu8(dr, narrowThreshold), zero);
+
+            // Nothing matches a negative threshold
+            if (threshold < 0)
+                match = zero;
         }
-        if (outRowExtra != 0)
-            outPtr += (wordSize - outRowExtra);
+
+        // Store the mask
+        _mm_storeu_si128((__m128i *)&mask[i], match);
     }
+
+    // Return the number of pixels we handled
+    return i;
 }
 
+#endif
+
 //------------------------------------------------------------------------
 // Private function
-// Computes the 'difference' between the given color and key color
+// Computes a mask for a run of 'count' pixels, whose color channels are
+// 'pixelStride' bytes apart.  Each mask value is 255 if the pixel's
+// 'difference' from the key color is within the threshold, or 0 if not.
+// The loops avoid branches (and the equation is picked once for the
+// whole run), so the compiler can vectorize them.
 //------------------------------------------------------------------------
-int vsChromaKey::calcDifference(unsigned char red, unsigned char green,
-    unsigned char blue)
+void vsChromaKey::calcKeyMask(unsigned char *red, unsigned char *green,
+    unsigned char *blue, int pixelStride, int count, unsigned char *mask)
 {
-    int result = -1;
-    int dr, dg, db;
+    int kr, kg, kb, threshold;
+    int dr, dg, db, diff;
+    int first;
+    int i;
+
+    // Separate channel images go through the SIMD kernel where there is
+    // one, and the loops below finish whatever it leaves
+    first = 0;
+#ifdef VS_CHROMAKEY_USE_SSE2
+    if ((pixelStride == 1) &&
+        ((keyEquation == VS_CHROMAKEY_DIFF_SUM) ||
+         (keyEquation == VS_CHROMAKEY_DIFF_LARGEST)))
+        first = keyMaskSSE2(red, green, blue, count, keyRed, keyGreen,
+            keyBlue, keyEquation, keyThreshold, mask);
+#endif
+
+    // Copy the key settings locally, so the compiler knows they can't
+    // change while we loop
+    kr = keyRed;
+    kg = keyGreen;
+    kb = keyBlue;
+    threshold = keyThreshold;
 
     switch (keyEquation)
     {
         // Sum of differences
         case VS_CHROMAKEY_DIFF_SUM:
-            result = abs(red - keyRed)
-                   + abs(green - keyGreen)
-                   + abs(blue - keyBlue);
+            for (i = first; i < count; i++)
+            {
+                diff = abs(red[i * pixelStride] - kr)
+                     + abs(green[i * pixelStride] - kg)
+                     + abs(blue[i * pixelStride] - kb);
+                mask[i] = (unsigned char)(-(diff <= threshold));
+            }
             break;
 
         // Sum of differences squared
         case VS_CHROMAKEY_DIFF_SUM_SQUARED:
-            result = AT_SQR(red - keyRed)
-                   + AT_SQR(green - keyGreen)
-                   + AT_SQR(blue - keyBlue);
+            for (i = first; i < count; i++)
+            {
+                dr = red[i * pixelStride] - kr;
+                dg = green[i * pixelStride] - kg;
+                db = blue[i * pixelStride] - kb;
+                diff = AT_SQR(dr) + AT_SQR(dg) + AT_SQR(db);
+                mask[i] = (unsigned char)(-(diff <= threshold));
+            }
             break;
 
         // Largest difference only
         case VS_CHROMAKEY_DIFF_LARGEST:
-            dr = abs(red - keyRed);
-            dg = abs(green - keyGreen);
-            db = abs(blue - keyBlue);
-            result = ((dr > dg) ? dr : dg);
-            result = ((result > db) ? result : db);
+            for (i = first; i < count; i++)
+            {
+                dr = abs(red[i * pixelStride] - kr);
+                dg = abs(green[i * pixelStride] - kg);
+                db = abs(blue[i * pixelStride] - kb);
+                diff = ((dr > dg) ? dr : dg);
+                diff = ((diff > db) ? diff : db);
+                mask[i] = (unsigned char)(-(diff <= threshold));
+            }
+            break;
+
+        // Unknown equation, nothing matches the key
+        default:
+            memset(&mask[first], 0, count - first);
             break;
     }
+}
+
+//------------------------------------------------------------------------
+// Private function
+// Performs the job's operation on the rows [firstRow, lastRow) of the
+// image.  Each row is handled in fixed-size runs of pixels: first the key
+// mask is computed for the run, then the mask is applied to produce the
+// output, again without any per-pixel branches.
+//------------------------------------------------------------------------
+void vsChromaKey::processRows(vsChromaKeyJob *job, int firstRow,
+    int lastRow)
+{
+    unsigned char mask[VS_CHROMAKEY_RUN_LENGTH];
+    unsigned char *red, *green, *blue;
+    unsigned char *back, *out;
+    int inOffset, outOffset;
+    int row, column;
+    int count;
+    int i;
+
+    // Loop through the requested rows of the image
+    for (row = firstRow; row < lastRow; row++)
+    {
+        // Work across the row a run at a time
+        for (column = 0; column < job->imageWidth;
+             column += VS_CHROMAKEY_RUN_LENGTH)
+        {
+            // Figure out how many pixels are in this run
+            count = job->imageWidth - column;
+            if (count > VS_CHROMAKEY_RUN_LENGTH)
+                count = VS_CHROMAKEY_RUN_LENGTH;
+
+            // Find the start of the run in the input image
+            inOffset = row * job->inRowStride + column * job->pixelStride;
+            red = &job->red[inOffset];
+            green = &job->green[inOffset];
+            blue = &job->blue[inOffset];
+
+            // Determine which pixels match the key color
+            calcKeyMask(red, green, blue, job->pixelStride, count, mask);
+
+            // Apply the mask
+            switch (job->operation)
+            {
+                case VS_CHROMAKEY_OP_CREATE_RGBA:
+                    // Copy the color, and make the matching pixels
+                    // transparent and the rest opaque
+                    out = &job->output[row * job->outRowStride + column * 4];
+                    for (i = 0; i < count; i++)
+                    {
+                        out[i * 4 + 0] = red[i * 3];
+                        out[i * 4 + 1] = green[i * 3];
+                        out[i * 4 + 2] = blue[i * 3];
+                        out[i * 4 + 3] = ~mask[i];
+                    }
+                    break;
+
+                case VS_CHROMAKEY_OP_CREATE_ALPHA:
+                    // Make the matching pixels transparent and the rest
+                    // opaque
+                    out = &job->output[row * job->outRowStride + column];
+                    for (i = 0; i < count; i++)
+                        out[i] = ~mask[i];
+                    break;
+
+                case VS_CHROMAKEY_OP_MODIFY_RGBA:
+                    // Clear the alpha of the matching pixels, leaving the
+                    // rest alone
+                    out = &job->output[row * job->outRowStride + column * 4];
+                    for (i = 0; i < count; i++)
+                        out[i * 4] &= ~mask[i];
+                    break;
+
+                case VS_CHROMAKEY_OP_MODIFY_ALPHA:
+                    // Clear the alpha of the matching pixels, leaving the
+                    // rest alone
+                    out = &job->output[row * job->outRowStride + column];
+                    for (i = 0; i < count; i++)
+                        out[i] &= ~mask[i];
+                    break;
+
+                case VS_CHROMAKEY_OP_COMBINE:
+                    // Take the background color where the foreground
+                    // matches the key, and the foreground color elsewhere
+                    outOffset = row * job->outRowStride + column * 3;
+                    back = &job->background[outOffset];
+                    out = &job->output[outOffset];
+                    for (i = 0; i < count; i++)
+                    {
+                        out[i * 3 + 0] = (back[i * 3 + 0] & mask[i]) |
+                            (red[i * 3] & ~mask[i]);
+                        out[i * 3 + 1] = (back[i * 3 + 1] & mask[i]) |
+                            (green[i * 3] & ~mask[i]);
+                        out[i * 3 + 2] = (back[i * 3 + 2] & mask[i]) |
+                            (blue[i * 3] & ~mask[i]);
+                    }
+                    break;
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------
+// Static private function
+// Thread pool task that processes a range of rows of an image
+//------------------------------------------------------------------------
+void vsChromaKey::rowTaskFunc(void *userData, int firstRow, int lastRow)
+{
+    vsChromaKeyJob *job;
+
+    // Hand the rows to the chroma key object that owns the job
+    job = (vsChromaKeyJob *)userData;
+    job->chromaKey->processRows(job, firstRow, lastRow);
+}
+
+//------------------------------------------------------------------------
+// Private function
+// Processes all rows of the image described by the job, splitting the
+// rows among the threads of the default thread pool
+//------------------------------------------------------------------------
+void vsChromaKey::runJob(vsChromaKeyJob *job, int imageHeight)
+{
+    // Nothing to do for an empty image
+    if ((job->imageWidth <= 0) || (imageHeight <= 0))
+        return;
+
+    // The rows are independent, so just split them up
+    job->chromaKey = this;
+    vsThreadPool::getDefaultPool()->parallelFor(imageHeight,
+        VS_CHROMAKEY_ROWS_PER_TASK, rowTaskFunc, job);
+}
+
+//------------------------------------------------------------------------
+// Private function
+// Returns the number of bytes from the start of one image row to the
+// start of the next, given the number of bytes of pixel data in the row
+// (rows are padded out to a multiple of the word size)
+//------------------------------------------------------------------------
+int vsChromaKey::getRowStride(int rowBytes)
+{
+    int rowExtra;
 
-    return result;
+    // Pad the row, if needed
+    rowExtra = rowBytes % wordSize;
+    if (rowExtra != 0)
+        return rowBytes + (wordSize - rowExtra);
+    else
+        return rowBytes;
 }
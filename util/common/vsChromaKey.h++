@@ -25,6 +25,8 @@
 
 #include "vsObject.h++"
 
+struct vsChromaKeyJob;
+
 enum vsChromaKeyEquationType
 {
     VS_CHROMAKEY_DIFF_SUM         = 0,
@@ -42,10 +44,22 @@ private:
 
     int                        wordSize;
 
-    // Computes the 'difference' between the given color and key color
-    int                        calcDifference(unsigned char red,
-                                              unsigned char green,
-                                              unsigned char blue);
+    // Marks which of a run of pixels are close enough to the key color
+    void                       calcKeyMask(unsigned char *red,
+                                           unsigned char *green,
+                                           unsigned char *blue,
+                                           int pixelStride, int count,
+                                           unsigned char *mask);
+
+    // Processes a range of rows of an image
+    void                       processRows(vsChromaKeyJob *job,
+                                           int firstRow, int lastRow);
+    static void                rowTaskFunc(void *userData, int firstRow,
+                                           int lastRow);
+
+    void                       runJob(vsChromaKeyJob *job,
+                                      int imageHeight);
+    int                        getRowStride(int rowBytes);
 
 public:
 
@@ -20,19 +20,46 @@
 //------------------------------------------------------------------------
 
 #include <stdio.h>
+#include <stdlib.h>
 #include "vsGlobals.h++"
 
 #include "vsObject.h++"
+#include "vsAtomic.h++"
 
-vsTreeMap *vsObject::currentObjectList = NULL;
+vsTreeMap *vsObject::currentObjectList[VS_OBJ_LIST_SHARD_COUNT];
 pthread_once_t vsObject::initObjectListOnce = PTHREAD_ONCE_INIT;
-pthread_mutex_t vsObject::objectListMutex;
+pthread_mutex_t vsObject::objectListMutex[VS_OBJ_LIST_SHARD_COUNT];
+
+//------------------------------------------------------------------------
+// Comparison function for qsort(), used to put the current objects in
+// address order when printing them
+//------------------------------------------------------------------------
+static int compareObjectAddresses(const void *first, const void *second)
+{
+    vsObject *firstObj, *secondObj;
+
+    // Get the two objects
+    firstObj = *((vsObject **)first);
+    secondObj = *((vsObject **)second);
+
+    // Order them by address
+    if (firstObj < secondObj)
+        return -1;
+    else if (firstObj > secondObj)
+        return 1;
+    else
+        return 0;
+}
 
 //------------------------------------------------------------------------
 // Constructor - Initializes the magic number and reference count
 //------------------------------------------------------------------------
 vsObject::vsObject()
 {
+#ifdef VESS_DEBUG
+    int shard;
+#endif
+
     // Copy the magic number into the first four bytes of the object
     magicNumber = VS_OBJ_MAGIC_NUMBER;
 
@@ -45,10 +72,12 @@ vsObject::vsObject()
     // make sure the initialization only happens once)
     pthread_once(&initObjectListOnce, initObjectList);
 
-    // Add this object to the object list
-    pthread_mutex_lock(&objectListMutex);
-    currentObjectList->addEntry(this, NULL);
-    pthread_mutex_unlock(&objectListMutex);
+    // Add this object to its piece of the object list
+    shard = getObjectListShard(this);
+    pthread_mutex_lock(&objectListMutex[shard]);
+    if (currentObjectList[shard])
+        currentObjectList[shard]->addEntry(this, NULL);
+    pthread_mutex_unlock(&objectListMutex[shard]);
 
 #endif
 }
@@ -59,7 +88,10 @@ vsObject::vsObject()
 //------------------------------------------------------------------------
 vsObject::~vsObject()
 {
+#ifdef VESS_DEBUG
     atPair *objListEntry;
+    int shard;
+#endif
 
     // Error checking
     if (magicNumber != VS_OBJ_MAGIC_NUMBER)
@@ -69,23 +101,27 @@ vsObject::~vsObject()
 
 #ifdef VESS_DEBUG
 
-    // Lock the object list mutex
-    pthread_mutex_lock(&objectListMutex);
+    // Lock the mutex for this object's piece of the object list
+    shard = getObjectListShard(this);
+    pthread_mutex_lock(&objectListMutex[shard]);
 
     // Remove this object from the object list
-    if (currentObjectList)
+    if (currentObjectList[shard])
     {
         // Remove the entry for this object from the global object map
-        objListEntry = currentObjectList->removeEntry(this);
+        objListEntry = currentObjectList[shard]->removeEntry(this);
 
         // Remove this object from the pair before deleting it, otherwise the
         // pair will try to free its memory again in its destructor
-        objListEntry->removeFirst();
-        delete objListEntry;
+        if (objListEntry)
+        {
+            objListEntry->removeFirst();
+            delete objListEntry;
+        }
     }
 
     // Release the object list mutex
-    pthread_mutex_unlock(&objectListMutex);
+    pthread_mutex_unlock(&objectListMutex[shard]);
 
 #endif
 
@@ -100,12 +136,33 @@ vsObject::~vsObject()
 //------------------------------------------------------------------------
 void vsObject::initObjectList()
 {
-    // Create a mutex to protect the object list (very necessary if we're
-    // running multiple threads)
-    pthread_mutex_init(&objectListMutex, NULL);
+    int i;
+
+    for (i = 0; i < VS_OBJ_LIST_SHARD_COUNT; i++)
+    {
+        // Create a mutex to protect each piece of the object list (very
+        // necessary if we're running multiple threads)
+        pthread_mutex_init(&objectListMutex[i], NULL);
 
-    // Create a tree map as a list for all allocated objects
-    currentObjectList = new vsTreeMap();
+        // Create a tree map as a list for the allocated objects
+        currentObjectList[i] = new vsTreeMap();
+    }
+}
+
+//------------------------------------------------------------------------
+// Returns which piece of the object list the given object belongs in
+//------------------------------------------------------------------------
+int vsObject::getObjectListShard(vsObject *obj)
+{
+    size_t address;
+
+    // Mix the address bits (the low bits are always zero because of
+    // alignment, and objects allocated together tend to share their high
+    // bits)
+    address = (size_t)obj;
+    address = (address >> 4) ^ (address >> 10) ^ (address >> 16);
+
+    return (int)(address % VS_OBJ_LIST_SHARD_COUNT);
 }
 
 //------------------------------------------------------------------------
@@ -120,31 +177,53 @@ void vsObject::ref()
         return;
     }
     
-    // Increment the reference count
-    refCount++;
+    // Increment the reference count (atomically, since objects may be
+    // shared between threads)
+    vsAtomicAdd(&refCount, 1);
 }
 
 //------------------------------------------------------------------------
-// Informs this object that it is no longer being used by another
+// Private function
+// Atomically decrements the reference count and returns the new count,
+// or -1 if the count couldn't be decremented
 //------------------------------------------------------------------------
-void vsObject::unref()
+int vsObject::releaseRef()
 {
+    int oldCount;
+
     // Magic number verify
     if (magicNumber != VS_OBJ_MAGIC_NUMBER)
     {
         notify(AT_WARN, "vsObject::unref: Operation on invalid object\n");
-        return;
+        return -1;
     }
 
-    // Reference count verify
-    if (refCount < 1)
+    // Keep trying until we decrement the count without another thread
+    // changing it out from under us
+    do
     {
-        notify(AT_WARN, "vsObject::unref: Called on unreferenced object\n");
-        return;
+        // Reference count verify
+        oldCount = refCount;
+        if (oldCount < 1)
+        {
+            notify(AT_WARN,
+                "vsObject::unref: Called on unreferenced object\n");
+            return -1;
+        }
     }
-    
+    while (!vsAtomicCompareAndSwap(&refCount, oldCount, oldCount - 1));
+
+    // Return the new count
+    return oldCount - 1;
+}
+
+//------------------------------------------------------------------------
+// Informs this object that it is no longer being used by another
+//------------------------------------------------------------------------
+void vsObject::unref()
+{
     // Decrement the reference count
-    refCount--;
+    releaseRef();
 }
 
 //------------------------------------------------------------------------
@@ -182,15 +261,19 @@ void vsObject::checkDelete(vsObject *obj)
 //------------------------------------------------------------------------
 // Static function
 // Unreferences the given object, then deletes the object if its reference
-// count is zero
+// count is zero.  Only the thread that releases the last reference
+// deletes the object.
 //------------------------------------------------------------------------
 void vsObject::unrefDelete(vsObject *obj)
 {
     if (obj == NULL)
         return;
     if (obj->getRefCount() > 0)
-        obj->unref();
-    if (obj->getRefCount() == 0)
+    {
+        if (obj->releaseRef() == 0)
+            delete obj;
+    }
+    else if (obj->getRefCount() == 0)
         delete obj;
 }
 
@@ -203,34 +286,64 @@ void vsObject::printCurrentObjects(FILE *outfile)
 {
     atList keyList;
     int listSize;
+    vsObject **objectArray;
     vsObject *currentObj;
+    int i, count;
 
     // Bail if no object list present
-    if (!currentObjectList)
+    if (!currentObjectList[0])
         return;
 
-    // Get the size of the list
-    listSize = currentObjectList->getNumEntries();
+    // Lock every piece of the object list, so we get a consistent picture
+    // of what's allocated
+    for (i = 0; i < VS_OBJ_LIST_SHARD_COUNT; i++)
+        pthread_mutex_lock(&objectListMutex[i]);
 
-    // Get a sorted list of keys and values from the tree map
-    currentObjectList->getSortedList(&keyList, NULL);
+    // Get the total size of the list
+    listSize = 0;
+    for (i = 0; i < VS_OBJ_LIST_SHARD_COUNT; i++)
+        listSize += currentObjectList[i]->getNumEntries();
+
+    // Gather the objects from all of the pieces
+    objectArray = new vsObject *[listSize + 1];
+    count = 0;
+    for (i = 0; i < VS_OBJ_LIST_SHARD_COUNT; i++)
+    {
+        // Get a list of keys from this piece's tree map
+        currentObjectList[i]->getSortedList(&keyList, NULL);
+
+        // Copy them to the array
+        currentObj = (vsObject *) keyList.getFirstEntry();
+        while ((currentObj != NULL) && (count < listSize))
+        {
+            objectArray[count] = currentObj;
+            count++;
+            currentObj = (vsObject *) keyList.getNextEntry();
+        }
+
+        // Remove the keys so they aren't deleted when the list is reused
+        // or goes out of scope
+        keyList.removeAllEntries();
+    }
+
+    // Put the objects back in address order
+    qsort(objectArray, count, sizeof(vsObject *), compareObjectAddresses);
 
     // Print all objects that are currently allocated to the output file
     fprintf(outfile, "list of allocated objects (%d):\n", listSize);
-    currentObj = (vsObject *) keyList.getFirstEntry();
-    while (currentObj != NULL)
+    for (i = 0; i < count; i++)
     {
         // Print the object's characteristics to the file
+        currentObj = objectArray[i];
         fprintf(outfile, "  object: %p   refcount = %d   class = \"%s\"   valid = %s\n",
             currentObj, currentObj->getRefCount(), currentObj->getClassName(),
             (currentObj->isValidObject() ? "TRUE" : "FALSE"));
-
-        // Next object
-        currentObj = (vsObject *) keyList.getNextEntry();
     }
 
-    // Remove the keys so they aren't deleted when the list goes out of scope
-    keyList.removeAllEntries();
+    // Clean up
+    delete [] objectArray;
+    for (i = VS_OBJ_LIST_SHARD_COUNT - 1; i >= 0; i--)
+        pthread_mutex_unlock(&objectListMutex[i]);
 }
 
 //------------------------------------------------------------------------
@@ -239,16 +352,24 @@ void vsObject::printCurrentObjects(FILE *outfile)
 //------------------------------------------------------------------------
 void vsObject::deleteObjectList()
 {
+    vsTreeMap *objectList;
+    int i;
+
     // Check if the list exists before deleting it
-    if (currentObjectList)
+    if (currentObjectList[0])
     {
-        // Remove all items from the map before deleting it
-        currentObjectList->removeAllEntries();
-        delete currentObjectList;
-        currentObjectList = NULL;
-
-        // Get rid of the mutex that protects this object as well
-        pthread_mutex_destroy(&objectListMutex);
+        for (i = 0; i < VS_OBJ_LIST_SHARD_COUNT; i++)
+        {
+            // Detach this piece of the list, so objects deleted from now
+            // on don't try to remove themselves from it
+            pthread_mutex_lock(&objectListMutex[i]);
+            objectList = currentObjectList[i];
+            currentObjectList[i] = NULL;
+            pthread_mutex_unlock(&objectListMutex[i]);
+
+            // Remove all items from the map before deleting it
+            objectList->removeAllEntries();
+            delete objectList;
+        }
     }
 }
-
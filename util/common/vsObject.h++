@@ -30,19 +30,27 @@
 
 #define VS_OBJ_MAGIC_NUMBER 0xFEEDF00D
 
+// Number of separately-locked pieces the list of current objects is split
+// into (objects are assigned to a piece by their address, so threads
+// creating and deleting objects rarely wait on each other)
+#define VS_OBJ_LIST_SHARD_COUNT 64
+
 class VESS_SYM vsObject : public atItem
 {
 private:
 
-    static vsTreeMap         *currentObjectList;
+    static vsTreeMap         *currentObjectList[VS_OBJ_LIST_SHARD_COUNT];
     static pthread_once_t    initObjectListOnce;
-    static pthread_mutex_t   objectListMutex;
+    static pthread_mutex_t   objectListMutex[VS_OBJ_LIST_SHARD_COUNT];
 
     int                      magicNumber;
     
-    int                      refCount;
+    volatile int             refCount;
 
     static void              initObjectList();
+    static int               getObjectListShard(vsObject *obj);
+
+    int                      releaseRef();
 
 public:
 
@@ -23,6 +23,8 @@
 //------------------------------------------------------------------------
 
 #include "vsSequencer.h++"
+#include "vsThreadPool.h++"
+#include "vsAtomic.h++"
 
 #include <stdlib.h>
 #include <string.h>
@@ -31,6 +33,51 @@
     #include <unistd.h>
 #endif
 
+// Data handed to the thread pool when running a stage of the parallel
+// schedule
+struct vsSequencerStageData
+{
+    vsSequencer       *sequencer;
+    UpdatableEntry    **entries;
+};
+
+// Thread-specific key used to number the threads in the Chrome trace
+static pthread_once_t   vsSequencerLaneOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t    vsSequencerLaneKey;
+static volatile int     vsSequencerLaneCount = 0;
+
+// ------------------------------------------------------------------------
+// Creates the thread-specific key used to number the threads in the trace
+// ------------------------------------------------------------------------
+static void vsSequencerCreateLaneKey()
+{
+    pthread_key_create(&vsSequencerLaneKey, NULL);
+}
+
+// ------------------------------------------------------------------------
+// Writes the given string to the file as a JSON string (without the
+// surrounding quotes), escaping any characters that need it
+// ------------------------------------------------------------------------
+static void vsSequencerWriteTraceString(FILE *file, const char *string)
+{
+    const char *ch;
+
+    // Escape quotes and backslashes, and replace control characters with
+    // spaces
+    for (ch = string; *ch != '\0'; ch++)
+    {
+        if ((*ch == '"') || (*ch == '\\'))
+        {
+            fputc('\\', file);
+            fputc(*ch, file);
+        }
+        else if ((unsigned char)(*ch) < 0x20)
+            fputc(' ', file);
+        else
+            fputc(*ch, file);
+    }
+}
+
 // ------------------------------------------------------------------------
 // Default constructor
 // ------------------------------------------------------------------------
@@ -41,8 +88,22 @@ vsSequencer::vsSequencer(void) : vsUpdatable()
     updatableListHead = NULL;
     updatableListTail = NULL;
     
-    // Create the vsTimer to time the gaps between tasks
+    // Create the vsTimer to time the updatables.  It is marked only once,
+    // here, so it also serves as the time base for the trace.
     sequencerTimer = new vsTimer();
+
+    // Update serially, in list order, by default
+    scheduleMode = VS_SEQUENCER_SERIAL;
+    scheduleDirty = true;
+    scheduleList = NULL;
+    stageStart = NULL;
+    stageCount = 0;
+
+    // Keep timing statistics, but don't keep a trace until asked to
+    timingEnabled = true;
+    traceEvents = NULL;
+    traceSize = 0;
+    traceEventCount = 0;
 }
 
 // ------------------------------------------------------------------------
@@ -58,11 +119,17 @@ vsSequencer::~vsSequencer(void)
         tempEntry = updatableListHead;
         updatableListHead = updatableListHead->next;
 
-        // Unreference the vsUpdatable
-        vsObject::unrefDelete( tempEntry->updatable );
-
-        free(tempEntry);
+        // Unreference the vsUpdatable and free the entry
+        freeEntry(tempEntry);
     }
+
+    // Free the schedule and trace
+    if (scheduleList != NULL)
+        free(scheduleList);
+    if (stageStart != NULL)
+        free(stageStart);
+    if (traceEvents != NULL)
+        free(traceEvents);
     
     // Delete the timer
     delete sequencerTimer;
@@ -115,6 +182,15 @@ void vsSequencer::addUpdatable(vsUpdatable *updatable, double time,
     tempEntry->name[VS_SEQUENCER_MAX_UPDATABLE_NAME_LENGTH - 1] = '\0';
     tempEntry->next = NULL;
 
+    // The updatable starts out without any declared resources or
+    // dependencies, and with no timing statistics
+    tempEntry->accessList = NULL;
+    tempEntry->accessCount = 0;
+    tempEntry->dependencyList = NULL;
+    tempEntry->dependencyCount = 0;
+    tempEntry->stage = 0;
+    memset(&tempEntry->timing, 0, sizeof(UpdatableTiming));
+
     // Insert it to the end of the list.
     if (!updatableListHead)
     {
@@ -130,6 +206,9 @@ void vsSequencer::addUpdatable(vsUpdatable *updatable, double time,
 
     // Increment the count of updatables.
     updatableCount++;
+
+    // The parallel schedule needs to be rebuilt
+    scheduleDirty = true;
 }
 
 // ------------------------------------------------------------------------
@@ -139,6 +218,7 @@ void vsSequencer::removeUpdatable(vsUpdatable *updatable)
 {
     UpdatableEntry  *tempEntry;
     bool            found;
+    int             i;
 
     // Go through the list, starting at the head.
     tempEntry = updatableListHead;
@@ -151,12 +231,9 @@ void vsSequencer::removeUpdatable(vsUpdatable *updatable)
             // Remove the entry from the list.
             removeEntryFromList(tempEntry);
 
-            // Unreference the vsUpdatable
-            vsObject::unrefDelete( tempEntry->updatable );
-
-            // Delete the structure, decrement count,
-            // and set the found variable to true.
-            free(tempEntry);
+            // Unreference the vsUpdatable and delete the structure,
+            // decrement count, and set the found variable to true.
+            freeEntry(tempEntry);
             updatableCount--;
             found = true;
         }
@@ -171,7 +248,29 @@ void vsSequencer::removeUpdatable(vsUpdatable *updatable)
     if (!found)
     {
         printf("vsSequencer::removeUpdatable: Updatable not found!\n");
+        return;
     }
+
+    // Remove the updatable from the dependencies of the other entries
+    for (tempEntry = updatableListHead; tempEntry; tempEntry = tempEntry->next)
+    {
+        i = 0;
+        while (i < tempEntry->dependencyCount)
+        {
+            if (tempEntry->dependencyList[i] == updatable)
+            {
+                // Move the last dependency into this spot
+                tempEntry->dependencyCount--;
+                tempEntry->dependencyList[i] =
+                    tempEntry->dependencyList[tempEntry->dependencyCount];
+            }
+            else
+                i++;
+        }
+    }
+
+    // The parallel schedule needs to be rebuilt
+    scheduleDirty = true;
 }
 
 // ------------------------------------------------------------------------
@@ -232,6 +331,10 @@ void vsSequencer::setUpdatableTime(vsUpdatable *updatable, double time)
         {
             tempEntry->time = time;
             found = true;
+
+            // Timed entries are scheduled differently, so the parallel
+            // schedule needs to be rebuilt
+            scheduleDirty = true;
         }
         // Else continue down the list.
         else
@@ -421,6 +524,9 @@ void vsSequencer::setUpdatablePosition(vsUpdatable *updatable,
         // Else it is already where it belongs.
     }
     // Else it cannot be moved.
+
+    // The parallel schedule needs to be rebuilt
+    scheduleDirty = true;
 }
 
 // ------------------------------------------------------------------------
@@ -537,70 +643,775 @@ vsUpdatable *vsSequencer::getUpdatableByName(char *name)
         return tempEntry->updatable;
 }
 
+// ------------------------------------------------------------------------
+// Sets how the updatables are run.  In serial mode (the default), they
+// are updated one at a time, in list order.  In parallel mode, updatables
+// that have declared the resources they access (or the updatables they
+// depend on) may be updated at the same time as other such updatables
+// on the thread pool, as long as they don't conflict.  Updatables that
+// declare nothing, and updatables with a slot time, still run alone, in
+// their place in the list.
+// ------------------------------------------------------------------------
+void vsSequencer::setScheduleMode(vsSequencerScheduleMode mode)
+{
+    scheduleMode = mode;
+    scheduleDirty = true;
+}
+
+// ------------------------------------------------------------------------
+// Returns how the updatables are run
+// ------------------------------------------------------------------------
+vsSequencerScheduleMode vsSequencer::getScheduleMode(void)
+{
+    return scheduleMode;
+}
+
+// ------------------------------------------------------------------------
+// Declares that the specified updatable reads or writes the named
+// resource during its update.  Two updatables conflict (and are never
+// run at the same time) if they both access the same resource and at
+// least one of them writes it.  The resource names are arbitrary, they
+// are only compared to each other.
+// ------------------------------------------------------------------------
+void vsSequencer::addUpdatableAccess(vsUpdatable *updatable,
+                                     char *resourceName,
+                                     vsSequencerAccessMode mode)
+{
+    UpdatableEntry  *tempEntry;
+    UpdatableAccess *newList;
+    int             i;
+
+    // Find the updatable's entry
+    tempEntry = findEntry(updatable);
+    if (!tempEntry)
+    {
+        printf("vsSequencer::addUpdatableAccess: Updatable not found!\n");
+        return;
+    }
+
+    // If the resource is already declared, just upgrade the access mode
+    // if necessary
+    for (i = 0; i < tempEntry->accessCount; i++)
+    {
+        if (strcmp(tempEntry->accessList[i].resourceName, resourceName) == 0)
+        {
+            if (mode == VS_SEQUENCER_WRITE)
+            {
+                tempEntry->accessList[i].mode = VS_SEQUENCER_WRITE;
+                scheduleDirty = true;
+            }
+            return;
+        }
+    }
+
+    // Make room for the new resource
+    newList = (UpdatableAccess *)realloc(tempEntry->accessList,
+        sizeof(UpdatableAccess) * (tempEntry->accessCount + 1));
+    if (!newList)
+    {
+        printf("vsSequencer::addUpdatableAccess: Unable to allocate space "
+            "for resource!\n");
+        return;
+    }
+    tempEntry->accessList = newList;
+
+    // Add the resource
+    tempEntry->accessList[tempEntry->accessCount].resourceName =
+        strdup(resourceName);
+    tempEntry->accessList[tempEntry->accessCount].mode = mode;
+    tempEntry->accessCount++;
+
+    // The parallel schedule needs to be rebuilt
+    scheduleDirty = true;
+}
+
+// ------------------------------------------------------------------------
+// Declares that the specified updatable must not be updated until the
+// dependency has finished updating.  The dependency must come before the
+// updatable in the sequencer.
+// ------------------------------------------------------------------------
+void vsSequencer::addUpdatableDependency(vsUpdatable *updatable,
+                                         vsUpdatable *dependency)
+{
+    UpdatableEntry  *tempEntry;
+    vsUpdatable     **newList;
+    int             i;
+
+    // An updatable can't depend on itself
+    if (updatable == dependency)
+    {
+        printf("vsSequencer::addUpdatableDependency: An updatable can't "
+            "depend on itself!\n");
+        return;
+    }
+
+    // Find the updatable's entry and make sure the dependency is also in
+    // this sequencer
+    tempEntry = findEntry(updatable);
+    if ((!tempEntry) || (!findEntry(dependency)))
+    {
+        printf("vsSequencer::addUpdatableDependency: Updatable not "
+            "found!\n");
+        return;
+    }
+
+    // Ignore the dependency if we already know about it
+    for (i = 0; i < tempEntry->dependencyCount; i++)
+        if (tempEntry->dependencyList[i] == dependency)
+            return;
+
+    // Make room for the new dependency
+    newList = (vsUpdatable **)realloc(tempEntry->dependencyList,
+        sizeof(vsUpdatable *) * (tempEntry->dependencyCount + 1));
+    if (!newList)
+    {
+        printf("vsSequencer::addUpdatableDependency: Unable to allocate "
+            "space for dependency!\n");
+        return;
+    }
+    tempEntry->dependencyList = newList;
+
+    // Add the dependency
+    tempEntry->dependencyList[tempEntry->dependencyCount] = dependency;
+    tempEntry->dependencyCount++;
+
+    // The parallel schedule needs to be rebuilt
+    scheduleDirty = true;
+}
+
+// ------------------------------------------------------------------------
+// Removes all of the resources and dependencies declared for the given
+// updatable.  It will go back to being updated alone, in its place in
+// the list.
+// ------------------------------------------------------------------------
+void vsSequencer::clearUpdatableDependencies(vsUpdatable *updatable)
+{
+    UpdatableEntry  *tempEntry;
+    int             i;
+
+    // Find the updatable's entry
+    tempEntry = findEntry(updatable);
+    if (!tempEntry)
+    {
+        printf("vsSequencer::clearUpdatableDependencies: Updatable not "
+            "found!\n");
+        return;
+    }
+
+    // Free the resource names and the lists
+    for (i = 0; i < tempEntry->accessCount; i++)
+        free(tempEntry->accessList[i].resourceName);
+    if (tempEntry->accessList != NULL)
+        free(tempEntry->accessList);
+    if (tempEntry->dependencyList != NULL)
+        free(tempEntry->dependencyList);
+    tempEntry->accessList = NULL;
+    tempEntry->accessCount = 0;
+    tempEntry->dependencyList = NULL;
+    tempEntry->dependencyCount = 0;
+
+    // The parallel schedule needs to be rebuilt
+    scheduleDirty = true;
+}
+
+// ------------------------------------------------------------------------
+// Enables or disables the collection of timing statistics (and trace
+// events) for the updatables
+// ------------------------------------------------------------------------
+void vsSequencer::setTimingEnabled(bool enable)
+{
+    timingEnabled = enable;
+}
+
+// ------------------------------------------------------------------------
+// Returns whether timing statistics are being collected
+// ------------------------------------------------------------------------
+bool vsSequencer::isTimingEnabled(void)
+{
+    return timingEnabled;
+}
+
+// ------------------------------------------------------------------------
+// Clears the timing statistics of all updatables, as well as the trace
+// ------------------------------------------------------------------------
+void vsSequencer::resetTiming(void)
+{
+    UpdatableEntry  *tempEntry;
+
+    // Clear each entry's statistics
+    for (tempEntry = updatableListHead; tempEntry; tempEntry = tempEntry->next)
+        memset(&tempEntry->timing, 0, sizeof(UpdatableTiming));
+
+    // Empty the trace
+    traceEventCount = 0;
+}
+
+// ------------------------------------------------------------------------
+// Copies the timing statistics of the given updatable into the given
+// structure.  All times are in seconds.  Returns false if the updatable
+// isn't in this sequencer.
+// ------------------------------------------------------------------------
+bool vsSequencer::getUpdatableTiming(vsUpdatable *updatable,
+                                     UpdatableTiming *timing)
+{
+    UpdatableEntry  *tempEntry;
+
+    // Find the updatable's entry
+    tempEntry = findEntry(updatable);
+    if (!tempEntry)
+    {
+        printf("vsSequencer::getUpdatableTiming: Updatable not found!\n");
+        return false;
+    }
+
+    // Copy the statistics
+    memcpy(timing, &tempEntry->timing, sizeof(UpdatableTiming));
+    return true;
+}
+
+// ------------------------------------------------------------------------
+// Static function
+// Returns the upper limit (in seconds) of the given bucket of the timing
+// histograms.  The last bucket has no upper limit, so a negative value
+// is returned for it.
+// ------------------------------------------------------------------------
+double vsSequencer::getTimingBucketLimit(int bucket)
+{
+    double limit;
+    int    i;
+
+    // Check the bucket index
+    if ((bucket < 0) || (bucket >= VS_SEQUENCER_TIMING_BUCKETS - 1))
+        return -1.0;
+
+    // Bucket i holds times less than 2^i microseconds
+    limit = 1.0e-6;
+    for (i = 0; i < bucket; i++)
+        limit *= 2.0;
+    return limit;
+}
+
+// ------------------------------------------------------------------------
+// Sets the number of update events to keep for the Chrome trace.  Once
+// this many events have been recorded, the oldest ones are overwritten.
+// A size of zero (the default) disables the trace.
+// ------------------------------------------------------------------------
+void vsSequencer::setTraceSize(int maxEvents)
+{
+    // Get rid of the old trace
+    if (traceEvents != NULL)
+        free(traceEvents);
+    traceEvents = NULL;
+    traceSize = 0;
+    traceEventCount = 0;
+
+    // Create the new one, if requested
+    if (maxEvents > 0)
+    {
+        traceEvents = (UpdatableTraceEvent *)
+            calloc(maxEvents, sizeof(UpdatableTraceEvent));
+        if (!traceEvents)
+        {
+            printf("vsSequencer::setTraceSize: Unable to allocate space "
+                "for trace!\n");
+            return;
+        }
+        traceSize = maxEvents;
+    }
+}
+
+// ------------------------------------------------------------------------
+// Returns the number of update events kept for the Chrome trace
+// ------------------------------------------------------------------------
+int vsSequencer::getTraceSize(void)
+{
+    return traceSize;
+}
+
+// ------------------------------------------------------------------------
+// Writes the recorded update events to the given file in the Chrome
+// trace event format (viewable in chrome://tracing).  Each thread that
+// ran updatables gets its own row.  Returns false if there's no trace or
+// the file can't be written.
+// ------------------------------------------------------------------------
+bool vsSequencer::writeChromeTrace(char *filename)
+{
+    FILE            *traceFile;
+    unsigned int    eventCount;
+    unsigned int    i;
+
+    // Make sure we have a trace to write
+    if (traceEvents == NULL)
+    {
+        printf("vsSequencer::writeChromeTrace: Tracing is not enabled!\n");
+        return false;
+    }
+
+    // Open the file
+    traceFile = fopen(filename, "w");
+    if (traceFile == NULL)
+    {
+        printf("vsSequencer::writeChromeTrace: Unable to open '%s'!\n",
+            filename);
+        return false;
+    }
+
+    // Figure out how many events are in the buffer (the viewer sorts the
+    // events by time, so it doesn't matter where the oldest one is)
+    eventCount = (unsigned int)traceEventCount;
+    if (eventCount > (unsigned int)traceSize)
+        eventCount = (unsigned int)traceSize;
+
+    // Write each event as a complete ("X") event, with times in
+    // microseconds
+    fprintf(traceFile, "{\"traceEvents\":[\n");
+    for (i = 0; i < eventCount; i++)
+    {
+        fprintf(traceFile, "%s{\"name\":\"", (i > 0) ? ",\n" : "");
+        vsSequencerWriteTraceString(traceFile, traceEvents[i].name);
+        fprintf(traceFile, "\",\"cat\":\"vsSequencer\",\"ph\":\"X\","
+            "\"ts\":%.3lf,\"dur\":%.3lf,\"pid\":0,\"tid\":%d}",
+            traceEvents[i].startTime * 1.0e6,
+            traceEvents[i].duration * 1.0e6, traceEvents[i].lane);
+    }
+    fprintf(traceFile, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+    // Close the file and report whether everything was written
+    if (fclose(traceFile) != 0)
+    {
+        printf("vsSequencer::writeChromeTrace: Error writing '%s'!\n",
+            filename);
+        return false;
+    }
+    return true;
+}
+
 // ------------------------------------------------------------------------
 // Update all the updatables this sequencer manages.
 // ------------------------------------------------------------------------
 void vsSequencer::update(void)
+{
+    UpdatableEntry          *tempEntry;
+    vsSequencerStageData    stageData;
+    int                     stage;
+    int                     first, count;
+
+    // In serial mode, go through the list, starting at the head.
+    if (scheduleMode == VS_SEQUENCER_SERIAL)
+    {
+        tempEntry = updatableListHead;
+        while (tempEntry)
+        {
+            updateEntry(tempEntry);
+            tempEntry = tempEntry->next;
+        }
+
+        return;
+    }
+
+    // Work out which updatables can run together, if anything changed
+    if (scheduleDirty)
+        buildSchedule();
+
+    // Run each stage of the schedule in turn
+    stageData.sequencer = this;
+    for (stage = 0; stage < stageCount; stage++)
+    {
+        // Get the entries in this stage
+        first = stageStart[stage];
+        count = stageStart[stage + 1] - first;
+
+        // Single entries (including all of the timed and undeclared ones)
+        // are just updated here.  Otherwise, spread the entries out over
+        // the thread pool, one entry at a time, so threads that finish
+        // early pick up the remaining entries.
+        if (count == 1)
+            updateEntry(scheduleList[first]);
+        else
+        {
+            stageData.entries = &scheduleList[first];
+            vsThreadPool::getDefaultPool()->parallelFor(count, 1,
+                stageTaskFunc, &stageData);
+        }
+    }
+}
+
+// ------------------------------------------------------------------------
+// Private function
+// Returns the entry holding the given updatable, or NULL if it isn't in
+// this sequencer
+// ------------------------------------------------------------------------
+UpdatableEntry *vsSequencer::findEntry(vsUpdatable *updatable)
 {
     UpdatableEntry  *tempEntry;
-    double          tempTime;
-    double          endTime;
-    unsigned long   sleepTime;
 
     // Go through the list, starting at the head.
     tempEntry = updatableListHead;
-    while (tempEntry)
+    while ((tempEntry) && (tempEntry->updatable != updatable))
+        tempEntry = tempEntry->next;
+
+    return tempEntry;
+}
+
+// ------------------------------------------------------------------------
+// Private function
+// Unreferences the entry's updatable and frees the entry, along with its
+// declared resources and dependencies.  The entry must already be out of
+// the list.
+// ------------------------------------------------------------------------
+void vsSequencer::freeEntry(UpdatableEntry *entry)
+{
+    int i;
+
+    // Unreference the vsUpdatable
+    vsObject::unrefDelete(entry->updatable);
+
+    // Free the resources and dependencies
+    for (i = 0; i < entry->accessCount; i++)
+        free(entry->accessList[i].resourceName);
+    if (entry->accessList != NULL)
+        free(entry->accessList);
+    if (entry->dependencyList != NULL)
+        free(entry->dependencyList);
+
+    // Free the entry itself
+    free(entry);
+}
+
+// ------------------------------------------------------------------------
+// Private function
+// Returns whether the two entries access the same resource, with at
+// least one of them writing it
+// ------------------------------------------------------------------------
+bool vsSequencer::entriesConflict(UpdatableEntry *first,
+                                  UpdatableEntry *second)
+{
+    int i, j;
+
+    // Compare each pair of resources
+    for (i = 0; i < first->accessCount; i++)
     {
-        if (tempEntry->time != 0.0)
+        for (j = 0; j < second->accessCount; j++)
         {
-            // Mark the time we begin
-            sequencerTimer->mark();
+            if (((first->accessList[i].mode == VS_SEQUENCER_WRITE) ||
+                 (second->accessList[j].mode == VS_SEQUENCER_WRITE)) &&
+                (strcmp(first->accessList[i].resourceName,
+                        second->accessList[j].resourceName) == 0))
+                return true;
+        }
+    }
+
+    return false;
+}
 
-            // Update the updatable.
-            tempEntry->updatable->update();
+// ------------------------------------------------------------------------
+// Private function
+// Returns whether the entry has declared a dependency on the other one
+// ------------------------------------------------------------------------
+bool vsSequencer::entryDependsOn(UpdatableEntry *entry,
+                                 UpdatableEntry *dependency)
+{
+    int i;
+
+    // Look for the dependency's updatable in the entry's list
+    for (i = 0; i < entry->dependencyCount; i++)
+        if (entry->dependencyList[i] == dependency->updatable)
+            return true;
+
+    return false;
+}
 
-            // Get the time when the updating should be over.
-            endTime = tempEntry->time;
+// ------------------------------------------------------------------------
+// Private function
+// Returns whether the entry must be run by itself in the parallel
+// schedule.  That's the case for entries with a slot time (the time is
+// measured on the sequencer's thread), and for entries that haven't
+// declared anything (we can't know what they touch, so they keep their
+// place in the list relative to everything else).
+// ------------------------------------------------------------------------
+bool vsSequencer::isBarrierEntry(UpdatableEntry *entry)
+{
+    return ((entry->time != 0.0) ||
+            ((entry->accessCount == 0) && (entry->dependencyCount == 0)));
+}
 
-            // Get the amount of time elapsed since we marked the timer
-            tempTime = sequencerTimer->getElapsed();
+// ------------------------------------------------------------------------
+// Private function
+// Divides the updatables into stages for the parallel schedule.  The
+// stages are run one after the other, and the entries in a stage may run
+// at the same time.  Each barrier entry gets a stage of its own, after
+// everything before it in the list and before everything after it.  Any
+// other entry goes in the first stage after the last barrier and after
+// every earlier entry it conflicts with or depends on, so the list order
+// is kept wherever it matters.
+// ------------------------------------------------------------------------
+void vsSequencer::buildSchedule()
+{
+    UpdatableEntry  *tempEntry;
+    UpdatableEntry  *prevEntry;
+    int             lastBarrierStage;
+    int             *fillIndex;
+    bool            found;
+    int             i;
+
+    // Get rid of the old schedule
+    if (scheduleList != NULL)
+        free(scheduleList);
+    if (stageStart != NULL)
+        free(stageStart);
+    scheduleList = NULL;
+    stageStart = NULL;
+    stageCount = 0;
+    scheduleDirty = false;
+
+    // Nothing to do if there aren't any updatables
+    if (updatableCount == 0)
+        return;
 
-            // If the end time is small, do a busy wait.  Otherwise, use
-            // usleep() to do the waiting
-            if (endTime < 0.01)
+    // Assign each entry to a stage
+    lastBarrierStage = -1;
+    for (tempEntry = updatableListHead; tempEntry; tempEntry = tempEntry->next)
+    {
+        if (isBarrierEntry(tempEntry))
+        {
+            // Barriers go after everything so far
+            tempEntry->stage = stageCount;
+            lastBarrierStage = tempEntry->stage;
+        }
+        else
+        {
+            // Start right after the last barrier, then move past any
+            // earlier entry (since that barrier) that this one conflicts
+            // with or depends on
+            tempEntry->stage = lastBarrierStage + 1;
+            prevEntry = tempEntry->prev;
+            while ((prevEntry) && (!isBarrierEntry(prevEntry)))
             {
-                // While we have not reached the end time, keep querying 
-                // the time.
-                while (tempTime < endTime)
-                {
-                    // Get the amount of time elapsed since we marked the timer
-                    tempTime = sequencerTimer->getElapsed();
-                }
+                if (((entriesConflict(prevEntry, tempEntry)) ||
+                     (entryDependsOn(tempEntry, prevEntry))) &&
+                    (prevEntry->stage >= tempEntry->stage))
+                    tempEntry->stage = prevEntry->stage + 1;
+
+                prevEntry = prevEntry->prev;
             }
-            else
+
+            // Warn about any dependencies that come after this entry, as
+            // they can't be honored without breaking the list order
+            for (i = 0; i < tempEntry->dependencyCount; i++)
             {
-                if (tempTime < endTime)
+                found = false;
+                prevEntry = tempEntry->prev;
+                while ((prevEntry) && (!found))
                 {
-                    // Compute the amount of time to sleep
-                    tempTime = endTime - tempTime;
-
-                    // Don't try to sleep if we've already reached the
-                    // end time
-                    if (tempTime > 0.0)
-                    {
-                        sleepTime = ((unsigned long) (tempTime * 1000000.0));
-                        usleep(sleepTime);
-                    }
+                    found = (prevEntry->updatable ==
+                        tempEntry->dependencyList[i]);
+                    prevEntry = prevEntry->prev;
                 }
+
+                if (!found)
+                    printf("vsSequencer::buildSchedule: Updatable '%s' "
+                        "depends on an updatable that comes after it; "
+                        "dependency ignored\n", tempEntry->name);
             }
         }
-        else
-        {
-            tempEntry->updatable->update();
-        }
 
-        tempEntry = tempEntry->next;
+        // Keep track of how many stages there are
+        if (tempEntry->stage >= stageCount)
+            stageCount = tempEntry->stage + 1;
+    }
+
+    // Allocate the schedule
+    scheduleList = (UpdatableEntry **)
+        malloc(sizeof(UpdatableEntry *) * updatableCount);
+    stageStart = (int *)calloc(stageCount + 1, sizeof(int));
+    fillIndex = (int *)malloc(sizeof(int) * stageCount);
+    if ((!scheduleList) || (!stageStart) || (!fillIndex))
+    {
+        printf("vsSequencer::buildSchedule: Unable to allocate space for "
+            "schedule!\n");
+        exit(1);
     }
+
+    // Count the entries in each stage, and work out where each stage
+    // starts in the schedule
+    for (tempEntry = updatableListHead; tempEntry; tempEntry = tempEntry->next)
+        stageStart[tempEntry->stage + 1]++;
+    for (i = 0; i < stageCount; i++)
+    {
+        stageStart[i + 1] += stageStart[i];
+        fillIndex[i] = stageStart[i];
+    }
+
+    // Place the entries, keeping the list order within each stage
+    for (tempEntry = updatableListHead; tempEntry; tempEntry = tempEntry->next)
+    {
+        scheduleList[fillIndex[tempEntry->stage]] = tempEntry;
+        fillIndex[tempEntry->stage]++;
+    }
+
+    // Clean up
+    free(fillIndex);
+}
+
+// ------------------------------------------------------------------------
+// Private function
+// Updates the updatable in the given entry, keeping track of how long it
+// took, and then waits out the rest of the entry's slot time (if any)
+// ------------------------------------------------------------------------
+void vsSequencer::updateEntry(UpdatableEntry *entry)
+{
+    double startTime;
+    double endTime;
+
+    // If we don't need to time this one, just update it
+    if ((!timingEnabled) && (entry->time == 0.0))
+    {
+        entry->updatable->update();
+        return;
+    }
+
+    // Update the updatable, noting the time before and after
+    startTime = sequencerTimer->getElapsed();
+    entry->updatable->update();
+    endTime = sequencerTimer->getElapsed();
+
+    // Record the time it took
+    if (timingEnabled)
+        recordTiming(entry, startTime, endTime);
+
+    // Wait for the rest of the slot
+    if (entry->time != 0.0)
+        waitForSlot(startTime, entry->time);
+}
+
+// ------------------------------------------------------------------------
+// Private function
+// Waits until the given slot time has passed since the given start time.
+// Most of the wait is done by sleeping, but the last little bit is spent
+// polling the timer, since sleeps tend to overshoot.
+// ------------------------------------------------------------------------
+void vsSequencer::waitForSlot(double startTime, double slotTime)
+{
+    double         remainingTime;
+    unsigned long  sleepTime;
+
+    // Figure out how much of the slot is left
+    remainingTime = slotTime - (sequencerTimer->getElapsed() - startTime);
+
+    // Sleep through all but the end of the slot
+    if (remainingTime > VS_SEQUENCER_SPIN_TIME)
+    {
+        sleepTime = (unsigned long)
+            ((remainingTime - VS_SEQUENCER_SPIN_TIME) * 1000000.0);
+        usleep(sleepTime);
+    }
+
+    // While we have not reached the end time, keep querying the time.
+    while ((sequencerTimer->getElapsed() - startTime) < slotTime)
+        ;
+}
+
+// ------------------------------------------------------------------------
+// Private function
+// Adds an update of the given entry to its timing statistics and to the
+// trace.  Only the thread running the entry touches its statistics, so
+// only the trace needs to be shared safely.
+// ------------------------------------------------------------------------
+void vsSequencer::recordTiming(UpdatableEntry *entry, double startTime,
+                               double endTime)
+{
+    UpdatableTiming      *timing;
+    UpdatableTraceEvent  *event;
+    double               duration;
+    double               bucketLimit;
+    int                  bucket;
+    unsigned int         eventIndex;
+
+    // Get the duration (the clock can step backwards, so clamp it)
+    duration = endTime - startTime;
+    if (duration < 0.0)
+        duration = 0.0;
+
+    // Update the statistics
+    timing = &entry->timing;
+    if ((timing->updateCount == 0) || (duration < timing->minTime))
+        timing->minTime = duration;
+    if (duration > timing->maxTime)
+        timing->maxTime = duration;
+    timing->lastTime = duration;
+    timing->totalTime += duration;
+    timing->updateCount++;
+
+    // Count the update as an overrun if it took longer than its slot
+    if ((entry->time != 0.0) && (duration > entry->time))
+        timing->overrunCount++;
+
+    // Find the histogram bucket for this duration
+    bucket = 0;
+    bucketLimit = 1.0e-6;
+    while ((bucket < VS_SEQUENCER_TIMING_BUCKETS - 1) &&
+           (duration >= bucketLimit))
+    {
+        bucket++;
+        bucketLimit *= 2.0;
+    }
+    timing->histogram[bucket]++;
+
+    // Add an event to the trace, if we're keeping one
+    if (traceEvents != NULL)
+    {
+        // Claim the next event in the ring buffer
+        eventIndex = (unsigned int)vsAtomicFetchAdd(&traceEventCount, 1);
+        event = &traceEvents[eventIndex % (unsigned int)traceSize];
+
+        // Fill it in
+        strcpy(event->name, entry->name);
+        event->startTime = startTime;
+        event->duration = duration;
+        event->lane = getThreadLane();
+    }
+}
+
+// ------------------------------------------------------------------------
+// Static private function
+// Returns a small number identifying the calling thread in the trace
+// ------------------------------------------------------------------------
+int vsSequencer::getThreadLane()
+{
+    void *laneValue;
+    long lane;
+
+    // Make sure the key exists
+    pthread_once(&vsSequencerLaneOnce, vsSequencerCreateLaneKey);
+
+    // Give the thread a number the first time we see it (the numbers
+    // start at one, so a NULL value means the thread doesn't have one yet)
+    laneValue = pthread_getspecific(vsSequencerLaneKey);
+    if (laneValue == NULL)
+    {
+        lane = vsAtomicAdd(&vsSequencerLaneCount, 1);
+        pthread_setspecific(vsSequencerLaneKey, (void *)lane);
+    }
+    else
+        lane = (long)laneValue;
+
+    return (int)lane;
+}
+
+// ------------------------------------------------------------------------
+// Static private function
+// Thread pool task that updates a range of the entries in a stage of the
+// parallel schedule
+// ------------------------------------------------------------------------
+void vsSequencer::stageTaskFunc(void *userData, int first, int last)
+{
+    vsSequencerStageData *stageData;
+    int                  i;
+
+    // Update each entry in the range
+    stageData = (vsSequencerStageData *)userData;
+    for (i = first; i < last; i++)
+        stageData->sequencer->updateEntry(stageData->entries[i]);
 }
 
 // ------------------------------------------------------------------------
@@ -28,12 +28,51 @@
 #include "vsUpdatable.h++"
 #include "vsTimer.h++"
 #include "vsGlobals.h++"
+#include <stdio.h>
 
 // Maximum length of a name of a vsUpdatable in the sequencer.
 // This includes space for the \0 ending character (all names are
 // required to end in \0).
 #define VS_SEQUENCER_MAX_UPDATABLE_NAME_LENGTH   80
 
+// Number of buckets in each updatable's timing histogram.  Bucket i
+// counts updates that took less than 2^i microseconds (and at least
+// 2^(i-1) microseconds); the last bucket counts everything longer.
+#define VS_SEQUENCER_TIMING_BUCKETS              24
+
+// Slot times are waited out by sleeping, except for this last bit of
+// time (in seconds), which is spent polling the timer for accuracy
+#define VS_SEQUENCER_SPIN_TIME                   0.002
+
+enum vsSequencerScheduleMode
+{
+    VS_SEQUENCER_SERIAL,
+    VS_SEQUENCER_PARALLEL
+};
+
+enum vsSequencerAccessMode
+{
+    VS_SEQUENCER_READ,
+    VS_SEQUENCER_WRITE
+};
+
+struct VESS_SYM UpdatableAccess
+{
+    char                     *resourceName;
+    vsSequencerAccessMode    mode;
+};
+
+struct VESS_SYM UpdatableTiming
+{
+    unsigned long   updateCount;
+    unsigned long   overrunCount;
+    double          lastTime;
+    double          totalTime;
+    double          minTime;
+    double          maxTime;
+    unsigned long   histogram[VS_SEQUENCER_TIMING_BUCKETS];
+};
+
 struct VESS_SYM UpdatableEntry
 {
     vsUpdatable     *updatable;
@@ -41,18 +80,64 @@ struct VESS_SYM UpdatableEntry
     char            name[VS_SEQUENCER_MAX_UPDATABLE_NAME_LENGTH];
     UpdatableEntry  *prev;
     UpdatableEntry  *next;
+
+    UpdatableAccess *accessList;
+    int             accessCount;
+    vsUpdatable     **dependencyList;
+    int             dependencyCount;
+    int             stage;
+
+    UpdatableTiming timing;
+};
+
+struct VESS_SYM UpdatableTraceEvent
+{
+    char            name[VS_SEQUENCER_MAX_UPDATABLE_NAME_LENGTH];
+    double          startTime;
+    double          duration;
+    int             lane;
 };
 
 class VESS_SYM vsSequencer : public vsUpdatable
 {
 private:
 
-    unsigned long   updatableCount;
-    UpdatableEntry  *updatableListHead;
-    UpdatableEntry  *updatableListTail;
-    vsTimer         *sequencerTimer;
-
-    void            removeEntryFromList(UpdatableEntry *entry);
+    unsigned long              updatableCount;
+    UpdatableEntry             *updatableListHead;
+    UpdatableEntry             *updatableListTail;
+    vsTimer                    *sequencerTimer;
+
+    vsSequencerScheduleMode    scheduleMode;
+    bool                       scheduleDirty;
+    UpdatableEntry             **scheduleList;
+    int                        *stageStart;
+    int                        stageCount;
+
+    bool                       timingEnabled;
+    UpdatableTraceEvent        *traceEvents;
+    int                        traceSize;
+    volatile int               traceEventCount;
+
+    void                       removeEntryFromList(UpdatableEntry *entry);
+    UpdatableEntry             *findEntry(vsUpdatable *updatable);
+    void                       freeEntry(UpdatableEntry *entry);
+
+    bool                       entriesConflict(UpdatableEntry *first,
+                                               UpdatableEntry *second);
+    bool                       entryDependsOn(UpdatableEntry *entry,
+                                              UpdatableEntry *dependency);
+    bool                       isBarrierEntry(UpdatableEntry *entry);
+    void                       buildSchedule();
+
+    void                       updateEntry(UpdatableEntry *entry);
+    void                       waitForSlot(double startTime, double slotTime);
+    void                       recordTiming(UpdatableEntry *entry,
+                                            double startTime,
+                                            double endTime);
+
+    static int                 getThreadLane();
+    static void                stageTaskFunc(void *userData, int first,
+                                             int last);
 
 public:
 
@@ -81,6 +166,27 @@ public:
     vsUpdatable     *getUpdatable(unsigned long i);
     vsUpdatable     *getUpdatableByName(char *name);
 
+    void            setScheduleMode(vsSequencerScheduleMode mode);
+    vsSequencerScheduleMode    getScheduleMode(void);
+
+    void            addUpdatableAccess(vsUpdatable *updatable,
+                                       char *resourceName,
+                                       vsSequencerAccessMode mode);
+    void            addUpdatableDependency(vsUpdatable *updatable,
+                                           vsUpdatable *dependency);
+    void            clearUpdatableDependencies(vsUpdatable *updatable);
+
+    void            setTimingEnabled(bool enable);
+    bool            isTimingEnabled(void);
+    void            resetTiming(void);
+    bool            getUpdatableTiming(vsUpdatable *updatable,
+                                       UpdatableTiming *timing);
+    static double   getTimingBucketLimit(int bucket);
+
+    void            setTraceSize(int maxEvents);
+    int             getTraceSize(void);
+    bool            writeChromeTrace(char *filename);
+
     virtual void    update(void);
 };
 
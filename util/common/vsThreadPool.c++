@@ -0,0 +1,314 @@
+//------------------------------------------------------------------------
+//
+//    VIRTUAL ENVIRONMENT SOFTWARE SANDBOX (VESS)
+//
+//    Copyright (c) 2001, University of Central Florida
+//
+//       See the file LICENSE for license information
+//
+//    E-mail:  vess@ist.ucf.edu
+//    WWW:     http://vess.ist.ucf.edu/
+//
+//------------------------------------------------------------------------
+//
+//    VESS Module:  vsThreadPool.c++
+//
+//    Description:  Pool of worker threads used to split data-parallel
+//                  work (skinning, intersection batches, etc.) across
+//                  the available processors
+//
+//    Author(s):    agent
+//
+//------------------------------------------------------------------------
+
+#include "vsThreadPool.h++"
+#include "vsAtomic.h++"
+
+#ifdef __linux__
+    #include <unistd.h>
+#endif
+
+vsThreadPool * volatile vsThreadPool::defaultPool = NULL;
+pthread_mutex_t vsThreadPool::defaultPoolMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// ------------------------------------------------------------------------
+// Constructor - Starts the given number of worker threads.  The thread
+// calling parallelFor() also takes part in the work, so a pool with zero
+// worker threads simply runs everything serially.
+// ------------------------------------------------------------------------
+vsThreadPool::vsThreadPool(int numThreads)
+{
+    int i;
+
+    // Figure out how many workers to start if we're asked for the default
+    if (numThreads < 0)
+        numThreads = getProcessorCount() - 1;
+    if (numThreads < 0)
+        numThreads = 0;
+    threadCount = numThreads;
+
+    // Initialize the synchronization objects
+    pthread_mutex_init(&submitMutex, NULL);
+    pthread_mutex_init(&poolMutex, NULL);
+    pthread_cond_init(&workCondition, NULL);
+    pthread_cond_init(&doneCondition, NULL);
+
+    // No job yet
+    taskFunc = NULL;
+    taskData = NULL;
+    taskCount = 0;
+    taskGrain = 1;
+    nextTaskIndex = 0;
+    jobGeneration = 0;
+    busyWorkers = 0;
+    shutdownFlag = false;
+
+    // Start the worker threads
+    if (threadCount > 0)
+        workerThreads = new pthread_t[threadCount];
+    else
+        workerThreads = NULL;
+    for (i = 0; i < threadCount; i++)
+        pthread_create(&workerThreads[i], NULL, workerThreadFunc, this);
+}
+
+// ------------------------------------------------------------------------
+// Destructor - Signals the workers to quit and waits for them to exit
+// ------------------------------------------------------------------------
+vsThreadPool::~vsThreadPool()
+{
+    int i;
+
+    // Tell the workers to shut down
+    pthread_mutex_lock(&poolMutex);
+    shutdownFlag = true;
+    pthread_cond_broadcast(&workCondition);
+    pthread_mutex_unlock(&poolMutex);
+
+    // Wait for them to finish
+    for (i = 0; i < threadCount; i++)
+        pthread_join(workerThreads[i], NULL);
+    if (workerThreads != NULL)
+        delete [] workerThreads;
+
+    // Clean up the synchronization objects
+    pthread_cond_destroy(&doneCondition);
+    pthread_cond_destroy(&workCondition);
+    pthread_mutex_destroy(&poolMutex);
+    pthread_mutex_destroy(&submitMutex);
+}
+
+// ------------------------------------------------------------------------
+// Gets a string representation of this object's class name
+// ------------------------------------------------------------------------
+const char *vsThreadPool::getClassName()
+{
+    return "vsThreadPool";
+}
+
+// ------------------------------------------------------------------------
+// Static function
+// Main loop for the worker threads.  Each worker waits for a new job to
+// be posted, helps process it, then reports back that it's done
+// ------------------------------------------------------------------------
+void *vsThreadPool::workerThreadFunc(void *arg)
+{
+    vsThreadPool *pool;
+    int lastGeneration;
+
+    // Get the pool that owns this thread
+    pool = (vsThreadPool *)arg;
+    lastGeneration = 0;
+
+    while (true)
+    {
+        // Wait for a new job (or for the pool to shut down)
+        pthread_mutex_lock(&pool->poolMutex);
+        while ((!pool->shutdownFlag) &&
+               (pool->jobGeneration == lastGeneration))
+            pthread_cond_wait(&pool->workCondition, &pool->poolMutex);
+
+        // Bail out if we're shutting down
+        if (pool->shutdownFlag)
+        {
+            pthread_mutex_unlock(&pool->poolMutex);
+            break;
+        }
+
+        // Remember which job we're working on
+        lastGeneration = pool->jobGeneration;
+        pthread_mutex_unlock(&pool->poolMutex);
+
+        // Help with the job
+        pool->runTasks();
+
+        // Let the submitting thread know we're finished with this job
+        pthread_mutex_lock(&pool->poolMutex);
+        pool->busyWorkers--;
+        if (pool->busyWorkers == 0)
+            pthread_cond_signal(&pool->doneCondition);
+        pthread_mutex_unlock(&pool->poolMutex);
+    }
+
+    return NULL;
+}
+
+// ------------------------------------------------------------------------
+// Pulls chunks of work off of the current job until none are left
+// ------------------------------------------------------------------------
+void vsThreadPool::runTasks()
+{
+    int first, last;
+
+    while (true)
+    {
+        // Claim the next chunk of work items
+        first = vsAtomicFetchAdd(&nextTaskIndex, taskGrain);
+        if (first >= taskCount)
+            return;
+
+        // Clamp the chunk to the end of the range and process it
+        last = first + taskGrain;
+        if (last > taskCount)
+            last = taskCount;
+        taskFunc(taskData, first, last);
+    }
+}
+
+// ------------------------------------------------------------------------
+// Returns the number of worker threads in the pool (not counting the
+// thread that calls parallelFor())
+// ------------------------------------------------------------------------
+int vsThreadPool::getThreadCount()
+{
+    return threadCount;
+}
+
+// ------------------------------------------------------------------------
+// Runs the given function over the work items [0, count), split into
+// chunks of grainSize items, using the worker threads and the calling
+// thread.  Returns once all items have been processed.  If the pool is
+// already busy (for example, when called from inside another task) the
+// work is simply done serially on the calling thread.
+// ------------------------------------------------------------------------
+void vsThreadPool::parallelFor(int count, int grainSize,
+                               vsThreadPoolTaskFunc func, void *userData)
+{
+    // Nothing to do for an empty range
+    if ((count <= 0) || (func == NULL))
+        return;
+
+    // Sanitize the grain size
+    if (grainSize < 1)
+        grainSize = 1;
+
+    // Just run the job here if it's too small to split up, if we don't have
+    // any workers, or if the pool is already in use
+    if ((threadCount == 0) || (count <= grainSize) ||
+        (pthread_mutex_trylock(&submitMutex) != 0))
+    {
+        func(userData, 0, count);
+        return;
+    }
+
+    // Post the job and wake up the workers
+    pthread_mutex_lock(&poolMutex);
+    taskFunc = func;
+    taskData = userData;
+    taskCount = count;
+    taskGrain = grainSize;
+    nextTaskIndex = 0;
+    busyWorkers = threadCount;
+    jobGeneration++;
+    pthread_cond_broadcast(&workCondition);
+    pthread_mutex_unlock(&poolMutex);
+
+    // Pitch in on the work ourselves
+    runTasks();
+
+    // Wait for all workers to check in before returning (the job data
+    // usually lives on the caller's stack)
+    pthread_mutex_lock(&poolMutex);
+    while (busyWorkers > 0)
+        pthread_cond_wait(&doneCondition, &poolMutex);
+    taskFunc = NULL;
+    taskData = NULL;
+    pthread_mutex_unlock(&poolMutex);
+
+    // Allow the next job to be submitted
+    pthread_mutex_unlock(&submitMutex);
+}
+
+// ------------------------------------------------------------------------
+// Static function
+// Returns the number of processors available on this machine
+// ------------------------------------------------------------------------
+int vsThreadPool::getProcessorCount()
+{
+#ifdef WIN32
+    SYSTEM_INFO sysInfo;
+
+    GetSystemInfo(&sysInfo);
+    return (int)sysInfo.dwNumberOfProcessors;
+#else
+    long count;
+
+    count = sysconf(_SC_NPROCESSORS_ONLN);
+    if (count < 1)
+        return 1;
+    return (int)count;
+#endif
+}
+
+// ------------------------------------------------------------------------
+// Static function
+// Returns the shared, default-sized thread pool, creating it if needed
+// ------------------------------------------------------------------------
+vsThreadPool *vsThreadPool::getDefaultPool()
+{
+    vsThreadPool *pool;
+
+    // Once the pool exists, it can be returned without locking (the
+    // barrier pairs with the one below, so we never see the pointer
+    // before the pool it points to)
+    pool = defaultPool;
+    vsMemoryBarrier();
+    if (pool != NULL)
+        return pool;
+
+    // Several threads may ask for the pool at once, so only create it
+    // while holding the lock, and only if nobody beat us to it
+    pthread_mutex_lock(&defaultPoolMutex);
+    if (defaultPool == NULL)
+    {
+        // Finish constructing the pool before publishing the pointer
+        pool = new vsThreadPool(VS_THREAD_POOL_DEFAULT_SIZE);
+        vsMemoryBarrier();
+        defaultPool = pool;
+    }
+    pool = defaultPool;
+    pthread_mutex_unlock(&defaultPoolMutex);
+
+    // Return the pool
+    return pool;
+}
+
+// ------------------------------------------------------------------------
+// Static function
+// Shuts down and deletes the default thread pool
+// ------------------------------------------------------------------------
+void vsThreadPool::deleteDefaultPool()
+{
+    vsThreadPool *pool;
+
+    // Take the pool out of circulation under the lock, so a concurrent
+    // getDefaultPool() either sees the old pool or creates a new one
+    pthread_mutex_lock(&defaultPoolMutex);
+    pool = defaultPool;
+    defaultPool = NULL;
+    pthread_mutex_unlock(&defaultPoolMutex);
+
+    // Delete the old pool if there was one
+    if (pool != NULL)
+        delete pool;
+}
@@ -0,0 +1,85 @@
+//------------------------------------------------------------------------
+//
+//    VIRTUAL ENVIRONMENT SOFTWARE SANDBOX (VESS)
+//
+//    Copyright (c) 2001, University of Central Florida
+//
+//       See the file LICENSE for license information
+//
+//    E-mail:  vess@ist.ucf.edu
+//    WWW:     http://vess.ist.ucf.edu/
+//
+//------------------------------------------------------------------------
+//
+//    VESS Module:  vsThreadPool.h++
+//
+//    Description:  Pool of worker threads used to split data-parallel
+//                  work (skinning, intersection batches, etc.) across
+//                  the available processors
+//
+//    Author(s):    agent
+//
+//------------------------------------------------------------------------
+
+#ifndef VS_THREAD_POOL_HPP
+#define VS_THREAD_POOL_HPP
+
+#include "vsObject.h++"
+#include <pthread.h>
+
+// Passing this as the thread count creates one worker per processor,
+// less one for the calling thread (which also does work)
+#define VS_THREAD_POOL_DEFAULT_SIZE -1
+
+// Function type for a parallel task.  The task is handed a half-open
+// range [first, last) of work items to process
+typedef void (*vsThreadPoolTaskFunc)(void *userData, int first, int last);
+
+class VESS_SYM vsThreadPool : public vsObject
+{
+private:
+
+    static vsThreadPool     * volatile defaultPool;
+    static pthread_mutex_t  defaultPoolMutex;
+
+    int                     threadCount;
+    pthread_t               *workerThreads;
+
+    pthread_mutex_t         submitMutex;
+    pthread_mutex_t         poolMutex;
+    pthread_cond_t          workCondition;
+    pthread_cond_t          doneCondition;
+
+    vsThreadPoolTaskFunc    taskFunc;
+    void                    *taskData;
+    int                     taskCount;
+    int                     taskGrain;
+    volatile int            nextTaskIndex;
+
+    int                     jobGeneration;
+    int                     busyWorkers;
+    bool                    shutdownFlag;
+
+    static void             *workerThreadFunc(void *arg);
+
+    void                    runTasks();
+
+public:
+
+                            vsThreadPool(int numThreads);
+    virtual                 ~vsThreadPool();
+
+    virtual const char      *getClassName();
+
+    int                     getThreadCount();
+
+    void                    parallelFor(int count, int grainSize,
+                                        vsThreadPoolTaskFunc func,
+                                        void *userData);
+
+    static int              getProcessorCount();
+    static vsThreadPool     *getDefaultPool();
+    static void             deleteDefaultPool();
+};
+
+#endif
@@ -13,13 +13,20 @@
 //
 //    VESS Module:  vsVideoQueue.c++
 //
-//    Description:  
+//    Description:  Class for holding a series of images.  The images are
+//                  kept in a fixed pool of reference-counted frame slots.
+//                  A producer fills a slot in place and commits it, and
+//                  consumers lease committed frames read-only and release
+//                  them when they're done, so no image data needs to be
+//                  copied on the way through the queue.
 //
 //    Author(s):    Casey Thurston
 //
 //------------------------------------------------------------------------
 
 #include "vsVideoQueue.h++"
+#include "vsAtomic.h++"
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -30,6 +37,8 @@
 // ------------------------------------------------------------------------
 vsVideoQueue::vsVideoQueue(int width, int height, int capacity)
 {
+    int i;
+
     // Store the stream properties.
     streamWidth = width;
     streamHeight = height;
@@ -40,31 +49,63 @@ vsVideoQueue::vsVideoQueue(int width, int height, int capacity)
     // Calculate the number of bytes required for each complete image.
     bytesPerImage = streamWidth * streamHeight * bytesPerPixel;
 
-    // Store the queue capacity and create the ring buffer.
+    // Keep one more slot than the requested capacity, so the producer can
+    // always fill a new frame while the last 'capacity' frames remain
+    // available to the consumers.
     if (capacity <= 0)
-    {
-        bufferCapacity = bytesPerImage + sizeof(double);
-    }
+        frameCount = 2;
     else
+        frameCount = capacity + 1;
+
+    // Create the frame slots, with all of the image data in one block.
+    frameList = (vsVideoFrame *)calloc(frameCount, sizeof(vsVideoFrame));
+    frameData = (unsigned char *)malloc(frameCount * bytesPerImage);
+    for (i = 0; i < frameCount; i++)
     {
-        bufferCapacity = capacity * (bytesPerImage + sizeof(double));
+        // Each slot starts out empty and unleased.
+        frameList[i].data = &frameData[i * bytesPerImage];
+        frameList[i].timestamp = 0.0;
+        frameList[i].sequence = -1;
+        frameList[i].leaseCount = 0;
     }
 
-    // Create the ring buffer and initialize the tail at byte 0.
-    bufferTail = 0;
-    ringBuffer = (unsigned char *)malloc(bufferCapacity);
+    // No frames have been written yet.
+    writeFrame = NULL;
+    frameTail = 0;
 
     // Begin with zero references.
     totalRefCount = 0;
     referenceListHead = NULL;
+
+    // Initialize the mutex to protect the reference list.
+    pthread_mutex_init(&listMutex, NULL);
 }
 
 // ------------------------------------------------------------------------
-// Destructor - This destructor does nothing because the parent class
-// destructor frees all memory.
+// Destructor
+// Frees the frame slots.  Any frames still leased at this point become
+// invalid, so consumers should release their frames before giving up
+// their reference to the queue.
 // ------------------------------------------------------------------------
 vsVideoQueue::~vsVideoQueue()
 {
+    vsMQRefNode *traversalNode;
+
+    // Free all of the nodes in the reference list.
+    traversalNode = referenceListHead;
+    while (traversalNode)
+    {
+        referenceListHead = traversalNode->next;
+        free(traversalNode);
+        traversalNode = referenceListHead;
+    }
+
+    // Free the frame slots and their image data.
+    free(frameList);
+    free(frameData);
+
+    // Free the mutex semaphore.
+    pthread_mutex_destroy(&listMutex);
 }
 
 // ------------------------------------------------------------------------
@@ -75,6 +116,85 @@ const char *vsVideoQueue::getClassName()
     return "vsVideoQueue";
 }
 
+// ------------------------------------------------------------------------
+// Adds a new reference to the queue and returns its ID.  Each reference
+// reads the frames independently of the others, starting with the oldest
+// frame still in the queue.
+// ------------------------------------------------------------------------
+int vsVideoQueue::addReference()
+{
+    vsMQRefNode *addNode;
+    int returnID;
+
+    // Create a new reference node.
+    addNode = (vsMQRefNode *)malloc(sizeof(vsMQRefNode));
+
+    // Acquire exclusive access to the list so the node may be inserted.
+    pthread_mutex_lock(&listMutex);
+
+    // Assign the new reference the next ID.
+    totalRefCount++;
+    addNode->refID = totalRefCount;
+    returnID = addNode->refID;
+
+    // Begin the head at the first frame.  The head is moved up to the
+    // oldest frame still in the queue the first time it's used.
+    addNode->bufferHead = 0;
+
+    // Add the node to the head of the list.
+    addNode->next = referenceListHead;
+    referenceListHead = addNode;
+
+    // Yield access to the list and return the new ID.
+    pthread_mutex_unlock(&listMutex);
+    return returnID;
+}
+
+// ------------------------------------------------------------------------
+// Removes the reference with the given ID from the queue.  Any frames the
+// reference still has leased must be released separately.
+// ------------------------------------------------------------------------
+void vsVideoQueue::yieldReference(int id)
+{
+    vsMQRefNode *traversalNode;
+    vsMQRefNode *removalNode;
+
+    // Acquire exclusive access to the list so the node may be removed.
+    pthread_mutex_lock(&listMutex);
+
+    // Find the node with the given ID and unlink it.
+    removalNode = NULL;
+    if (referenceListHead)
+    {
+        if (referenceListHead->refID == id)
+        {
+            // The node is at the head of the list.
+            removalNode = referenceListHead;
+            referenceListHead = removalNode->next;
+        }
+        else
+        {
+            // Loop until the NEXT node is the one to be removed.
+            traversalNode = referenceListHead;
+            while ((traversalNode->next) &&
+                (traversalNode->next->refID != id))
+                traversalNode = traversalNode->next;
+
+            // Unlink the node if we found it.
+            if (traversalNode->next)
+            {
+                removalNode = traversalNode->next;
+                traversalNode->next = removalNode->next;
+            }
+        }
+    }
+
+    // Yield access to the list, then free the node.
+    pthread_mutex_unlock(&listMutex);
+    if (removalNode)
+        free(removalNode);
+}
+
 // ------------------------------------------------------------------------
 // Returns the width of images stored in this video stream.
 // ------------------------------------------------------------------------
@@ -108,26 +228,205 @@ int vsVideoQueue::getBytesPerImage()
     return bytesPerImage;
 }
 
+// ------------------------------------------------------------------------
+// Claims a frame slot for the producer and returns the image buffer to be
+// filled (getBytesPerImage() bytes).  The slot holding the oldest frame
+// that no consumer is leasing is reused.  Returns NULL if every slot is
+// leased, in which case the new frame should be dropped.  Only one thread
+// may act as the producer for a given queue.
+// ------------------------------------------------------------------------
+unsigned char *vsVideoQueue::acquireWriteFrame()
+{
+    vsVideoFrame *oldestFrame;
+    int attempt;
+    int i;
+
+    // If the producer already holds a slot, just hand it back.
+    if (writeFrame != NULL)
+        return writeFrame->data;
+
+    // A consumer may lease the chosen slot before we can claim it, so try
+    // again (a bounded number of times) if that happens.
+    for (attempt = 0; attempt < frameCount; attempt++)
+    {
+        // Find the unleased slot holding the oldest frame.  Empty slots have
+        // a sequence of -1, so they're always chosen first.
+        oldestFrame = NULL;
+        for (i = 0; i < frameCount; i++)
+        {
+            if ((frameList[i].leaseCount == 0) &&
+                ((oldestFrame == NULL) ||
+                 (frameList[i].sequence < oldestFrame->sequence)))
+                oldestFrame = &frameList[i];
+        }
+
+        // If every slot is leased, there's nowhere to put the frame.
+        if (oldestFrame == NULL)
+            return NULL;
+
+        // Try to claim the slot, which locks the consumers out of it until
+        // it's committed.
+        if (vsAtomicCompareAndSwap(&oldestFrame->leaseCount, 0,
+            VS_VIDEO_FRAME_WRITING))
+        {
+            // The old frame is going away, so mark the slot empty in case
+            // the write is canceled.
+            oldestFrame->sequence = -1;
+            writeFrame = oldestFrame;
+            return writeFrame->data;
+        }
+    }
+
+    // The consumers kept beating us to the slots.
+    return NULL;
+}
+
+// ------------------------------------------------------------------------
+// Publishes the frame the producer filled after calling
+// acquireWriteFrame(), making it available to all consumers.
+// ------------------------------------------------------------------------
+void vsVideoQueue::commitWriteFrame(double timestamp)
+{
+    // Nothing to do if the producer isn't holding a slot.
+    if (writeFrame == NULL)
+        return;
+
+    // Stamp the frame with its time and place in the stream.
+    writeFrame->timestamp = timestamp;
+    writeFrame->sequence = frameTail;
+
+    // Make sure the image data and the stamps are visible before the slot
+    // is opened up to the consumers.
+    vsMemoryBarrier();
+    vsAtomicCompareAndSwap(&writeFrame->leaseCount, VS_VIDEO_FRAME_WRITING,
+        0);
+
+    // Advance the tail past the new frame.
+    vsAtomicAdd(&frameTail, 1);
+
+    // The producer is done with the slot.
+    writeFrame = NULL;
+}
+
+// ------------------------------------------------------------------------
+// Gives back the slot claimed by acquireWriteFrame() without publishing a
+// frame (if the frame couldn't be completed, for example).
+// ------------------------------------------------------------------------
+void vsVideoQueue::cancelWriteFrame()
+{
+    // Nothing to do if the producer isn't holding a slot.
+    if (writeFrame == NULL)
+        return;
+
+    // The slot was marked empty when it was claimed, so just unlock it.
+    vsAtomicCompareAndSwap(&writeFrame->leaseCount, VS_VIDEO_FRAME_WRITING,
+        0);
+    writeFrame = NULL;
+}
+
+// ------------------------------------------------------------------------
+// Leases the next frame for the reference with the given ID, advancing
+// the reference past it.  Frames that have been overwritten since the
+// reference last read are skipped.  Returns NULL if no new frame is
+// available or the ID is invalid.  The frame's image must be treated as
+// read-only, and the frame must be given back with releaseFrame().
+// ------------------------------------------------------------------------
+vsVideoFrame *vsVideoQueue::leaseFrame(int id)
+{
+    return leaseNextFrame(id, true);
+}
+
+// ------------------------------------------------------------------------
+// Leases the next frame for the reference with the given ID, like
+// leaseFrame(), but without advancing the reference past it.  The frame
+// must be given back with releaseFrame().
+// ------------------------------------------------------------------------
+vsVideoFrame *vsVideoQueue::peekFrame(int id)
+{
+    return leaseNextFrame(id, false);
+}
+
+// ------------------------------------------------------------------------
+// Leases the newest frame in the queue, regardless of any reference.
+// This takes no locks, so it's suitable for consumers (such as a display)
+// that only ever want the current image.  Returns NULL if no frame is
+// available.  The frame must be given back with releaseFrame().
+// ------------------------------------------------------------------------
+vsVideoFrame *vsVideoQueue::leaseLatestFrame()
+{
+    vsVideoFrame *frame;
+    int tail;
+    int sequence;
+
+    // Start with the newest frame, and fall back to older ones if the
+    // newest can't be leased (this only happens if it was overwritten in
+    // the meantime)
+    tail = vsAtomicLoad(&frameTail);
+    for (sequence = tail - 1;
+         (sequence >= 0) && (sequence >= tail - frameCount); sequence--)
+    {
+        frame = leaseSequence(sequence);
+        if (frame != NULL)
+            return frame;
+    }
+
+    // No frames to be had
+    return NULL;
+}
+
+// ------------------------------------------------------------------------
+// Gives back a frame obtained from leaseFrame(), peekFrame(), or
+// leaseLatestFrame(), allowing its slot to be reused.
+// ------------------------------------------------------------------------
+void vsVideoQueue::releaseFrame(vsVideoFrame *frame)
+{
+    // Drop this consumer's lease on the frame.
+    if (frame != NULL)
+        vsAtomicAdd(&frame->leaseCount, -1);
+}
+
 // ------------------------------------------------------------------------
 // This method will copy the data from the image with the given timestamp.
+// The frame is dropped if the consumers are leasing every slot.
 // ------------------------------------------------------------------------
 void vsVideoQueue::enqueue(char *image, double timestamp)
 {
-    // Enqueue the timestamp and then the image data.
-    vsMultiQueue::enqueue(&timestamp, sizeof(double));
-    vsMultiQueue::enqueue(image, bytesPerImage);
+    unsigned char *frameBuffer;
+
+    // Claim a slot for the image.
+    frameBuffer = acquireWriteFrame();
+    if (frameBuffer == NULL)
+        return;
+
+    // Copy the image into the slot and publish it.
+    memcpy(frameBuffer, image, bytesPerImage);
+    commitWriteFrame(timestamp);
 }
 
 // ------------------------------------------------------------------------
 // This method will fill the provided pointers with the image and timestamp
 // data of the first frame in the queue and return true, or return false if
 // there is no data in the list. This method removes the data from the
-// queue.
+// queue. Either pointer may be NULL if that data isn't needed.
 // ------------------------------------------------------------------------
 bool vsVideoQueue::dequeue(char *image, double *timestamp, int id)
 {
-    return (readBuffer(timestamp, 0, sizeof(double), id, true) &&
-        readBuffer(image, 0, bytesPerImage, id, true));
+    vsVideoFrame *frame;
+
+    // Lease the next frame, moving the reference past it.
+    frame = leaseNextFrame(id, true);
+    if (frame == NULL)
+        return false;
+
+    // Copy out whatever was requested.
+    if (image)
+        memcpy(image, frame->data, bytesPerImage);
+    if (timestamp)
+        *timestamp = frame->timestamp;
+
+    // Give back the frame.
+    releaseFrame(frame);
+    return true;
 }
 
 // ------------------------------------------------------------------------
@@ -137,29 +436,201 @@ bool vsVideoQueue::dequeue(char *image, double *timestamp, int id)
 // ------------------------------------------------------------------------
 bool vsVideoQueue::peek(char *image, double *timestamp, int id)
 {
-    // See if the timestamp value is requested.
+    vsVideoFrame *frame;
+
+    // Lease the next frame without moving the reference.
+    frame = leaseNextFrame(id, false);
+    if (frame == NULL)
+        return false;
+
+    // Copy out whatever was requested.
+    if (image)
+        memcpy(image, frame->data, bytesPerImage);
     if (timestamp)
+        *timestamp = frame->timestamp;
+
+    // Give back the frame.
+    releaseFrame(frame);
+    return true;
+}
+
+// ------------------------------------------------------------------------
+// This method 'clears' all of the frames waiting for the provided
+// reference ID by moving its head forward to the newest frame.
+// ------------------------------------------------------------------------
+void vsVideoQueue::clear(int id)
+{
+    vsMQRefNode *traversalNode;
+
+    // Acquire exclusive access to the list for reference ID lookup.
+    pthread_mutex_lock(&listMutex);
+
+    // Look up the reference ID and move its head to the tail.
+    traversalNode = referenceListHead;
+    while (traversalNode)
     {
-        // Attempt to read the timestamp from the buffer, returning false if
-        // the operation fails.
-        if (!readBuffer(timestamp, 0, sizeof(double), id, false))
+        if (traversalNode->refID == id)
         {
-            return false;
+            traversalNode->bufferHead = vsAtomicLoad(&frameTail);
+            traversalNode = NULL;
+        }
+        else
+        {
+            traversalNode = traversalNode->next;
         }
     }
 
-    // See if the image data is requested.
-    if (image)
+    // Yield list access before returning.
+    pthread_mutex_unlock(&listMutex);
+}
+
+// ------------------------------------------------------------------------
+// Returns the number of frames waiting for the provided reference ID
+// ------------------------------------------------------------------------
+int vsVideoQueue::getLength(int id)
+{
+    vsMQRefNode *traversalNode;
+    int tail;
+    int framesAvailable;
+
+    // Acquire exclusive access to the list for reference ID lookup.
+    pthread_mutex_lock(&listMutex);
+
+    // Look up the reference ID from the list, starting at the head.
+    traversalNode = referenceListHead;
+    while ((traversalNode) && (traversalNode->refID != id))
+        traversalNode = traversalNode->next;
+
+    // See if the lookup operation failed.
+    if (traversalNode == NULL)
     {
-        // Attempt to read the timestamp from the buffer, returning false if
-        // the operation fails.
-        if (!readBuffer(image, sizeof(double), bytesPerImage, id, false))
-        {
+        // Yield list access and report the failure.
+        pthread_mutex_unlock(&listMutex);
+        fprintf(stderr, "vsVideoQueue::getLength: Invalid reference ID! "
+            "(%d)\n", id);
+        return 0;
+    }
+
+    // Count the frames between the head and the tail, but no more than the
+    // queue can actually hold.
+    tail = vsAtomicLoad(&frameTail);
+    framesAvailable = tail - traversalNode->bufferHead;
+    if (framesAvailable > frameCount)
+        framesAvailable = frameCount;
+
+    // Yield list access before returning our answer
+    pthread_mutex_unlock(&listMutex);
+    return framesAvailable;
+}
+
+// ------------------------------------------------------------------------
+// Protected function
+// Attempts to lease the given slot, as long as it still holds the frame
+// with the given sequence number.  Returns whether the lease was taken.
+// ------------------------------------------------------------------------
+bool vsVideoQueue::leaseSlot(vsVideoFrame *frame, int sequence)
+{
+    int count;
+
+    // Bump the lease count, unless the producer owns the slot
+    do
+    {
+        count = vsAtomicLoad(&frame->leaseCount);
+        if ((count < 0) || (frame->sequence != sequence))
             return false;
-        }
+    }
+    while (!vsAtomicCompareAndSwap(&frame->leaseCount, count, count + 1));
+
+    // The producer may have recycled the slot between our sequence check
+    // and the lease, so make sure it still holds the same frame
+    vsMemoryBarrier();
+    if (frame->sequence != sequence)
+    {
+        releaseFrame(frame);
+        return false;
     }
 
-    // Return true, indicating that all requested operations succeeded.
+    // The frame is ours until we release it
     return true;
 }
 
+// ------------------------------------------------------------------------
+// Protected function
+// Finds and leases the slot holding the frame with the given sequence
+// number.  Returns NULL if that frame is no longer in the queue.
+// ------------------------------------------------------------------------
+vsVideoFrame *vsVideoQueue::leaseSequence(int sequence)
+{
+    int i;
+
+    // Check each slot for the frame
+    for (i = 0; i < frameCount; i++)
+    {
+        if ((frameList[i].sequence == sequence) &&
+            (leaseSlot(&frameList[i], sequence)))
+            return &frameList[i];
+    }
+
+    // The frame has been overwritten (or hasn't been written yet)
+    return NULL;
+}
+
+// ------------------------------------------------------------------------
+// Protected function
+// Leases the oldest frame still available to the given reference,
+// optionally moving the reference past it.  Only the reference list is
+// locked (to look up the ID); the frames themselves are accessed without
+// locking and nothing is copied.
+// ------------------------------------------------------------------------
+vsVideoFrame *vsVideoQueue::leaseNextFrame(int id, bool dequeue)
+{
+    vsMQRefNode *traversalNode;
+    vsVideoFrame *frame;
+    int tail;
+    int head;
+
+    // Acquire exclusive access to the list for reference ID lookup.
+    pthread_mutex_lock(&listMutex);
+
+    // Look up the reference ID from the list, starting at the head.
+    traversalNode = referenceListHead;
+    while ((traversalNode) && (traversalNode->refID != id))
+        traversalNode = traversalNode->next;
+
+    // See if the lookup operation failed.
+    if (traversalNode == NULL)
+    {
+        // Yield list access and report the failure.
+        pthread_mutex_unlock(&listMutex);
+        fprintf(stderr, "vsVideoQueue::leaseFrame: Invalid reference ID! "
+            "(%d)\n", id);
+        return NULL;
+    }
+
+    // Fix the position of the head if it had previously been left behind.
+    tail = vsAtomicLoad(&frameTail);
+    head = traversalNode->bufferHead;
+    if (tail - head > frameCount)
+        head = tail - frameCount;
+
+    // Lease the first frame from the head onward that's still around
+    // (frames may have been recycled while we were looking).
+    frame = NULL;
+    while ((frame == NULL) && (head < tail))
+    {
+        frame = leaseSequence(head);
+        if (frame == NULL)
+            head++;
+    }
+
+    // Move the head past the frame if this is a dequeue, or up to it if
+    // this is just a peek.
+    if ((frame != NULL) && (dequeue))
+        traversalNode->bufferHead = head + 1;
+    else
+        traversalNode->bufferHead = head;
+
+    // Yield list access and return the frame (if any)
+    pthread_mutex_unlock(&listMutex);
+    return frame;
+}
@@ -13,7 +13,12 @@
 //
 //    VESS Module:  vsVideoQueue.h++
 //
-//    Description:  Class for holding a series of images.
+//    Description:  Class for holding a series of images.  The images are
+//                  kept in a fixed pool of reference-counted frame slots.
+//                  A producer fills a slot in place and commits it, and
+//                  consumers lease committed frames read-only and release
+//                  them when they're done, so no image data needs to be
+//                  copied on the way through the queue.
 //
 //    Author(s):    Casey Thurston
 //
@@ -26,30 +31,77 @@
 #include "vsMultiQueue.h++"
 #include <pthread.h>
 
-class VESS_SYM vsVideoQueue : public vsMultiQueue
+// Lease count of a frame slot while the producer is writing into it
+#define VS_VIDEO_FRAME_WRITING    -1
+
+struct VESS_SYM vsVideoFrame
+{
+    unsigned char    *data;
+    double           timestamp;
+
+    // Sequence number of the frame held in this slot (-1 if the slot has
+    // never been committed)
+    volatile int     sequence;
+
+    // Number of consumers currently leasing this slot, or
+    // VS_VIDEO_FRAME_WRITING while the producer owns it
+    volatile int     leaseCount;
+};
+
+class VESS_SYM vsVideoQueue : public vsObject
 {
 protected:
 
-    int         streamWidth;
-    int         streamHeight;
-    int         bytesPerPixel;
-    int         bytesPerImage;
+    int             totalRefCount;
+    vsMQRefNode     *referenceListHead;
+    pthread_mutex_t listMutex;
+
+    int             streamWidth;
+    int             streamHeight;
+    int             bytesPerPixel;
+    int             bytesPerImage;
+
+    vsVideoFrame    *frameList;
+    int             frameCount;
+    unsigned char   *frameData;
+
+    vsVideoFrame    *writeFrame;
+    volatile int    frameTail;
+
+    bool            leaseSlot(vsVideoFrame *frame, int sequence);
+    vsVideoFrame    *leaseSequence(int sequence);
+    vsVideoFrame    *leaseNextFrame(int id, bool dequeue);
 
 public:
 
-                vsVideoQueue(int width, int height, int capacity);
-    virtual     ~vsVideoQueue();
+                    vsVideoQueue(int width, int height, int capacity);
+    virtual         ~vsVideoQueue();
 
     virtual const char    *getClassName();
 
-    int         getWidth();
-    int         getHeight();
-    int         getBytesPerPixel();
-    int         getBytesPerImage();
+    int             addReference();
+    void            yieldReference(int id);
+
+    int             getWidth();
+    int             getHeight();
+    int             getBytesPerPixel();
+    int             getBytesPerImage();
+
+    unsigned char   *acquireWriteFrame();
+    void            commitWriteFrame(double timestamp);
+    void            cancelWriteFrame();
+
+    vsVideoFrame    *leaseFrame(int id);
+    vsVideoFrame    *peekFrame(int id);
+    vsVideoFrame    *leaseLatestFrame();
+    void            releaseFrame(vsVideoFrame *frame);
+
+    void            enqueue(char *image, double timestamp);
+    bool            dequeue(char *image, double *timestamp, int id);
+    bool            peek(char *image, double *timestamp, int id);
 
-    void        enqueue(char *image, double timestamp);
-    bool        dequeue(char *image, double *timestamp, int id);
-    bool        peek(char *image, double *timestamp, int id);
+    void            clear(int id);
+    int             getLength(int id);
 };
 
 #endif